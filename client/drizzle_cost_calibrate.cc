@@ -0,0 +1,402 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+  drizzle_cost_calibrate
+
+  Measures the machine drizzled runs on and writes a cost model file
+  for the --optimizer-cost-model server option.
+
+  Every constant of the model is relative to the sequential read of one
+  IO_SIZE block. The IO constants come from timing sequential and
+  random block reads of a scratch file.
+
+  The CPU constants come from timing queries against a running server
+  over a MEMORY table, so they include what the server really does per
+  row:
+
+    - a full scan, for reading a row of an in-memory table,
+    - the same scan with a WHERE clause, for evaluating a condition,
+    - the same scan sorted, for comparing two keys.
+
+  A cold block read and a server side row evaluation are too far apart
+  to be compared directly (the server's "block read" is mostly a buffer
+  pool hit), so the CPU measurements are only used relative to each
+  other and scaled so that row_evaluate_cost keeps its default of 0.2.
+
+  With --engine the lines are prefixed with the engine name, so the
+  output can be appended to a file that already holds the server wide
+  values.
+*/
+
+#include "client/client_priv.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <boost/program_options.hpp>
+
+#include "user_detect.h"
+
+namespace po= boost::program_options;
+using namespace std;
+
+/* Must match IO_SIZE of the server, the unit of Cursor::scan_time() */
+static const size_t BLOCK_SIZE= 4096;
+/* Must match BLOCKS_IN_AVG_SEEK of the server's default model */
+static const double BLOCKS_IN_AVG_SEEK= 128;
+/* Default row_evaluate_cost of the server, the CPU measurements are scaled to it */
+static const double ROW_EVALUATE_COST= 0.2;
+/* Each query is run this often and the fastest run is kept */
+static const int QUERY_RUNS= 5;
+
+static const char *calibrate_table= "drizzle_cost_calibrate";
+
+static double now_usec()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double) tv.tv_sec * 1000000.0 + (double) tv.tv_usec;
+}
+
+/* Ask the kernel to forget the file so the reads go to the device */
+static void drop_cache(int fd)
+{
+#ifdef POSIX_FADV_DONTNEED
+  fdatasync(fd);
+  (void) posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#else
+  (void) fd;
+#endif
+}
+
+static bool create_file(const string &path, size_t blocks)
+{
+  int fd= open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0600);
+  if (fd < 0)
+    return true;
+
+  vector<char> block(BLOCK_SIZE);
+  for (size_t x= 0; x < blocks; x++)
+  {
+    for (size_t y= 0; y < BLOCK_SIZE; y+= sizeof(size_t))
+      memcpy(&block[y], &x, sizeof(size_t));
+    if (write(fd, &block[0], BLOCK_SIZE) != (ssize_t) BLOCK_SIZE)
+    {
+      close(fd);
+      return true;
+    }
+  }
+  drop_cache(fd);
+  return close(fd) != 0;
+}
+
+/* Microseconds per block */
+static double time_reads(const string &path, size_t blocks, bool random_order)
+{
+  int fd= open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return -1.0;
+  drop_cache(fd);
+
+  vector<char> block(BLOCK_SIZE);
+  unsigned int seed= 1;
+  double start= now_usec();
+  for (size_t x= 0; x < blocks; x++)
+  {
+    off_t offset= (off_t) (random_order ? rand_r(&seed) % blocks : x) * BLOCK_SIZE;
+    if (pread(fd, &block[0], BLOCK_SIZE, offset) != (ssize_t) BLOCK_SIZE)
+    {
+      close(fd);
+      return -1.0;
+    }
+  }
+  double elapsed= now_usec() - start;
+  close(fd);
+
+  return elapsed / (double) blocks;
+}
+
+/* Run a statement and read its whole result, false on error */
+static bool run_query(drizzle_con_st *con, const string &query)
+{
+  drizzle_result_st result;
+  drizzle_return_t ret;
+
+  if (drizzle_query_str(con, &result, query.c_str(), &ret) == NULL ||
+      ret != DRIZZLE_RETURN_OK)
+  {
+    if (ret == DRIZZLE_RETURN_ERROR_CODE)
+    {
+      cerr << "Error executing '" << query << "': " << drizzle_result_error(&result) << endl;
+      drizzle_result_free(&result);
+    }
+    else
+    {
+      cerr << "Error executing '" << query << "': " << drizzle_con_error(con) << endl;
+    }
+    return false;
+  }
+
+  ret= drizzle_result_buffer(&result);
+  drizzle_result_free(&result);
+  if (ret != DRIZZLE_RETURN_OK)
+  {
+    cerr << "Could not read the result of '" << query << "': " << drizzle_con_error(con) << endl;
+    return false;
+  }
+  return true;
+}
+
+/* Microseconds of the fastest of QUERY_RUNS runs, negative on error */
+static double time_query(drizzle_con_st *con, const string &query)
+{
+  double best= -1.0;
+  for (int x= 0; x < QUERY_RUNS; x++)
+  {
+    double start= now_usec();
+    if (not run_query(con, query))
+      return -1.0;
+    double elapsed= now_usec() - start;
+    if (best < 0.0 || elapsed < best)
+      best= elapsed;
+  }
+  return best;
+}
+
+/*
+  Fill the scratch table with at least "rows" rows: a is unique and
+  b is scrambled so that sorting on it really compares.
+*/
+static bool fill_table(drizzle_con_st *con, size_t rows, size_t *filled)
+{
+  ostringstream create;
+  create << "CREATE TABLE " << calibrate_table
+         << " (a BIGINT NOT NULL, b BIGINT NOT NULL) ENGINE=MEMORY";
+  if (not run_query(con, string("DROP TABLE IF EXISTS ") + calibrate_table) ||
+      not run_query(con, create.str()))
+    return false;
+
+  ostringstream insert;
+  insert << "INSERT INTO " << calibrate_table << " VALUES ";
+  for (size_t x= 0; x < 1024; x++)
+    insert << (x ? ",(" : "(") << x << "," << (x * 2654435761U) % 1000003 << ")";
+  if (not run_query(con, insert.str()))
+    return false;
+
+  for (*filled= 1024; *filled < rows; *filled*= 2)
+  {
+    ostringstream copy;
+    copy << "INSERT INTO " << calibrate_table
+         << " SELECT a + " << *filled << ", (b * 7919 + a) % 1000003 FROM "
+         << calibrate_table;
+    if (not run_query(con, copy.str()))
+      return false;
+  }
+  return true;
+}
+
+struct ServerCosts
+{
+  double row_read;                              /* usec per scanned row */
+  double row_evaluate;                          /* usec per WHERE evaluation */
+  double key_compare;                           /* usec per sort comparison */
+};
+
+static bool time_server(drizzle_con_st *con, size_t rows, ServerCosts *costs)
+{
+  size_t filled;
+  if (not fill_table(con, rows, &filled))
+    return false;
+
+  string table(calibrate_table);
+  double round_trip= time_query(con, "SELECT 1");
+  double scan= time_query(con, "SELECT COUNT(b) FROM " + table);
+  /* Both conditions are true for every row, so the COUNT() work is the same */
+  double where= time_query(con, "SELECT COUNT(b) FROM " + table + " WHERE a >= 0 AND b >= 0");
+  double sort= time_query(con, "SELECT a FROM " + table + " ORDER BY b LIMIT 1");
+
+  (void) run_query(con, "DROP TABLE " + table);
+
+  if (round_trip < 0.0 || scan < 0.0 || where < 0.0 || sort < 0.0)
+    return false;
+
+  double n= (double) filled;
+  costs->row_read= (scan - round_trip) / n;
+  costs->row_evaluate= (where - scan) / n;
+  /* A sort does about n * log2(n) comparisons on top of the scan */
+  costs->key_compare= (sort - scan) / (n * log2(n));
+
+  return costs->row_read > 0.0 && costs->row_evaluate > 0.0 && costs->key_compare > 0.0;
+}
+
+int main(int argc, char *argv[])
+{
+  string directory;
+  string output;
+  string engine;
+  string host;
+  string user;
+  string password;
+  string database;
+  uint32_t port;
+  size_t file_size;
+  size_t rows;
+
+  po::options_description options("Options");
+  options.add_options()
+    ("help,?", "Display this help and exit.")
+    ("directory,d", po::value<string>(&directory)->default_value("."),
+     "Directory of the scratch file, should be on the device holding the data directory.")
+    ("file-size", po::value<size_t>(&file_size)->default_value(256),
+     "Size of the scratch file in megabytes.")
+    ("host,h", po::value<string>(&host)->default_value("localhost"),
+     "Server to time the CPU costs on.")
+    ("port,p", po::value<uint32_t>(&port)->default_value(0),
+     "Port number to use for the connection.")
+    ("user,u", po::value<string>(&user)->default_value(UserDetect().getUser()),
+     "User for login.")
+    ("password,P", po::value<string>(&password)->default_value(""),
+     "Password to use when connecting to the server.")
+    ("database,D", po::value<string>(&database)->default_value("test"),
+     "Schema the scratch table is created in.")
+    ("rows", po::value<size_t>(&rows)->default_value(262144),
+     "Number of rows in the scratch table the CPU costs are timed on.")
+    ("engine,e", po::value<string>(&engine)->default_value(""),
+     "Write the values as overrides for this storage engine only.")
+    ("output,o", po::value<string>(&output)->default_value(""),
+     "Cost model file to write, standard output if not given.")
+    ;
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, options), vm);
+    po::notify(vm);
+  }
+  catch (std::exception &e)
+  {
+    cerr << argv[0] << ": " << e.what() << endl;
+    return 1;
+  }
+
+  if (vm.count("help"))
+  {
+    cout << "Usage: " << argv[0] << " [OPTIONS]" << endl << options << endl;
+    return 0;
+  }
+
+  if (file_size == 0 || rows < 1024 || port > 65535)
+  {
+    cerr << argv[0] << ": --file-size must be greater than 0, --rows at least 1024"
+         << " and --port at most 65535" << endl;
+    return 1;
+  }
+
+  drizzle_st *drizzle= drizzle_create();
+  if (drizzle == NULL)
+  {
+    cerr << argv[0] << ": could not allocate the connection" << endl;
+    return 1;
+  }
+  drizzle_con_st *con= drizzle_con_add_tcp(drizzle, host.c_str(), port,
+                                           user.c_str(), password.c_str(),
+                                           database.c_str(), DRIZZLE_CON_MYSQL);
+  if (con == NULL || drizzle_con_connect(con) != DRIZZLE_RETURN_OK)
+  {
+    cerr << argv[0] << ": could not connect to " << host << ": "
+         << (con ? drizzle_con_error(con) : "out of memory") << endl;
+    drizzle_free(drizzle);
+    return 1;
+  }
+
+  ServerCosts server;
+  bool timed= time_server(con, rows, &server);
+  drizzle_free(drizzle);
+  if (not timed)
+  {
+    cerr << argv[0] << ": could not time the server" << endl;
+    return 1;
+  }
+
+  size_t blocks= file_size * 1024 * 1024 / BLOCK_SIZE;
+  string path= directory + "/drizzle_cost_calibrate.tmp";
+
+  if (create_file(path, blocks))
+  {
+    cerr << argv[0] << ": could not write '" << path << "': " << strerror(errno) << endl;
+    unlink(path.c_str());
+    return 1;
+  }
+  double sequential= time_reads(path, blocks, false);
+  double random= time_reads(path, blocks, true);
+  unlink(path.c_str());
+
+  if (sequential <= 0.0 || random <= 0.0)
+  {
+    cerr << argv[0] << ": could not read '" << path << "'" << endl;
+    return 1;
+  }
+
+  double seek_cost= random / sequential;
+  double cpu_scale= ROW_EVALUATE_COST / server.row_evaluate;
+
+  ofstream file;
+  if (not output.empty())
+  {
+    file.open(output.c_str());
+    if (not file)
+    {
+      cerr << argv[0] << ": could not open '" << output << "'" << endl;
+      return 1;
+    }
+  }
+  ostream &out= output.empty() ? cout : file;
+  string prefix= engine.empty() ? "" : engine + ".";
+
+  out.precision(6);
+  out << "# Written by drizzle_cost_calibrate, 1.0 = sequential read of one "
+      << BLOCK_SIZE << " byte block (" << sequential << " usec)" << endl;
+  out << "# Server usec per row read " << server.row_read
+      << ", per row evaluation " << server.row_evaluate
+      << ", per key compare " << server.key_compare << endl;
+  out << prefix << "io_block_read_cost = 1.0" << endl;
+  out << prefix << "io_seek_cost = " << seek_cost << endl;
+  /* Keep the split of the historical model: 90% of a seek is fixed */
+  out << prefix << "disk_seek_base_cost = " << seek_cost * 0.9 << endl;
+  out << prefix << "disk_seek_prop_cost = " << seek_cost * 0.1 / BLOCKS_IN_AVG_SEEK << endl;
+  out << prefix << "row_evaluate_cost = " << ROW_EVALUATE_COST << endl;
+  out << prefix << "key_compare_cost = " << server.key_compare * cpu_scale << endl;
+  out << prefix << "memory_row_read_cost = " << server.row_read * cpu_scale << endl;
+
+  return out ? 0 : 1;
+}
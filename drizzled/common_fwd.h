@@ -165,8 +165,11 @@ namespace plugin
 
 namespace optimizer 
 { 
+  class AnalyzeStats;
   class compare_functor;
+  class CostModel;
   class CostVector; 
+  class ExplainAnalyze;
   class Parameter;
   class Position;
   class QuickRange;
@@ -182,6 +185,7 @@ namespace optimizer
 
 namespace session 
 { 
+  class MemoryUsage;
   class State; 
   class TableMessages;
   class Times;
@@ -338,6 +342,7 @@ class var;
 class XID;
 
 struct CacheField;
+struct Field_translator;
 struct Ha_data;
 struct charset_info_st;
 struct option;
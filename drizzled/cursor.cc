@@ -33,6 +33,7 @@
 #include <drizzled/item/int.h>
 #include <drizzled/lock.h>
 #include <drizzled/message/table.h>
+#include <drizzled/optimizer/cost_model.h>
 #include <drizzled/optimizer/cost_vector.h>
 #include <drizzled/plugin/client.h>
 #include <drizzled/plugin/event_observer.h>
@@ -67,6 +68,7 @@ Cursor::Cursor(plugin::StorageEngine &engine_arg,
     ref_length(sizeof(internal::my_off_t)),
     inited(NONE),
     locked(false),
+    cost_model(&optimizer::CostModel::forEngine(engine_arg.getName())),
     next_insert_id(0), insert_id_for_cur_row(0)
 { }
 
@@ -821,7 +823,31 @@ double Cursor::index_only_read_time(uint32_t keynr, double key_records)
   uint32_t keys_per_block= (stats.block_size/2/
 			(getTable()->key_info[keynr].key_length + ref_length) + 1);
   return ((double) (key_records + keys_per_block-1) /
-          (double) keys_per_block);
+          (double) keys_per_block) * getCostModel().getIOSeekCost();
+}
+
+/**
+  Estimated cost of a full table scan: one sequential read per block
+  of the data file, plus the setup of the scan.
+*/
+double Cursor::scan_time()
+{
+  return static_cast<double>(stats.data_file_length) / IO_SIZE *
+         getCostModel().getIOBlockReadCost() + 2;
+}
+
+/**
+  Estimated cost of reading 'rows' rows in 'ranges' ranges through an
+  index: one random read per range and per row.
+*/
+double Cursor::read_time(uint32_t, uint32_t ranges, ha_rows rows)
+{
+  return static_cast<double>(ranges + rows) * getCostModel().getIOSeekCost();
+}
+
+const optimizer::CostModel &Cursor::getCostModel() const
+{
+  return *cost_model;
 }
 
 
@@ -908,7 +934,8 @@ Cursor::multi_range_read_info_const(uint32_t keyno, RANGE_SEQ_IF *seq,
       cost->setIOCount(index_only_read_time(keyno, (uint32_t)total_rows));
     else
       cost->setIOCount(read_time(keyno, n_ranges, total_rows));
-    cost->setCpuCost((double) total_rows / TIME_FOR_COMPARE + 0.01);
+    cost->setCpuCost((double) total_rows /
+                     getCostModel().timeForCompare() + 0.01);
   }
   return total_rows;
 }
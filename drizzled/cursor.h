@@ -162,6 +162,11 @@ public:
   enum {NONE=0, INDEX, RND} inited;
   bool locked;
 
+private:
+  /** Resolved once, cost models do not change after startup */
+  const optimizer::CostModel *cost_model;
+
+public:
   /**
     next_insert_id is the next value which should be inserted into the
     auto_increment column: in a inserting-multi-row statement (like INSERT
@@ -241,13 +246,14 @@ public:
   int update_auto_increment();
 
   /* Estimates calculation */
-  virtual double scan_time(void)
-  { return static_cast<double>(stats.data_file_length) / IO_SIZE + 2; }
-  virtual double read_time(uint32_t, uint32_t ranges, ha_rows rows)
-  { return ranges + rows; }
+  virtual double scan_time(void);
+  virtual double read_time(uint32_t, uint32_t ranges, ha_rows rows);
 
   virtual double index_only_read_time(uint32_t keynr, double records);
 
+  /** Cost constants of this cursor's engine */
+  const optimizer::CostModel &getCostModel() const;
+
   virtual ha_rows multi_range_read_info_const(uint32_t keyno, RANGE_SEQ_IF *seq,
                                               void *seq_init_param,
                                               uint32_t n_ranges, uint32_t *bufsz,
@@ -702,6 +708,7 @@ find_field_in_tables(Session *session, Item_ident *item,
                      bool register_tree_change);
 Field *
 find_field_in_table_ref(Session *session, TableList *table_list,
+                        Name_resolution_context *context,
                         const char *name, uint32_t length,
                         const char *item_name, const char *db_name,
                         const char *table_name, Item **ref,
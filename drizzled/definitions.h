@@ -136,33 +136,6 @@ const uint32_t MAX_KEY_LENGTH_DECIMAL_WIDTH = 4; // strlen("4096")
 #define MIN_FILE_LENGTH_TO_USE_ROW_CACHE (10L*1024*1024)
 #define MIN_ROWS_TO_USE_TABLE_CACHE	 100
 
-/**
-  The following is used to decide if MySQL should use table scanning
-  instead of reading with keys.  The number says how many evaluation of the
-  WHERE clause is comparable to reading one extra row from a table.
-*/
-#define TIME_FOR_COMPARE   5	// 5 compares == one read
-
-/**
-  Number of comparisons of table rowids equivalent to reading one row from a
-  table.
-*/
-#define TIME_FOR_COMPARE_ROWID  (TIME_FOR_COMPARE*2)
-
-/*
-  For sequential disk seeks the cost formula is:
-    DISK_SEEK_BASE_COST + DISK_SEEK_PROP_COST * #blocks_to_skip
-
-  The cost of average seek
-    DISK_SEEK_BASE_COST + DISK_SEEK_PROP_COST*BLOCKS_IN_AVG_SEEK =1.0.
-*/
-#define DISK_SEEK_BASE_COST ((double)0.9)
-
-#define BLOCKS_IN_AVG_SEEK  128
-
-#define DISK_SEEK_PROP_COST ((double)0.1/BLOCKS_IN_AVG_SEEK)
-
-
 /**
   Number of rows in a reference table when refereed through a not unique key.
   This value is only used when we don't know anything about the key
@@ -281,7 +254,8 @@ const uint32_t HA_MAX_REC_LENGTH = 65535;
 enum start_transaction_option_t
 {
   START_TRANS_NO_OPTIONS,
-  START_TRANS_OPT_WITH_CONS_SNAPSHOT
+  START_TRANS_OPT_WITH_CONS_SNAPSHOT,
+  START_TRANS_OPT_WITH_SHARED_SNAPSHOT /* Read the snapshot of Session::getSnapshotSource() */
 };
 
 /* Flags for method is_fatal_error */
@@ -562,6 +536,16 @@ static const uint32_t RECORD_CACHE_SIZE= 64*1024;
 #define likely(x)  __builtin_expect((x),1)
 #define unlikely(x)  __builtin_expect((x),0)
 
+/*
+ * Ask the processor to start loading the cache line at addr, which is
+ * about to be read. Prefetching an address that is not mapped is harmless.
+ */
+#if !defined(__GNUC__)
+#define __builtin_prefetch(addr, rw, locality) ((void) (addr))
+#endif
+
+#define prefetch_read(addr)  __builtin_prefetch((addr),0,3)
+
 
 /*
   Only Linux is known to need an explicit sync of the directory to make sure a
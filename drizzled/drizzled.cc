@@ -56,9 +56,11 @@
 #include <drizzled/internal/my_sys.h>
 #include <drizzled/item/cmpfunc.h>
 #include <drizzled/item/create.h>
+#include <drizzled/memory/block_pool.h>
 #include <drizzled/message/cache.h>
 #include <drizzled/module/load_list.h>
 #include <drizzled/module/registry.h>
+#include <drizzled/optimizer/cost_model.h>
 #include <drizzled/plugin/client.h>
 #include <drizzled/plugin/error_message.h>
 #include <drizzled/plugin/event_observer.h>
@@ -560,6 +562,7 @@ void clean_up(bool print_message)
 
   table_cache_free();
   free_charsets();
+  memory::BlockPool::clear();
   module::Registry &modules= module::Registry::singleton();
   modules.shutdownModules();
 
@@ -920,6 +923,16 @@ static void check_limits_osd(uint32_t in_optimizer_search_depth)
   global_system_variables.optimizer_search_depth= in_optimizer_search_depth;
 }
 
+static void check_limits_parallel_degree(uint64_t in_parallel_degree)
+{
+  global_system_variables.parallel_degree= 1;
+  if (in_parallel_degree < 1 || in_parallel_degree > 64)
+  {
+    drizzled_abort << _("Invalid Value for parallel_degree");
+  }
+  global_system_variables.parallel_degree= in_parallel_degree;
+}
+
 static void check_limits_pbs(uint64_t in_preload_buff_size)
 {
   global_system_variables.preload_buff_size= (32*1024L);
@@ -1029,6 +1042,16 @@ static void check_limits_thread_stack(uint32_t in_my_thread_stack_size)
   my_thread_stack_size= in_my_thread_stack_size - (in_my_thread_stack_size % 1024);
 }
 
+static void check_limits_subquery_cache_size(uint64_t in_subquery_cache_size)
+{
+  global_system_variables.subquery_cache_size= 1024;
+  if (in_subquery_cache_size > UINT32_MAX)
+  {
+    drizzled_abort << _("Invalid Value for subquery_cache_size");
+  }
+  global_system_variables.subquery_cache_size= in_subquery_cache_size;
+}
+
 static void check_limits_tmp_table_size(uint64_t in_tmp_table_size)
 {
   global_system_variables.tmp_table_size= 16*1024*1024L;
@@ -1252,6 +1275,9 @@ bool init_variables_before_daemonizing(int argc, char **argv)
   _("The number of bytes to use when sorting BLOB or TEXT values "
      "(only the first max_sort_length bytes of each value are used; the "
      "rest are ignored)."))
+  ("max-statement-memory", po::value<uint64_t>(&global_system_variables.max_statement_memory)->default_value(0),
+  _("Bytes of memory a statement may allocate in its session before it is "
+     "aborted. 0 means unlimited."))
   ("max-write-lock-count", po::value<uint64_t>(&max_write_lock_count)->default_value(UINT64_MAX),
   _("After this many write locks, allow some read locks to run in between."))
   ("min-examined-row-limit", po::value<uint64_t>(&global_system_variables.min_examined_row_limit)->default_value(0)->notifier(&check_limits_merl),
@@ -1269,6 +1295,15 @@ bool init_variables_before_daemonizing(int argc, char **argv)
      "automatically pick a reasonable value; if set to MAX_TABLES+2, the "
      "optimizer will switch to the original find_best (used for "
      "testing/comparison)."))
+  ("optimizer-cost-model", po::value<string>(),
+  _("File with the cost constants the optimizer prices plans with, as "
+     "written by drizzle_cost_calibrate. Lines are 'name = value' for the "
+     "server wide model or 'engine.name = value' for one storage engine."))
+  ("parallel-degree",
+  po::value<uint64_t>(&global_system_variables.parallel_degree)->default_value(1)->notifier(&check_limits_parallel_degree),
+  _("Number of primary key ranges an aggregate query over one table is "
+     "split into, each scanned by a session of its own. 1 scans the table "
+     "in the session that runs the query."))
   ("preload-buffer-size", po::value<uint64_t>(&global_system_variables.preload_buff_size)->default_value(32*1024L)->notifier(&check_limits_pbs),
   _("The size of the buffer that is allocated when preloading indexes"))
   ("query-alloc-block-size",
@@ -1296,6 +1331,11 @@ bool init_variables_before_daemonizing(int argc, char **argv)
   ("read-rnd-threshold",
   po::value<uint64_t>()->default_value(0),
   _("A global cap on the size of read-rnd-buffer-size (0 means unlimited)"))
+  ("root-block-pool-size",
+  po::value<uint64_t>(&memory::root_block_pool_size)->default_value(16*1024*1024L),
+  _("Memory kept in a server wide pool of freed blocks of statement and "
+     "session memory, for reuse without calling the system allocator. 0 "
+     "disables the pool."))
   ("scheduler", po::value<string>(),
   _("Select scheduler to be used (by default multi-thread)."))
   ("sort-buffer-size",
@@ -1304,6 +1344,14 @@ bool init_variables_before_daemonizing(int argc, char **argv)
   ("sort-heap-threshold",
   po::value<uint64_t>()->default_value(0),
   _("A global cap on the amount of memory that can be allocated by session sort buffers (0 means unlimited)"))
+  ("sort-run-compression", po::value<bool>(&global_system_variables.sort_run_compression)->default_value(false)->zero_tokens(),
+  _("Compress the sorted runs filesort writes to temporary files, so "
+     "merge passes read fewer bytes."))
+  ("subquery-cache-size",
+  po::value<uint64_t>(&global_system_variables.subquery_cache_size)->default_value(1024)->notifier(&check_limits_subquery_cache_size),
+  _("Number of results of a correlated subquery that are kept for reuse "
+     "while a statement runs, keyed on the values the subquery takes from "
+     "the outer query. 0 disables the cache."))
   ("table-definition-cache", po::value<size_t>(&table_def_size)->default_value(128)->notifier(&check_limits_tdc),
   _("The number of cached table definitions."))
   ("table-open-cache", po::value<uint64_t>(&table_cache_size)->default_value(TABLE_OPEN_CACHE_DEFAULT)->notifier(&check_limits_toc),
@@ -1619,6 +1667,7 @@ enum options_drizzled
   OPT_MAX_HEP_TABLE_SIZE,
   OPT_MAX_JOIN_SIZE,
   OPT_MAX_SORT_LENGTH,
+  OPT_MAX_STATEMENT_MEMORY,
   OPT_MAX_SEEKS_FOR_KEY, OPT_MAX_TMP_TABLES, OPT_MAX_USER_CONNECTIONS,
   OPT_MAX_LENGTH_FOR_SORT_DATA,
   OPT_MAX_WRITE_LOCK_COUNT, OPT_BULK_INSERT_BUFFER_SIZE,
@@ -1627,11 +1676,14 @@ enum options_drizzled
   OPT_MYISAM_MAX_SORT_FILE_SIZE, OPT_MYISAM_SORT_BUFFER_SIZE,
   OPT_MYISAM_USE_MMAP, OPT_MYISAM_REPAIR_THREADS,
   OPT_NET_BUFFER_LENGTH,
+  OPT_PARALLEL_DEGREE,
   OPT_PRELOAD_BUFFER_SIZE,
   OPT_RECORD_BUFFER,
   OPT_RECORD_RND_BUFFER, OPT_DIV_PRECINCREMENT,
+  OPT_ROOT_BLOCK_POOL_SIZE,
   OPT_DEBUGGING,
-  OPT_SORT_BUFFER, OPT_TABLE_OPEN_CACHE, OPT_TABLE_DEF_CACHE,
+  OPT_SORT_BUFFER, OPT_SUBQUERY_CACHE_SIZE,
+  OPT_TABLE_OPEN_CACHE, OPT_TABLE_DEF_CACHE,
   OPT_TMP_TABLE_SIZE, OPT_THREAD_STACK,
   OPT_WAIT_TIMEOUT,
   OPT_RANGE_ALLOC_BLOCK_SIZE,
@@ -1809,6 +1861,12 @@ struct option my_long_options[] =
    (char**) &global_system_variables.max_sort_length,
    NULL, 0, GET_SIZE,
    REQUIRED_ARG, 1024, 4, 8192*1024L, 0, 1, 0},
+  {"max_statement_memory", OPT_MAX_STATEMENT_MEMORY,
+   N_("Bytes of memory a statement may allocate in its session before it is "
+      "aborted. 0 means unlimited."),
+   (char**) &global_system_variables.max_statement_memory,
+   NULL, 0, GET_ULL,
+   REQUIRED_ARG, 0, 0, UINT64_MAX, 0, 1, 0},
   {"max_write_lock_count", OPT_MAX_WRITE_LOCK_COUNT,
    N_("After this many write locks, allow some read locks to run in between."),
    (char**) &max_write_lock_count, NULL, 0, GET_ULL,
@@ -1861,6 +1919,13 @@ struct option my_long_options[] =
       "[for example: --plugin_load=crc32,logger_gearman]"),
    NULL, NULL, 0,
    GET_STR, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
+  {"parallel_degree", OPT_PARALLEL_DEGREE,
+   N_("Number of primary key ranges an aggregate query over one table is "
+      "split into, each scanned by a session of its own. 1 scans the table "
+      "in the session that runs the query."),
+   (char**) &global_system_variables.parallel_degree,
+   NULL, 0, GET_ULL,
+   REQUIRED_ARG, 1, 1, 64, 0, 1, 0},
   {"preload_buffer_size", OPT_PRELOAD_BUFFER_SIZE,
    N_("The size of the buffer that is allocated when preloading indexes"),
    (char**) &global_system_variables.preload_buff_size,
@@ -1899,6 +1964,12 @@ struct option my_long_options[] =
    NULL, 0,
    GET_UINT, REQUIRED_ARG, 256*1024L, 64 /*IO_SIZE*2+MALLOC_OVERHEAD*/ ,
    UINT32_MAX, MALLOC_OVERHEAD, 1 /* Small lower limit to be able to test MRR */, 0},
+  {"root_block_pool_size", OPT_ROOT_BLOCK_POOL_SIZE,
+   N_("Memory kept in a server wide pool of freed blocks of statement and "
+      "session memory, for reuse without calling the system allocator. 0 "
+      "disables the pool."),
+   (char**) &memory::root_block_pool_size,
+   NULL, 0, GET_ULL, REQUIRED_ARG, 16*1024*1024L, 0, UINT64_MAX, 0, 1024, 0},
   /* x8 compared to MySQL's x2. We have UTF8 to consider. */
   {"sort_buffer_size", OPT_SORT_BUFFER,
    N_("Each thread that needs to do a sort allocates a buffer of this size."),
@@ -1906,6 +1977,13 @@ struct option my_long_options[] =
    NULL, 0, GET_SIZE, REQUIRED_ARG,
    MAX_SORT_MEMORY, MIN_SORT_MEMORY+MALLOC_OVERHEAD*8, (int64_t)SIZE_MAX,
    MALLOC_OVERHEAD, 1, 0},
+  {"subquery_cache_size", OPT_SUBQUERY_CACHE_SIZE,
+   N_("Number of results of a correlated subquery that are kept for reuse "
+      "while a statement runs, keyed on the values the subquery takes from "
+      "the outer query. 0 disables the cache."),
+   (char**) &global_system_variables.subquery_cache_size,
+   NULL, 0, GET_ULL,
+   REQUIRED_ARG, 1024, 0, UINT32_MAX, 0, 1, 0},
   {"table_definition_cache", OPT_TABLE_DEF_CACHE,
    N_("The number of cached table definitions."),
    (char**) &table_def_size, NULL,
@@ -2029,9 +2107,11 @@ static void drizzle_init_variables()
   max_system_variables.max_length_for_sort_data= 8192*1024L;
   max_system_variables.max_seeks_for_key= ULONG_MAX;
   max_system_variables.max_sort_length= 8192*1024L;
+  max_system_variables.max_statement_memory= UINT64_MAX;
   max_system_variables.min_examined_row_limit= ULONG_MAX;
   max_system_variables.optimizer_prune_level= 1;
   max_system_variables.optimizer_search_depth= MAX_TABLES+2;
+  max_system_variables.parallel_degree= 64;
   max_system_variables.preload_buff_size= 1024*1024*1024L;
   max_system_variables.query_alloc_block_size= UINT32_MAX;
   max_system_variables.query_prealloc_size= UINT32_MAX;
@@ -2039,6 +2119,7 @@ static void drizzle_init_variables()
   max_system_variables.read_buff_size= INT32_MAX;
   max_system_variables.read_rnd_buff_size= UINT32_MAX;
   max_system_variables.sortbuff_size= SIZE_MAX;
+  max_system_variables.subquery_cache_size= UINT32_MAX;
   max_system_variables.tmp_table_size= MAX_MEM_TABLE_SIZE;
 
   /* Variables that depends on compile options */
@@ -2071,6 +2152,12 @@ static void get_options()
     }
   }
 
+  if (vm.count("optimizer-cost-model"))
+  {
+    if (optimizer::CostModel::load(vm["optimizer-cost-model"].as<string>()))
+      drizzled_abort << _("Unable to load optimizer-cost-model");
+  }
+
   if (vm.count("sort-heap-threshold"))
   {
     if ((vm["sort-heap-threshold"].as<uint64_t>() > 0) and
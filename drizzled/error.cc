@@ -665,6 +665,8 @@ ErrorMap::ErrorMap()
   
   // Errors in scripts, such as JavaScript
   ADD_ERROR_MESSAGE(ER_SCRIPT, N_("Script error: %s"));
+
+  ADD_ERROR_MESSAGE(ER_STATEMENT_MEMORY_LIMIT, N_("Statement used more memory than max_statement_memory allows (%" PRIu64 " bytes)."));
 }
 
 } /* namespace drizzled */
@@ -867,7 +867,8 @@ enum error_t {
   ER_TRANSACTION_ALREADY_STARTED,
   ER_CARTESIAN_JOIN_ATTEMPTED,
   ER_NO_LOCK_HELD,
-  ER_SCRIPT                                         /* Error executing script: (such as JavaScript) */
+  ER_SCRIPT,                                        /* Error executing script: (such as JavaScript) */
+  ER_STATEMENT_MEMORY_LIMIT
 };
 
 
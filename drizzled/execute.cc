@@ -33,70 +33,84 @@ namespace drizzled {
 
 Execute::Execute(Session &arg, bool wait_arg) :
   wait(wait_arg),
+  share_snapshot(false),
   _session(arg)
 {
 }
 
-void Execute::run(str_ref execution_string, sql::ResultSet &result_set)
+thread_ptr Execute::start(str_ref execution_string, sql::ResultSet &result_set)
 {
   if (not _session.isConcurrentExecuteAllowed())
   {
     my_error(ER_WRONG_ARGUMENTS, MYF(0), "A Concurrent Execution Session can not launch another session.");
-    return;
+    return thread_ptr();
   }
-  thread_ptr thread;
+  plugin::client::Cached *client= new plugin::client::Cached(result_set);
+  client->pushSQL(execution_string);
+  Session::shared_ptr new_session= Session::make_shared(client, catalog::local());
+  
+  // We set the current schema.  @todo do the same with catalog
+  util::string::ptr schema(_session.schema());
+  if (not schema->empty())
+    new_session->set_schema(*schema);
+  
+  new_session->setConcurrentExecute(false);
+  
+  // Overwrite the context in the next session, with what we have in our
+  // session. Eventually we will allow someone to change the effective
+  // user.
+  new_session->user()= _session.user();
+  new_session->setOriginatingServerUUID(_session.getOriginatingServerUUID());
+  new_session->setOriginatingCommitID(_session.getOriginatingCommitID());
+
+  if (share_snapshot)
   {
-    plugin::client::Cached *client= new plugin::client::Cached(result_set);
-    client->pushSQL(execution_string);
-    Session::shared_ptr new_session= Session::make_shared(client, catalog::local());
-    
-    // We set the current schema.  @todo do the same with catalog
-    util::string::ptr schema(_session.schema());
-    if (not schema->empty())
-      new_session->set_schema(*schema);
-    
-    new_session->setConcurrentExecute(false);
-    
-    // Overwrite the context in the next session, with what we have in our
-    // session. Eventually we will allow someone to change the effective
-    // user.
-    new_session->user()= _session.user();
-    new_session->setOriginatingServerUUID(_session.getOriginatingServerUUID());
-    new_session->setOriginatingCommitID(_session.getOriginatingCommitID());
-    
-    if (Session::schedule(new_session))
-    {
-      Session::unlink(new_session);
-    }
-    else if (wait)
-    {
-      thread= new_session->getThread();
-    }
+    // Read like this session does, in its snapshot
+    new_session->setSnapshotSource(&_session);
+    new_session->variables.tx_isolation= _session.variables.tx_isolation;
   }
   
-  if (wait && thread && thread->joinable())
+  if (Session::schedule(new_session))
   {
-    // We want to make sure that we can be killed
-    if (_session.getThread())
+    Session::unlink(new_session);
+    return thread_ptr();
+  }
+  return new_session->getThread();
+}
+
+bool Execute::join(thread_ptr thread)
+{
+  if (not thread || not thread->joinable())
+    return false;
+
+  // We want to make sure that we can be killed
+  if (_session.getThread())
+  {
+    boost::this_thread::restore_interruption dl(_session.getThreadInterupt());
+    
+    try 
     {
-      boost::this_thread::restore_interruption dl(_session.getThreadInterupt());
-      
-      try 
-      {
-        thread->join();
-      }
-      catch(boost::thread_interrupted const&)
-      {
-        // Just surpress and return the error
-        my_error(drizzled::ER_QUERY_INTERRUPTED, MYF(0));
-        return;
-      }
+      thread->join();
     }
-    else
+    catch(boost::thread_interrupted const&)
     {
-      thread->join();
+      // Just surpress and return the error
+      my_error(drizzled::ER_QUERY_INTERRUPTED, MYF(0));
+      return true;
     }
   }
+  else
+  {
+    thread->join();
+  }
+  return false;
+}
+
+void Execute::run(str_ref execution_string, sql::ResultSet &result_set)
+{
+  thread_ptr thread= start(execution_string, result_set);
+  if (wait)
+    join(thread);
 }
 
 void Execute::run(str_ref execution_string)
@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include <drizzled/pthread_globals.h>
 #include <drizzled/visibility.h>
 
 namespace drizzled {
@@ -27,6 +28,7 @@ namespace drizzled {
 class DRIZZLED_API Execute
 {
   bool wait;
+  bool share_snapshot;
   Session &_session;
 
 public:
@@ -35,6 +37,20 @@ public:
   void run(str_ref);
   void run(str_ref, sql::ResultSet&);
 
+  /**
+    Schedule a session that runs the statements and caches their results,
+    without waiting for it. An empty pointer means no session was started.
+  */
+  thread_ptr start(str_ref, sql::ResultSet&);
+
+  /**
+    Wait for a session started by start().
+
+    @retval true  This session was killed while waiting
+    @retval false OK
+  */
+  bool join(thread_ptr);
+
   Session &session()
   {
     return _session;
@@ -45,6 +61,15 @@ public:
     wait= arg;
   }
 
+  /**
+    Make the sessions start() schedules read the snapshot of this session.
+    This session must not end its statement before they end.
+  */
+  void setShareSnapshot(bool arg= true)
+  {
+    share_snapshot= arg;
+  }
+
 private:
 };
 
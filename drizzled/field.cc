@@ -1056,6 +1056,8 @@ uint32_t Field::fill_cache_field(CacheField *copy)
   copy->str=ptr;
   copy->length=pack_length();
   copy->blob_field=0;
+  copy->length_bytes= 0;
+  copy->null_field= real_maybe_null() ? this : NULL;
   if (flags & BLOB_FLAG)
   {
     copy->blob_field=(Field_blob*) this;
@@ -1067,6 +1069,8 @@ uint32_t Field::fill_cache_field(CacheField *copy)
   {
     copy->strip=0;
     store_length= 0;
+    if (real_type() == DRIZZLE_TYPE_VARCHAR)
+      copy->length_bytes= ((Field_varstring*) this)->pack_length_no_ptr();
   }
   return copy->length+ store_length;
 }
@@ -19,6 +19,7 @@
 
 #include <config.h>
 #include <drizzled/field_iterator.h>
+#include <drizzled/item/direct_ref.h>
 #include <drizzled/table_list.h>
 #include <drizzled/session.h>
 #include <drizzled/sql_lex.h>
@@ -50,6 +51,34 @@ Item *Field_iterator_table::create_item(Session *session)
 }
 
 
+void Field_iterator_view::set(TableList *table)
+{
+  assert(table->is_merged_derived());
+  view= table;
+  ptr= table->field_translation;
+  array_end= table->field_translation_end;
+}
+
+
+void Field_iterator_view::next()
+{
+  ptr++;
+}
+
+
+const char *Field_iterator_view::name() const
+{
+  return ptr->name;
+}
+
+
+Item *Field_iterator_view::create_item(Session *session)
+{
+  assert(context);
+  return new Item_direct_ref(context, &ptr->item, view->alias, ptr->name);
+}
+
+
 void Field_iterator_natural_join::set(TableList *table_ref)
 {
   assert(table_ref->join_columns);
@@ -80,6 +109,12 @@ void Field_iterator_table_ref::set_field_iterator()
   {
     field_it= &natural_join_it;
   }
+  /* This is a derived table merged into the outer query. */
+  else if (table_ref->is_merged_derived())
+  {
+    view_field_it.set_context(context);
+    field_it= &view_field_it;
+  }
   /* This is a base table or stored view. */
   else
   {
@@ -102,6 +137,19 @@ void Field_iterator_table_ref::set(TableList *table)
 }
 
 
+/*
+  The columns of merged derived tables are created in the name resolution
+  context of the select list they are added to.
+*/
+
+void Field_iterator_table_ref::set(TableList *table,
+                                   Name_resolution_context *context_arg)
+{
+  context= context_arg;
+  set(table);
+}
+
+
 void Field_iterator_table_ref::next()
 {
   /* Move to the next field in the current table reference. */
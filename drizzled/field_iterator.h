@@ -64,7 +64,24 @@ public:
 };
 
 
-/* Iterator over the fields of a merge view. */
+/* Iterator over the fields of a merged derived table. */
+
+class Field_iterator_view : public Field_iterator
+{
+  Field_translator *ptr, *array_end;
+  TableList *view;
+  Name_resolution_context *context;
+public:
+  Field_iterator_view() :ptr(0), array_end(0), view(0), context(0) {}
+  void set(TableList *table);
+  void set_context(Name_resolution_context *context_arg) { context= context_arg; }
+  void next();
+  bool end_of_fields() const { return ptr == array_end; }
+  const char *name() const;
+  Item *create_item(Session *session);
+  Field *field() { return 0; }
+};
+
 
 /*
   Field_iterator interface to the list of materialized fields of a
@@ -107,12 +124,15 @@ class Field_iterator_table_ref: public Field_iterator
 {
   TableList *table_ref, *first_leaf, *last_leaf;
   Field_iterator_table        table_field_it;
+  Field_iterator_view         view_field_it;
   Field_iterator_natural_join natural_join_it;
   Field_iterator *field_it;
+  Name_resolution_context *context;
   void set_field_iterator();
 public:
-  Field_iterator_table_ref() :field_it(NULL) {}
+  Field_iterator_table_ref() :field_it(NULL), context(NULL) {}
   void set(TableList *table);
+  void set(TableList *table, Name_resolution_context *context_arg);
   void next();
   bool end_of_fields() const
   { return (table_ref == last_leaf && field_it->end_of_fields()); }
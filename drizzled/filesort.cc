@@ -29,6 +29,7 @@
 #include <queue>
 #include <algorithm>
 #include <iostream>
+#include <vector>
 
 #include <drizzled/drizzled.h>
 #include <drizzled/sql_sort.h>
@@ -36,8 +37,10 @@
 #include <drizzled/error.h>
 #include <drizzled/probes.h>
 #include <drizzled/session.h>
+#include <drizzled/session/memory_usage.h>
 #include <drizzled/table.h>
 #include <drizzled/table_list.h>
+#include <drizzled/optimizer/analyze_stats.h>
 #include <drizzled/optimizer/range.h>
 #include <drizzled/records.h>
 #include <drizzled/internal/iocache.h>
@@ -47,6 +50,7 @@
 #include <drizzled/atomics.h>
 #include <drizzled/global_buffer.h>
 #include <drizzled/sort_field.h>
+#include <drizzled/sort_run_codec.h>
 #include <drizzled/item/subselect.h>
 #include <drizzled/statistics_variables.h>
 #include <drizzled/system_variables.h>
@@ -61,6 +65,16 @@ namespace drizzled {
 #define MERGEBUFF		7
 #define MERGEBUFF2		15
 
+/* Size of the uncompressed records in a block of a compressed run */
+#define SORT_RUN_BLOCK_LENGTH	(64*1024)
+
+/* Shorter string key parts are not worth storing with a length */
+#define MIN_PACKED_KEY_PART_LENGTH	8
+/* Longest key my_string_ptr_sort() may radix sort */
+#define MAX_RADIX_SORT_LENGTH	20
+/* Length stored in front of packed addon fields */
+#define PACKED_ADDON_LENGTH_BYTES	2
+
 class BufferCompareContext
 {
 public:
@@ -74,6 +88,30 @@ public:
 
 };
 
+/**
+  Layout of one part of a sort key, as made by make_sortkey().
+
+  A packed part is stored as a two byte length followed by the part
+  without the trailing bytes it shares with pad, a NULL value is stored
+  as its null byte alone.
+*/
+class SortKeyPart
+{
+public:
+  uint32_t length;                  /* Length of the part, null byte excluded */
+  bool maybe_null;
+  unsigned char null_value;         /* Null byte of a NULL value */
+  bool packed;
+  std::vector<unsigned char> pad;   /* Key of an empty string */
+
+  SortKeyPart() :
+    length(0),
+    maybe_null(false),
+    null_value(0),
+    packed(false)
+  { }
+};
+
 class SortParam {
 public:
   uint32_t rec_length;          /* Length of sorted records */
@@ -90,6 +128,20 @@ public:
   unsigned char *unique_buff;
   bool not_killable;
   char *tmp_buffer;
+  bool compress_runs;           /* Runs are written as SortRunCodec blocks */
+  uint32_t run_block_records;   /* Records in a full block of a run */
+  ha_rows run_records;          /* Records written to the runs in tempfile */
+  uint64_t run_bytes;           /* Bytes of the records written to runs */
+  uint64_t run_compressed_bytes; /* Bytes written for them */
+  uint64_t run_codec_usec;      /* Time spent compressing and decompressing */
+  std::vector<unsigned char> run_buffer; /* A block being decompressed */
+  bool packed_keys;             /* String key parts are stored with a length */
+  bool packed_addons;           /* Addon fields are stored with a length */
+  std::vector<SortKeyPart> key_parts; /* Set if packed_keys */
+  unsigned char *sort_buffer_end; /* End of the sort_keys buffer */
+  unsigned char *record_top;    /* Last record stored in the sort_keys buffer */
+  std::vector<unsigned char> key_buffer;    /* A key before it is packed */
+  std::vector<unsigned char> record_buffer; /* A record before it is stored */
   /* The fields below are used only by Unique class */
   qsort2_cmp compare;
   BufferCompareContext cmp_context;
@@ -110,6 +162,16 @@ public:
     unique_buff(0),
     not_killable(0),
     tmp_buffer(0),
+    compress_runs(false),
+    run_block_records(0),
+    run_records(0),
+    run_bytes(0),
+    run_compressed_bytes(0),
+    run_codec_usec(0),
+    packed_keys(false),
+    packed_addons(false),
+    sort_buffer_end(0),
+    record_top(0),
     compare(0)
   {
   }
@@ -124,13 +186,149 @@ public:
                  internal::io_cache_st *buffer_file,
                  internal::io_cache_st *tempfile);
 
-  void make_sortkey(unsigned char *to,
-                    unsigned char *ref_pos);
+  uint32_t make_sortkey(unsigned char *to,
+                        unsigned char *ref_pos);
   void register_used_fields();
   void save_index(unsigned char **sort_keys,
                   uint32_t count,
                   filesort_info *table_sort);
 
+  void setup_packed_keys(SortField *sortorder, uint32_t s_length);
+  uint32_t pack_key(const unsigned char *from, unsigned char *to) const;
+  void sort_records(unsigned char **sort_keys, uint32_t count);
+  int compare_packed_keys(const unsigned char *a, const unsigned char *b) const;
+
+  /*
+    With packed records the sort_keys buffer is used as a heap: the
+    pointers are stored from its start and the records, each as long as
+    it needs to be, from its end.
+  */
+  bool packed_records() const
+  {
+    return packed_keys || packed_addons;
+  }
+
+  bool buffer_full(unsigned char **sort_keys, uint32_t count) const
+  {
+    return (unsigned char *) (sort_keys + count + 1) + rec_length > record_top;
+  }
+
+  void store_record(unsigned char **sort_key, unsigned char *ref_pos)
+  {
+    uint32_t length= make_sortkey(&record_buffer[0], ref_pos);
+    record_top-= length;
+    memcpy(record_top, &record_buffer[0], length);
+    *sort_key= record_top;
+  }
+
+  /** Length of the key parts of a record made with packed_keys */
+  uint32_t packed_key_length(const unsigned char *record) const
+  {
+    const unsigned char *pos= record;
+    for (std::vector<SortKeyPart>::const_iterator part= key_parts.begin();
+         part != key_parts.end(); part++)
+    {
+      if (part->maybe_null && *pos++ == part->null_value)
+        continue;
+      pos+= part->packed ? 2 + uint2korr(pos) : part->length;
+    }
+    return (uint32_t) (pos - record);
+  }
+
+  /** The addon fields or row reference of a record */
+  unsigned char *res_part(unsigned char *record) const
+  {
+    return record + (packed_keys ? packed_key_length(record) :
+                     rec_length - res_length);
+  }
+
+  uint32_t res_part_length(const unsigned char *res) const
+  {
+    return packed_addons ? uint2korr(res) : res_length;
+  }
+
+  /*
+    Runs hold records of rec_length bytes. A packed record is stored with
+    zeros after it, which the run compression takes away again.
+  */
+  const unsigned char *run_record(unsigned char *record)
+  {
+    if (not packed_records())
+      return record;
+    unsigned char *res= res_part(record);
+    uint32_t length= (uint32_t) (res - record) + res_part_length(res);
+    memcpy(&record_buffer[0], record, length);
+    memset(&record_buffer[length], 0, rec_length - length);
+    return &record_buffer[0];
+  }
+};
+
+/**
+  Writes the records of one run to a filesort temporary file.
+
+  With compress set, the records are collected in blocks of
+  SortParam::run_block_records and each full block is written with
+  SortRunCodec. finish() writes the last, shorter, block.
+*/
+class SortRunWriter
+{
+public:
+  SortRunWriter(SortParam *param_arg, internal::io_cache_st *file_arg,
+                bool compress_arg) :
+    param(param_arg),
+    file(file_arg),
+    compress(compress_arg),
+    records(0)
+  {
+    if (compress)
+    {
+      block.resize((size_t) param->run_block_records * param->rec_length);
+      packed.resize(SortRunCodec::max_block_length(param->run_block_records,
+                                                   param->rec_length));
+    }
+  }
+
+  /** Append count records stored one after the other, true on error */
+  bool write(const unsigned char *from, uint32_t count)
+  {
+    uint32_t rec_length= param->rec_length;
+    if (not compress)
+      return file->write(from, (size_t) count * rec_length);
+
+    for (; count--; from+= rec_length)
+    {
+      memcpy(&block[(size_t) records * rec_length], from, rec_length);
+      if (++records == param->run_block_records && write_block())
+        return true;
+    }
+    return false;
+  }
+
+  /** Write the records not written yet, true on error */
+  bool finish()
+  {
+    return records && write_block();
+  }
+
+private:
+  bool write_block()
+  {
+    uint64_t start= optimizer::AnalyzeStats::now();
+    size_t length= SortRunCodec::encode(&block[0], records, param->rec_length,
+                                        &packed[0]);
+    param->run_codec_usec+= optimizer::AnalyzeStats::now() - start;
+    param->run_bytes+= (uint64_t) records * param->rec_length;
+    param->run_compressed_bytes+= length;
+    records= 0;
+    return file->write(&packed[0], length);
+  }
+
+  SortParam *param;
+  internal::io_cache_st *file;
+  bool compress;
+  uint32_t records;                   /* Records collected in block */
+  std::vector<unsigned char> block;   /* Records of the current block */
+  std::vector<unsigned char> packed;  /* The block as it is written */
 };
 
 /* functions defined in this file */
@@ -145,6 +343,10 @@ static unsigned char *read_buffpek_from_file(internal::io_cache_st *buffer_file,
 static uint32_t suffix_length(uint32_t string_length);
 static void unpack_addon_fields(sort_addon_field *addon_field,
                                 unsigned char *buff);
+static void unpack_packed_addon_fields(sort_addon_field *addon_field,
+                                       unsigned char *buff);
+static bool has_packed_addon_fields(sort_addon_field *addon_field);
+static int packed_key_cmp(const void *arg, const void *a, const void *b);
 
 FileSort::FileSort(Session &arg) :
   _session(arg)
@@ -194,6 +396,7 @@ ha_rows FileSort::run(Table *table, SortField *sortorder, uint32_t s_length,
   uint32_t memavl= 0, min_sort_memory;
   uint32_t maxbuffer;
   size_t allocated_sort_memory= 0;
+  size_t charged_sort_memory= 0;
   buffpek *buffpek_inst= 0;
   ha_rows records= HA_POS_ERROR;
   unsigned char **sort_keys= 0;
@@ -240,12 +443,19 @@ ha_rows FileSort::run(Table *table, SortField *sortorder, uint32_t s_length,
     param.addon_field= get_addon_fields(table->getFields(),
                                         param.sort_length,
                                         &param.addon_length);
+    if (param.addon_field && has_packed_addon_fields(param.addon_field))
+    {
+      param.packed_addons= true;
+      param.addon_length+= PACKED_ADDON_LENGTH_BYTES;
+    }
   }
 
   table_sort.addon_buf= 0;
   table_sort.addon_length= param.addon_length;
   table_sort.addon_field= param.addon_field;
-  table_sort.unpack= unpack_addon_fields;
+  table_sort.unpack= param.packed_addons ? unpack_packed_addon_fields :
+                                           unpack_addon_fields;
+  table_sort.packed_addons= param.packed_addons;
   if (param.addon_field)
   {
     param.res_length= param.addon_length;
@@ -261,6 +471,9 @@ ha_rows FileSort::run(Table *table, SortField *sortorder, uint32_t s_length,
     param.sort_length+= param.ref_length;
   }
   param.rec_length= param.sort_length+param.addon_length;
+  param.setup_packed_keys(sortorder, s_length);
+  if (param.packed_records())
+    param.record_buffer.resize(param.rec_length + 4);
   param.max_rows= max_rows;
 
   if (select && select->quick)
@@ -325,6 +538,15 @@ ha_rows FileSort::run(Table *table, SortField *sortorder, uint32_t s_length,
     my_error(ER_OUT_OF_SORTMEMORY,MYF(ME_ERROR+ME_WAITTANG));
     goto err;
   }
+  param.sort_buffer_end= param.record_top=
+    (unsigned char *) sort_keys + (size_t) param.keys * (param.rec_length + sizeof(char*));
+  if (not getSession().memory_usage.allocated(allocated_sort_memory))
+  {
+    /* Over max_statement_memory, the error is already reported */
+    getSession().memory_usage.freed(allocated_sort_memory);
+    goto err;
+  }
+  charged_sort_memory= allocated_sort_memory;
 
   if (buffpek_pointers.open_cached_file(drizzle_tmpdir.c_str(),TEMP_PREFIX, DISK_BUFFER_SIZE, MYF(MY_WME)))
   {
@@ -332,6 +554,16 @@ ha_rows FileSort::run(Table *table, SortField *sortorder, uint32_t s_length,
   }
 
   param.keys--;  			/* TODO: check why we do this */
+  if (getSession().variables.sort_run_compression)
+  {
+    /*
+      A merge reads at least param.keys / MERGEBUFF2 records of each run at
+      a time, a block must not be larger than that.
+    */
+    param.run_block_records= min(param.keys / (MERGEBUFF2 + 1),
+                                 max((uint32_t) (SORT_RUN_BLOCK_LENGTH / param.rec_length), 1U));
+    param.compress_runs= param.run_block_records != 0;
+  }
   param.sort_form= table;
   param.end=(param.local_sortorder=sortorder)+s_length;
   if ((records= find_all_keys(&param,select,sort_keys, &buffpek_pointers,
@@ -361,12 +593,12 @@ ha_rows FileSort::run(Table *table, SortField *sortorder, uint32_t s_length,
     table_sort.buffpek_len= maxbuffer;
     buffpek_pointers.close_cached_file();
 	/* Open cached file if it isn't open */
-    if (not outfile->inited() && outfile->open_cached_file(drizzle_tmpdir.c_str(),TEMP_PREFIX,READ_RECORD_BUFFER, MYF(MY_WME)))
+    if (not outfile->inited() && outfile->open_cached_file(drizzle_tmpdir.c_str(),TEMP_PREFIX,READ_RECORD_BUFFER, MYF(MY_WME), true))
     {
       goto err;
     }
 
-    if (outfile->reinit_io_cache(internal::WRITE_CACHE,0L,0,0))
+    if (outfile->reinit_io_cache(internal::WRITE_CACHE,0L,1,0))
     {
       goto err;
     }
@@ -432,15 +664,21 @@ ha_rows FileSort::run(Table *table, SortField *sortorder, uint32_t s_length,
 
   if (error)
   {
-    my_message(ER_FILSORT_ABORT, ER(ER_FILSORT_ABORT),
-               MYF(ME_ERROR+ME_WAITTANG));
+    /* Going over max_statement_memory has reported its own error */
+    if (not getSession().memory_usage.limitExceeded())
+      my_message(ER_FILSORT_ABORT, ER(ER_FILSORT_ABORT),
+                 MYF(ME_ERROR+ME_WAITTANG));
   }
   else
   {
     getSession().status_var.filesort_rows+= (uint32_t) records;
   }
+  getSession().status_var.filesort_run_bytes+= param.run_bytes;
+  getSession().status_var.filesort_run_compressed_bytes+= param.run_compressed_bytes;
+  getSession().status_var.filesort_run_compression_usec+= param.run_codec_usec;
   examined_rows= param.examined_rows;
   global_sort_buffer.sub(allocated_sort_memory);
+  getSession().memory_usage.freed(charged_sort_memory);
   table->sort= table_sort;
   DRIZZLE_FILESORT_DONE(error, records);
   return (error ? HA_POS_ERROR : records);
@@ -632,14 +870,18 @@ ha_rows FileSort::find_all_keys(SortParam *param,
       param->examined_rows++;
     if (error == 0 && (!select || select->skip_record() == 0))
     {
-      if (idx == param->keys)
+      if (param->packed_records() ? param->buffer_full(sort_keys, idx) :
+                                    idx == param->keys)
       {
 	if (param->write_keys(sort_keys, idx, buffpek_pointers, tempfile))
 	  return(HA_POS_ERROR);
 	idx=0;
 	indexpos++;
       }
-      param->make_sortkey(sort_keys[idx++], ref_pos);
+      if (param->packed_records())
+        param->store_record(sort_keys + idx++, ref_pos);
+      else
+        param->make_sortkey(sort_keys[idx++], ref_pos);
     }
     else
     {
@@ -682,7 +924,7 @@ ha_rows FileSort::find_all_keys(SortParam *param,
     return(HA_POS_ERROR);
   }
 
-  return tempfile->inited() ? (ha_rows) (tempfile->tell() / param->rec_length) : idx;
+  return tempfile->inited() ? param->run_records : idx;
 } /* find_all_keys */
 
 
@@ -713,9 +955,9 @@ int SortParam::write_keys(unsigned char **sort_keys, uint32_t count,
 {
   buffpek buffpek;
 
-  internal::my_string_ptr_sort((unsigned char*) sort_keys, (uint32_t) count, sort_length);
+  sort_records(sort_keys, count);
   if (not tempfile->inited() &&
-      tempfile->open_cached_file(drizzle_tmpdir.c_str(), TEMP_PREFIX, DISK_BUFFER_SIZE, MYF(MY_WME)))
+      tempfile->open_cached_file(drizzle_tmpdir.c_str(), TEMP_PREFIX, DISK_BUFFER_SIZE, MYF(MY_WME), true))
   {
     return 1;
   }
@@ -730,14 +972,21 @@ int SortParam::write_keys(unsigned char **sort_keys, uint32_t count,
     count=(uint32_t) max_rows;
 
   buffpek.count=(ha_rows) count;
+  run_records+= count;
 
+  SortRunWriter run(this, tempfile, compress_runs);
   for (unsigned char **ptr= sort_keys + count ; sort_keys != ptr ; sort_keys++)
   {
-    if (tempfile->write(*sort_keys, rec_length))
+    if (run.write(run_record(*sort_keys), 1))
     {
       return 1;
     }
   }
+  if (run.finish())
+  {
+    return 1;
+  }
+  record_top= sort_buffer_end;
 
   if (buffpek_pointers->write(&buffpek, sizeof(buffpek)))
   {
@@ -771,13 +1020,17 @@ static inline void store_length(unsigned char *to, uint32_t length, uint32_t pac
 }
 
 
-/** Make a sort-key from record. */
+/** Make a sort-key from record, returns the length of the record made. */
 
-void SortParam::make_sortkey(unsigned char *to, unsigned char *ref_pos)
+uint32_t SortParam::make_sortkey(unsigned char *to, unsigned char *ref_pos)
 {
   Field *field;
   SortField *sort_field;
   size_t length;
+  unsigned char *record= to;
+
+  if (packed_keys)
+    to= &key_buffer[0];
 
   for (sort_field= local_sortorder ;
        sort_field != end ;
@@ -960,15 +1213,23 @@ void SortParam::make_sortkey(unsigned char *to, unsigned char *ref_pos)
     }
   }
 
+  if (packed_keys)
+    to= record + pack_key(&key_buffer[0], record);
+
   if (addon_field)
   {
     /*
       Save field values appended to sorted fields.
       First null bit indicators are appended then field values follow.
       In this implementation we use fixed layout for field values -
-      the same for all records.
+      the same for all records. With packed_addons the total length comes
+      first and the values of the fields that are not NULL follow each
+      other.
     */
     sort_addon_field *addonf= addon_field;
+    unsigned char *start= to;
+    if (packed_addons)
+      to+= PACKED_ADDON_LENGTH_BYTES;
     unsigned char *nulls= to;
     assert(addonf != 0);
     memset(nulls, 0, addonf->offset);
@@ -978,10 +1239,17 @@ void SortParam::make_sortkey(unsigned char *to, unsigned char *ref_pos)
       if (addonf->null_bit && field->is_null())
       {
         nulls[addonf->null_offset]|= addonf->null_bit;
+        if (packed_addons)
+          continue;
 #ifdef HAVE_VALGRIND
 	memset(to, 0, addonf->length);
 #endif
       }
+      else if (packed_addons)
+      {
+        to= field->pack(to, field->ptr);
+        continue;
+      }
       else
       {
 #ifdef HAVE_VALGRIND
@@ -996,12 +1264,52 @@ void SortParam::make_sortkey(unsigned char *to, unsigned char *ref_pos)
       }
       to+= addonf->length;
     }
+    if (packed_addons)
+      int2store(start, (uint32_t) (to - start));
   }
   else
   {
     /* Save filepos last */
     memcpy(to, ref_pos, (size_t) ref_length);
+    to+= ref_length;
+  }
+  return (uint32_t) (to - record);
+}
+
+
+/**
+  Copy a key made by make_sortkey() to a packed key, returns its length.
+*/
+
+uint32_t SortParam::pack_key(const unsigned char *from, unsigned char *to) const
+{
+  unsigned char *start= to;
+
+  for (std::vector<SortKeyPart>::const_iterator part= key_parts.begin();
+       part != key_parts.end(); part++)
+  {
+    if (part->maybe_null)
+    {
+      *to= *from++;
+      if (*to++ == part->null_value)
+      {
+        from+= part->length;
+        continue;
+      }
+    }
+    uint32_t length= part->length;
+    if (part->packed)
+    {
+      while (length && from[length - 1] == part->pad[length - 1])
+        length--;
+      int2store(to, length);
+      to+= 2;
+    }
+    memcpy(to, from, length);
+    to+= length;
+    from+= part->length;
   }
+  return (uint32_t) (to - start);
 }
 
 
@@ -1048,22 +1356,168 @@ void SortParam::register_used_fields()
 
 void SortParam::save_index(unsigned char **sort_keys, uint32_t count, filesort_info *table_sort)
 {
-  internal::my_string_ptr_sort((unsigned char*) sort_keys, (uint32_t) count, sort_length);
-  uint32_t offset= rec_length - res_length;
+  sort_records(sort_keys, count);
 
   if ((ha_rows) count > max_rows)
     count=(uint32_t) max_rows;
 
-  unsigned char* to= table_sort->record_pointers= (unsigned char*) malloc(res_length*count);
+  /* Packed addon fields are kept packed, rr_unpack_from_buffer() knows */
+  size_t length= (size_t) res_length * count;
+  if (packed_addons)
+  {
+    length= 0;
+    for (uint32_t x= 0; x < count; x++)
+      length+= res_part_length(res_part(sort_keys[x]));
+  }
+  table_sort->record_pointers_length= length;
+
+  unsigned char* to= table_sort->record_pointers= (unsigned char*) malloc(length);
 
   for (unsigned char **end_ptr= sort_keys+count ; sort_keys != end_ptr ; sort_keys++)
   {
-    memcpy(to, *sort_keys+offset, res_length);
-    to+= res_length;
+    unsigned char *res= res_part(*sort_keys);
+    uint32_t res_part_len= res_part_length(res);
+    memcpy(to, res, res_part_len);
+    to+= res_part_len;
   }
 }
 
 
+/**
+  Find the key parts worth packing.
+
+  Only string parts are packed, they are mostly padding. Keys short
+  enough to be radix sorted are left alone.
+*/
+
+void SortParam::setup_packed_keys(SortField *sortorder, uint32_t s_length)
+{
+  uint32_t packed_parts= 0;
+
+  if (sort_length <= MAX_RADIX_SORT_LENGTH)
+    return;
+
+  key_parts.resize(s_length);
+  for (uint32_t x= 0; x < s_length; x++)
+  {
+    SortField *sort_field= sortorder + x;
+    SortKeyPart &part= key_parts[x];
+    const charset_info_st *cs;
+    bool string_part;
+
+    part.length= (uint32_t) sort_field->length;
+    part.null_value= sort_field->reverse ? 255 : 0;
+    if (sort_field->field)
+    {
+      part.maybe_null= sort_field->field->maybe_null();
+      cs= sort_field->field->sort_charset();
+      string_part= sort_field->field->result_type() == STRING_RESULT &&
+                   cs != &my_charset_bin;
+    }
+    else
+    {
+      part.maybe_null= sort_field->item->maybe_null;
+      cs= sort_field->item->collation.collation;
+      string_part= sort_field->result_type == STRING_RESULT &&
+                   not sort_field->suffix_length;
+    }
+    if (not string_part || part.length < MIN_PACKED_KEY_PART_LENGTH ||
+        part.length > UINT16_MAX)
+      continue;
+
+    /* Any pad gives the same order, the key of '' strips the most */
+    part.packed= true;
+    part.pad.resize(part.length);
+    if (cs->use_strnxfrm())
+      cs->strnxfrm(&part.pad[0], part.length, (const unsigned char *) "", 0);
+    else
+      memset(&part.pad[0], (cs->state & MY_CS_BINSORT) ? 0 : ' ', part.length);
+    if (sort_field->reverse)
+    {
+      for (uint32_t y= 0; y < part.length; y++)
+        part.pad[y]= (unsigned char) ~part.pad[y];
+    }
+    packed_parts++;
+  }
+
+  if (not packed_parts)
+  {
+    key_parts.clear();
+    return;
+  }
+  packed_keys= true;
+  rec_length+= 2 * packed_parts;
+  /* All item->str() to use some extra byte for end null.. */
+  key_buffer.resize(sort_length + 4);
+}
+
+
+/**
+  Compare two packed keys. The result is the one of a memcmp() of the
+  keys they were packed from.
+*/
+
+int SortParam::compare_packed_keys(const unsigned char *a, const unsigned char *b) const
+{
+  for (std::vector<SortKeyPart>::const_iterator part= key_parts.begin();
+       part != key_parts.end(); part++)
+  {
+    if (part->maybe_null)
+    {
+      if (*a != *b)
+        return (int) *a - (int) *b;
+      b++;
+      if (*a++ == part->null_value)
+        continue;
+    }
+    int cmp;
+    if (not part->packed)
+    {
+      if ((cmp= memcmp(a, b, part->length)))
+        return cmp;
+      a+= part->length;
+      b+= part->length;
+      continue;
+    }
+
+    uint32_t a_length= uint2korr(a);
+    uint32_t b_length= uint2korr(b);
+    a+= 2;
+    b+= 2;
+    cmp= memcmp(a, b, min(a_length, b_length));
+    if (not cmp)
+    {
+      /* The stripped bytes of the shorter part are the ones of pad */
+      if (a_length > b_length)
+        cmp= memcmp(a + b_length, &part->pad[b_length], a_length - b_length);
+      else if (a_length < b_length)
+        cmp= memcmp(&part->pad[a_length], b + a_length, b_length - a_length);
+    }
+    if (cmp)
+      return cmp;
+    a+= a_length;
+    b+= b_length;
+  }
+  return addon_field ? 0 : memcmp(a, b, ref_length);
+}
+
+
+static int packed_key_cmp(const void *arg, const void *a, const void *b)
+{
+  return ((const SortParam *) arg)->compare_packed_keys(*(const unsigned char **) a,
+                                                        *(const unsigned char **) b);
+}
+
+
+void SortParam::sort_records(unsigned char **sort_keys, uint32_t count)
+{
+  if (packed_keys)
+    internal::my_qsort2(sort_keys, count, sizeof(unsigned char *), packed_key_cmp, this);
+  else
+    internal::my_string_ptr_sort((unsigned char*) sort_keys, count, sort_length);
+}
+
+
 /** Merge buffers to make < MERGEBUFF2 buffers. */
 
 int FileSort::merge_many_buff(SortParam *param, unsigned char *sort_buffer,
@@ -1075,7 +1529,7 @@ int FileSort::merge_many_buff(SortParam *param, unsigned char *sort_buffer,
   if (*maxbuffer < MERGEBUFF2)
     return 0;
   if (t_file->flush() ||
-      t_file2.open_cached_file(drizzle_tmpdir.c_str(),TEMP_PREFIX,DISK_BUFFER_SIZE, MYF(MY_WME)))
+      t_file2.open_cached_file(drizzle_tmpdir.c_str(),TEMP_PREFIX,DISK_BUFFER_SIZE, MYF(MY_WME), true))
   {
     return 1;
   }
@@ -1084,7 +1538,7 @@ int FileSort::merge_many_buff(SortParam *param, unsigned char *sort_buffer,
   while (*maxbuffer >= MERGEBUFF2)
   {
     if (from_file->reinit_io_cache(internal::READ_CACHE, 0, 0, 0)
-      || to_file->reinit_io_cache(internal::WRITE_CACHE, 0, 0, 0))
+      || to_file->reinit_io_cache(internal::WRITE_CACHE, 0, 1, 0))
       break;
 
     uint32_t i= 0;
@@ -1122,15 +1576,64 @@ cleanup:
 /**
   Read data to buffer.
 
+  Compressed runs are read a whole block at a time, as many blocks as fit
+  in buffpek_inst->max_keys records.
+
   @retval
     (uint32_t)-1 if something goes wrong
 */
 
-uint32_t FileSort::read_to_buffer(internal::io_cache_st *fromfile, buffpek *buffpek_inst, uint32_t rec_length)
+uint32_t FileSort::read_to_buffer(internal::io_cache_st *fromfile, buffpek *buffpek_inst, SortParam *param)
 {
+  uint32_t rec_length= param->rec_length;
   uint32_t count;
   uint32_t length;
 
+  if (param->compress_runs)
+  {
+    uint64_t start= optimizer::AnalyzeStats::now();
+    unsigned char header[SortRunCodec::HEADER_LENGTH];
+    off_t file_pos= buffpek_inst->file_pos;
+
+    count= 0;
+    while (buffpek_inst->count > count)
+    {
+      uint32_t block_records;
+      bool packed;
+      if (pread(fromfile->file, header, sizeof(header), file_pos) != (ssize_t) sizeof(header))
+        return((uint32_t) -1);
+      length= (uint32_t) SortRunCodec::read_header(header, &block_records, &packed);
+      if (not block_records || block_records > buffpek_inst->count - count)
+        return((uint32_t) -1);
+      if (count + block_records > buffpek_inst->max_keys)
+        break;
+
+      unsigned char *to= buffpek_inst->base + (size_t) count * rec_length;
+      if (param->run_buffer.size() < length)
+        param->run_buffer.resize(length);
+      if (pread(fromfile->file, &param->run_buffer[0], length, file_pos + sizeof(header)) != (ssize_t) length ||
+          SortRunCodec::decode(&param->run_buffer[0], length, packed,
+                               block_records, rec_length, to))
+        return((uint32_t) -1);
+
+      file_pos+= sizeof(header) + length;
+      count+= block_records;
+    }
+    param->run_codec_usec+= optimizer::AnalyzeStats::now() - start;
+
+    /* Blocks are never larger than a merge reads at a time */
+    if (not count && buffpek_inst->count && buffpek_inst->max_keys)
+      return((uint32_t) -1);
+    if (count)
+    {
+      buffpek_inst->key= buffpek_inst->base;
+      buffpek_inst->file_pos= file_pos;
+      buffpek_inst->count-= count;
+      buffpek_inst->mem_count= count;
+    }
+    return (count*rec_length);
+  }
+
   if ((count= (uint32_t) min((ha_rows) buffpek_inst->max_keys,buffpek_inst->count)))
   {
     if (pread(fromfile->file,(unsigned char*) buffpek_inst->base, (length= rec_length*count),buffpek_inst->file_pos) == 0)
@@ -1189,7 +1692,7 @@ int FileSort::merge_buffers(SortParam *param, internal::io_cache_st *from_file,
                             int flag)
 {
   int error;
-  uint32_t rec_length,res_length,offset;
+  uint32_t rec_length;
   size_t sort_length;
   uint32_t maxcount;
   ha_rows max_rows,org_max_rows;
@@ -1210,9 +1713,7 @@ int FileSort::merge_buffers(SortParam *param, internal::io_cache_st *from_file,
 
   error=0;
   rec_length= param->rec_length;
-  res_length= param->res_length;
   sort_length= param->sort_length;
-  offset= rec_length-res_length;
   maxcount= (uint32_t) (param->keys/((uint32_t) (Tb-Fb) +1));
   to_start_filepos= to_file->tell();
   strpos= (unsigned char*) sort_buffer;
@@ -1226,19 +1727,25 @@ int FileSort::merge_buffers(SortParam *param, internal::io_cache_st *from_file,
     cmp= param->compare;
     first_cmp_arg= (void *) &param->cmp_context;
   }
+  else if (param->packed_keys)
+  {
+    cmp= packed_key_cmp;
+    first_cmp_arg= (void *) param;
+  }
   else
   {
     cmp= internal::get_ptr_compare(sort_length);
     first_cmp_arg= (void*) &sort_length;
   }
+  /* The final merge writes plain result records, the others write runs */
+  SortRunWriter run(param, to_file, flag == 0 && param->compress_runs);
   priority_queue<buffpek *, vector<buffpek *>, compare_functor >
     queue(compare_functor(cmp, first_cmp_arg));
   for (buffpek_inst= Fb ; buffpek_inst <= Tb ; buffpek_inst++)
   {
     buffpek_inst->base= strpos;
     buffpek_inst->max_keys= maxcount;
-    strpos+= (uint32_t) (error= (int) read_to_buffer(from_file, buffpek_inst,
-                                                                         rec_length));
+    strpos+= (uint32_t) (error= (int) read_to_buffer(from_file, buffpek_inst, param));
     if (error == -1)
       return -1;
 
@@ -1258,7 +1765,7 @@ int FileSort::merge_buffers(SortParam *param, internal::io_cache_st *from_file,
     */
     buffpek_inst= queue.top();
     memcpy(param->unique_buff, buffpek_inst->key, rec_length);
-    if (to_file->write(buffpek_inst->key, rec_length))
+    if (run.write(buffpek_inst->key, 1))
     {
       return 1;
     }
@@ -1296,14 +1803,15 @@ int FileSort::merge_buffers(SortParam *param, internal::io_cache_st *from_file,
       }
       if (flag == 0)
       {
-        if (to_file->write(buffpek_inst->key, rec_length))
+        if (run.write(buffpek_inst->key, 1))
         {
           return 1;
         }
       }
       else
       {
-        if (to_file->write(buffpek_inst->key+offset, res_length))
+        unsigned char *res= param->res_part(buffpek_inst->key);
+        if (to_file->write(res, param->res_part_length(res)))
         {
           return 1;
         }
@@ -1318,8 +1826,7 @@ int FileSort::merge_buffers(SortParam *param, internal::io_cache_st *from_file,
       buffpek_inst->key+= rec_length;
       if (! --buffpek_inst->mem_count)
       {
-        if (!(error= (int) read_to_buffer(from_file,buffpek_inst,
-                                          rec_length)))
+        if (!(error= (int) read_to_buffer(from_file,buffpek_inst, param)))
         {
           queue.pop();
           break;                        /* One buffer have been removed */
@@ -1361,7 +1868,7 @@ int FileSort::merge_buffers(SortParam *param, internal::io_cache_st *from_file,
     max_rows-= buffpek_inst->mem_count;
     if (flag == 0)
     {
-      if (to_file->write(buffpek_inst->key, (rec_length*buffpek_inst->mem_count)))
+      if (run.write(buffpek_inst->key, buffpek_inst->mem_count))
       {
         return 1;
       }
@@ -1369,12 +1876,13 @@ int FileSort::merge_buffers(SortParam *param, internal::io_cache_st *from_file,
     else
     {
       unsigned char *end;
-      strpos= buffpek_inst->key+offset;
+      strpos= buffpek_inst->key;
       for (end= strpos+buffpek_inst->mem_count*rec_length ;
            strpos != end ;
            strpos+= rec_length)
       {
-        if (to_file->write(strpos, res_length))
+        unsigned char *res= param->res_part(strpos);
+        if (to_file->write(res, param->res_part_length(res)))
         {
           return 1;
         }
@@ -1382,10 +1890,14 @@ int FileSort::merge_buffers(SortParam *param, internal::io_cache_st *from_file,
     }
   }
 
-  while ((error=(int) read_to_buffer(from_file,buffpek_inst, rec_length))
+  while ((error=(int) read_to_buffer(from_file,buffpek_inst, param))
          != -1 && error != 0);
 
 end:
+  if (run.finish())
+  {
+    return 1;
+  }
   lastbuff->count= min(org_max_rows-max_rows, param->max_rows);
   lastbuff->file_pos= to_start_filepos;
 
@@ -1609,6 +2121,19 @@ sort_addon_field *FileSort::get_addon_fields(Field **ptabfield, uint32_t sortlen
 }
 
 
+/** Whether some addon field is packed shorter than its maximum length */
+
+static bool has_packed_addon_fields(sort_addon_field *addon_field)
+{
+  for (sort_addon_field *addonf= addon_field; addonf->field; addonf++)
+  {
+    if (addonf->field->type() == DRIZZLE_TYPE_VARCHAR)
+      return true;
+  }
+  return false;
+}
+
+
 /**
   Copy (unpack) values appended to sorted fields from a buffer back to
   their regular positions specified by the Field::ptr pointers.
@@ -1642,6 +2167,32 @@ unpack_addon_fields(sort_addon_field *addon_field, unsigned char *buff)
   }
 }
 
+/**
+  Unpack addon fields stored with packed_addons: the total length, the
+  null bits and the values of the fields that are not NULL, one after
+  the other.
+*/
+
+static void
+unpack_packed_addon_fields(sort_addon_field *addon_field, unsigned char *buff)
+{
+  Field *field;
+  sort_addon_field *addonf= addon_field;
+  unsigned char *nulls= buff + PACKED_ADDON_LENGTH_BYTES;
+  const unsigned char *from= nulls + addonf->offset;
+
+  for ( ; (field= addonf->field) ; addonf++)
+  {
+    if (addonf->null_bit && (addonf->null_bit & nulls[addonf->null_offset]))
+    {
+      field->set_null();
+      continue;
+    }
+    field->set_notnull();
+    from= field->unpack(field->ptr, from);
+  }
+}
+
 /*
 ** functions to change a double or float to a sortable string
 ** The following should work for IEEE
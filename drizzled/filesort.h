@@ -63,7 +63,7 @@ class FileSort
                       uint32_t *maxbuffer, internal::io_cache_st *t_file);
 
   uint32_t read_to_buffer(internal::io_cache_st *fromfile, buffpek *buffpek,
-                          uint32_t sort_length);
+                          SortParam *param);
 
 
 
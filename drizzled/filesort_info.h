@@ -36,7 +36,9 @@ public:
   size_t    addon_length;       /* Length of the buffer */
   sort_addon_field *addon_field;     /* Pointer to the fields info */
   void    (*unpack)(sort_addon_field *, unsigned char *); /* To unpack back */
+  bool      packed_addons;      /* Addon records start with their length */
   unsigned char     *record_pointers;    /* If sorted in memory */
+  size_t    record_pointers_length; /* Bytes of records in record_pointers */
   ha_rows   found_records;      /* How many records in sort */
 
   filesort_info() :
@@ -48,7 +50,9 @@ public:
     addon_length(0),
     addon_field(0),
     unpack(0),
+    packed_addons(false),
     record_pointers(0),
+    record_pointers_length(0),
     found_records()
   { }
 
@@ -61,7 +65,9 @@ public:
     addon_length(arg.addon_length),
     addon_field(arg.addon_field),
     unpack(arg.unpack),
+    packed_addons(arg.packed_addons),
     record_pointers(arg.record_pointers),
+    record_pointers_length(arg.record_pointers_length),
     found_records(arg.found_records)
   {
   }
@@ -35,7 +35,7 @@ namespace internal {
 */
 
 bool io_cache_st::open_cached_file(const char *dir_arg, const char *prefix_arg,
-		      size_t cache_size_arg, myf cache_myflags)
+		      size_t cache_size_arg, myf cache_myflags, bool use_async_io)
 {
   dir= dir_arg ? strdup(dir_arg) : NULL;
   prefix= prefix_arg ? strdup(prefix_arg) : NULL;
@@ -45,7 +45,7 @@ bool io_cache_st::open_cached_file(const char *dir_arg, const char *prefix_arg,
 
   file_name= 0;
   buffer= 0;				/* Mark that not open */
-  if (not init_io_cache(-1, cache_size_arg,WRITE_CACHE,0L,0, MYF(cache_myflags | MY_NABP)))
+  if (not init_io_cache(-1, cache_size_arg,WRITE_CACHE,0L,use_async_io, MYF(cache_myflags | MY_NABP)))
   {
     return false;
   }
@@ -27,6 +27,8 @@ namespace internal {
 
 #define my_b_EOF INT_MIN
 
+class io_cache_async;
+
 class io_cache_st    /* Used when cacheing files */
 {
 public:
@@ -124,6 +126,16 @@ public:
     somewhere else
   */
   bool alloced_buffer;
+  /*
+    Read-ahead and write-behind state, NULL unless init_io_cache() was
+    asked for async io. The I/O threads fill or empty its second buffer
+    while the caller works on this one.
+  */
+  io_cache_async *async;
+  /* Reads and writes handed to the I/O threads */
+  uint64_t async_requests;
+  /* Times the caller had to wait for one of them to finish */
+  uint64_t async_stalls;
 
   io_cache_st() :
     pos_in_file(0),
@@ -154,7 +166,10 @@ public:
     buffer_length(0),
     read_length(0),
     myflags(0),
-    alloced_buffer(0)
+    alloced_buffer(0),
+    async(0),
+    async_requests(0),
+    async_stalls(0)
   { }
 
   int get();
@@ -167,7 +182,7 @@ public:
 
   bool reinit_io_cache(cache_type type_arg, my_off_t seek_offset, bool use_async_io, bool clear_cache);
   void setup_io_cache();
-  bool open_cached_file(const char *dir, const char *prefix, size_t cache_size, myf cache_myflags);
+  bool open_cached_file(const char *dir, const char *prefix, size_t cache_size, myf cache_myflags, bool use_async_io= false);
   int flush(int need_append_buffer_lock= 1);
 
   void clear()
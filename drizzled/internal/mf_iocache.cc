@@ -18,7 +18,9 @@
   length records. A read isn't allowed to go over file-length. A read is ok
   if it ends at file-length and next read can try to read after file-length
   (and get a EOF-error).
-  Possibly use of asyncronic io.
+  With use_async_io, READ_CACHE reads the next buffer in the background
+  while the caller works on the current one, and WRITE_CACHE writes out a
+  full buffer in the background while the caller fills the other one.
   macros for read and writes for faster io.
   Used instead of FILE when reading or writing whole files.
   This code makes mf_rec_cache obsolete (currently only used by ISAM)
@@ -59,7 +61,14 @@ TODO:
 #include <errno.h>
 #include <drizzled/util/test.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include <algorithm>
+#include <deque>
+
+#include <boost/bind.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 
 using namespace std;
 
@@ -67,8 +76,225 @@ namespace drizzled {
 namespace internal {
 
 static int _my_b_read(io_cache_st *info, unsigned char *Buffer, size_t Count);
+static int _my_b_async_read(io_cache_st *info, unsigned char *Buffer, size_t Count);
 static int _my_b_write(io_cache_st *info, const unsigned char *Buffer, size_t Count);
 
+/**
+ * @brief
+ *   A read-ahead or write-behind of an io_cache_st
+ *
+ * @details
+ *   Set up by the thread using the cache, executed by one of the
+ *   AsyncIoThreads. Only one request of a cache is pending at a time.
+ */
+class io_cache_async
+{
+public:
+  io_cache_async(unsigned char *other_arg) :
+    other(other_arg),
+    enabled(true),
+    pending(false),
+    done(false),
+    is_write(false),
+    file(-1),
+    buf(NULL),
+    length(0),
+    offset(0),
+    result(0),
+    error_number(0)
+  { }
+
+  /** Do the read or write, called by an I/O thread */
+  void execute()
+  {
+    ssize_t total= 0;
+    int saved_errno= 0;
+    while ((size_t) total < length)
+    {
+      ssize_t count= is_write ?
+        pwrite(file, buf + total, length - total, offset + total) :
+        pread(file, buf + total, length - total, offset + total);
+      if (count < 0 && errno == EINTR)
+        continue;
+      if (count < 0)
+      {
+        saved_errno= errno;
+        total= -1;
+        break;
+      }
+      if (count == 0)
+      {
+        /* End of file for a read, a full disk for a write */
+        if (is_write)
+          saved_errno= ENOSPC;
+        break;
+      }
+      total+= count;
+    }
+
+    boost::mutex::scoped_lock scopedLock(lock);
+    result= total;
+    error_number= saved_errno;
+    done= true;
+    cond.notify_all();
+  }
+
+  boost::mutex lock;
+  boost::condition_variable cond;
+  unsigned char *other; /* The buffer the I/O threads work on */
+  bool enabled;         /* Cleared by reinit_io_cache() without use_async_io */
+  bool pending;         /* Started and result not taken yet */
+  bool done;            /* Finished by the I/O thread */
+  bool is_write;
+  int file;
+  unsigned char *buf;
+  size_t length;
+  my_off_t offset;
+  ssize_t result;       /* Bytes read or written, -1 on error */
+  int error_number;
+};
+
+/**
+ * @brief
+ *   Threads executing the io_cache_async requests of all caches
+ */
+class AsyncIoThreads
+{
+public:
+  static const size_t THREAD_COUNT= 4;
+
+  AsyncIoThreads() :
+    started(false)
+  { }
+
+  void submit(io_cache_async *request)
+  {
+    boost::mutex::scoped_lock scopedLock(lock);
+    if (not started)
+    {
+      for (size_t x= 0; x < THREAD_COUNT; x++)
+        boost::thread(boost::bind(&AsyncIoThreads::run, this)).detach();
+      started= true;
+    }
+    queue.push_back(request);
+    cond.notify_one();
+  }
+
+private:
+  void run()
+  {
+    for (;;)
+    {
+      io_cache_async *request;
+      {
+        boost::mutex::scoped_lock scopedLock(lock);
+        while (queue.empty())
+          cond.wait(scopedLock);
+        request= queue.front();
+        queue.pop_front();
+      }
+      request->execute();
+    }
+  }
+
+  boost::mutex lock;
+  boost::condition_variable cond;
+  std::deque<io_cache_async *> queue;
+  bool started;
+};
+
+/*
+  Never destroyed, the threads are still waiting on it when static objects
+  are destroyed at exit.
+*/
+static AsyncIoThreads &async_io_threads()
+{
+  static AsyncIoThreads *threads= new AsyncIoThreads;
+  return *threads;
+}
+
+inline
+static bool async_io_enabled(io_cache_st *info)
+{
+  return info->async && info->async->enabled;
+}
+
+/**
+ * @brief
+ *   Hand a read or write of the second buffer to the I/O threads
+ */
+static void async_start(io_cache_st *info, bool is_write, size_t length, my_off_t offset)
+{
+  io_cache_async *async= info->async;
+  async->is_write= is_write;
+  async->file= info->file;
+  async->buf= async->other;
+  async->length= length;
+  async->offset= offset;
+  async->done= false;
+  async->pending= true;
+  info->async_requests++;
+  async_io_threads().submit(async);
+}
+
+/**
+ * @brief
+ *   Wait for the pending request of info
+ *
+ * @retval Bytes read or written
+ * @retval -1 On error; errno contains error code.
+ */
+static ssize_t async_wait(io_cache_st *info)
+{
+  io_cache_async *async= info->async;
+  boost::mutex::scoped_lock scopedLock(async->lock);
+  if (not async->done)
+  {
+    info->async_stalls++;
+    while (not async->done)
+      async->cond.wait(scopedLock);
+  }
+  async->pending= false;
+  if (async->error_number)
+    errno= async->error_number;
+  return async->result;
+}
+
+/**
+ * @brief
+ *   Finish the pending request of info, if any, so that its buffer and
+ *   file can be reused. A read-ahead is thrown away.
+ *
+ * @retval 0 Ok
+ * @retval 1 The pending write failed
+ */
+static int async_finish(io_cache_st *info)
+{
+  if (not info->async || not info->async->pending)
+    return 0;
+
+  bool is_write= info->async->is_write;
+  size_t length= info->async->length;
+  if (async_wait(info) == (ssize_t) length || not is_write)
+    return 0;
+
+  if (info->myflags & (MY_WME | MY_FAE))
+    my_error(EE_WRITE, MYF(ME_BELL+ME_WAITTANG), "unknown", errno);
+  return 1;
+}
+
+/**
+ * @brief
+ *   Start reading the part of the file after the buffer into the second
+ *   buffer.
+ */
+static void async_read_ahead(io_cache_st *info)
+{
+  my_off_t ahead= info->pos_in_file + (size_t) (info->read_end - info->buffer);
+  if (ahead < info->end_of_file)
+    async_start(info, false, (size_t) min((my_off_t) info->read_length, info->end_of_file - ahead), ahead);
+}
+
 /**
  * @brief
  *   Lock appends for the io_cache_st if required (need_append_buffer_lock)   
@@ -147,7 +373,7 @@ void io_cache_st::init_functions()
     */
     break;
   default:
-    read_function = _my_b_read;
+    read_function = (type == READ_CACHE && async_io_enabled(this)) ? _my_b_async_read : _my_b_read;
     write_function = _my_b_write;
   }
 
@@ -164,7 +390,8 @@ void io_cache_st::init_functions()
  *                      If == 0 then use my_default_record_cache_size
  * @param type Type of cache
  * @param seek_offset Where cache should start reading/writing
- * @param use_async_io Set to 1 if we should use async_io (if avaiable)
+ * @param use_async_io Set to 1 to read ahead or write behind in the background,
+ *                     allocates a second buffer of cachesize
  * @param cache_myflags Bitmap of different flags
                             MY_WME | MY_FAE | MY_NABP | MY_FNABP | MY_DONT_CHECK_FILESIZE
  * 
@@ -178,6 +405,7 @@ int io_cache_st::init_io_cache(int file_arg, size_t cachesize,
   size_t min_cache;
   off_t pos;
   my_off_t end_of_file_local= ~(my_off_t) 0;
+  bool seekable= true;
 
   file= file_arg;
   type= TYPE_NOT_SET;	    /* Don't set it until mutex are created */
@@ -187,6 +415,8 @@ int io_cache_st::init_io_cache(int file_arg, size_t cachesize,
   alloced_buffer = 0;
   buffer=0;
   seek_not_done= 0;
+  async= 0;
+  async_requests= async_stalls= 0;
 
   if (file >= 0)
   {
@@ -198,6 +428,7 @@ int io_cache_st::init_io_cache(int file_arg, size_t cachesize,
          flag that will make us again try to seek() later and fail.
       */
       seek_not_done= 0;
+      seekable= false;
       /*
         Additionally, if we're supposed to start somewhere other than the
         the beginning of whatever this file is, then somebody made a bad
@@ -247,6 +478,10 @@ int io_cache_st::init_io_cache(int file_arg, size_t cachesize,
     buffer= (unsigned char*) malloc(buffer_block);
     write_buffer=buffer;
     alloced_buffer= true;
+
+    if (use_async_io && seekable &&
+        (type_arg == READ_CACHE || type_arg == WRITE_CACHE))
+      async= new io_cache_async((unsigned char*) malloc(buffer_block));
   }
 
   read_length=buffer_length=cachesize;
@@ -264,6 +499,8 @@ int io_cache_st::init_io_cache(int file_arg, size_t cachesize,
   error= 0;
   type= type_arg;
   init_functions();
+  if (type == READ_CACHE && async_io_enabled(this) && file >= 0)
+    async_read_ahead(this);
   return 0;
 }						/* init_io_cache */
 
@@ -279,13 +516,19 @@ int io_cache_st::init_io_cache(int file_arg, size_t cachesize,
  */
 bool io_cache_st::reinit_io_cache(enum cache_type type_arg,
                                   my_off_t seek_offset,
-                                  bool,
+                                  bool use_async_io,
                                   bool clear_cache)
 {
   /* One can't do reinit with the following types */
   assert(type_arg != READ_NET && type != READ_NET &&
 	      type_arg != WRITE_NET && type != WRITE_NET);
 
+  /* The second buffer may be about to be reused */
+  if (async_finish(this))
+    return 1;
+  if (async)
+    async->enabled= use_async_io;
+
   /* If the whole file is in memory, avoid flushing to disk */
   if (! clear_cache &&
       seek_offset >= pos_in_file &&
@@ -346,6 +589,9 @@ bool io_cache_st::reinit_io_cache(enum cache_type type_arg,
   type= type_arg;
   error=0;
   init_functions();
+  if (type == READ_CACHE && async_io_enabled(this) && file >= 0 &&
+      read_pos == read_end)
+    async_read_ahead(this);
 
   return 0;
 } /* reinit_io_cache */
@@ -466,6 +712,75 @@ static int _my_b_read(io_cache_st *info, unsigned char *Buffer, size_t Count)
   return 0;
 }
 
+/**
+ * @brief
+ *   Read buffered, with read-ahead.
+ *
+ * @detail
+ *   Like _my_b_read(), but the buffer after the current one is read by
+ *   an I/O thread into the second buffer while the caller works on the
+ *   current one. When the caller needs it, the two buffers are swapped.
+ *   If the caller moved in the file since, the read-ahead is thrown away.
+ *
+ *   All reads use pread(), so the file offset is left alone and
+ *   seek_not_done is set for the other functions.
+ *
+ * @retval 0 We succeeded in reading all data
+ * @retval 1 Error: can't read requested characters
+ */
+static int _my_b_async_read(io_cache_st *info, unsigned char *Buffer, size_t Count)
+{
+  size_t left_length= 0;
+
+  for (;;)
+  {
+    size_t length_local= min(Count, (size_t) (info->read_end - info->read_pos));
+    memcpy(Buffer, info->read_pos, length_local);
+    info->read_pos+= length_local;
+    Buffer+= length_local;
+    Count-= length_local;
+    left_length+= length_local;
+    if (!Count)
+      return 0;
+
+    /* pos_in_file always point on where info->buffer was read */
+    my_off_t pos_in_file_local= info->pos_in_file + (size_t) (info->read_end - info->buffer);
+    io_cache_async *async= info->async;
+    ssize_t read_length;
+
+    if (async->pending && not async->is_write &&
+        async->offset == pos_in_file_local)
+    {
+      read_length= async_wait(info);
+      std::swap(info->buffer, async->other);
+      info->write_buffer= info->buffer;
+    }
+    else
+    {
+      async_finish(info);
+      read_length= 0;
+      if (pos_in_file_local < info->end_of_file)
+        read_length= pread(info->file, info->buffer,
+                           (size_t) min((my_off_t) info->read_length,
+                                        info->end_of_file - pos_in_file_local),
+                           pos_in_file_local);
+    }
+
+    info->pos_in_file= pos_in_file_local;
+    info->seek_not_done= 1;
+    info->request_pos= info->read_pos= info->read_end= info->buffer;
+    if (read_length <= 0)
+    {
+      info->error= read_length < 0 ? -1 : (int) left_length;
+      return 1;
+    }
+    info->read_end= info->buffer + read_length;
+
+    /* Read the next buffer while the caller works on this one */
+    async_read_ahead(info);
+  }
+}
+
 /**
  * @brief
  *   Read one byte when buffer is empty
@@ -488,6 +803,41 @@ int io_cache_st::get()
   return buff;
 }
 
+/**
+ * @brief
+ *   Hand the full write buffer to the I/O threads and continue with the
+ *   second one.
+ *
+ * @retval 0 On success
+ * @retval -1 On error, the write of the previous buffer failed
+ */
+static int my_b_async_flush(io_cache_st *info)
+{
+  if (info->file == -1 && info->real_open_cached_file())
+    return info->error= -1;
+
+  /* The second buffer is free once its own write is done */
+  if (async_finish(info))
+    return info->error= -1;
+
+  size_t length_local= (size_t) (info->write_pos - info->write_buffer);
+  if (!length_local)
+    return 0;
+
+  my_off_t pos_in_file_local= info->pos_in_file;
+  std::swap(info->write_buffer, info->async->other);
+  async_start(info, true, length_local, pos_in_file_local);
+
+  info->buffer= info->request_pos= info->write_pos= info->write_buffer;
+  info->pos_in_file+= length_local;
+  info->write_end= (info->write_buffer+info->buffer_length-
+                    ((pos_in_file_local+length_local) & (IO_SIZE-1)));
+  set_if_bigger(info->end_of_file, pos_in_file_local+length_local);
+  /* pwrite() leaves the file offset alone */
+  info->seek_not_done= 1;
+  return 0;
+}
+
 /**
  * @brief
  *   Write a byte buffer to io_cache_st and flush to disk if io_cache_st is full.
@@ -512,7 +862,7 @@ int _my_b_write(io_cache_st *info, const unsigned char *Buffer, size_t Count)
   Count-=rest_length;
   info->write_pos+=rest_length;
 
-  if (info->flush(1))
+  if (async_io_enabled(info) ? my_b_async_flush(info) : info->flush(1))
     return 1;
   if (Count >= IO_SIZE)
   {					/* Fill first intern buffer */
@@ -525,7 +875,7 @@ int _my_b_write(io_cache_st *info, const unsigned char *Buffer, size_t Count)
         "seek_not_done" to indicate this to other functions operating
         on the io_cache_st.
       */
-      if (lseek(info->file,info->pos_in_file,SEEK_SET))
+      if (lseek(info->file,info->pos_in_file,SEEK_SET) == MY_FILEPOS_ERROR)
       {
         info->error= -1;
         return (1);
@@ -555,6 +905,10 @@ static int my_block_write(io_cache_st *info, const unsigned char *Buffer, size_t
   size_t length_local;
   int error=0;
 
+  /* The part of the file before the buffer may still be written behind */
+  if (async_finish(info))
+    return info->error= -1;
+
   if (pos < info->pos_in_file)
   {
     /* Of no overlap, write everything without buffering */
@@ -609,6 +963,9 @@ static int my_b_flush_io_cache(io_cache_st *info, int need_append_buffer_lock)
 
   if (info->type == WRITE_CACHE || append_cache)
   {
+    /* The previous buffer must be on disk before this one */
+    if (async_finish(info))
+      return((info->error= -1));
     if (info->file == -1)
     {
       if (info->real_open_cached_file())
@@ -698,6 +1055,13 @@ int io_cache_st::end_io_cache()
     alloced_buffer=0;
     if (file != -1)			/* File doesn't exist */
       _error= my_b_flush_io_cache(this, 1);
+    if (async)
+    {
+      async_finish(this);
+      free(async->other);
+      delete async;
+      async= 0;
+    }
     free((unsigned char*) buffer);
     buffer=read_pos=(unsigned char*) 0;
   }
@@ -604,6 +604,19 @@ bool Item::collect_item_field_processor(unsigned char *)
   return false;
 }
 
+/**
+  Collect the outer references of a subquery into a subselect_memo.
+
+  Results of subqueries that call RAND() or the like cannot be reused,
+  Item_ident adds the outer references themselves.
+*/
+bool Item::collect_outer_ref_processor(unsigned char *arg)
+{
+  if (used_tables() & RAND_TABLE_BIT)
+    ((subselect_memo *) arg)->enabled= false;
+  return false;
+}
+
 bool Item::find_item_in_field_list_processor(unsigned char *)
 {
   return false;
@@ -657,6 +657,7 @@ public:
 
   virtual bool remove_dependence_processor(unsigned char * arg);
   virtual bool collect_item_field_processor(unsigned char * arg);
+  virtual bool collect_outer_ref_processor(unsigned char *arg);
   virtual bool find_item_in_field_list_processor(unsigned char *arg);
   virtual bool change_context_processor(unsigned char *context);
   virtual bool register_field_in_read_map(unsigned char *arg);
@@ -21,6 +21,8 @@
 #include <drizzled/show.h>
 #include <drizzled/table.h>
 #include <drizzled/item/ident.h>
+#include <drizzled/item/subselect_memo.h>
+#include <drizzled/sql_lex.h>
 
 #include <cstdio>
 
@@ -78,6 +80,29 @@ bool Item_ident::remove_dependence_processor(unsigned char * arg)
   return 0;
 }
 
+/**
+  Add an outer reference to the key of a subquery memo. This also covers
+  Item_ref, whose walk() visits the ref itself after what it refers to,
+  so that the outer reference and not its referent becomes the key.
+*/
+bool Item_ident::collect_outer_ref_processor(unsigned char *arg)
+{
+  subselect_memo *memo= (subselect_memo *) arg;
+
+  if (not depended_from || depended_from->nest_level >= memo->nest_level)
+    return Item::collect_outer_ref_processor(arg);
+
+  for (std::vector<Item *>::iterator it= memo->outer_refs.begin();
+       it != memo->outer_refs.end();
+       ++it)
+  {
+    if ((*it)->eq(this, false))
+      return false;
+  }
+  memo->outer_refs.push_back(this);
+  return false;
+}
+
 const char *Item_ident::full_name() const
 {
   if (!table_name || !field_name)
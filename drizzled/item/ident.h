@@ -62,6 +62,7 @@ public:
   const char *full_name() const;
   void cleanup();
   bool remove_dependence_processor(unsigned char * arg);
+  bool collect_outer_ref_processor(unsigned char *arg);
   virtual void print(String *str);
   virtual bool change_context_processor(unsigned char *cntx)
     { context= (Name_resolution_context *)cntx; return false; }
@@ -111,7 +111,23 @@ public:
     return ref ? (*ref)->real_item() : this;
   }
   bool walk(Item_processor processor, bool walk_subquery, unsigned char *arg)
-  { return (*ref)->walk(processor, walk_subquery, arg); }
+  {
+    return (*ref)->walk(processor, walk_subquery, arg) ||
+           (this->*processor)(arg);
+  }
+  /*
+    Of the processors Item_ident acts on only collect_outer_ref_processor
+    is meant for the ref itself, an outer reference being the key of a
+    subquery memo. The others act on what the ref refers to.
+  */
+  bool remove_dependence_processor(unsigned char *)
+  {
+    return false;
+  }
+  bool change_context_processor(unsigned char *)
+  {
+    return false;
+  }
   virtual void print(String *str);
   bool result_as_int64_t()
   {
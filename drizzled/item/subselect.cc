@@ -46,6 +46,7 @@
 #include <drizzled/select_exists_subselect.h>
 #include <drizzled/select_union.h>
 #include <drizzled/sql_lex.h>
+#include <drizzled/statistics_variables.h>
 #include <drizzled/system_variables.h>
 #include <drizzled/key_part_info.h>
 
@@ -71,6 +72,8 @@ Item_subselect::Item_subselect() :
   parsing_place(NO_MATTER),
   have_to_be_excluded(false),
   const_item_cache(true),
+  memo(NULL),
+  memo_checked(false),
   engine_changed(false),
   changed(false),
   is_correlated(false)
@@ -150,6 +153,9 @@ void Item_subselect::cleanup()
     engine->cleanup();
   reset();
   value_assigned= 0;
+  delete memo;
+  memo= NULL;
+  memo_checked= false;
 }
 
 void Item_singlerow_subselect::cleanup()
@@ -173,6 +179,7 @@ void Item_in_subselect::cleanup()
 
 Item_subselect::~Item_subselect()
 {
+  delete memo;
   delete engine;
 }
 
@@ -303,14 +310,170 @@ bool Item_subselect::walk(Item_processor processor, bool walk_subquery,
 }
 
 
+/*
+  Walk the ON conditions of the subquery and of the subqueries nested in
+  it, Item_subselect::walk() only covers the other clauses.
+*/
+static void walk_join_conds(Select_Lex_Unit *unit,
+                            Item_processor processor,
+                            unsigned char *arg)
+{
+  for (Select_Lex *sl= unit->first_select(); sl; sl= sl->next_select())
+  {
+    for (TableList *table= sl->leaf_tables; table; table= table->next_leaf)
+    {
+      for (TableList *embedded= table;
+           embedded;
+           embedded= embedded->getEmbedding())
+      {
+        if (embedded->on_expr)
+          embedded->on_expr->walk(processor, true, arg);
+      }
+    }
+    for (Select_Lex_Unit *inner= sl->first_inner_unit();
+         inner;
+         inner= inner->next_unit())
+    {
+      walk_join_conds(inner, processor, arg);
+    }
+  }
+}
+
+
+/*
+  Decide whether the results of this subquery are memoized.
+
+  Only correlated scalar and EXISTS subqueries are, and only when
+  everything their result depends on, besides the tables they read,
+  is found among the outer references collected as the memo key.
+  Aggregates of an outer query (with_sum_func) and RAND() like items
+  rule the memo out.
+*/
+void Item_subselect::memo_setup()
+{
+  uint64_t max_entries= session->variables.subquery_cache_size;
+  subselect_engine::enum_engine_type type= engine->engine_type();
+
+  if (not max_entries ||
+      not memo_allowed() ||
+      with_sum_func ||
+      not engine->uncacheable(UNCACHEABLE_DEPENDENT) ||
+      (type != subselect_engine::SINGLE_SELECT_ENGINE &&
+       type != subselect_engine::UNION_ENGINE))
+    return;
+
+  memo= new subselect_memo(max_entries, unit->first_select()->nest_level);
+  walk(&Item::collect_outer_ref_processor, true, (unsigned char *) memo);
+  walk_join_conds(unit, &Item::collect_outer_ref_processor,
+                  (unsigned char *) memo);
+
+  for (std::vector<Item *>::iterator it= memo->outer_refs.begin();
+       it != memo->outer_refs.end();
+       ++it)
+  {
+    if ((*it)->result_type() == ROW_RESULT)
+      memo->enabled= false;
+  }
+
+  if (not memo->enabled || memo->outer_refs.empty())
+  {
+    delete memo;
+    memo= NULL;
+  }
+}
+
+
+/*
+  Build the key of the current outer row from the outer references.
+
+  The values are compared as they are stored, so outer values that are
+  equal under a collation but differ in their bytes get entries of their
+  own.
+
+  @retval true   the result of the subquery can be looked up under key
+  @retval false  the subquery is not memoized
+*/
+bool Item_subselect::memo_key(std::string &key)
+{
+  if (not memo_checked)
+  {
+    memo_checked= true;
+    memo_setup();
+  }
+  if (not memo || not memo->enabled)
+    return false;
+
+  char buff[MAX_FIELD_WIDTH];
+  String tmp(buff, sizeof(buff), &my_charset_bin);
+  for (std::vector<Item *>::iterator it= memo->outer_refs.begin();
+       it != memo->outer_refs.end();
+       ++it)
+  {
+    Item *item= *it;
+    switch (item->result_type())
+    {
+    case INT_RESULT:
+      {
+        int64_t nr= item->val_int();
+        key.push_back(item->null_value ? 0 : 1);
+        if (not item->null_value)
+          key.append((const char *) &nr, sizeof(nr));
+        break;
+      }
+    case REAL_RESULT:
+      {
+        double nr= item->val_real();
+        key.push_back(item->null_value ? 0 : 1);
+        if (not item->null_value)
+          key.append((const char *) &nr, sizeof(nr));
+        break;
+      }
+    default:
+      {
+        String *res= item->val_str(&tmp);
+        if (item->null_value || not res)
+        {
+          key.push_back(0);
+          break;
+        }
+        uint32_t length= res->length();
+        key.push_back(1);
+        key.append((const char *) &length, sizeof(length));
+        key.append(res->ptr(), length);
+        break;
+      }
+    }
+  }
+  return not session->is_error();
+}
+
+
+/*
+  Execute the subquery, or take its result from the memo when the outer
+  references have been seen before, see memo_setup().
+*/
 bool Item_subselect::exec()
 {
   int res;
+  std::string key;
 
   if (session->is_error())
   /* Do not execute subselect in case of a fatal error */
     return 1;
 
+  bool memoize= memo_key(key);
+  if (memoize)
+  {
+    subselect_memo::Entry *entry= memo->find(key);
+    if (entry)
+    {
+      session->status_var.subquery_cache_hits++;
+      memo_restore(entry);
+      memo->count(true);
+      return 0;
+    }
+  }
+
   res= engine->exec();
 
   if (engine_changed)
@@ -318,6 +481,13 @@ bool Item_subselect::exec()
     engine_changed= 0;
     return exec();
   }
+
+  if (memoize && not res)
+  {
+    session->status_var.subquery_cache_misses++;
+    if (not memo->count(false))
+      memo_save(memo->insert(key));
+  }
   return (res);
 }
 
@@ -553,6 +723,38 @@ Item_singlerow_subselect::select_transformer(Join *join)
 }
 
 
+void Item_singlerow_subselect::memo_save(subselect_memo::Entry *entry)
+{
+  /* Without a row only value was reset, see restore below */
+  entry->value= assigned();
+  if (not entry->value)
+    return;
+
+  if (not entry->row)
+  {
+    entry->row= (Item_cache**) memory::sql_alloc(sizeof(Item_cache*) * max_columns);
+    for (uint32_t i= 0; i < max_columns; i++)
+    {
+      entry->row[i]= Item_cache::get_cache(row[i]);
+      entry->row[i]->setup(row[i]);
+    }
+  }
+  for (uint32_t i= 0; i < max_columns; i++)
+    entry->row[i]->store(row[i]);
+}
+
+void Item_singlerow_subselect::memo_restore(subselect_memo::Entry *entry)
+{
+  if (not entry->value)
+  {
+    /* What the engine does when the subquery returns no row */
+    reset();
+    return;
+  }
+  for (uint32_t i= 0; i < max_columns; i++)
+    row[i]->store(entry->row[i]);
+}
+
 void Item_singlerow_subselect::store(uint32_t i, Item *item)
 {
   row[i]->store(item);
@@ -23,6 +23,7 @@
 #include <drizzled/item/ref.h>
 #include <drizzled/item/field.h>
 #include <drizzled/item/bin_string.h>
+#include <drizzled/item/subselect_memo.h>
 #include <drizzled/util/test.h>
 
 namespace drizzled {
@@ -52,6 +53,21 @@ protected:
   bool have_to_be_excluded;
   /* cache of constant state */
   bool const_item_cache;
+  /* results of a correlated subquery, see exec() */
+  subselect_memo *memo;
+  /* memo was set up or found not applicable for this execution */
+  bool memo_checked;
+
+  /*
+    Memoization of correlated subqueries. memo_allowed() tells whether
+    the result of this kind of subquery is fully described by what
+    memo_save() stores in an entry.
+  */
+  virtual bool memo_allowed() { return false; }
+  virtual void memo_save(subselect_memo::Entry *) {}
+  virtual void memo_restore(subselect_memo::Entry *) {}
+  void memo_setup();
+  bool memo_key(std::string &key);
 
 public:
   /* changed engine indicator */
@@ -156,6 +172,10 @@ public:
   void cleanup();
   subs_type substype() { return SINGLEROW_SUBS; }
 
+  bool memo_allowed() { return true; }
+  void memo_save(subselect_memo::Entry *entry);
+  void memo_restore(subselect_memo::Entry *entry);
+
   void reset();
   trans_res select_transformer(Join *join);
   void store(uint32_t i, Item* item);
@@ -203,6 +223,8 @@ public:
 			Select_Lex *select_lex, bool max);
   virtual void print(String *str);
   void cleanup();
+  /* The result also depends on was_values */
+  bool memo_allowed() { return false; }
   bool any_value() { return was_values; }
   void register_value() { was_values= true; }
   void reset_value_registration() { was_values= false; }
@@ -225,6 +247,16 @@ public:
     value= 0;
   }
 
+  bool memo_allowed() { return true; }
+  void memo_save(subselect_memo::Entry *entry)
+  {
+    entry->value= value;
+  }
+  void memo_restore(subselect_memo::Entry *entry)
+  {
+    value= entry->value;
+  }
+
   enum Item_result result_type() const { return INT_RESULT;}
   int64_t val_int();
   double val_real();
@@ -329,6 +361,8 @@ public:
   {}
   void cleanup();
   subs_type substype() { return IN_SUBS; }
+  /* The left operand is pushed into the subquery, see left_expr_cache */
+  bool memo_allowed() { return false; }
   void reset()
   {
     value= 0;
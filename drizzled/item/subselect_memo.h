@@ -0,0 +1,134 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#pragma once
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
+#include <drizzled/common_fwd.h>
+
+namespace drizzled {
+
+/**
+  Results of a correlated subquery, keyed on the values of its outer
+  references.
+
+  A correlated scalar or EXISTS subquery is executed again for every row
+  of the outer query. When the outer references repeat, the result is
+  the same as the last time they had these values, so Item_subselect::exec()
+  looks it up here first. The cache keeps the most recently used entries
+  up to the subquery_cache_size session variable, and gives up for the
+  rest of the statement when too few lookups hit.
+*/
+class subselect_memo
+{
+public:
+  /** The result of one execution, see Item_subselect::memo_save() */
+  struct Entry
+  {
+    Entry() :row(NULL), value(false) {}
+
+    std::string key;
+    Item_cache **row; /**< Columns of a scalar subquery */
+    bool value;       /**< Result of an EXISTS subquery */
+  };
+
+  /**
+    Lookups after which the hit rate is checked, and the fraction of
+    them that must have hit for the cache to stay on.
+  */
+  static const uint64_t PROBE_LOOKUPS= 128;
+  static const uint64_t MIN_HIT_RATIO= 8;
+
+  subselect_memo(uint64_t max_entries_arg, int8_t nest_level_arg) :
+    max_entries(max_entries_arg),
+    nest_level(nest_level_arg),
+    enabled(true),
+    hits(0),
+    misses(0)
+  {}
+
+  /** Find the entry for key and make it the most recently used one */
+  Entry *find(const std::string &key)
+  {
+    Index::iterator it= index.find(key);
+    if (it == index.end())
+      return NULL;
+    entries.splice(entries.begin(), entries, it->second);
+    return &*it->second;
+  }
+
+  /**
+    Add an entry for key. When the cache is full, the least recently used
+    entry is recycled, its row caches are overwritten by the caller.
+  */
+  Entry *insert(const std::string &key)
+  {
+    if (index.size() < max_entries)
+      entries.push_front(Entry());
+    else
+    {
+      index.erase(entries.back().key);
+      entries.splice(entries.begin(), entries, --entries.end());
+    }
+    Entry &entry= entries.front();
+    entry.key= key;
+    index[entry.key]= entries.begin();
+    return &entry;
+  }
+
+  /** Count a lookup, returns true if the cache was turned off by it */
+  bool count(bool hit)
+  {
+    if (hit)
+      hits++;
+    else
+      misses++;
+    if (hits + misses == PROBE_LOOKUPS && hits * MIN_HIT_RATIO < PROBE_LOOKUPS)
+    {
+      enabled= false;
+      index.clear();
+      entries.clear();
+      return true;
+    }
+    return false;
+  }
+
+  uint64_t max_entries;
+  /** Items resolved in a select nested less deep than this are outer references */
+  int8_t nest_level;
+  bool enabled;
+  uint64_t hits;
+  uint64_t misses;
+  /** The outer references the result depends on, the parts of the key */
+  std::vector<Item *> outer_refs;
+
+private:
+  typedef std::list<Entry> EntryList;
+  typedef boost::unordered_map<std::string, EntryList::iterator> Index;
+
+  EntryList entries; /**< Most recently used first */
+  Index index;
+};
+
+} /* namespace drizzled */
@@ -2610,10 +2610,11 @@ bool Item_sum_count_distinct::setup(Session *session)
   table->cursor->extra(HA_EXTRA_NO_ROWS);		// Don't update rows
   table->no_rows=1;
 
-  if (table->getShare()->db_type() == heap_engine)
+  if (table->getShare()->db_type() == heap_engine &&
+      not table->getShare()->blob_fields)
   {
     /*
-      No blobs, otherwise it would have been MyISAM: set up a compare
+      No blobs, the rows are compared as they are: set up a compare
       function and its arguments to use with Unique.
     */
     qsort_cmp2 compare_key;
@@ -2734,7 +2735,8 @@ bool Item_sum_count_distinct::add()
     return tree->unique_add(table->record[0] + table->getShare()->null_bytes);
   }
   if ((error= table->cursor->insertRecord(table->record[0])) &&
-      table->cursor->is_fatal_error(error, HA_CHECK_DUP))
+      table->cursor->is_fatal_error(error, HA_CHECK_DUP) &&
+      create_myisam_from_heap(table->in_use, table, tmp_table_param, error, true))
     return true;
   return false;
 }
@@ -54,6 +54,8 @@
 #include <drizzled/optimizer/explain_plan.h>
 #include <drizzled/optimizer/access_method_factory.h>
 #include <drizzled/optimizer/access_method.h>
+#include <drizzled/optimizer/cost_model.h>
+#include <drizzled/optimizer/parallel_aggregate.h>
 #include <drizzled/records.h>
 #include <drizzled/probes.h>
 #include <drizzled/internal/my_bit.h>
@@ -1380,6 +1382,9 @@ void Join::exec()
 
   if (!tables_list && (tables || !select_lex->with_sum_func))
   {                                           
+    if (session->lex().explain_analyze)
+      session->lex().explain_analyze->attach(this, false, false, zero_result_cause ? zero_result_cause : "No tables used");
+
     /* Only test of functions */
     if (select_options & SELECT_DESCRIBE)
     {
@@ -1431,6 +1436,8 @@ void Join::exec()
 
   if (zero_result_cause)
   {
+    if (session->lex().explain_analyze)
+      session->lex().explain_analyze->attach(this, false, false, zero_result_cause);
     return_zero_rows(this, result, select_lex->leaf_tables, *columns_list, send_row_on_empty_set(), select_options, zero_result_cause, having);
     return;
   }
@@ -1466,6 +1473,28 @@ void Join::exec()
     return;
   }
 
+  if (session->variables.parallel_degree > 1)
+  {
+    optimizer::ParallelAggregate parallel(*this);
+    if (parallel.plan())
+    {
+      if (not parallel.run())
+      {
+        error= parallel.send_result();
+        return;
+      }
+      /* A range failed, the serial plan runs unless the session was killed */
+      if (session->is_error())
+      {
+        error= 1;
+        return;
+      }
+    }
+  }
+
+  if (session->lex().explain_analyze)
+    session->lex().explain_analyze->attach(this, need_tmp, order != 0 && ! skip_sort_order, NULL);
+
   Join *curr_join= this;
   List<Item> *curr_all_fields= &all_fields;
   List<Item> *curr_fields_list= &fields_list;
@@ -1502,6 +1531,14 @@ void Join::exec()
       return;
     }
     curr_tmp_table->cursor->info(HA_STATUS_VARIABLE);
+    if (const_tables < tables && join_tab[const_tables].analyze)
+    {
+      optimizer::AnalyzeStats *stats= join_tab[const_tables].analyze;
+      stats->tmp_rows+= curr_tmp_table->cursor->stats.records;
+      stats->tmp_bytes+= curr_tmp_table->cursor->stats.data_file_length;
+      if (curr_tmp_table->getShare()->db_type() != heap_engine)
+        stats->tmp_on_disk= true;
+    }
 
     if (curr_join->having)
       curr_join->having= curr_join->tmp_having= 0; // Allready done
@@ -2495,6 +2532,7 @@ int Join::rollup_send_data(uint32_t idx)
 */
 int Join::rollup_write_data(uint32_t idx, Table *table_arg)
 {
+  int write_error;
   for (uint32_t i= send_group_parts ; i-- > idx ; )
   {
     /* Get reference pointers to sum functions in place */
@@ -2509,11 +2547,10 @@ int Join::rollup_write_data(uint32_t idx, Table *table_arg)
           item->save_in_result_field(1);
       }
       copy_sum_funcs(sum_funcs_end[i+1], sum_funcs_end[i]);
-      if (table_arg->cursor->insertRecord(table_arg->getInsertRecord()))
-      {
-        my_error(ER_USE_SQL_BIG_RESULT, MYF(0));
+      if ((write_error= table_arg->cursor->insertRecord(table_arg->getInsertRecord())) &&
+          create_myisam_from_heap(session, table_arg, &tmp_table_param,
+                                  write_error, false))
         return 1;
-      }
     }
   }
   /* Restore ref_pointer_array */
@@ -2619,7 +2656,19 @@ enum_nested_loop_state evaluate_join_record(Join *join, JoinTable *join_tab, int
     join->session->send_kill_message();
     return NESTED_LOOP_KILLED;
   }
-  if (!select_cond || select_cond->val_int())
+
+  bool matched;
+  if (optimizer::AnalyzeStats *stats= join_tab->analyze)
+  {
+    uint64_t start= optimizer::AnalyzeStats::now();
+    matched= (!select_cond || select_cond->val_int());
+    stats->cond_usec+= optimizer::AnalyzeStats::now() - start;
+    stats->rows_examined++;
+  }
+  else
+    matched= (!select_cond || select_cond->val_int());
+
+  if (matched)
   {
     /*
       There is no select condition or the attached pushed down
@@ -2689,6 +2738,8 @@ enum_nested_loop_state evaluate_join_record(Join *join, JoinTable *join_tab, int
     if (found)
     {
       enum enum_nested_loop_state rc;
+      if (join_tab->analyze)
+        join_tab->analyze->rows_produced++;
       /* A match from join_tab is found for the current partial join. */
       rc= (*join_tab->next_select)(join, join_tab+1, 0);
       if (rc != NESTED_LOOP_OK && rc != NESTED_LOOP_NO_MORE_ROWS)
@@ -2807,12 +2858,20 @@ enum_nested_loop_state flush_cached_records(Join *join, JoinTable *join_tab, boo
     delete join_tab->select->quick;
     join_tab->select->quick= 0;
   }
+  optimizer::AnalyzeStats *stats= join_tab->analyze;
+  uint64_t start= stats ? optimizer::AnalyzeStats::now() : 0;
+
   /* read through all records */
   if ((error=join_init_read_record(join_tab)))
   {
     join_tab->cache.reset_cache_write();
     return error < 0 ? NESTED_LOOP_NO_MORE_ROWS: NESTED_LOOP_ERROR;
   }
+  if (stats)
+  {
+    stats->engine_usec+= optimizer::AnalyzeStats::now() - start;
+    stats->loops++;
+  }
 
   for (JoinTable *tmp=join->join_tab; tmp != join_tab ; tmp++)
   {
@@ -2829,6 +2888,11 @@ enum_nested_loop_state flush_cached_records(Join *join, JoinTable *join_tab, boo
       return NESTED_LOOP_KILLED;
     }
     optimizer::SqlSelect *select= join_tab->select;
+    if (stats)
+    {
+      stats->rows_examined++;
+      start= optimizer::AnalyzeStats::now();
+    }
     if (rc == NESTED_LOOP_OK &&
         (!join_tab->cache.select || !join_tab->cache.select->skip_record()))
     {
@@ -2841,7 +2905,14 @@ enum_nested_loop_state flush_cached_records(Join *join, JoinTable *join_tab, boo
         {
           int res= 0;
 
+          if (stats)
+          {
+            stats->cond_usec+= optimizer::AnalyzeStats::now() - start;
+            stats->rows_produced++;
+          }
           rc= (join_tab->next_select)(join,join_tab+1,0);
+          if (stats)
+            start= optimizer::AnalyzeStats::now();
           if (rc != NESTED_LOOP_OK && rc != NESTED_LOOP_NO_MORE_ROWS)
           {
             join_tab->cache.reset_cache_write();
@@ -2853,7 +2924,15 @@ enum_nested_loop_state flush_cached_records(Join *join, JoinTable *join_tab, boo
         }
       }
     }
-  } while (!(error=info->read_record(info)));
+    if (stats)
+    {
+      stats->cond_usec+= optimizer::AnalyzeStats::now() - start;
+      start= optimizer::AnalyzeStats::now();
+    }
+    error= info->read_record(info);
+    if (stats)
+      stats->engine_usec+= optimizer::AnalyzeStats::now() - start;
+  } while (!error);
 
   if (skip_last)
     join_tab->readCachedRecord();		// Restore current record
@@ -2976,8 +3055,9 @@ enum_nested_loop_state end_write(Join *join, JoinTable *, bool end_of_records)
           return NESTED_LOOP_OK;
         }
 
-        my_error(ER_USE_SQL_BIG_RESULT, MYF(0));
-        return NESTED_LOOP_ERROR;        // Table is_full error
+        if (create_myisam_from_heap(join->session, table, &join->tmp_table_param,
+                                    error, true))
+          return NESTED_LOOP_ERROR;        // Not a table_is_full error
       }
       if (++join->send_records >= join->tmp_table_param.end_write_records && join->do_send_rows)
       {
@@ -3053,8 +3133,14 @@ enum_nested_loop_state end_update(Join *join, JoinTable *, bool end_of_records)
     return NESTED_LOOP_ERROR;
   if ((error=table->cursor->insertRecord(table->getInsertRecord())))
   {
-    my_error(ER_USE_SQL_BIG_RESULT, MYF(0));
-    return NESTED_LOOP_ERROR;        // Table is_full error
+    if (create_myisam_from_heap(join->session, table, &join->tmp_table_param,
+                                error, false))
+      return NESTED_LOOP_ERROR;        // Not a table_is_full error
+    /*
+      The group key of the MyISAM table may be a unique constraint, which
+      can't be searched, so find the groups by their duplicate errors.
+    */
+    join->join_tab[join->tables-1].next_select= end_unique_update;
   }
   join->send_records++;
   return NESTED_LOOP_OK;
@@ -3518,6 +3604,7 @@ static void best_access_path(Join *join,
   table_map best_ref_depends_map= 0;
   double tmp;
   ha_rows rec;
+  const optimizer::CostModel &cost_model= s->table->cursor->getCostModel();
 
   if (s->keyuse)
   {                                            /* Use key if possible */
@@ -3856,9 +3943,9 @@ static void best_access_path(Join *join,
         }
 
       }
-      if (tmp < best_time - records/(double) TIME_FOR_COMPARE)
+      if (tmp < best_time - records/cost_model.timeForCompare())
       {
-        best_time= tmp + records/(double) TIME_FOR_COMPARE;
+        best_time= tmp + records/cost_model.timeForCompare();
         best= tmp;
         best_records= records;
         best_key= start_key;
@@ -3942,7 +4029,7 @@ static void best_access_path(Join *join,
       */
       tmp= record_count *
         (s->quick->read_time +
-         (s->found_records - rnd_records)/(double) TIME_FOR_COMPARE);
+         (s->found_records - rnd_records)/cost_model.timeForCompare());
     }
     else
     {
@@ -3957,7 +4044,7 @@ static void best_access_path(Join *join,
         */
         tmp= record_count *
           (tmp +
-           (s->records - rnd_records)/(double) TIME_FOR_COMPARE);
+           (s->records - rnd_records)/cost_model.timeForCompare());
       }
       else
       {
@@ -3972,18 +4059,18 @@ static void best_access_path(Join *join,
            we read the table (see flush_cached_records for details). Here we
            take into account cost to read and skip these records.
         */
-        tmp+= (s->records - rnd_records)/(double) TIME_FOR_COMPARE;
+        tmp+= (s->records - rnd_records)/cost_model.timeForCompare();
       }
     }
 
     /*
       We estimate the cost of evaluating WHERE clause for found records
-      as record_count * rnd_records / TIME_FOR_COMPARE. This cost plus
+      as record_count * rnd_records * row_evaluate_cost. This cost plus
       tmp give us total cost of using Table SCAN
     */
     if (compare_double(best, DBL_MAX) ||
-        (tmp  + record_count/(double) TIME_FOR_COMPARE*rnd_records <
-         best + record_count/(double) TIME_FOR_COMPARE*records))
+        (tmp  + record_count/cost_model.timeForCompare()*rnd_records <
+         best + record_count/cost_model.timeForCompare()*records))
     {
       /*
         If the table has a range (s->quick is set) make_join_select()
@@ -4043,12 +4130,15 @@ static void optimize_straight_join(Join *join, table_map join_tables)
   uint32_t idx= join->const_tables;
   double    record_count= 1.0;
   double    read_time=    0.0;
+  /* The rows of the plan are evaluated by the engine of its last table */
+  const optimizer::CostModel *cost_model= &optimizer::CostModel::global();
 
   for (JoinTable **pos= join->best_ref + idx ; (s= *pos) ; pos++)
   {
     /* Find the best access method from 's' to the current partial plan */
     best_access_path(join, s, join->session, join_tables, idx,
                      record_count, read_time);
+    cost_model= &s->table->cursor->getCostModel();
     /* compute the cost of the new plan extended with 's' */
     partial_pos= join->getPosFromPartialPlan(idx);
     record_count*= partial_pos.getFanout();
@@ -4057,7 +4147,7 @@ static void optimize_straight_join(Join *join, table_map join_tables)
     ++idx;
   }
 
-  read_time+= record_count / (double) TIME_FOR_COMPARE;
+  read_time+= record_count / cost_model->timeForCompare();
   partial_pos= join->getPosFromPartialPlan(join->const_tables);
   if (join->sort_by_table &&
       partial_pos.hasTableForSorting(join->sort_by_table))
@@ -4381,7 +4471,7 @@ static bool best_extension_by_limited_search(Join *join,
 
       /* Expand only partial plans with lower cost than the best QEP so far */
       if ((current_read_time +
-           current_record_count / (double) TIME_FOR_COMPARE) >= join->best_read)
+           current_record_count / s->table->cursor->getCostModel().timeForCompare()) >= join->best_read)
       {
         restore_prev_nj_state(s);
         continue;
@@ -4433,7 +4523,7 @@ static bool best_extension_by_limited_search(Join *join,
           or the best complete QEP so far, whichever is smaller.
         */
         partial_pos= join->getPosFromPartialPlan(join->const_tables);
-        current_read_time+= current_record_count / (double) TIME_FOR_COMPARE;
+        current_read_time+= current_record_count / s->table->cursor->getCostModel().timeForCompare();
         if (join->sort_by_table &&
             partial_pos.hasTableForSorting(join->sort_by_table))
           /* We have to make a temp table */
@@ -5511,8 +5601,9 @@ static int remove_duplicates(Join *join, Table *entry,List<Item> &fields, Item *
   entry->free_io_cache();				// Safety
   entry->cursor->info(HA_STATUS_VARIABLE);
   int error;
-  if (entry->getShare()->db_type() == heap_engine ||
-      (!entry->getShare()->blob_fields &&
+  /* The hash keys hold only a prefix of blobs, compare them in full instead */
+  if (!entry->getShare()->blob_fields &&
+      (entry->getShare()->db_type() == heap_engine ||
        ((ALIGN_SIZE(reclength) + HASH_OVERHEAD) * entry->cursor->stats.records < join->session->variables.sortbuff_size)))
   {
     error= remove_dup_with_hash_index(join->session, entry, field_count, first_field, reclength, having);
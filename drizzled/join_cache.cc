@@ -35,6 +35,7 @@
 #include <drizzled/internal/my_sys.h>
 #include <drizzled/table.h>
 #include <drizzled/session.h>
+#include <drizzled/session/memory_usage.h>
 #include <drizzled/system_variables.h>
 
 #include <algorithm>
@@ -92,6 +93,7 @@ int join_init_cache(Session *session, JoinTable *tables, uint32_t table_count)
   {
     size= cache->end - cache->buff;
     global_join_buffer.sub(size);
+    session->memory_usage.freed(size);
     free((unsigned char*) cache->buff);
     cache->buff=0;
     return 1;
@@ -107,20 +109,17 @@ int join_init_cache(Session *session, JoinTable *tables, uint32_t table_count)
     Field **f_ptr,*field;
     for (f_ptr= tables[i].table->getFields(), used_fields= tables[i].used_fields; used_fields; f_ptr++)
     {
-      field= *f_ptr;
-      if (field->isReadSet())
+      if ((*f_ptr)->isReadSet())
       {
         used_fields--;
-        length+=field->fill_cache_field(copy);
-        if (copy->blob_field)
-          (*blob_ptr++)=copy;
-        if (field->maybe_null())
+        if ((*f_ptr)->maybe_null())
           null_fields++;
-        copy->get_rowid= NULL;
-        copy++;
       }
     }
-    /* Copy null bits from table */
+    /*
+      Copy null bits from table. They come first, so reading a record can
+      tell which columns are NULL and were not stored.
+    */
     if (null_fields && tables[i].table->getNullFields())
     {						/* must copy null bits */
       copy->str= tables[i].table->null_flags;
@@ -128,6 +127,8 @@ int join_init_cache(Session *session, JoinTable *tables, uint32_t table_count)
       copy->strip=0;
       copy->blob_field=0;
       copy->get_rowid= NULL;
+      copy->length_bytes= 0;
+      copy->null_field= NULL;
       length+=copy->length;
       copy++;
       cache->fields++;
@@ -140,10 +141,25 @@ int join_init_cache(Session *session, JoinTable *tables, uint32_t table_count)
       copy->strip=0;
       copy->blob_field=0;
       copy->get_rowid= NULL;
+      copy->length_bytes= 0;
+      copy->null_field= NULL;
       length+=copy->length;
       copy++;
       cache->fields++;
     }
+    for (f_ptr= tables[i].table->getFields(), used_fields= tables[i].used_fields; used_fields; f_ptr++)
+    {
+      field= *f_ptr;
+      if (field->isReadSet())
+      {
+        used_fields--;
+        length+=field->fill_cache_field(copy);
+        if (copy->blob_field)
+          (*blob_ptr++)=copy;
+        copy->get_rowid= NULL;
+        copy++;
+      }
+    }
     /* SemiJoinDuplicateElimination: Allocate space for rowid if needed */
     if (tables[i].rowid_keep_flags & JoinTable::KEEP_ROWID)
     {
@@ -152,6 +168,8 @@ int join_init_cache(Session *session, JoinTable *tables, uint32_t table_count)
       copy->strip=0;
       copy->blob_field=0;
       copy->get_rowid= NULL;
+      copy->length_bytes= 0;
+      copy->null_field= NULL;
       if (tables[i].rowid_keep_flags & JoinTable::CALL_POSITION)
       {
         /* We will need to call h->position(): */
@@ -172,6 +190,13 @@ int join_init_cache(Session *session, JoinTable *tables, uint32_t table_count)
     my_error(ER_OUT_OF_GLOBAL_JOINMEMORY, MYF(ME_ERROR+ME_WAITTANG));
     return 1;
   }
+  if (not session->memory_usage.allocated(size))
+  {
+    /* Over max_statement_memory, the error is already reported */
+    session->memory_usage.freed(size);
+    global_join_buffer.sub(size);
+    return 1;
+  }
   cache->buff= (unsigned char*) malloc(size);
   cache->end= cache->buff+size;
   cache->reset_cache_write();
@@ -210,6 +235,9 @@ bool JoinCache::store_record_in_cache()
   cache->records++;
   for (copy= cache->field; copy < end_field; copy++)
   {
+    if (copy->null_field && copy->null_field->is_null())
+      continue;
+
     if (copy->blob_field)
     {
       if (last_record)
@@ -241,6 +269,14 @@ bool JoinCache::store_record_in_cache()
         int2store(local_pos, local_length);
         local_pos+= local_length+2;
       }
+      else if (copy->length_bytes)
+      {
+        /* Only the used part of a VARCHAR, after its length */
+        uint32_t local_length= copy->length_bytes +
+          (copy->length_bytes == 1 ? (uint32_t) *copy->str : uint2korr(copy->str));
+        memcpy(local_pos, copy->str, local_length);
+        local_pos+= local_length;
+      }
       else
       {
         memcpy(local_pos, copy->str, copy->length);
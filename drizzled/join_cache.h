@@ -37,6 +37,16 @@ public:
   Field_blob *blob_field;
   bool strip; /* true <=> Strip endspaces ?? */
   Table *get_rowid; /* _ != NULL <=> */
+  /*
+    Length bytes of a VARCHAR, whose used part only is stored, 0 for
+    other columns
+  */
+  uint32_t length_bytes;
+  /*
+    Set for nullable columns. Nothing is stored for them while they are
+    NULL, their null bits are stored and read before them.
+  */
+  Field *null_field;
 
   CacheField():
     str(NULL),
@@ -44,7 +54,9 @@ public:
     blob_length(0),
     blob_field(NULL),
     strip(false),
-    get_rowid(NULL)
+    get_rowid(NULL),
+    length_bytes(0),
+    null_field(NULL)
   {}
 
 };
@@ -52,6 +64,9 @@ public:
 class JoinCache
 {
 public:
+  /* How far ahead of the record being read the buffer is prefetched */
+  static const uint32_t PREFETCH_DISTANCE= 256;
+
   unsigned char *buff;
   unsigned char *pos;    /* Start of free space in the buffer */
   unsigned char *end;
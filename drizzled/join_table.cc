@@ -117,10 +117,15 @@ void JoinTable::readCachedRecord()
 
   last_record= this->cache.record_nr++ == this->cache.ptr_record;
   pos= this->cache.pos;
+  /* The records are read one after the other, load the next ones early */
+  prefetch_read(pos + JoinCache::PREFETCH_DISTANCE);
   for (copy= this->cache.field, end_field= copy+this->cache.fields;
        copy < end_field;
        copy++)
   {
+    if (copy->null_field && copy->null_field->is_null())
+      continue;
+
     if (copy->blob_field)
     {
       if (last_record)
@@ -144,6 +149,13 @@ void JoinTable::readCachedRecord()
         memset(copy->str+length, ' ', copy->length-length);
         pos+= 2 + length;
       }
+      else if (copy->length_bytes)
+      {
+        length= copy->length_bytes +
+          (copy->length_bytes == 1 ? (uint32_t) *pos : uint2korr(pos));
+        memcpy(copy->str, pos, length);
+        pos+= length;
+      }
       else
       {
         memcpy(copy->str,pos,copy->length);
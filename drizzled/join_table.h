@@ -32,6 +32,7 @@
 #include <drizzled/optimizer/range.h>
 #include <drizzled/join_cache.h>
 #include <drizzled/optimizer/key_use.h>
+#include <drizzled/optimizer/analyze_stats.h>
 
 #include <drizzled/records.h>
 
@@ -112,7 +113,8 @@ public:
     insideout_buf(NULL),
     found_match(false),
     rowid_keep_flags(0),
-    embedding_map(0)
+    embedding_map(0),
+    analyze(NULL)
   {}
   Table *table;
   optimizer::KeyUse *keyuse; /**< pointer to first used key */
@@ -228,6 +230,9 @@ public:
   /** Bitmap of nested joins this table is part of */
   std::bitset<64> embedding_map;
 
+  /** Run-time counters for EXPLAIN ANALYZE, NULL otherwise */
+  optimizer::AnalyzeStats *analyze;
+
   void cleanup();
 
   inline bool is_using_loose_index_scan()
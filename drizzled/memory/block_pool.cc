@@ -0,0 +1,252 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#include <drizzled/memory/block_pool.h>
+
+#include <cstdlib>
+#include <pthread.h>
+
+#ifdef HAVE_SCHED_H
+# include <sched.h>
+#endif
+
+#include <boost/thread/mutex.hpp>
+
+namespace drizzled {
+namespace memory {
+
+uint64_t root_block_pool_size= 16 * 1024 * 1024;
+
+const size_t BlockPool::MIN_CLASS_SIZE;
+const size_t BlockPool::MAX_CLASS_SIZE;
+
+namespace {
+
+/*
+  Each power of two between MIN_CLASS_SIZE and MAX_CLASS_SIZE is split in
+  CLASS_STEPS classes, so a block is at most 1/CLASS_STEPS larger than the
+  request it was rounded up from.
+*/
+const size_t CLASS_STEPS= 4;
+const size_t CLASS_COUNT= 10 * CLASS_STEPS + 1; /* MIN_CLASS_SIZE << 10 == MAX_CLASS_SIZE */
+const size_t SHARD_COUNT= 16;
+
+class Shard
+{
+public:
+  Shard() :
+    retained(0),
+    hits(0),
+    misses(0)
+  {
+    for (size_t x= 0; x < CLASS_COUNT; x++)
+      blocks[x]= NULL;
+  }
+
+  boost::mutex lock;
+  internal::UsedMemory *blocks[CLASS_COUNT]; /* Kept blocks, chained by next */
+  uint64_t retained;
+  uint64_t hits;
+  uint64_t misses;
+  char pad[64]; /* Keep the locks of two shards out of the same cache line */
+};
+
+/*
+  Allocated once and never destroyed: Roots are still freed by destructors
+  of static objects that run after the pool would have been destroyed.
+*/
+Shard *shards()
+{
+  static Shard *all= new Shard[SHARD_COUNT];
+  return all;
+}
+
+Shard &current_shard()
+{
+#ifdef HAVE_SCHED_GETCPU
+  int cpu= sched_getcpu();
+  if (cpu >= 0)
+    return shards()[cpu % SHARD_COUNT];
+#endif
+  /* Thread ids are usually aligned, use the bits above the alignment */
+  return shards()[((size_t) pthread_self() >> 12) % SHARD_COUNT];
+}
+
+/* Size of the blocks of class x */
+size_t class_size(size_t x)
+{
+  size_t base= BlockPool::MIN_CLASS_SIZE << (x / CLASS_STEPS);
+  return base + base / CLASS_STEPS * (x % CLASS_STEPS);
+}
+
+/* Smallest class holding size bytes, size must not exceed MAX_CLASS_SIZE */
+size_t class_for(size_t size)
+{
+  if (size <= BlockPool::MIN_CLASS_SIZE)
+    return 0;
+  size_t octave= 0;
+  while ((BlockPool::MIN_CLASS_SIZE << (octave + 1)) < size)
+    octave++;
+  size_t base= BlockPool::MIN_CLASS_SIZE << octave;
+  size_t step= base / CLASS_STEPS;
+  return octave * CLASS_STEPS + (size - base + step - 1) / step;
+}
+
+/* Size class of a block of exactly size bytes, CLASS_COUNT if there is none */
+size_t size_class(size_t size)
+{
+  if (size > BlockPool::MAX_CLASS_SIZE)
+    return CLASS_COUNT;
+  size_t x= class_for(size);
+  return class_size(x) == size ? x : CLASS_COUNT;
+}
+
+/* Free blocks of shard, largest first, until it keeps at most limit bytes */
+void trim_shard(Shard &shard, uint64_t limit)
+{
+  for (size_t x= CLASS_COUNT; x-- > 0 && shard.retained > limit;)
+  {
+    while (shard.retained > limit)
+    {
+      internal::UsedMemory *block= shard.blocks[x];
+      if (not block)
+        break;
+      shard.blocks[x]= block->next;
+      shard.retained-= block->size;
+      std::free(block);
+    }
+  }
+}
+
+} /* namespace */
+
+size_t BlockPool::block_size(size_t size)
+{
+  if (size > MAX_CLASS_SIZE)
+    return size;
+  return class_size(class_for(size));
+}
+
+internal::UsedMemory *BlockPool::acquire(size_t size)
+{
+  size_t x= size_class(size);
+  if (x < CLASS_COUNT && root_block_pool_size)
+  {
+    Shard &shard= current_shard();
+    boost::mutex::scoped_lock scopedLock(shard.lock);
+    internal::UsedMemory *block= shard.blocks[x];
+    if (block)
+    {
+      shard.blocks[x]= block->next;
+      shard.retained-= size;
+      shard.hits++;
+      return block;
+    }
+    shard.misses++;
+  }
+
+  internal::UsedMemory *block= static_cast<internal::UsedMemory *>(malloc(size));
+  if (block)
+    block->size= size;
+  return block;
+}
+
+void BlockPool::release(internal::UsedMemory *block)
+{
+  size_t x= size_class(block->size);
+  if (x < CLASS_COUNT)
+  {
+    Shard &shard= current_shard();
+    boost::mutex::scoped_lock scopedLock(shard.lock);
+    if (shard.retained + block->size <= root_block_pool_size / SHARD_COUNT)
+    {
+      block->next= shard.blocks[x];
+      shard.blocks[x]= block;
+      shard.retained+= block->size;
+      return;
+    }
+  }
+  std::free(block);
+}
+
+void BlockPool::trim()
+{
+  for (size_t y= 0; y < SHARD_COUNT; y++)
+  {
+    Shard &shard= shards()[y];
+    boost::mutex::scoped_lock scopedLock(shard.lock);
+    trim_shard(shard, root_block_pool_size / SHARD_COUNT);
+  }
+}
+
+void BlockPool::clear()
+{
+  for (size_t y= 0; y < SHARD_COUNT; y++)
+  {
+    Shard &shard= shards()[y];
+    boost::mutex::scoped_lock scopedLock(shard.lock);
+    for (size_t x= 0; x < CLASS_COUNT; x++)
+    {
+      while (internal::UsedMemory *block= shard.blocks[x])
+      {
+        shard.blocks[x]= block->next;
+        std::free(block);
+      }
+    }
+    shard.retained= 0;
+  }
+}
+
+uint64_t BlockPool::hits()
+{
+  uint64_t count= 0;
+  for (size_t y= 0; y < SHARD_COUNT; y++)
+  {
+    boost::mutex::scoped_lock scopedLock(shards()[y].lock);
+    count+= shards()[y].hits;
+  }
+  return count;
+}
+
+uint64_t BlockPool::misses()
+{
+  uint64_t count= 0;
+  for (size_t y= 0; y < SHARD_COUNT; y++)
+  {
+    boost::mutex::scoped_lock scopedLock(shards()[y].lock);
+    count+= shards()[y].misses;
+  }
+  return count;
+}
+
+uint64_t BlockPool::retained_bytes()
+{
+  uint64_t count= 0;
+  for (size_t y= 0; y < SHARD_COUNT; y++)
+  {
+    boost::mutex::scoped_lock scopedLock(shards()[y].lock);
+    count+= shards()[y].retained;
+  }
+  return count;
+}
+
+} /* namespace memory */
+} /* namespace drizzled */
@@ -0,0 +1,89 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/**
+ * @file
+ * @brief Process wide cache of memory::Root blocks
+ */
+
+#pragma once
+
+#include <drizzled/memory/root.h>
+#include <drizzled/visibility.h>
+
+namespace drizzled {
+namespace memory {
+
+/**
+ * Upper limit of the bytes kept in BlockPool, 0 turns the pool off.
+ * Set by the root-block-pool-size option.
+ */
+extern DRIZZLED_API uint64_t root_block_pool_size;
+
+/**
+ * @brief
+ * Blocks freed by Root::free_root() kept for the next Root::alloc()
+ *
+ * @details
+ * Block sizes between MIN_CLASS_SIZE and MAX_CLASS_SIZE are rounded up to
+ * one of four size classes per power of two, so a freed block fits most
+ * requests of its size class and wastes at most a quarter of its size.
+ * Larger blocks go straight back to the system allocator.
+ *
+ * The pool is split in shards, picked by the CPU the thread runs on, so
+ * sessions running at the same time seldom wait for each other. Each shard
+ * keeps at most its part of root_block_pool_size.
+ */
+class DRIZZLED_API BlockPool
+{
+public:
+  static const size_t MIN_CLASS_SIZE= 1024;
+  static const size_t MAX_CLASS_SIZE= 1024 * 1024;
+
+  /**
+   * Size of the block to allocate for a request of size bytes, the size
+   * class when there is one.
+   */
+  static size_t block_size(size_t size);
+
+  /**
+   * Get a block of size bytes, from the pool if one is kept for this size.
+   * The returned block has its size member set.
+   */
+  static internal::UsedMemory *acquire(size_t size);
+
+  /** Keep block for reuse, or free it if it has no size class or the pool is full */
+  static void release(internal::UsedMemory *block);
+
+  /** Free kept blocks until the pool is within root_block_pool_size */
+  static void trim();
+
+  /** Free all kept blocks */
+  static void clear();
+
+  /** Requests served from the pool */
+  static uint64_t hits();
+  /** Requests of a size class the pool had no block for */
+  static uint64_t misses();
+  /** Bytes currently kept */
+  static uint64_t retained_bytes();
+};
+
+} /* namespace memory */
+} /* namespace drizzled */
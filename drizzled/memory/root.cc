@@ -22,6 +22,7 @@
 
 #include <drizzled/definitions.h>
 #include <drizzled/memory/root.h>
+#include <drizzled/memory/block_pool.h>
 #include <drizzled/internal/my_sys.h>
 #include <drizzled/internal/m_string.h>
 #include <drizzled/sql_string.h>
@@ -61,6 +62,34 @@ void Root::init(size_t block_size_arg)
   block_size= block_size_arg - ROOT_MIN_BLOCK_SIZE;
   block_num= 4;			/* We shift this with >>2 */
   first_block_usage= 0;
+  tracker= 0;
+}
+
+/**
+ * @brief
+ * Get a block from the BlockPool, telling the tracker about it
+ */
+internal::UsedMemory* Root::get_block(size_t size)
+{
+  internal::UsedMemory* block= BlockPool::acquire(size);
+  /*
+    Callers of alloc() cannot handle a failure, so the block is used even
+    when it takes the tracker over its limit. The tracker reports that.
+  */
+  if (block && tracker)
+    (void) tracker->allocated(size);
+  return block;
+}
+
+/**
+ * @brief
+ * Give a block back to the BlockPool, telling the tracker about it
+ */
+void Root::put_block(internal::UsedMemory* block)
+{
+  if (tracker)
+    tracker->freed(block->size);
+  BlockPool::release(block);
 }
 
 /**
@@ -104,14 +133,13 @@ void Root::reset_defaults(size_t block_size_arg, size_t pre_alloc_size)
         {
           /* remove block from the list and free it */
           *prev= mem->next;
-          std::free(mem);
+          put_block(mem);
         }
         else
           prev= &mem->next;
       }
       /* Allocate new prealloc block and add it to the end of free list */
-      mem= static_cast<internal::UsedMemory *>(malloc(size));
-      mem->size= size;
+      mem= get_block(size);
       mem->left= pre_alloc_size;
       mem->next= *prev;
       *prev= pre_alloc= mem;
@@ -126,7 +154,7 @@ void Root::reset_defaults(size_t block_size_arg, size_t pre_alloc_size)
 /**
  * @brief 
  * Allocate a chunk of memory from the Root structure provided, 
- * obtaining more memory from the heap if necessary
+ * obtaining more memory from the BlockPool or the heap if necessary
  *
  * @pre
  * mem_root must have been initialised via init()
@@ -163,12 +191,11 @@ unsigned char* Root::alloc(size_t length)
   {						/* Time to alloc new block */
     size_t tmp_block_size= this->block_size * (this->block_num >> 2);
     size_t get_size= length+ALIGN_SIZE(sizeof(internal::UsedMemory));
-    get_size= max(get_size, tmp_block_size);
+    get_size= BlockPool::block_size(max(get_size, tmp_block_size));
 
-    next = static_cast<internal::UsedMemory *>(malloc(get_size));
+    next= get_block(get_size);
     this->block_num++;
     next->next= *prev;
-    next->size= get_size;
     next->left= get_size-ALIGN_SIZE(sizeof(internal::UsedMemory));
     *prev=next;
   }
@@ -279,6 +306,9 @@ void Root::mark_blocks_free()
  * init() or with a zero:ed block.
  * It's also safe to call this multiple times with the same mem_root.
  *
+ * Freed blocks are handed to the BlockPool, which keeps them for the
+ * next Root that needs a block of the same size class.
+ *
  * @param   root     Memory root
  * @param   MyFlags  Flags for what should be freed:
  *   @li   MARK_BLOCKS_FREED	Don't free blocks, just mark them free
@@ -300,14 +330,14 @@ void Root::free_root(myf MyFlags)
     internal::UsedMemory* old =next; 
     next= next->next;
     if (old != this->pre_alloc)
-      std::free(old);
+      put_block(old);
   }
   for (internal::UsedMemory* next=this->free; next;)
   {
     internal::UsedMemory* old= next; 
     next= next->next;
     if (old != this->pre_alloc)
-      std::free(old);
+      put_block(old);
   }
   this->used=this->free=0;
   if (this->pre_alloc)
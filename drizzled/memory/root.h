@@ -52,6 +52,29 @@ namespace internal
   };
 }
 
+/**
+ * @brief
+ * Told about the blocks a Root gets and gives back
+ *
+ * @details
+ * Lets the owner of a Root account for the memory it uses, see
+ * session::MemoryUsage.
+ */
+class DRIZZLED_API Tracker
+{
+public:
+  virtual ~Tracker() {}
+
+  /**
+   * Count size more bytes as used.
+   *
+   * @return false if that takes the owner over its limit. The bytes are
+   * counted anyway, a caller that then gives the memory up calls freed().
+   */
+  virtual bool allocated(size_t size)= 0;
+  virtual void freed(size_t size)= 0;
+};
+
 static const size_t ROOT_MIN_BLOCK_SIZE= (MALLOC_OVERHEAD + sizeof(internal::UsedMemory) + 8);
 
 class DRIZZLED_API Root
@@ -64,7 +87,8 @@ public:
     min_malloc(0),
     block_size(0),
     block_num(0),
-    first_block_usage(0)
+    first_block_usage(0),
+    tracker(0)
   { }
 
   Root(size_t block_size_arg)
@@ -74,6 +98,7 @@ public:
     block_size= block_size_arg - memory::ROOT_MIN_BLOCK_SIZE;
     block_num= 4;			/* We shift this with >>2 */
     first_block_usage= 0;
+    tracker= 0;
   }
 
   /**
@@ -105,6 +130,11 @@ public:
    */
   unsigned int first_block_usage;
 
+  /**
+   * Told about every block allocated and freed, if set
+   */
+  Tracker *tracker;
+
   void reset_defaults(size_t block_size, size_t prealloc_size);
   unsigned char* alloc(size_t Size);
   void mark_blocks_free();
@@ -128,6 +158,10 @@ public:
     memset(ptr, 0, size);
     return ptr;
   }
+
+private:
+  internal::UsedMemory* get_block(size_t size);
+  void put_block(internal::UsedMemory*);
 };
 
 } /* namespace memory */
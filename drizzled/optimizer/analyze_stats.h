@@ -0,0 +1,79 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+#include <sys/time.h>
+
+namespace drizzled {
+namespace optimizer {
+
+/**
+  Run-time counters of one JoinTable, filled in while EXPLAIN ANALYZE
+  executes the statement.
+
+  JoinTable::analyze is NULL for every other statement, so the nested
+  loop only pays for a pointer test when nobody is looking.
+*/
+class AnalyzeStats
+{
+public:
+  AnalyzeStats() :
+    loops(0),
+    rows_examined(0),
+    rows_produced(0),
+    engine_usec(0),
+    cond_usec(0),
+    sort_rows(0),
+    sort_merge_passes(0),
+    tmp_rows(0),
+    tmp_bytes(0),
+    tmp_on_disk(false)
+  {}
+
+  /** Monotonic clock, in microseconds */
+  static uint64_t now()
+  {
+#ifdef HAVE_CLOCK_GETTIME
+    struct timespec tp;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return (uint64_t) tp.tv_sec * 1000000 + (uint64_t) tp.tv_nsec / 1000;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t) tv.tv_sec * 1000000 + (uint64_t) tv.tv_usec;
+#endif
+  }
+
+  uint64_t loops;             /**< Times the table was scanned or looked up */
+  uint64_t rows_examined;     /**< Rows returned by the storage engine */
+  uint64_t rows_produced;     /**< Rows passed on to the next table */
+  uint64_t engine_usec;       /**< Time spent reading from the engine */
+  uint64_t cond_usec;         /**< Time spent in the attached condition */
+  uint64_t sort_rows;         /**< Rows sorted by filesort for this table */
+  uint64_t sort_merge_passes; /**< Filesort merge passes (runs on disk) */
+  uint64_t tmp_rows;          /**< Rows written to the temporary table */
+  uint64_t tmp_bytes;         /**< Data size of the temporary table */
+  bool tmp_on_disk;           /**< Temporary table was converted to disk */
+};
+
+} /* namespace optimizer */
+} /* namespace drizzled */
@@ -0,0 +1,178 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#include <drizzled/optimizer/cost_model.h>
+#include <drizzled/errmsg_print.h>
+#include <drizzled/gettext.h>
+
+#include <boost/algorithm/string.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+
+using namespace std;
+
+namespace drizzled {
+namespace optimizer {
+
+/*
+  Number of blocks an average random seek skips: an average seek costs
+  disk_seek_base_cost + disk_seek_prop_cost * BLOCKS_IN_AVG_SEEK = 1.0
+*/
+static const double BLOCKS_IN_AVG_SEEK= 128;
+
+static CostModel global_model;
+
+typedef map<string, CostModel> EngineModels;
+static EngineModels engine_models;
+
+/** One line of a cost model file */
+struct CostModelEntry
+{
+  string engine;
+  string name;
+  double value;
+};
+
+CostModel::CostModel() :
+  io_block_read_cost(1.0),
+  io_seek_cost(1.0),
+  disk_seek_base_cost(0.9),
+  disk_seek_prop_cost(0.1 / BLOCKS_IN_AVG_SEEK),
+  row_evaluate_cost(0.2),
+  key_compare_cost(0.1),
+  memory_row_read_cost(0.05)
+{}
+
+bool CostModel::set(const string &name, double value)
+{
+  if (value <= 0.0)
+    return true;
+
+  if (name == "io_block_read_cost")
+    io_block_read_cost= value;
+  else if (name == "io_seek_cost")
+    io_seek_cost= value;
+  else if (name == "disk_seek_base_cost")
+    disk_seek_base_cost= value;
+  else if (name == "disk_seek_prop_cost")
+    disk_seek_prop_cost= value;
+  else if (name == "row_evaluate_cost")
+    row_evaluate_cost= value;
+  else if (name == "key_compare_cost")
+    key_compare_cost= value;
+  else if (name == "memory_row_read_cost")
+    memory_row_read_cost= value;
+  else
+    return true;
+
+  return false;
+}
+
+const CostModel &CostModel::global()
+{
+  return global_model;
+}
+
+const CostModel &CostModel::forEngine(const string &engine_name)
+{
+  if (engine_models.empty())
+    return global_model;
+
+  EngineModels::const_iterator it= engine_models.find(boost::to_lower_copy(engine_name));
+  return it == engine_models.end() ? global_model : it->second;
+}
+
+bool CostModel::load(const string &path)
+{
+  ifstream file(path.c_str());
+  if (not file)
+  {
+    errmsg_printf(error::ERROR, _("Could not open optimizer cost model file '%s'"),
+                  path.c_str());
+    return true;
+  }
+
+  vector<CostModelEntry> entries;
+
+  string line;
+  for (uint32_t line_number= 1; getline(file, line); line_number++)
+  {
+    string::size_type comment= line.find('#');
+    if (comment != string::npos)
+      line.erase(comment);
+    boost::trim(line);
+    if (line.empty())
+      continue;
+
+    string::size_type equal= line.find('=');
+    CostModelEntry entry;
+    char *end= NULL;
+    if (equal != string::npos)
+    {
+      string value(boost::trim_copy(line.substr(equal + 1)));
+      entry.value= strtod(value.c_str(), &end);
+      if (value.empty() || *end)
+        end= NULL;
+      entry.name= boost::to_lower_copy(boost::trim_copy(line.substr(0, equal)));
+      string::size_type dot= entry.name.rfind('.');
+      if (dot != string::npos)
+      {
+        entry.engine= entry.name.substr(0, dot);
+        entry.name.erase(0, dot + 1);
+      }
+    }
+
+    if (not end || CostModel().set(entry.name, entry.value))
+    {
+      errmsg_printf(error::ERROR, _("Invalid line %u in optimizer cost model file '%s'"),
+                    line_number, path.c_str());
+      return true;
+    }
+    entries.push_back(entry);
+  }
+
+  /* Engine overrides start from the server wide values, wherever they are */
+  CostModel model;
+  EngineModels engines;
+  for (vector<CostModelEntry>::iterator it= entries.begin(); it != entries.end(); ++it)
+  {
+    if (it->engine.empty())
+      model.set(it->name, it->value);
+  }
+  for (vector<CostModelEntry>::iterator it= entries.begin(); it != entries.end(); ++it)
+  {
+    if (it->engine.empty())
+      continue;
+    if (engines.find(it->engine) == engines.end())
+      engines[it->engine]= model;
+    engines[it->engine].set(it->name, it->value);
+  }
+
+  global_model= model;
+  engine_models.swap(engines);
+
+  return false;
+}
+
+} /* namespace optimizer */
+} /* namespace drizzled */
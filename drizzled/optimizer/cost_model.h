@@ -0,0 +1,152 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+
+#include <drizzled/visibility.h>
+
+namespace drizzled {
+namespace optimizer {
+
+/**
+  The constants the optimizer prices plans with.
+
+  The unit of every cost is the sequential read of one IO_SIZE block.
+  The defaults are the historical hard-coded values; they can be
+  replaced, server wide or for one storage engine, by a cost model
+  file given with --optimizer-cost-model. Such a file has one
+  "name = value" or "engine.name = value" line per constant, and is
+  what drizzle_cost_calibrate writes after measuring the local
+  machine.
+
+  The file is read once at startup, so the model is read-only while
+  queries run.
+*/
+class DRIZZLED_API CostModel
+{
+public:
+  CostModel();
+
+  /** Sequential read of one block, the unit used by scan_time() */
+  double getIOBlockReadCost() const
+  {
+    return io_block_read_cost;
+  }
+
+  /** Random read of one row or index block, the unit of read_time() */
+  double getIOSeekCost() const
+  {
+    return io_seek_cost;
+  }
+
+  /**
+    For sequential disk seeks the cost formula is:
+      disk_seek_base_cost + disk_seek_prop_cost * #blocks_to_skip
+  */
+  double getDiskSeekBaseCost() const
+  {
+    return disk_seek_base_cost;
+  }
+
+  double getDiskSeekPropCost() const
+  {
+    return disk_seek_prop_cost;
+  }
+
+  /** Evaluating the WHERE clause against one row */
+  double getRowEvaluateCost() const
+  {
+    return row_evaluate_cost;
+  }
+
+  /** Comparing two keys or rowids */
+  double getKeyCompareCost() const
+  {
+    return key_compare_cost;
+  }
+
+  /** Reading one row of an in-memory (MEMORY) table */
+  double getMemoryRowReadCost() const
+  {
+    return memory_row_read_cost;
+  }
+
+  /*
+    The optimizer divides row counts by "how many of these make one
+    read" rather than multiplying by a cost, so plans computed with the
+    default model stay bit-identical to the ones computed before the
+    constants were tunable. 1/0.2, 1/0.1 and 1/0.05 are exact.
+  */
+
+  /** Number of row evaluations that cost as much as one read */
+  double timeForCompare() const
+  {
+    return 1.0 / row_evaluate_cost;
+  }
+
+  /** Number of rowid comparisons that cost as much as one read */
+  double timeForCompareRowid() const
+  {
+    return 1.0 / key_compare_cost;
+  }
+
+  /** Number of in-memory rows that cost as much as one read */
+  double memoryRowsPerRead() const
+  {
+    return 1.0 / memory_row_read_cost;
+  }
+
+  /**
+    Set one constant by its name in a cost model file.
+
+    @retval true   unknown name or value not greater than zero
+    @retval false  success
+  */
+  bool set(const std::string &name, double value);
+
+  /** The server wide model */
+  static const CostModel &global();
+
+  /** The model of a storage engine, the server wide one if not overridden */
+  static const CostModel &forEngine(const std::string &engine_name);
+
+  /**
+    Load a cost model file, see the class description.
+
+    @retval true   the file could not be read or has a bad line; the
+                   error has been reported and nothing was changed
+    @retval false  success
+  */
+  static bool load(const std::string &path);
+
+private:
+  double io_block_read_cost;
+  double io_seek_cost;
+  double disk_seek_base_cost;
+  double disk_seek_prop_cost;
+  double row_evaluate_cost;
+  double key_compare_cost;
+  double memory_row_read_cost;
+};
+
+} /* namespace optimizer */
+} /* namespace drizzled */
@@ -31,12 +31,14 @@
 #include <drizzled/join.h>
 #include <drizzled/internal/m_string.h>
 #include <drizzled/select_result.h>
+#include <drizzled/select_send.h>
 #include <drizzled/sql_lex.h>
 
 #include <cstdio>
 #include <string>
 #include <sstream>
 #include <bitset>
+#include <vector>
 
 using namespace std;
 
@@ -74,17 +76,90 @@ static const string select_type_str[]=
   "UNION RESULT"
 };
 
+/**
+  Set the EXPLAIN select_type of a select from its place in its unit.
+*/
+static void set_select_type(Session *session, Select_Lex *sl)
+{
+  Select_Lex *first= sl->master_unit()->first_select();
+
+  if (&session->lex().select_lex == sl)
+  {
+    if (sl->first_inner_unit() || sl->next_select())
+    {
+      sl->type= optimizer::ST_PRIMARY;
+    }
+    else
+    {
+      sl->type= optimizer::ST_SIMPLE;
+    }
+  }
+  else
+  {
+    if (sl == first)
+    {
+      if (sl->linkage == DERIVED_TABLE_TYPE)
+      {
+        sl->type= optimizer::ST_DERIVED;
+      }
+      else
+      {
+        if (sl->uncacheable.test(UNCACHEABLE_DEPENDENT))
+        {
+          sl->type= optimizer::ST_DEPENDENT_SUBQUERY;
+        }
+        else
+        {
+          if (sl->uncacheable.any())
+          {
+            sl->type= optimizer::ST_UNCACHEABLE_SUBQUERY;
+          }
+          else
+          {
+            sl->type= optimizer::ST_SUBQUERY;
+          }
+        }
+      }
+    }
+    else
+    {
+      if (sl->uncacheable.test(UNCACHEABLE_DEPENDENT))
+      {
+        sl->type= optimizer::ST_DEPENDENT_UNION;
+      }
+      else
+      {
+        if (sl->uncacheable.any())
+        {
+          sl->type= optimizer::ST_UNCACHEABLE_UNION;
+        }
+        else
+        {
+          sl->type= optimizer::ST_UNION;
+        }
+      }
+    }
+  }
+}
+
 void optimizer::ExplainPlan::printPlan()
 {
   List<Item> item_list;
   Session *session= join->session;
-  select_result *result= join->result;
+  bool analyze= session->lex().explain_analyze != NULL;
   Item *item_null= new Item_null();
   const charset_info_st * const cs= system_charset_info;
   int quick_type;
-  /* Don't log this into the slow query log */
-  session->server_status&= ~(SERVER_QUERY_NO_INDEX_USED | SERVER_QUERY_NO_GOOD_INDEX_USED);
-  join->unit->offset_limit_cnt= 0;
+  /*
+    EXPLAIN ANALYZE describes a join that is about to run: leave its
+    state alone.
+  */
+  if (not analyze)
+  {
+    /* Don't log this into the slow query log */
+    session->server_status&= ~(SERVER_QUERY_NO_INDEX_USED | SERVER_QUERY_NO_GOOD_INDEX_USED);
+    join->unit->offset_limit_cnt= 0;
+  }
 
   /*
    NOTE: the number/types of items pushed into item_list must be in sync with
@@ -101,7 +176,7 @@ void optimizer::ExplainPlan::printPlan()
       item_list.push_back(item_null);
 
     item_list.push_back(new Item_string(str_ref(message), cs));
-    if (result->send_data(item_list))
+    if (sendRow(item_list, NULL))
       join->error= 1;
   }
   else if (join->select_lex == join->unit->fake_select_lex)
@@ -163,7 +238,7 @@ void optimizer::ExplainPlan::printPlan()
     else
       item_list.push_back(new Item_string(str_ref(""), cs));
 
-    if (result->send_data(item_list))
+    if (sendRow(item_list, NULL))
       join->error= 1;
   }
   else
@@ -180,21 +255,23 @@ void optimizer::ExplainPlan::printPlan()
       string tmp2;
       string tmp3;
 
+      access_method type= tab->type;
+
       quick_type= -1;
       item_list.clear();
       /* id */
       item_list.push_back(new Item_uint((uint32_t)join->select_lex->select_number));
       /* select_type */
       item_list.push_back(new Item_string(select_type_str[join->select_lex->type], cs));
-      if (tab->type == AM_ALL && tab->select && tab->select->quick)
+      if (type == AM_ALL && tab->select && tab->select->quick)
       {
         quick_type= tab->select->quick->get_type();
         if ((quick_type == optimizer::QuickSelectInterface::QS_TYPE_INDEX_MERGE) ||
             (quick_type == optimizer::QuickSelectInterface::QS_TYPE_ROR_INTERSECT) ||
             (quick_type == optimizer::QuickSelectInterface::QS_TYPE_ROR_UNION))
-          tab->type = AM_INDEX_MERGE;
+          type= AM_INDEX_MERGE;
         else
-          tab->type = AM_RANGE;
+          type= AM_RANGE;
       }
       /* table */
       if (table->derived_select_number)
@@ -212,7 +289,7 @@ void optimizer::ExplainPlan::printPlan()
         item_list.push_back(new Item_string(str_ref(real_table->alias), cs));
       }
       /* "type" column */
-      item_list.push_back(new Item_string(access_method_str[tab->type], cs));
+      item_list.push_back(new Item_string(access_method_str[type], cs));
       /* Build "possible_keys" value and add it to item_list */
       if (tab->keys.any())
       {
@@ -248,7 +325,7 @@ void optimizer::ExplainPlan::printPlan()
         }
         item_list.push_back(new Item_string(tmp2, cs));
       }
-      else if (tab->type == AM_NEXT)
+      else if (type == AM_NEXT)
       {
         KeyInfo *key_info=table->key_info+ tab->index;
         item_list.push_back(new Item_string(str_ref(key_info->name),cs));
@@ -276,7 +353,7 @@ void optimizer::ExplainPlan::printPlan()
       {
         examined_rows= tab->select->quick->records;
       }
-      else if (tab->type == AM_NEXT || tab->type == AM_ALL)
+      else if (type == AM_NEXT || type == AM_ALL)
       {
         examined_rows= tab->limit ? tab->limit : tab->table->cursor->records();
       }
@@ -303,7 +380,7 @@ void optimizer::ExplainPlan::printPlan()
 
       /* Build "Extra" field and add it to item_list. */
       bool key_read= table->key_read;
-      if ((tab->type == AM_NEXT || tab->type == AM_CONST) &&
+      if ((type == AM_NEXT || type == AM_CONST) &&
           table->covering_keys.test(tab->index))
         key_read= 1;
       if (quick_type == optimizer::QuickSelectInterface::QS_TYPE_ROR_INTERSECT &&
@@ -328,7 +405,8 @@ void optimizer::ExplainPlan::printPlan()
       {
         if (quick_type == optimizer::QuickSelectInterface::QS_TYPE_ROR_UNION ||
             quick_type == optimizer::QuickSelectInterface::QS_TYPE_ROR_INTERSECT ||
-            quick_type == optimizer::QuickSelectInterface::QS_TYPE_INDEX_MERGE)
+            quick_type == optimizer::QuickSelectInterface::QS_TYPE_INDEX_MERGE ||
+            quick_type == optimizer::QuickSelectInterface::QS_TYPE_SKIP_SCAN)
         {
           extra.append("; Using ");
           tab->select->quick->add_info_string(&extra);
@@ -410,20 +488,35 @@ void optimizer::ExplainPlan::printPlan()
       }
       // For next iteration
       used_tables|=table->map;
-      if (result->send_data(item_list))
+      if (sendRow(item_list, tab->analyze))
         join->error= 1;
     }
   }
+  /* EXPLAIN ANALYZE attaches the inner units as they are executed */
+  if (analyze)
+    return;
+
   for (Select_Lex_Unit *unit= join->select_lex->first_inner_unit();
       unit;
       unit= unit->next_unit())
   {
-    if (explainUnion(session, unit, result))
+    if (explainUnion(session, unit, join->result))
       return;
   }
   return;
 }
 
+bool optimizer::ExplainPlan::sendRow(List<Item> &item_list,
+                                     optimizer::AnalyzeStats *stats)
+{
+  if (optimizer::ExplainAnalyze *analyze= join->session->lex().explain_analyze)
+  {
+    analyze->addRow(join->select_lex, item_list, stats);
+    return false;
+  }
+  return join->result->send_data(item_list);
+}
+
 bool optimizer::ExplainPlan::explainUnion(Session *session,
                                           Select_Lex_Unit *unit,
                                           select_result *result)
@@ -437,63 +530,7 @@ bool optimizer::ExplainPlan::explainUnion(Session *session,
   {
     // drop UNCACHEABLE_EXPLAIN, because it is for internal usage only
     sl->uncacheable.reset(UNCACHEABLE_EXPLAIN);
-    if (&session->lex().select_lex == sl)
-    {
-      if (sl->first_inner_unit() || sl->next_select())
-      {
-        sl->type= optimizer::ST_PRIMARY;
-      }
-      else
-      {
-        sl->type= optimizer::ST_SIMPLE;
-      }
-    }
-    else
-    {
-      if (sl == first)
-      {
-        if (sl->linkage == DERIVED_TABLE_TYPE)
-        {
-          sl->type= optimizer::ST_DERIVED;
-        }
-        else
-        {
-          if (sl->uncacheable.test(UNCACHEABLE_DEPENDENT))
-          {
-            sl->type= optimizer::ST_DEPENDENT_SUBQUERY;
-          }
-          else
-          {
-            if (sl->uncacheable.any())
-            {
-              sl->type= optimizer::ST_UNCACHEABLE_SUBQUERY;
-            }
-            else
-            {
-              sl->type= optimizer::ST_SUBQUERY;
-            }
-          }
-        }
-      }
-      else
-      {
-        if (sl->uncacheable.test(UNCACHEABLE_DEPENDENT))
-        {
-          sl->type= optimizer::ST_DEPENDENT_UNION;
-        }
-        else
-        {
-          if (sl->uncacheable.any())
-          {
-            sl->type= optimizer::ST_UNCACHEABLE_UNION;
-          }
-          else
-          {
-            sl->type= optimizer::ST_UNION;
-          }
-        }
-      }
-    }
+    set_select_type(session, sl);
     sl->options|= SELECT_DESCRIBE;
   }
 
@@ -530,4 +567,250 @@ bool optimizer::ExplainPlan::explainUnion(Session *session,
   return (res || session->is_error());
 }
 
+/**
+  Swallows the rows of the statement EXPLAIN ANALYZE executes, after
+  evaluating them so the select list is paid for as usual.
+*/
+class select_analyze_sink : public select_result
+{
+public:
+  void send_fields(List<Item>&)
+  {}
+
+  bool send_data(List<Item>& items)
+  {
+    if (unit->offset_limit_cnt)
+    {						// using limit offset,count
+      unit->offset_limit_cnt--;
+      return false;
+    }
+
+    List<Item>::iterator li(items.begin());
+    char buff[MAX_FIELD_WIDTH];
+    String buffer(buff, sizeof(buff), &my_charset_bin);
+
+    while (Item* item= li++)
+      item->val_str(&buffer);
+
+    return session->is_error();
+  }
+
+  bool send_eof()
+  {
+    return false;
+  }
+};
+
+optimizer::ExplainAnalyze::ExplainAnalyze(Session &in_session) :
+  session(in_session),
+  describe(0)
+{}
+
+optimizer::ExplainAnalyze::~ExplainAnalyze()
+{
+  stop();
+}
+
+void optimizer::ExplainAnalyze::start()
+{
+  LEX &lex= session.lex();
+
+  /*
+    The statement runs as a plain SELECT; the describe flags are only
+    needed again to send the EXPLAIN columns.
+  */
+  describe= lex.describe;
+  lex.describe= 0;
+  lex.select_lex.options&= ~SELECT_DESCRIBE;
+  lex.explain_analyze= this;
+}
+
+void optimizer::ExplainAnalyze::stop()
+{
+  LEX &lex= session.lex();
+
+  if (lex.explain_analyze != this)
+    return;
+
+  lex.explain_analyze= NULL;
+  lex.describe= describe;
+}
+
+void optimizer::ExplainAnalyze::attach(Join *join,
+                                       bool need_tmp_table,
+                                       bool need_order,
+                                       const char *message)
+{
+  Select_Lex *select_lex= join->select_lex;
+
+  /* Dependent subqueries run once per outer row, describe them once */
+  if (not attached.insert(select_lex).second)
+    return;
+
+  if (select_lex == select_lex->master_unit()->fake_select_lex)
+    select_lex->type= optimizer::ST_UNION_RESULT;
+  else
+    set_select_type(&session, select_lex);
+
+  if (not message)
+  {
+    for (uint32_t i= join->const_tables; i < join->tables; i++)
+      join->join_tab[i].analyze= new (session.mem) optimizer::AnalyzeStats;
+  }
+
+  optimizer::ExplainPlan planner(join,
+                                 need_tmp_table,
+                                 need_order,
+                                 join->select_distinct,
+                                 message);
+  planner.printPlan();
+}
+
+void optimizer::ExplainAnalyze::addRow(Select_Lex *select_lex,
+                                       List<Item> &item_list,
+                                       optimizer::AnalyzeStats *stats)
+{
+  rows.push_back(Row());
+  Row &row= rows.back();
+  row.select_lex= select_lex;
+  row.stats= stats;
+
+  List<Item>::iterator it(item_list.begin());
+  while (Item *item= it++)
+  {
+    /*
+      The row is sent after the join is gone, and printPlan() builds
+      its strings in local buffers.
+    */
+    if (item->type() == Item::STRING_ITEM)
+    {
+      String *str= item->val_str(NULL);
+      item= new Item_string(session.mem.strdup(str->ptr(), str->length()),
+                            str->length(),
+                            system_charset_info);
+    }
+    row.items.push_back(item);
+  }
+}
+
+bool optimizer::ExplainAnalyze::execute()
+{
+  LEX &lex= session.lex();
+  select_analyze_sink sink;
+
+  bool res= handle_select(&session, &lex, &sink, 0);
+  stop();
+  if (res || session.is_error())
+    return true;
+
+  /*
+    We always use select_send for EXPLAIN ANALYZE, for the same reason
+    EXPLAIN does: the statement's own output is irrelevant here.
+  */
+  select_send *result= new select_send();
+  List<Item> no_fields;
+  result->prepare(no_fields, &lex.unit);
+  lex.unit.offset_limit_cnt= 0;
+  session.send_explain_fields(result);
+
+  res= sendUnit(&lex.unit, result);
+  if (res)
+    result->abort();
+  else
+    result->send_eof();
+
+  delete result;
+  return res;
+}
+
+bool optimizer::ExplainAnalyze::sendUnit(Select_Lex_Unit *unit,
+                                         select_result *result)
+{
+  for (Select_Lex *sl= unit->first_select(); sl; sl= sl->next_select())
+  {
+    if (sendSelect(sl, result))
+      return true;
+
+    for (Select_Lex_Unit *inner= sl->first_inner_unit();
+         inner;
+         inner= inner->next_unit())
+    {
+      if (sendUnit(inner, result))
+        return true;
+    }
+  }
+
+  if (unit->fake_select_lex)
+    return sendSelect(unit->fake_select_lex, result);
+
+  return false;
+}
+
+bool optimizer::ExplainAnalyze::sendSelect(Select_Lex *select_lex,
+                                           select_result *result)
+{
+  const charset_info_st * const cs= system_charset_info;
+  Item *item_null= new Item_null();
+
+  for (vector<Row>::iterator row= rows.begin(); row != rows.end(); ++row)
+  {
+    if (row->select_lex != select_lex)
+      continue;
+
+    List<Item> item_list;
+    for (vector<Item *>::iterator it= row->items.begin();
+         it != row->items.end();
+         ++it)
+    {
+      item_list.push_back(*it);
+    }
+
+    optimizer::AnalyzeStats *stats= row->stats;
+    if (not stats)
+    {
+      for (uint32_t i= 0; i < 6; i++)
+        item_list.push_back(item_null);
+    }
+    else
+    {
+      item_list.push_back(new Item_int((int64_t) stats->loops,
+                                       MY_INT64_NUM_DECIMAL_DIGITS));
+      item_list.push_back(new Item_int((int64_t) stats->rows_produced,
+                                       MY_INT64_NUM_DECIMAL_DIGITS));
+      item_list.push_back(new Item_int((int64_t) stats->rows_examined,
+                                       MY_INT64_NUM_DECIMAL_DIGITS));
+      item_list.push_back(new Item_float(stats->engine_usec / 1000.0, 3));
+      item_list.push_back(new Item_float(stats->cond_usec / 1000.0, 3));
+
+      /* Build "r_extra" from what was spilled by sorting and grouping */
+      stringstream extra;
+      if (stats->sort_rows)
+      {
+        extra << "; Sort: " << stats->sort_rows << " rows, "
+              << stats->sort_merge_passes << " merge passes";
+      }
+      if (stats->tmp_rows || stats->tmp_on_disk)
+      {
+        extra << "; Temporary: " << stats->tmp_rows << " rows, "
+              << stats->tmp_bytes
+              << (stats->tmp_on_disk ? " bytes on disk" : " bytes in memory");
+      }
+      string str(extra.str());
+      if (str.length())
+      {
+        str.erase(0, 2);        /* Skip initial "; "*/
+        item_list.push_back(new Item_string(session.mem.strdup(str.c_str(), str.length()),
+                                            str.length(), cs));
+      }
+      else
+        item_list.push_back(item_null);
+    }
+
+    if (result->send_data(item_list))
+      return true;
+  }
+
+  return false;
+}
+
 } /* namespace drizzled */
@@ -19,6 +19,9 @@
 
 #pragma once
 
+#include <set>
+#include <vector>
+
 namespace drizzled {
 namespace optimizer {
 
@@ -71,6 +74,8 @@ public:
 
 private:
 
+  bool sendRow(List<Item> &item_list, AnalyzeStats *stats);
+
   Join *join;
 
   bool need_tmp_table;
@@ -82,6 +87,61 @@ private:
   const char *message;
 };
 
+/**
+  Drives EXPLAIN ANALYZE.
+
+  The statement is executed for real. Every Join hands over its EXPLAIN
+  rows through attach() right before it starts reading rows, and gets
+  an AnalyzeStats on each of its non-const tables. Once the statement
+  is done the rows are sent in EXPLAIN order, followed by the counters
+  collected meanwhile.
+*/
+class ExplainAnalyze
+{
+public:
+  explicit ExplainAnalyze(Session &in_session);
+  ~ExplainAnalyze();
+
+  /** Switch the statement over to instrumented execution */
+  void start();
+
+  void attach(Join *join,
+              bool need_tmp_table,
+              bool need_order,
+              const char *message);
+
+  void addRow(Select_Lex *select_lex,
+              List<Item> &item_list,
+              AnalyzeStats *stats);
+
+  /** Run the statement, discarding its result, and send the plan */
+  bool execute();
+
+private:
+
+  struct Row
+  {
+    Select_Lex *select_lex;
+    std::vector<Item *> items;
+    AnalyzeStats *stats;
+  };
+
+  void stop();
+
+  bool sendUnit(Select_Lex_Unit *unit, select_result *result);
+
+  bool sendSelect(Select_Lex *select_lex, select_result *result);
+
+  Session &session;
+
+  /** LEX::describe of the statement, cleared while it executes */
+  uint8_t describe;
+
+  std::set<Select_Lex *> attached;
+
+  std::vector<Row> rows;
+};
+
 } /* namespace optimizer */
 
 } /* namespace drizzled */
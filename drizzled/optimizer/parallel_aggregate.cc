@@ -0,0 +1,800 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#include <drizzled/optimizer/parallel_aggregate.h>
+
+#include <drizzled/cursor.h>
+#include <drizzled/execute.h>
+#include <drizzled/item/cmpfunc.h>
+#include <drizzled/item/decimal.h>
+#include <drizzled/item/field.h>
+#include <drizzled/item/int.h>
+#include <drizzled/item/null.h>
+#include <drizzled/item/string.h>
+#include <drizzled/item/sum.h>
+#include <drizzled/item/uint.h>
+#include <drizzled/join.h>
+#include <drizzled/key.h>
+#include <drizzled/key_part_info.h>
+#include <drizzled/optimizer/range.h>
+#include <drizzled/plugin/storage_engine.h>
+#include <drizzled/select_send.h>
+#include <drizzled/session.h>
+#include <drizzled/sql/result_set.h>
+#include <drizzled/sql_lex.h>
+#include <drizzled/statistics_variables.h>
+#include <drizzled/system_variables.h>
+#include <drizzled/table.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+
+using namespace std;
+
+namespace drizzled {
+namespace optimizer {
+
+const uint64_t ParallelAggregate::MIN_RANGE_ROWS;
+
+namespace {
+
+/* Most records_in_range() calls spent on finding one bound */
+const uint32_t MAX_BOUND_PROBES= 64;
+
+/* Types whose text a range session returns converts back to the same value */
+bool supported_type(Item *item)
+{
+  switch (item->field_type())
+  {
+  case DRIZZLE_TYPE_LONG:
+  case DRIZZLE_TYPE_LONGLONG:
+  case DRIZZLE_TYPE_DECIMAL:
+  case DRIZZLE_TYPE_VARCHAR:
+    return true;
+  default:
+    return false;
+  }
+}
+
+string print_item(Item *item)
+{
+  char buff[256];
+  String str(buff, sizeof(buff), system_charset_info);
+  str.length(0);
+  item->print(&str);
+  return string(str.ptr(), str.length());
+}
+
+string print_identifier(const string &name)
+{
+  char buff[256];
+  String str(buff, sizeof(buff), system_charset_info);
+  str.length(0);
+  str.append_identifier(name);
+  return string(str.ptr(), str.length());
+}
+
+bool store_decimal(const string &text, type::Decimal *to)
+{
+  return to->store(E_DEC_FATAL_ERROR, text.data(), text.size(), &my_charset_bin) != E_DEC_OK;
+}
+
+} /* namespace */
+
+/* Convert the text a range session returned for item to its type */
+void ParallelAggregate::read_value(Item *item, sql::ResultSet &result_set,
+                                   size_t position, Value *value)
+{
+  value->null= result_set.isNull(position);
+  if (value->null)
+    return;
+
+  string text(result_set.getString(position));
+  switch (item->result_type())
+  {
+  case INT_RESULT:
+    value->integer= item->unsigned_flag ?
+      (int64_t) strtoull(text.c_str(), NULL, 10) :
+      strtoll(text.c_str(), NULL, 10);
+    break;
+  case DECIMAL_RESULT:
+    store_decimal(text, &value->decimal);
+    break;
+  default:
+    value->text= text;
+    break;
+  }
+}
+
+/* Compare two values of item the way the serial plan does, NULL first */
+int ParallelAggregate::compare_values(Item *item, const Value &a, const Value &b)
+{
+  if (a.null || b.null)
+    return a.null == b.null ? 0 : (a.null ? -1 : 1);
+
+  switch (item->result_type())
+  {
+  case INT_RESULT:
+    if (item->unsigned_flag)
+    {
+      uint64_t x= (uint64_t) a.integer;
+      uint64_t y= (uint64_t) b.integer;
+      return x < y ? -1 : (x > y ? 1 : 0);
+    }
+    return a.integer < b.integer ? -1 : (a.integer > b.integer ? 1 : 0);
+  case DECIMAL_RESULT:
+    return class_decimal_cmp(&a.decimal, &b.decimal);
+  default:
+    {
+      const charset_info_st *cs= item->collation.collation;
+      return cs->coll->strnncollsp(cs, (const unsigned char*) a.text.data(), a.text.size(),
+                                   (const unsigned char*) b.text.data(), b.text.size(), 0);
+    }
+  }
+}
+
+/* An item that sends value the way item sends it */
+Item *ParallelAggregate::make_item(Item *item, const Value &value)
+{
+  if (value.null)
+    return new Item_null();
+
+  switch (item->result_type())
+  {
+  case INT_RESULT:
+    if (item->unsigned_flag)
+      return new Item_uint((uint64_t) value.integer);
+    return new Item_int(value.integer);
+  case DECIMAL_RESULT:
+    {
+      type::Decimal rounded;
+      class_decimal_round(E_DEC_FATAL_ERROR, &value.decimal, item->decimals, false, &rounded);
+      return new Item_decimal(&rounded);
+    }
+  default:
+    return new Item_string(session.mem.strdup(value.text.data(), value.text.size()),
+                           value.text.size(), item->collation.collation);
+  }
+}
+
+class ParallelAggregate::GroupLess
+{
+public:
+  explicit GroupLess(const ParallelAggregate &arg) : aggregate(arg) {}
+
+  bool operator()(const Group &a, const Group &b) const
+  {
+    return aggregate.compare_keys(a.key, b.key) < 0;
+  }
+
+private:
+  const ParallelAggregate &aggregate;
+};
+
+ParallelAggregate::ParallelAggregate(Join &join_arg) :
+  join(join_arg),
+  session(*join_arg.session),
+  table(NULL),
+  key_field(NULL),
+  result_columns(0)
+{
+}
+
+bool ParallelAggregate::plan()
+{
+  Select_Lex *select_lex= join.select_lex;
+  uint64_t degree= session.variables.parallel_degree;
+
+  if (degree < 2 ||
+      session.lex().sql_command != SQLCOM_SELECT ||
+      (session.getTxIsolation() != ISO_REPEATABLE_READ &&
+       session.getTxIsolation() != ISO_READ_COMMITTED) ||
+      session.lex().explain_analyze ||
+      not session.isConcurrentExecuteAllowed() ||
+      session.inTransaction() ||
+      select_lex != &session.lex().select_lex ||
+      join.unit->first_select()->next_select() ||
+      select_lex->first_inner_unit() ||
+      not select_lex->with_sum_func ||
+      select_lex->olap == ROLLUP_TYPE ||
+      select_lex->having ||
+      select_lex->order_list.elements ||
+      (select_lex->options & SELECT_DISTINCT) ||
+      (join.select_options & (OPTION_FOUND_ROWS | SELECT_DESCRIBE)) ||
+      join.tables != 1 || join.const_tables || join.zero_result_cause ||
+      not dynamic_cast<select_send *>(join.result))
+    return false;
+
+  /*
+    A full scan of a table other sessions can open, and read in the
+    snapshot of this session
+  */
+  JoinTable *tab= join.join_tab;
+  table= tab->table;
+  if (tab->type != AM_ALL || (tab->select && tab->select->quick) ||
+      table->getShare()->getType() != message::Table::STANDARD ||
+      not table->cursor->getEngine()->check_flag(HTON_BIT_SHARED_SNAPSHOT) ||
+      not table->getShare()->hasPrimaryKey())
+    return false;
+
+  KeyInfo *key_info= &table->key_info[table->getShare()->getPrimaryKey()];
+  key_field= key_info->key_part[0].field;
+  if (key_info->key_parts != 1 || key_field->isUnsigned() ||
+      (key_field->type() != DRIZZLE_TYPE_LONG &&
+       key_field->type() != DRIZZLE_TYPE_LONGLONG))
+    return false;
+
+  for (Order *order= (Order*) select_lex->group_list.first; order; order= order->next)
+  {
+    Item *item= *order->item;
+    if (item->type() != Item::FIELD_ITEM || not printable(item) ||
+        not supported_type(item))
+      return false;
+    key_parts.push_back(item);
+    key_part_asc.push_back(order->asc);
+  }
+  result_columns= (uint32_t) key_parts.size();
+
+  List<Item>::iterator it(join.fields_list.begin());
+  while (Item *item= it++)
+  {
+    if (not add_column(item))
+      return false;
+  }
+
+  if (select_lex->where && not printable(select_lex->where))
+    return false;
+
+  degree= min(degree, table->cursor->stats.records / MIN_RANGE_ROWS);
+  if (degree < 2)
+    return false;
+
+  int64_t min_value, max_value;
+  if (read_bounds(&min_value, &max_value) || min_value == max_value)
+    return false;
+  split(min_value, max_value, (uint32_t) degree);
+  return not bounds.empty();
+}
+
+/*
+  Only columns of the table, constants and comparisons, which print back
+  as SQL that means the same in another session.
+*/
+bool ParallelAggregate::printable(Item *item)
+{
+  switch (item->type())
+  {
+  case Item::FIELD_ITEM:
+    {
+      Field *field= ((Item_field*) item)->field;
+      return field && field->getTable() == table;
+    }
+  case Item::INT_ITEM:
+  case Item::DECIMAL_ITEM:
+  case Item::STRING_ITEM:
+  case Item::NULL_ITEM:
+    return true;
+  case Item::COND_ITEM:
+    {
+      Item_cond *cond= (Item_cond*) item;
+      if (cond->functype() != Item_func::COND_AND_FUNC &&
+          cond->functype() != Item_func::COND_OR_FUNC)
+        return false;
+      List<Item>::iterator it(cond->argument_list()->begin());
+      while (Item *arg= it++)
+      {
+        if (not printable(arg))
+          return false;
+      }
+      return true;
+    }
+  case Item::FUNC_ITEM:
+    {
+      Item_func *func= (Item_func*) item;
+      switch (func->functype())
+      {
+      case Item_func::EQ_FUNC:
+      case Item_func::EQUAL_FUNC:
+      case Item_func::NE_FUNC:
+      case Item_func::LT_FUNC:
+      case Item_func::LE_FUNC:
+      case Item_func::GE_FUNC:
+      case Item_func::GT_FUNC:
+      case Item_func::ISNULL_FUNC:
+      case Item_func::ISNOTNULL_FUNC:
+      case Item_func::BETWEEN:
+      case Item_func::IN_FUNC:
+      case Item_func::NOT_FUNC:
+      case Item_func::NEG_FUNC:
+        break;
+      default:
+        return false;
+      }
+      for (uint32_t x= 0; x < func->argument_count(); x++)
+      {
+        if (not printable(func->arguments()[x]))
+          return false;
+      }
+      return true;
+    }
+  default:
+    return false;
+  }
+}
+
+bool ParallelAggregate::add_column(Item *item)
+{
+  Column column;
+  column.item= item;
+  column.arg= NULL;
+  column.key_part= 0;
+
+  if (item->type() == Item::FIELD_ITEM)
+  {
+    /* A group column, any other column has no single value per group */
+    for (size_t x= 0; x < key_parts.size(); x++)
+    {
+      if (((Item_field*) key_parts[x])->field == ((Item_field*) item)->field)
+      {
+        column.kind= GROUP;
+        column.key_part= (uint32_t) x;
+        columns.push_back(column);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  if (item->type() != Item::SUM_FUNC_ITEM)
+    return false;
+
+  Item_sum *sum= (Item_sum*) item;
+  if (sum->arg_count != 1 || not printable(sum->args[0]))
+    return false;
+  column.arg= sum->args[0];
+
+  switch (sum->sum_func())
+  {
+  case Item_sum::COUNT_FUNC:
+    column.kind= COUNT;
+    break;
+  case Item_sum::SUM_FUNC:
+  case Item_sum::AVG_FUNC:
+    /* Exact sums only, the order of adding doubles changes the result */
+    if (item->result_type() != DECIMAL_RESULT)
+      return false;
+    column.kind= sum->sum_func() == Item_sum::SUM_FUNC ? SUM : AVG;
+    break;
+  case Item_sum::MIN_FUNC:
+  case Item_sum::MAX_FUNC:
+    if (not supported_type(column.arg))
+      return false;
+    column.kind= sum->sum_func() == Item_sum::MIN_FUNC ? MIN : MAX;
+    break;
+  default:
+    return false;
+  }
+  columns.push_back(column);
+  result_columns+= column.kind == AVG ? 2 : 1;
+  return true;
+}
+
+/* Lowest and highest primary key, returns true if there are none */
+bool ParallelAggregate::read_bounds(int64_t *min_value, int64_t *max_value)
+{
+  table->setReadSet(key_field->position());
+  if (table->cursor->startIndexScan(table->getShare()->getPrimaryKey(), true))
+    return true;
+
+  bool error= table->cursor->index_first(table->record[0]);
+  if (not error)
+  {
+    *min_value= key_field->val_int();
+    error= table->cursor->index_last(table->record[0]);
+    *max_value= key_field->val_int();
+  }
+  table->cursor->endIndexScan();
+  return error;
+}
+
+/* Estimate of the rows with a primary key below value */
+uint64_t ParallelAggregate::rows_below(int64_t value)
+{
+  uint32_t pk= table->getShare()->getPrimaryKey();
+  KeyInfo *key_info= &table->key_info[pk];
+  unsigned char key[MAX_KEY_LENGTH];
+
+  /* The key is built from the record, nothing is written to the table */
+  boost::dynamic_bitset<> *save_write_set= table->write_set;
+  table->write_set= NULL;
+  key_field->store(value, false);
+  table->write_set= save_write_set;
+  key_copy(key, table->record[0], key_info, key_info->key_length);
+
+  key_range max_key;
+  max_key.key= key;
+  max_key.length= key_info->key_length;
+  max_key.flag= HA_READ_BEFORE_KEY;
+  max_key.keypart_map= 1;
+  return table->cursor->records_in_range(pk, NULL, &max_key);
+}
+
+/*
+  Pick degree - 1 bounds between the lowest and the highest key, so the
+  ranges hold about as many rows each. Engines that cannot estimate the
+  rows in a range get ranges of equal width.
+*/
+void ParallelAggregate::split(int64_t min_value, int64_t max_value, uint32_t degree)
+{
+  uint64_t width= (uint64_t) max_value - (uint64_t) min_value;
+  bool estimate= table->index_flags(table->getShare()->getPrimaryKey()) & HA_READ_RANGE;
+  uint64_t total= estimate ? rows_below(max_value) : 0;
+  int64_t low= min_value;
+
+  for (uint32_t x= 1; x < degree; x++)
+  {
+    int64_t bound;
+    if (estimate && total)
+    {
+      /* Lowest key with at least x / degree of the rows below it */
+      uint64_t target= total * x / degree;
+      int64_t high= max_value;
+      for (uint32_t probe= 0; low < high && probe < MAX_BOUND_PROBES; probe++)
+      {
+        int64_t middle= (int64_t) ((uint64_t) low + ((uint64_t) high - (uint64_t) low) / 2);
+        if (rows_below(middle) < target)
+          low= middle + 1;
+        else
+          high= middle;
+      }
+      bound= low;
+    }
+    else
+      bound= (int64_t) ((uint64_t) min_value + width / degree * x);
+
+    if (bound > min_value && (bounds.empty() || bound > bounds.back()))
+      bounds.push_back(bound);
+  }
+}
+
+string ParallelAggregate::range_query(size_t range)
+{
+  string key_column;
+  string group_by;
+  string sql("SELECT ");
+
+  if (table->alias_name_used)
+  {
+    key_column= print_identifier(table->getAlias());
+  }
+  else
+  {
+    key_column= print_identifier(boost::to_lower_copy(string(table->getSchemaName())));
+    key_column+= '.';
+    key_column+= print_identifier(boost::to_lower_copy(string(table->getAlias())));
+  }
+  key_column+= '.';
+  key_column+= print_identifier(key_field->field_name);
+
+  for (size_t x= 0; x < key_parts.size(); x++)
+  {
+    if (x)
+      group_by+= ", ";
+    group_by+= print_item(key_parts[x]);
+  }
+  sql+= group_by;
+
+  for (vector<Column>::iterator column= columns.begin(); column != columns.end(); column++)
+  {
+    string arg(column->arg ? print_item(column->arg) : string());
+    switch (column->kind)
+    {
+    case GROUP:
+      continue;
+    case COUNT:
+      arg= "COUNT(" + arg + ")";
+      break;
+    case SUM:
+      arg= "SUM(" + arg + ")";
+      break;
+    case AVG:
+      arg= "SUM(" + arg + "), COUNT(" + arg + ")";
+      break;
+    case MIN:
+      arg= "MIN(" + arg + ")";
+      break;
+    case MAX:
+      arg= "MAX(" + arg + ")";
+      break;
+    }
+    if (sql.size() > sizeof("SELECT ") - 1)
+      sql+= ", ";
+    sql+= arg;
+  }
+
+  sql+= " FROM ";
+  sql+= print_identifier(table->getSchemaName());
+  sql+= '.';
+  sql+= print_identifier(table->getTableName());
+  if (table->alias_name_used)
+  {
+    sql+= " AS ";
+    sql+= print_identifier(table->getAlias());
+  }
+
+  sql+= " WHERE ";
+  if (join.select_lex->where)
+  {
+    sql+= print_item(join.select_lex->where);
+    sql+= " AND ";
+  }
+  if (range)
+    sql+= key_column + " >= " + boost::lexical_cast<string>(bounds[range - 1]);
+  if (range && range < bounds.size())
+    sql+= " AND ";
+  if (range < bounds.size())
+    sql+= key_column + " < " + boost::lexical_cast<string>(bounds[range]);
+
+  if (not group_by.empty())
+    sql+= " GROUP BY " + group_by;
+  return sql;
+}
+
+bool ParallelAggregate::run()
+{
+  size_t ranges= bounds.size() + 1;
+  vector<boost::shared_ptr<sql::ResultSet> > results;
+  vector<thread_ptr> threads;
+  Execute execute(session, true);
+  bool error= false;
+
+  /* Every range reads the snapshot this statement reads */
+  execute.setShareSnapshot();
+
+  for (size_t x= 0; x < ranges; x++)
+  {
+    results.push_back(boost::shared_ptr<sql::ResultSet>(new sql::ResultSet(result_columns)));
+    threads.push_back(execute.start(range_query(x), *results.back()));
+    if (not threads.back())
+      error= true;
+  }
+
+  /*
+    The sessions write to the result sets until they end, so wait for all
+    of them even when this session is killed meanwhile.
+  */
+  bool killed= false;
+  for (vector<thread_ptr>::iterator thread= threads.begin(); thread != threads.end(); thread++)
+  {
+    if (killed)
+    {
+      if (*thread && (*thread)->joinable())
+        (*thread)->join();
+    }
+    else
+      killed= execute.join(*thread);
+  }
+  if (killed)
+    return true;
+
+  for (size_t x= 0; not error && x < ranges; x++)
+    error= read_result(*results[x]);
+  if (error)
+    return true;
+
+  /* A stable sort keeps the first value of a group that the scan would meet first */
+  std::stable_sort(groups.begin(), groups.end(), GroupLess(*this));
+  vector<Group>::iterator last= groups.begin();
+  for (vector<Group>::iterator group= groups.begin(); group != groups.end(); group++)
+  {
+    if (group == last)
+      continue;
+    if (compare_keys(last->key, group->key))
+      *++last= *group;
+    else
+      merge(last->values, group->values);
+  }
+  if (not groups.empty())
+    groups.erase(last + 1, groups.end());
+
+  /* Without GROUP BY there is one row, even for no rows at all */
+  if (key_parts.empty() && groups.empty())
+  {
+    groups.resize(1);
+    groups.back().values.resize(columns.size());
+    for (size_t x= 0; x < columns.size(); x++)
+    {
+      if (columns[x].kind == COUNT)
+        groups.back().values[x].null= false;
+    }
+  }
+
+  session.status_var.parallel_aggregate_queries++;
+  session.status_var.parallel_aggregate_ranges+= ranges;
+  return false;
+}
+
+/* Add the rows one range session returned to groups */
+bool ParallelAggregate::read_result(sql::ResultSet &result_set)
+{
+  drizzled::error_t err= result_set.getException().getErrorCode();
+  if (err != EE_OK && err != ER_EMPTY_QUERY)
+    return true;
+
+  while (result_set.next())
+  {
+    Group group;
+    size_t position= 0;
+    for (; position < key_parts.size(); position++)
+    {
+      Value value;
+      read_value(key_parts[position], result_set, position, &value);
+      group.key.push_back(value);
+    }
+
+    for (vector<Column>::iterator column= columns.begin(); column != columns.end(); column++)
+    {
+      Value value;
+      switch (column->kind)
+      {
+      case GROUP:
+        break;
+      case COUNT:
+        value.null= false;
+        value.count= strtoll(result_set.getString(position++).c_str(), NULL, 10);
+        break;
+      case SUM:
+        read_value(column->item, result_set, position++, &value);
+        break;
+      case AVG:
+        /* The partial SUM() has the type of the SUM() the serial plan would use */
+        value.null= result_set.isNull(position);
+        if (not value.null)
+          store_decimal(result_set.getString(position), &value.decimal);
+        position++;
+        value.count= strtoll(result_set.getString(position++).c_str(), NULL, 10);
+        break;
+      case MIN:
+      case MAX:
+        read_value(column->arg, result_set, position++, &value);
+        break;
+      }
+      group.values.push_back(value);
+    }
+    groups.push_back(group);
+  }
+  return false;
+}
+
+int ParallelAggregate::compare_keys(const Row &a, const Row &b) const
+{
+  for (size_t x= 0; x < key_parts.size(); x++)
+  {
+    int cmp= compare_values(key_parts[x], a[x], b[x]);
+    if (cmp)
+      return key_part_asc[x] ? cmp : -cmp;
+  }
+  return 0;
+}
+
+void ParallelAggregate::merge(Row &to, const Row &from) const
+{
+  for (size_t x= 0; x < columns.size(); x++)
+  {
+    const Column &column= columns[x];
+    Value &value= to[x];
+    const Value &partial= from[x];
+
+    switch (column.kind)
+    {
+    case GROUP:
+      break;
+    case COUNT:
+      value.count+= partial.count;
+      break;
+    case SUM:
+    case AVG:
+      value.count+= partial.count;
+      if (partial.null)
+        break;
+      if (value.null)
+      {
+        value= partial;
+        break;
+      }
+      {
+        type::Decimal sum;
+        class_decimal_add(E_DEC_FATAL_ERROR, &sum, &value.decimal, &partial.decimal);
+        class_decimal2decimal(&sum, &value.decimal);
+      }
+      break;
+    case MIN:
+    case MAX:
+      {
+        if (partial.null)
+          break;
+        int cmp= compare_values(column.arg, partial, value);
+        if (value.null || (column.kind == MIN ? cmp < 0 : cmp > 0))
+          value= partial;
+      }
+      break;
+    }
+  }
+}
+
+bool ParallelAggregate::send_group(const Group &group)
+{
+  List<Item> items;
+  for (size_t x= 0; x < columns.size(); x++)
+  {
+    const Column &column= columns[x];
+    const Value &value= column.kind == GROUP ? group.key[column.key_part] : group.values[x];
+
+    switch (column.kind)
+    {
+    case COUNT:
+      items.push_back(new Item_int(value.count));
+      break;
+    case AVG:
+      if (value.null || not value.count)
+        items.push_back(new Item_null());
+      else
+      {
+        Value avg;
+        type::Decimal count;
+        avg.null= false;
+        int2_class_decimal(E_DEC_FATAL_ERROR, value.count, false, &count);
+        class_decimal_div(E_DEC_FATAL_ERROR, &avg.decimal, &value.decimal, &count,
+                          ((Item_sum_avg*) column.item)->prec_increment);
+        items.push_back(make_item(column.item, avg));
+      }
+      break;
+    default:
+      items.push_back(make_item(column.item, value));
+      break;
+    }
+  }
+  return join.result->send_data(items);
+}
+
+bool ParallelAggregate::send_result()
+{
+  Select_Lex_Unit *unit= join.unit;
+  ha_rows sent= 0;
+
+  join.result->send_fields(join.fields_list);
+  for (vector<Group>::iterator group= groups.begin();
+       group != groups.end() && sent < unit->select_limit_cnt;
+       group++, sent++)
+  {
+    if (send_group(*group))
+      return true;
+  }
+  session.limit_found_rows= sent;
+  return join.result->send_eof();
+}
+
+} /* namespace optimizer */
+} /* namespace drizzled */
@@ -0,0 +1,162 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#pragma once
+
+#include <drizzled/common_fwd.h>
+#include <drizzled/type/decimal.h>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace drizzled {
+namespace optimizer {
+
+/**
+  Runs an aggregate query over one table as several scans of primary key
+  ranges at the same time, and merges their partial results.
+
+  The ranges are picked with records_in_range() so each holds about the
+  same number of rows. Every range is read by a session of its own,
+  started the way EXECUTE starts one, that runs the query restricted to
+  the range with each aggregate replaced by its partial form: AVG() by
+  SUM() and COUNT(). The partial rows are converted back to the types of
+  the select list, merged by group and sent in the order of the GROUP BY,
+  like the serial plan sends them.
+
+  Only simple queries qualify: one transactional table with a single
+  integer column primary key, no HAVING, DISTINCT, ORDER BY or ROLLUP,
+  and a WHERE clause and aggregate arguments made of columns, constants
+  and comparisons. The range sessions start their transactions on the
+  snapshot of the session that runs the statement, so the engine of the
+  table has to be able to share one (HTON_BIT_SHARED_SNAPSHOT) and the
+  isolation level has to read from a snapshot.
+*/
+class ParallelAggregate
+{
+public:
+  /** Fewest rows that are worth a range session of their own */
+  static const uint64_t MIN_RANGE_ROWS= 1000;
+
+  explicit ParallelAggregate(Join &join_arg);
+
+  /**
+    Check that the query qualifies and split the table into ranges.
+
+    @retval true  The query can run in parallel
+    @retval false Run the serial plan
+  */
+  bool plan();
+
+  /**
+    Run the ranges and merge their results. When a range fails the
+    merged result is incomplete, and the caller runs the serial plan
+    unless the session was killed.
+
+    @retval true  Failed
+    @retval false OK
+  */
+  bool run();
+
+  /** Send the merged rows to the client, returns true on error */
+  bool send_result();
+
+private:
+  enum Kind { GROUP, COUNT, SUM, AVG, MIN, MAX };
+
+  /** One column of the select list */
+  struct Column
+  {
+    Kind kind;
+    Item *item;
+    Item *arg; /**< Argument of an aggregate */
+    uint32_t key_part; /**< Group column the select column shows */
+  };
+
+  /** A value of the result type of the item it belongs to */
+  struct Value
+  {
+    Value() : null(true), integer(0), count(0) {}
+
+    Value(const Value &from) :
+      null(from.null),
+      integer(from.integer),
+      text(from.text),
+      count(from.count)
+    {
+      class_decimal2decimal(&from.decimal, &decimal);
+    }
+
+    Value &operator=(const Value &from)
+    {
+      null= from.null;
+      integer= from.integer;
+      class_decimal2decimal(&from.decimal, &decimal);
+      text= from.text;
+      count= from.count;
+      return *this;
+    }
+
+    bool null;
+    int64_t integer; /**< INT_RESULT */
+    type::Decimal decimal; /**< DECIMAL_RESULT, and sums */
+    std::string text; /**< STRING_RESULT */
+    int64_t count; /**< COUNT(), and the rows of an AVG() */
+  };
+
+  typedef std::vector<Value> Row;
+
+  /** Merged result of one group */
+  struct Group
+  {
+    Row key;
+    Row values;
+  };
+
+  bool printable(Item *item);
+  bool add_column(Item *item);
+  bool read_bounds(int64_t *min_value, int64_t *max_value);
+  uint64_t rows_below(int64_t value);
+  void split(int64_t min_value, int64_t max_value, uint32_t degree);
+  std::string range_query(size_t range);
+  void read_value(Item *item, sql::ResultSet &result_set, size_t position, Value *value);
+  static int compare_values(Item *item, const Value &a, const Value &b);
+  Item *make_item(Item *item, const Value &value);
+  bool read_result(sql::ResultSet &result_set);
+  int compare_keys(const Row &a, const Row &b) const;
+  void merge(Row &to, const Row &from) const;
+  bool send_group(const Group &group);
+
+  class GroupLess;
+
+  Join &join;
+  Session &session;
+  Table *table;
+  Field *key_field;
+  std::vector<Item *> key_parts;
+  std::vector<bool> key_part_asc;
+  std::vector<Column> columns;
+  std::vector<int64_t> bounds; /**< Ranges start at each bound, a first one starts at the lowest key */
+  std::vector<Group> groups;
+  uint32_t result_columns;
+};
+
+} /* namespace optimizer */
+} /* namespace drizzled */
@@ -0,0 +1,272 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+#include <drizzled/session.h>
+#include <drizzled/optimizer/range.h>
+#include <drizzled/optimizer/quick_range.h>
+#include <drizzled/optimizer/quick_skip_scan_select.h>
+#include <drizzled/optimizer/sel_arg.h>
+#include <drizzled/internal/m_string.h>
+#include <drizzled/key.h>
+#include <drizzled/table.h>
+#include <drizzled/system_variables.h>
+#include <drizzled/key_part_info.h>
+#include <drizzled/util/test.h>
+
+using namespace std;
+
+namespace drizzled {
+namespace optimizer {
+
+QuickSkipScanSelect::QuickSkipScanSelect(Session *session,
+                                         Table *table,
+                                         uint32_t use_index,
+                                         uint32_t prefix_key_parts_arg,
+                                         double read_cost_arg,
+                                         ha_rows records_arg)
+  :
+    index_info(table->key_info + use_index),
+    prefix_key_parts(prefix_key_parts_arg),
+    prefix_len(0),
+    min_key(NULL),
+    max_key(NULL),
+    seen_first_key(false),
+    in_range(false)
+{
+  head= table;
+  cursor= head->cursor;
+  index= use_index;
+  record= head->record[0];
+  read_time= read_cost_arg;
+  records= records_arg;
+  sorted= true;
+
+  KeyPartInfo *key_part= index_info->key_part;
+  for (uint32_t part= 0; part < prefix_key_parts; part++, key_part++)
+    prefix_len+= key_part->store_length;
+  range_part_len= key_part->store_length;
+
+  used_key_parts= prefix_key_parts + 1;
+  max_used_key_length= prefix_len + range_part_len;
+  cur_range= ranges.end();
+
+  /* The ranges are allocated by make_quick() in this memory pool. */
+  alloc.init(session->variables.range_alloc_block_size);
+  session->mem_root= &alloc;
+}
+
+
+QuickSkipScanSelect::~QuickSkipScanSelect()
+{
+  range_end();
+  if (head->key_read)
+  {
+    head->key_read= 0;
+    cursor->extra(HA_EXTRA_NO_KEYREAD);
+  }
+  ranges.clear();
+  alloc.free_root(MYF(0));
+}
+
+
+bool QuickSkipScanSelect::add_range(SEL_ARG *sel_range)
+{
+  uint32_t range_flag= sel_range->min_flag | sel_range->max_flag;
+
+  if (! (sel_range->min_flag & NO_MIN_RANGE) &&
+      ! (sel_range->max_flag & NO_MAX_RANGE))
+  {
+    if (sel_range->maybe_null &&
+        sel_range->min_value[0] && sel_range->max_value[0])
+      range_flag|= NULL_RANGE; /* IS NULL condition */
+    else if (memcmp(sel_range->min_value, sel_range->max_value,
+                    range_part_len) == 0)
+      range_flag|= EQ_RANGE;  /* equality condition */
+  }
+  QuickRange *range= new QuickRange(sel_range->min_value,
+                                    range_part_len,
+                                    make_keypart_map(sel_range->part),
+                                    sel_range->max_value,
+                                    range_part_len,
+                                    make_keypart_map(sel_range->part),
+                                    range_flag);
+  if (! range)
+    return true;
+  ranges.push_back(range);
+  return false;
+}
+
+
+int QuickSkipScanSelect::init()
+{
+  if (min_key) /* Already initialized. */
+    return 0;
+
+  min_key= alloc.alloc(max_used_key_length);
+  max_key= alloc.alloc(max_used_key_length);
+  return 0;
+}
+
+
+int QuickSkipScanSelect::reset()
+{
+  int error;
+
+  assert(! ranges.empty());
+  seen_first_key= false;
+  in_range= false;
+  cur_range= ranges.end();
+
+  if (cursor->inited == Cursor::NONE && (error= cursor->startIndexScan(index, 1)))
+    return error;
+  return 0;
+}
+
+
+void QuickSkipScanSelect::range_end()
+{
+  if (cursor->inited != Cursor::NONE)
+    cursor->ha_index_or_rnd_end();
+}
+
+
+int QuickSkipScanSelect::next_prefix()
+{
+  int result;
+
+  if (! seen_first_key)
+  {
+    result= cursor->index_first(record);
+    seen_first_key= true;
+  }
+  else
+  {
+    /* Load the first key after the current prefix into record. */
+    result= cursor->index_read_map(record,
+                                   min_key,
+                                   make_prev_keypart_map(prefix_key_parts),
+                                   HA_READ_AFTER_KEY);
+  }
+  if (result)
+    return (result == HA_ERR_KEY_NOT_FOUND) ? HA_ERR_END_OF_FILE : result;
+
+  /* Save the new prefix, the ranges are appended to it. */
+  key_copy(min_key, record, index_info, prefix_len);
+  memcpy(max_key, min_key, prefix_len);
+  return 0;
+}
+
+
+int QuickSkipScanSelect::start_range(QuickRange *range)
+{
+  key_range start_key;
+  key_range end_key;
+
+  start_key.key= min_key;
+  if (range->flag & NO_MIN_RANGE)
+  {
+    start_key.length= prefix_len;
+    start_key.keypart_map= make_prev_keypart_map(prefix_key_parts);
+    start_key.flag= HA_READ_KEY_EXACT;
+  }
+  else
+  {
+    memcpy(min_key + prefix_len, range->min_key, range->min_length);
+    start_key.length= prefix_len + range->min_length;
+    start_key.keypart_map= make_prev_keypart_map(prefix_key_parts + 1);
+    start_key.flag= (range->flag & (EQ_RANGE | NULL_RANGE)) ?
+                    HA_READ_KEY_EXACT : (range->flag & NEAR_MIN) ?
+                    HA_READ_AFTER_KEY : HA_READ_KEY_OR_NEXT;
+  }
+
+  /* Without an upper boundary the range ends with the prefix. */
+  end_key.key= max_key;
+  if (range->flag & NO_MAX_RANGE)
+  {
+    end_key.length= prefix_len;
+    end_key.keypart_map= make_prev_keypart_map(prefix_key_parts);
+    end_key.flag= HA_READ_AFTER_KEY;
+  }
+  else
+  {
+    memcpy(max_key + prefix_len, range->max_key, range->max_length);
+    end_key.length= prefix_len + range->max_length;
+    end_key.keypart_map= make_prev_keypart_map(prefix_key_parts + 1);
+    end_key.flag= (range->flag & NEAR_MAX) ?
+                  HA_READ_BEFORE_KEY : HA_READ_AFTER_KEY;
+  }
+
+  return cursor->read_range_first(&start_key, &end_key,
+                                  test(range->flag & EQ_RANGE), sorted);
+}
+
+
+int QuickSkipScanSelect::get_next()
+{
+  int result;
+
+  for (;;)
+  {
+    if (in_range)
+    {
+      result= cursor->read_range_next();
+      if (result != HA_ERR_END_OF_FILE)
+        return result;
+      in_range= false;
+      ++cur_range;
+    }
+
+    if (cur_range == ranges.end())
+    {
+      if ((result= next_prefix()))
+        return result;
+      cur_range= ranges.begin();
+    }
+
+    result= start_range(*cur_range);
+    if (result == 0)
+    {
+      in_range= true;
+      return 0;
+    }
+    if (result != HA_ERR_END_OF_FILE)
+      return result;
+    ++cur_range;
+  }
+}
+
+
+void QuickSkipScanSelect::add_keys_and_lengths(string *key_names,
+                                               string *used_lengths)
+{
+  char buf[64];
+  key_names->append(index_info->name);
+  uint32_t length= internal::int64_t2str(max_used_key_length, buf, 10) - buf;
+  used_lengths->append(buf, length);
+}
+
+
+void QuickSkipScanSelect::add_info_string(string *str)
+{
+  str->append("skip scan");
+}
+
+} /* namespace optimizer */
+} /* namespace drizzled */
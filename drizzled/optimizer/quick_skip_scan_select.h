@@ -0,0 +1,144 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#pragma once
+
+#include <drizzled/optimizer/range.h>
+
+#include <vector>
+
+namespace drizzled {
+namespace optimizer {
+
+/**
+  Index scan for range predicates on a non-leading key part.
+
+  Given an index (A_1,...,A_k, B, ...) and a query of the form
+
+       SELECT ... FROM T WHERE RNG(B) [AND other conditions]
+
+  where nothing restricts A_1,...,A_k, this quick select jumps from one
+  distinct value of the prefix (A_1,...,A_k) to the next, and for every
+  prefix reads the ranges RNG(B) with that prefix prepended. It pays
+  off when the prefix has few distinct values, which is estimated from
+  the prefix cardinality in get_best_skip_scan() in optimizer/range.cc.
+
+  Rows are returned in index order. Predicates on the key parts after B
+  are not used for the lookups; they are left to the WHERE clause.
+*/
+class QuickSkipScanSelect : public QuickSelectInterface
+{
+private:
+  Cursor *cursor; /**< The Cursor used to get data. */
+  KeyInfo *index_info; /**< The index chosen for data access */
+  uint32_t prefix_key_parts; /**< Number of skipped key parts (k above) */
+  uint32_t prefix_len; /**< Length of the skipped key parts */
+  uint32_t range_part_len; /**< Length of the range key part (B above) */
+  unsigned char *min_key; /**< Current prefix + lower boundary of a range */
+  unsigned char *max_key; /**< Current prefix + upper boundary of a range */
+  std::vector<QuickRange *> ranges; /**< Ranges on the key part B */
+  std::vector<QuickRange *>::iterator cur_range; /**< Range being read */
+  bool seen_first_key; /**< Denotes whether the first prefix was read */
+  bool in_range; /**< Denotes whether read_range_next() may be called */
+
+  /**
+   * Move to the next distinct value of the prefix.
+   *
+   * @details
+   * Reads the first key after the current prefix and stores its prefix in
+   * min_key and max_key.
+   *
+   * @retval 0                   on success
+   * @retval HA_ERR_END_OF_FILE  if there are no more prefixes
+   * @retval other               if some error occurred
+   */
+  int next_prefix();
+
+  /**
+   * Position the cursor on the first key of the current prefix within range.
+   *
+   * @retval 0                   on success
+   * @retval HA_ERR_END_OF_FILE  if the range is empty for this prefix
+   * @retval other               if some error occurred
+   */
+  int start_range(QuickRange *range);
+
+public:
+  /** Memory pool for this quick select and its ranges */
+  memory::Root alloc;
+
+  /*
+     Construct a new skip scan quick select.
+     SYNOPSIS
+     QuickSkipScanSelect::QuickSkipScanSelect()
+     session           Thread handle
+     table             The table being accessed
+     use_index         The index to scan
+     prefix_key_parts  Number of leading key parts that are skipped
+     read_cost         Cost of this access method
+     records           Number of records returned
+  */
+  QuickSkipScanSelect(Session *session,
+                      Table *table,
+                      uint32_t use_index,
+                      uint32_t prefix_key_parts,
+                      double read_cost,
+                      ha_rows records);
+
+  ~QuickSkipScanSelect();
+
+  /**
+   * Create and add a new quick range for the key part after the prefix.
+   *
+   * @retval false on success
+   * @retval true  otherwise
+   */
+  bool add_range(SEL_ARG *sel_range);
+
+  int init();
+
+  int reset();
+
+  int get_next();
+
+  void range_end();
+
+  bool reverse_sorted() const
+  {
+    return false;
+  }
+
+  bool unique_key_range() const
+  {
+    return false;
+  }
+
+  int get_type() const
+  {
+    return QS_TYPE_SKIP_SCAN;
+  }
+
+  void add_keys_and_lengths(std::string *key_names,
+                            std::string *used_lengths);
+
+  void add_info_string(std::string *str);
+};
+
+} /* namespace optimizer */
+} /* namespace drizzled */
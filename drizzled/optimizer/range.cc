@@ -117,6 +117,7 @@
 #include <drizzled/internal/iocache.h>
 #include <drizzled/internal/my_sys.h>
 #include <drizzled/item/cmpfunc.h>
+#include <drizzled/optimizer/cost_model.h>
 #include <drizzled/optimizer/cost_vector.h>
 #include <drizzled/optimizer/quick_group_min_max_select.h>
 #include <drizzled/optimizer/quick_index_merge_select.h>
@@ -124,6 +125,7 @@
 #include <drizzled/optimizer/quick_range_select.h>
 #include <drizzled/optimizer/quick_ror_intersect_select.h>
 #include <drizzled/optimizer/quick_ror_union_select.h>
+#include <drizzled/optimizer/quick_skip_scan_select.h>
 #include <drizzled/optimizer/range.h>
 #include <drizzled/optimizer/range_param.h>
 #include <drizzled/optimizer/sel_arg.h>
@@ -196,7 +198,8 @@ static unsigned char is_null_string[2]= {1,0};
 
     1 = half_rotation_cost + move_cost * 1/3 * typical_data_file_length
 
-  We define half_rotation_cost as DISK_SEEK_BASE_COST=0.9.
+  We define half_rotation_cost as disk_seek_base_cost of the cost model
+  (0.9 by default).
 
   @param table             Table to be accessed
   @param nrows             Number of rows to retrieve
@@ -231,8 +234,9 @@ static void get_sweep_read_cost(Table *table,
     if (! interrupted)
     {
       /* Assume reading is done in one 'sweep' */
-      cost->setAvgIOCost((DISK_SEEK_BASE_COST +
-                          DISK_SEEK_PROP_COST*n_blocks/busy_blocks));
+      const optimizer::CostModel &cost_model= table->cursor->getCostModel();
+      cost->setAvgIOCost((cost_model.getDiskSeekBaseCost() +
+                          cost_model.getDiskSeekPropCost()*n_blocks/busy_blocks));
     }
   }
 }
@@ -292,6 +296,11 @@ optimizer::TableReadPlan *get_best_disjunct_quick(Session *session,
 static
 optimizer::GroupMinMaxReadPlan *get_best_group_min_max(optimizer::Parameter *param, optimizer::SEL_TREE *tree);
 
+static
+optimizer::SkipScanReadPlan *get_best_skip_scan(optimizer::Parameter *param,
+                                                optimizer::SEL_TREE *tree,
+                                                double read_time);
+
 static optimizer::SEL_TREE *tree_and(optimizer::RangeParameter *param,
                                      optimizer::SEL_TREE *tree1,
                                      optimizer::SEL_TREE *tree2);
@@ -649,7 +658,7 @@ int optimizer::SqlSelect::test_quick_select(Session *session,
   records= head->cursor->stats.records;
   if (!records)
     records++;
-  scan_time= (double) records / TIME_FOR_COMPARE + 1;
+  scan_time= (double) records / head->cursor->getCostModel().timeForCompare() + 1;
   read_time= (double) head->cursor->scan_time() + scan_time + 1.1;
   if (head->force_index)
     scan_time= read_time= DBL_MAX;
@@ -735,7 +744,7 @@ int optimizer::SqlSelect::test_quick_select(Session *session,
       int key_for_use= head->find_shortest_key(&head->covering_keys);
       double key_read_time=
         param.table->cursor->index_only_read_time(key_for_use, records) +
-        (double) records / TIME_FOR_COMPARE;
+        (double) records / param.table->cursor->getCostModel().timeForCompare();
       if (key_read_time < read_time)
         read_time= key_read_time;
     }
@@ -799,6 +808,17 @@ int optimizer::SqlSelect::test_quick_select(Session *session,
           best_read_time= best_trp->read_cost;
         }
 
+        /*
+          Try jumping over the distinct values of unconstrained leading
+          key parts, for indexes whose ranges start at a later key part.
+        */
+        optimizer::SkipScanReadPlan *skip_trp;
+        if ((skip_trp= get_best_skip_scan(&param, tree, best_read_time)))
+        {
+          best_trp= skip_trp;
+          best_read_time= best_trp->read_cost;
+        }
+
         /*
           Simultaneous key scans and row deletes on several Cursor
           objects are not allowed so don't use ROR-intersection for
@@ -928,7 +948,7 @@ int optimizer::SqlSelect::test_quick_select(Session *session,
       The total cost of reading all needed blocks in one "sweep" is:
 
       E(n_busy_blocks)*
-       (DISK_SEEK_BASE_COST + DISK_SEEK_PROP_COST*n_blocks/E(n_busy_blocks)).
+       (disk_seek_base_cost + disk_seek_prop_cost*n_blocks/E(n_busy_blocks)).
 
     3. Cost of Unique use is calculated in Unique::get_use_cost function.
 
@@ -1022,7 +1042,7 @@ optimizer::TableReadPlan *get_best_disjunct_quick(Session *session,
       Add one ROWID comparison for each row retrieved on non-CPK scan.  (it
       is done in QuickRangeSelect::row_in_ranges)
      */
-    imerge_cost += non_cpk_scan_records / TIME_FOR_COMPARE_ROWID;
+    imerge_cost += non_cpk_scan_records / param->table->cursor->getCostModel().timeForCompareRowid();
   }
 
   /* Calculate cost(rowid_to_row_scan) */
@@ -1093,7 +1113,7 @@ skip_to_ror_scan:
       cost= param->table->cursor->
               read_time(param->real_keynr[(*cur_child)->key_idx], 1,
                         (*cur_child)->records) +
-              static_cast<double>((*cur_child)->records) / TIME_FOR_COMPARE;
+              static_cast<double>((*cur_child)->records) / param->table->cursor->getCostModel().timeForCompare();
     }
     else
       cost= read_time;
@@ -1141,7 +1161,7 @@ skip_to_ror_scan:
                         &sweep_cost);
     roru_total_cost= roru_index_costs +
                      static_cast<double>(roru_total_records)*log((double)n_child_scans) /
-                     (TIME_FOR_COMPARE_ROWID * M_LN2) +
+                     (param->table->cursor->getCostModel().timeForCompareRowid() * M_LN2) +
                      sweep_cost.total_cost();
   }
 
@@ -1535,11 +1555,11 @@ static bool ror_intersect_add(ROR_INTERSECT_INFO *info,
   {
     /*
       CPK scan is used to filter out rows. We apply filtering for
-      each record of every scan. Assuming 1/TIME_FOR_COMPARE_ROWID
+      each record of every scan. Assuming key_compare_cost
       per check this gives us:
     */
     info->index_scan_costs += static_cast<double>(info->index_records) /
-                              TIME_FOR_COMPARE_ROWID;
+                              info->param->table->cursor->getCostModel().timeForCompareRowid();
   }
   else
   {
@@ -1673,7 +1693,7 @@ optimizer::RorIntersectReadPlan *get_best_covering_ror_intersect(optimizer::Para
   /* Add priority queue use cost. */
   total_cost += static_cast<double>(records) *
                 log((double)(ror_scan_mark - tree->ror_scans)) /
-                (TIME_FOR_COMPARE_ROWID * M_LN2);
+                (param->table->cursor->getCostModel().timeForCompareRowid() * M_LN2);
 
   if (total_cost > read_time)
     return NULL;
@@ -5336,7 +5356,7 @@ void cost_group_min_max(Table* table,
     no CPU cost. We leave it here to make this cost comparable to that of index
     scan as computed in SqlSelect::test_quick_select().
   */
-  cpu_cost= (double) num_groups / TIME_FOR_COMPARE;
+  cpu_cost= (double) num_groups / table->cursor->getCostModel().timeForCompare();
 
   *read_cost= io_cost + cpu_cost;
   *records= num_groups;
@@ -5445,6 +5465,174 @@ optimizer::GroupMinMaxReadPlan::make_quick(optimizer::Parameter *param, bool, me
 }
 
 
+/*
+  Compute the cost of a skip scan.
+
+  SYNOPSIS
+    cost_skip_scan()
+    param             Parameter from test_quick_select
+    keynr             Index to scan
+    prefix_key_parts  Number of skipped leading key parts
+    key_tree          Intervals on the key part after the prefix
+    read_cost   [out] The cost to retrieve rows via this quick select
+    records     [out] The number of rows retrieved
+
+  DESCRIPTION
+    The number of distinct prefixes is derived from the cardinality of the
+    prefix, rec_per_key of its last key part. For every prefix the scan makes
+    one index lookup to find it plus one per interval, and then reads the
+    rows of the intervals:
+
+      dives   = num_prefixes * (num_intervals + 1)
+      records = num_prefixes * SUM(rows of the interval within one prefix)
+
+    A single-point interval is expected to hold rec_per_key of the range key
+    part rows per prefix. Any other interval is guessed to hold a third of
+    the prefix, as there are no statistics on the distribution of the range
+    key part within a prefix.
+
+  RETURN
+    false  the cost was computed
+    true   there are no statistics for the prefix, it can't be priced
+*/
+static bool cost_skip_scan(optimizer::Parameter *param,
+                           uint32_t keynr,
+                           uint32_t prefix_key_parts,
+                           optimizer::SEL_ARG *key_tree,
+                           double *read_cost,
+                           ha_rows *records)
+{
+  Table *table= param->table;
+  KeyInfo *index_info= table->key_info + keynr;
+  ha_rows table_records= table->cursor->stats.records;
+  uint32_t keys_per_prefix= index_info->rec_per_key[prefix_key_parts - 1];
+  uint32_t keys_per_value= index_info->rec_per_key[prefix_key_parts];
+
+  if (keys_per_prefix == 0)
+    return true;
+  if (keys_per_value == 0) /* If there is no statistics try to guess */
+    /* each value covers 10% of a prefix */
+    keys_per_value= keys_per_prefix / 10 + 1;
+
+  double num_prefixes= (double) (table_records / keys_per_prefix) + 1;
+  double num_intervals= 0;
+  double rows_per_prefix= 0;
+  for (optimizer::SEL_ARG *interval= key_tree->first(); interval; interval= interval->next)
+  {
+    num_intervals++;
+    rows_per_prefix+= interval->is_singlepoint() ?
+                      (double) keys_per_value : (double) keys_per_prefix / 3;
+  }
+  set_if_smaller(rows_per_prefix, (double) keys_per_prefix);
+
+  double found_records= min(num_prefixes * rows_per_prefix, (double) table_records);
+  double dives= num_prefixes * (num_intervals + 1);
+  Cursor *cursor= table->cursor;
+  double io_cost= dives * cursor->getCostModel().getIOSeekCost();
+  if (table->covering_keys.test(keynr))
+    io_cost+= cursor->index_only_read_time(keynr, found_records);
+  else
+    io_cost+= cursor->read_time(keynr, 0, (ha_rows) found_records);
+
+  *read_cost= io_cost + found_records / table->cursor->getCostModel().timeForCompare();
+  *records= (ha_rows) found_records;
+  set_if_bigger(*records, (ha_rows) 1);
+  return false;
+}
+
+
+/*
+  Find the cheapest skip scan for the range tree.
+
+  SYNOPSIS
+    get_best_skip_scan()
+    param      Parameter from test_quick_select
+    tree       The range tree of the WHERE clause
+    read_time  Don't create a plan with cost > read_time
+
+  DESCRIPTION
+    A skip scan can be used for an index (A_1,...,A_k, B, ...) when the
+    tree for that index starts at key part B, i.e. there are no predicates
+    on A_1,...,A_k that the range optimizer could use. Such trees are
+    rejected by check_quick_select(), as a range scan can't be done over
+    them. The index must be able to read in order, and every interval on B
+    must be bounded on at least one side.
+
+  RETURN
+    The plan of the cheapest skip scan cheaper than read_time, or NULL
+*/
+static optimizer::SkipScanReadPlan *get_best_skip_scan(optimizer::Parameter *param,
+                                                       optimizer::SEL_TREE *tree,
+                                                       double read_time)
+{
+  optimizer::SkipScanReadPlan *read_plan= NULL;
+
+  for (uint32_t idx= 0; idx < param->keys; idx++)
+  {
+    optimizer::SEL_ARG *key_tree= tree->keys[idx];
+    uint32_t keynr= param->real_keynr[idx];
+    double found_read_time;
+    ha_rows found_records;
+
+    /* Trees starting at the first key part are for get_key_scans_params() */
+    if (! key_tree ||
+        key_tree->type != optimizer::SEL_ARG::KEY_RANGE ||
+        key_tree->part == 0 ||
+        key_tree->maybe_flag)
+      continue;
+
+    if ((param->table->index_flags(keynr) & (HA_READ_ORDER | HA_READ_RANGE)) !=
+        (HA_READ_ORDER | HA_READ_RANGE))
+      continue;
+
+    /* Skip (-inf,+inf) intervals, e.g. (x < 5 or x > 4). */
+    bool unbounded= false;
+    for (optimizer::SEL_ARG *interval= key_tree->first(); interval; interval= interval->next)
+    {
+      if ((interval->min_flag & NO_MIN_RANGE) && (interval->max_flag & NO_MAX_RANGE))
+        unbounded= true;
+    }
+    if (unbounded)
+      continue;
+
+    if (cost_skip_scan(param, keynr, key_tree->part, key_tree,
+                       &found_read_time, &found_records))
+      continue;
+
+    if (found_read_time < read_time)
+    {
+      read_time= found_read_time;
+      read_plan= new (*param->mem_root) optimizer::SkipScanReadPlan(key_tree, idx,
+                                                                   key_tree->part);
+      read_plan->records= found_records;
+      read_plan->read_cost= found_read_time;
+      read_plan->is_ror= false;
+    }
+  }
+  return read_plan;
+}
+
+
+optimizer::QuickSelectInterface *optimizer::SkipScanReadPlan::make_quick(optimizer::Parameter *param, bool, memory::Root *)
+{
+  optimizer::QuickSkipScanSelect *quick= new optimizer::QuickSkipScanSelect(param->session,
+                                                                           param->table,
+                                                                           param->real_keynr[key_idx],
+                                                                           prefix_key_parts,
+                                                                           read_cost,
+                                                                           records);
+  for (optimizer::SEL_ARG *interval= key->first(); interval; interval= interval->next)
+  {
+    if (quick->add_range(interval))
+    {
+      delete quick;
+      return NULL;
+    }
+  }
+  return quick;
+}
+
+
 optimizer::QuickSelectInterface *optimizer::RangeReadPlan::make_quick(optimizer::Parameter *param, bool, memory::Root *parent_alloc)
 {
   optimizer::QuickRangeSelect *quick= optimizer::get_quick_select(param, key_idx, key, mrr_flags, mrr_buf_size, parent_alloc);
@@ -189,7 +189,8 @@ public:
     QS_TYPE_RANGE_DESC= 2,
     QS_TYPE_ROR_INTERSECT= 4,
     QS_TYPE_ROR_UNION= 5,
-    QS_TYPE_GROUP_MIN_MAX= 6
+    QS_TYPE_GROUP_MIN_MAX= 6,
+    QS_TYPE_SKIP_SCAN= 7
   };
 
   /** Returns the type of this quick select - one of the QS_TYPE_* values */
@@ -215,6 +215,29 @@ public:
 };
 
 
+/*
+  Plan for a QuickSkipScanSelect scan.
+  SkipScanReadPlan::make_quick ignores retrieve_full_rows for the same
+  reason as RangeReadPlan::make_quick.
+*/
+class SkipScanReadPlan : public TableReadPlan
+{
+public:
+  SEL_ARG *key; /* intervals on the first key part after the prefix */
+  uint32_t key_idx; /* key number in Parameter::key */
+  uint32_t prefix_key_parts; /* number of skipped leading key parts */
+
+  SkipScanReadPlan(SEL_ARG *key_arg, uint32_t idx_arg, uint32_t prefix_key_parts_arg)
+    :
+      key(key_arg),
+      key_idx(idx_arg),
+      prefix_key_parts(prefix_key_parts_arg)
+  {}
+
+  QuickSelectInterface *make_quick(Parameter *param, bool, memory::Root *parent_alloc);
+};
+
+
 } /* namespace optimizer */
 
 } /* namespace drizzled */
@@ -71,6 +71,7 @@ enum engine_flag_bits {
   HTON_BIT_SKIP_STORE_LOCK,
   HTON_BIT_SCHEMA_DICTIONARY,
   HTON_BIT_FOREIGN_KEYS,
+  HTON_BIT_SHARED_SNAPSHOT,           // A transaction can start on the snapshot of another session
   HTON_BIT_SIZE
 };
 
@@ -100,6 +101,7 @@ static const std::bitset<HTON_BIT_SIZE> HTON_HAS_CHECKSUM(1 << HTON_BIT_HAS_CHEC
 static const std::bitset<HTON_BIT_SIZE> HTON_SKIP_STORE_LOCK(1 << HTON_BIT_SKIP_STORE_LOCK);
 static const std::bitset<HTON_BIT_SIZE> HTON_HAS_SCHEMA_DICTIONARY(1 << HTON_BIT_SCHEMA_DICTIONARY);
 static const std::bitset<HTON_BIT_SIZE> HTON_HAS_FOREIGN_KEYS(1 << HTON_BIT_FOREIGN_KEYS);
+static const std::bitset<HTON_BIT_SIZE> HTON_SHARED_SNAPSHOT(1 << HTON_BIT_SHARED_SNAPSHOT);
 
 
 namespace plugin {
@@ -119,7 +119,7 @@ int ReadRecord::init_read_record(Session *session_arg,
     read_record= table->sort.addon_field ? rr_unpack_from_tempfile : rr_from_tempfile;
 
     io_cache=tempfile;
-    io_cache->reinit_io_cache(internal::READ_CACHE,0L,0,0);
+    io_cache->reinit_io_cache(internal::READ_CACHE,0L,1,0);
     ref_pos=table->cursor->ref;
     if (!table->cursor->inited)
     {
@@ -163,7 +163,10 @@ int ReadRecord::init_read_record(Session *session_arg,
       return error;
 
     cache_pos=table->sort.record_pointers;
-    cache_end= cache_pos+ table->sort.found_records * ref_length;
+    if (table->sort.addon_field && table->sort.packed_addons)
+      cache_end= cache_pos + table->sort.record_pointers_length;
+    else
+      cache_end= cache_pos+ table->sort.found_records * ref_length;
     read_record= (table->sort.addon_field ?  rr_unpack_from_buffer : rr_from_pointers);
   }
   else
@@ -346,9 +349,19 @@ static int rr_from_tempfile(ReadRecord *info)
 */
 static int rr_unpack_from_tempfile(ReadRecord *info)
 {
-  if (info->io_cache->read(info->rec_buf, info->ref_length))
-    return -1;
   Table *table= info->table;
+  if (table->sort.packed_addons)
+  {
+    /* The record starts with its length, ref_length is the longest */
+    if (info->io_cache->read(info->rec_buf, 2))
+      return -1;
+    uint32_t length= uint2korr(info->rec_buf);
+    if (length < 2 || length > info->ref_length ||
+        info->io_cache->read(info->rec_buf + 2, length - 2))
+      return -1;
+  }
+  else if (info->io_cache->read(info->rec_buf, info->ref_length))
+    return -1;
   (*table->sort.unpack)(table->sort.addon_field, info->rec_buf);
 
   return 0;
@@ -401,7 +414,10 @@ static int rr_unpack_from_buffer(ReadRecord *info)
     return -1;                      /* End of buffer */
   Table *table= info->table;
   (*table->sort.unpack)(table->sort.addon_field, info->cache_pos);
-  info->cache_pos+= info->ref_length;
+  if (table->sort.packed_addons)
+    info->cache_pos+= uint2korr(info->cache_pos);
+  else
+    info->cache_pos+= info->ref_length;
 
   return 0;
 }
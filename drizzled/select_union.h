@@ -31,8 +31,29 @@ class select_union :public select_result_interceptor
   Tmp_Table_Param tmp_table_param;
 public:
   Table *table;
+  /**
+    Result the rows are passed on to as they arrive, see start_streaming().
+    NULL when the rows are only stored in table and read back from it once
+    all selects of the union have run.
+  */
+  select_result *stream_result;
+  /** Fields of table sent to stream_result */
+  List<Item> *stream_items;
+  /**
+    Whether rows are written to table. When streaming, table only serves
+    to drop duplicates, so this is false for UNION ALL parts.
+  */
+  bool store_rows;
+  /** Number of rows passed on to stream_result */
+  ha_rows streamed_rows;
 
-  select_union() :table(0) { }
+  select_union() :
+    table(0),
+    stream_result(0),
+    stream_items(0),
+    store_rows(true),
+    streamed_rows(0)
+  { }
   ~select_union() { }
 
   int prepare(List<Item> &list, Select_Lex_Unit *u);
@@ -42,7 +63,11 @@ public:
   void cleanup();
   bool create_result_table(Session *session, List<Item> *column_types,
                            bool is_distinct, uint64_t options,
-                           const char *alias);
+                           const char *alias,
+                           uint32_t *lookup_fields= NULL,
+                           uint32_t lookup_field_count= 0);
+  void start_streaming(select_result *result, List<Item> *items,
+                       bool is_distinct);
 };
 
 } /* namespace drizzled */
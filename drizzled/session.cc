@@ -64,6 +64,7 @@
 #include <drizzled/select_to_file.h>
 #include <drizzled/session.h>
 #include <drizzled/session/cache.h>
+#include <drizzled/session/memory_usage.h>
 #include <drizzled/session/state.h>
 #include <drizzled/session/table_messages.h>
 #include <drizzled/session/times.h>
@@ -149,6 +150,7 @@ public:
   typedef std::map<std::string, plugin::EventObserverList*> schema_event_observers_t;
 
   impl_c(Session& session) :
+    memory_usage(session),
     open_tables(session, g_refresh_version),
     schema(boost::make_shared<std::string>())
   {
@@ -170,6 +172,7 @@ public:
     the same lex. (@see mysql_parse for details).
   */
   LEX lex;
+  session::MemoryUsage memory_usage;
   Open_tables_state open_tables;
   properties_t properties;
   schema_event_observers_t schema_event_observers;
@@ -202,6 +205,7 @@ Session::Session(plugin::Client *client_arg, catalog::Instance::shared_ptr catal
 	transaction(impl_->transaction),
   open_tables(impl_->open_tables),
 	times(impl_->times),
+  memory_usage(impl_->memory_usage),
   first_successful_insert_id_in_prev_stmt(0),
   first_successful_insert_id_in_cur_stmt(0),
   limit_found_rows(0),
@@ -230,6 +234,7 @@ Session::Session(plugin::Client *client_arg, catalog::Instance::shared_ptr catal
   session_event_observers(NULL),
   xa_id(0),
   concurrent_execute_allowed(true),
+  snapshot_source(NULL),
   tablespace_op(false),
   use_usage(false),
   security_ctx(identifier::User::make_shared()),
@@ -244,6 +249,7 @@ Session::Session(plugin::Client *client_arg, catalog::Instance::shared_ptr catal
     will be re-initialized in init_for_queries().
   */
   mem.init(memory::ROOT_MIN_BLOCK_SIZE);
+  mem.tracker= &memory_usage;
   cuted_fields= sent_row_count= row_count= 0L;
   // Must be reset to handle error with Session's created for init of mysqld
   lex().current_select= 0;
@@ -803,6 +809,9 @@ bool Session::startTransaction(start_transaction_option_t opt)
   options|= OPTION_BEGIN;
   server_status|= SERVER_STATUS_IN_TRANS;
 
+  if (snapshot_source && opt == START_TRANS_NO_OPTIONS)
+    opt= START_TRANS_OPT_WITH_SHARED_SNAPSHOT;
+
   if (plugin::TransactionalStorageEngine::notifyStartTransaction(this, opt))
     return false;
   return true;
@@ -879,6 +888,21 @@ void Session::send_explain_fields(select_result *result)
   }
   item->maybe_null= 1;
   field_list.push_back(new Item_empty_string("Extra", 255, cs));
+  if (lex().describe & DESCRIBE_ANALYZE)
+  {
+    field_list.push_back(item= new Item_return_int("r_loops", 10, DRIZZLE_TYPE_LONGLONG));
+    item->maybe_null= 1;
+    field_list.push_back(item= new Item_return_int("r_rows", 10, DRIZZLE_TYPE_LONGLONG));
+    item->maybe_null= 1;
+    field_list.push_back(item= new Item_return_int("r_examined", 10, DRIZZLE_TYPE_LONGLONG));
+    item->maybe_null= 1;
+    field_list.push_back(item= new Item_float("r_engine_ms", 0.1234, 3, 10));
+    item->maybe_null= 1;
+    field_list.push_back(item= new Item_float("r_cond_ms", 0.1234, 3, 10));
+    item->maybe_null= 1;
+    field_list.push_back(item= new Item_empty_string("r_extra", 255, cs));
+    item->maybe_null= 1;
+  }
   result->send_fields(field_list);
 }
 
@@ -1485,6 +1509,8 @@ void Tmp_Table_Param::init()
   quick_group= 1;
   table_charset= 0;
   precomputed_group_by= 0;
+  lookup_fields= 0;
+  lookup_field_count= 0;
 }
 
 void Tmp_Table_Param::cleanup()
@@ -1499,6 +1525,9 @@ void Tmp_Table_Param::cleanup()
 
 void Session::send_kill_message() const
 {
+  /* MemoryUsage reported the error where the limit was crossed */
+  if (memory_usage.limitExceeded())
+    return;
   drizzled::error_t err= static_cast<drizzled::error_t>(killed_errno());
   if (err != EE_OK)
     my_message(err, ER(err), MYF(0));
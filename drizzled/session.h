@@ -348,6 +348,7 @@ public:
   session::Transactions& transaction;
   Open_tables_state& open_tables;
 	session::Times& times;
+  session::MemoryUsage& memory_usage;
 
   Field *dup_field;
   sigset_t signals;
@@ -364,6 +365,21 @@ public:
     return concurrent_execute_allowed;
   }
 
+  /**
+    Make the transactions of this session read the snapshot of another
+    session, that waits for this one to end. Used for the sessions that
+    run a part of a statement of source.
+  */
+  void setSnapshotSource(Session *source)
+  {
+    snapshot_source= source;
+  }
+
+  Session *getSnapshotSource() const
+  {
+    return snapshot_source;
+  }
+
   /*
     ALL OVER THIS FILE, "insert_id" means "*automatically generated* value for
     insertion into an auto_increment column".
@@ -1100,6 +1116,7 @@ private:
   const char *proc_info;
   bool abort_on_warning;
   bool concurrent_execute_allowed;
+  Session *snapshot_source;
   bool tablespace_op; /**< This is true in DISCARD/IMPORT TABLESPACE */
   bool use_usage;
   rusage usage;
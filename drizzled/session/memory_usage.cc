@@ -0,0 +1,92 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+#include <drizzled/session/memory_usage.h>
+#include <drizzled/error.h>
+#include <drizzled/session.h>
+
+namespace drizzled {
+namespace session {
+
+/* Raise counter to value unless another thread raised it further */
+static void raise_to(atomic<uint64_t> &counter, uint64_t value)
+{
+  uint64_t seen= counter;
+  while (value > seen && not counter.compare_and_swap(value, seen))
+    seen= counter;
+}
+
+/* Lower counter to value unless another thread lowered it further */
+static void lower_to(atomic<uint64_t> &counter, uint64_t value)
+{
+  uint64_t seen= counter;
+  while (value < seen && not counter.compare_and_swap(value, seen))
+    seen= counter;
+}
+
+MemoryUsage::MemoryUsage(Session& session_arg) :
+  session(session_arg),
+  statement_limit(0),
+  limit_exceeded(false)
+{
+  current= 0;
+  peak= 0;
+  statement_start= 0;
+  statement_peak= 0;
+}
+
+bool MemoryUsage::allocated(size_t size)
+{
+  uint64_t now= current.add_and_fetch(size);
+  raise_to(peak, now);
+  raise_to(statement_peak, now);
+
+  if (statement_limit && now - statement_start > statement_limit)
+  {
+    if (not limit_exceeded)
+    {
+      /* Set first, reporting the error may allocate again */
+      limit_exceeded= true;
+      session.setKilled(Session::KILL_QUERY);
+      my_error(ER_STATEMENT_MEMORY_LIMIT, MYF(0), statement_limit);
+    }
+    return false;
+  }
+  return true;
+}
+
+void MemoryUsage::freed(size_t size)
+{
+  uint64_t now= current.add_and_fetch(uint64_t(0) - size);
+  /* Memory of an earlier statement freed by this one */
+  lower_to(statement_start, now);
+}
+
+void MemoryUsage::startStatement(uint64_t limit)
+{
+  uint64_t now= current;
+  statement_start= now;
+  statement_peak= now;
+  statement_limit= limit;
+  limit_exceeded= false;
+}
+
+} /* namespace session */
+} /* namespace drizzled */
@@ -0,0 +1,99 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#pragma once
+
+#include <drizzled/atomics.h>
+#include <drizzled/common_fwd.h>
+#include <drizzled/memory/root.h>
+#include <drizzled/visibility.h>
+
+namespace drizzled {
+namespace session {
+
+/**
+ * @brief
+ * Bytes of memory in use by a session
+ *
+ * @details
+ * Counts the blocks of the session mem_root, sort buffers, join caches
+ * and internal MEMORY temporary tables. The allocation that takes a
+ * statement over its limit reports ER_STATEMENT_MEMORY_LIMIT and kills
+ * the statement with KILL_QUERY. Sort buffers, join caches and MEMORY
+ * table blocks are then refused, mem_root blocks are not, because the
+ * callers of Root::alloc() cannot handle a failure.
+ *
+ * The counters are atomic: threads working for the session may allocate
+ * concurrently, and other threads read them for the data dictionary.
+ */
+class DRIZZLED_API MemoryUsage : public memory::Tracker
+{
+public:
+  MemoryUsage(Session&);
+
+  bool allocated(size_t size);
+  void freed(size_t size);
+
+  /**
+   * Start counting for a new statement
+   *
+   * @param limit Bytes the statement may allocate, 0 for no limit
+   */
+  void startStatement(uint64_t limit);
+
+  uint64_t getCurrent() const
+  {
+    return current;
+  }
+
+  uint64_t getPeak() const
+  {
+    return peak;
+  }
+
+  /** Most bytes in use during the current or last statement */
+  uint64_t getStatementPeak() const
+  {
+    uint64_t start= statement_start;
+    uint64_t statement_max= statement_peak;
+    return statement_max > start ? statement_max - start : 0;
+  }
+
+  uint64_t getStatementLimit() const
+  {
+    return statement_limit;
+  }
+
+  bool limitExceeded() const
+  {
+    return limit_exceeded;
+  }
+
+private:
+  Session& session;
+  atomic<uint64_t> current;
+  atomic<uint64_t> peak;
+  atomic<uint64_t> statement_start; /**< current when the statement started */
+  atomic<uint64_t> statement_peak;
+  uint64_t statement_limit;
+  bool limit_exceeded;
+};
+
+} /* namespace session */
+} /* namespace drizzled */
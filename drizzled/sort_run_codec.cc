@@ -0,0 +1,243 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#include <drizzled/sort_run_codec.h>
+#include <drizzled/korr.h>
+
+#include <cstring>
+
+namespace drizzled {
+
+const size_t SortRunCodec::HEADER_LENGTH;
+const uint32_t SortRunCodec::MIN_REPEAT;
+
+namespace {
+
+const uint32_t MAX_LITERAL= 128;
+const uint32_t MAX_REPEAT= 63 + SortRunCodec::MIN_REPEAT;
+const size_t MAX_VARINT_LENGTH= 5;
+
+/* First control byte of repeats of one and two byte units */
+const uint32_t REPEAT_BYTE= 128;
+const uint32_t REPEAT_PAIR= 192;
+
+unsigned char *store_varint(unsigned char *to, uint32_t value)
+{
+  while (value >= 0x80)
+  {
+    *to++= (unsigned char) (value | 0x80);
+    value>>= 7;
+  }
+  *to++= (unsigned char) value;
+  return to;
+}
+
+const unsigned char *read_varint(const unsigned char *from,
+                                 const unsigned char *end, uint32_t *value)
+{
+  uint32_t result= 0;
+  for (uint32_t shift= 0; from < end && shift < 35; shift+= 7)
+  {
+    unsigned char byte= *from++;
+    result|= (uint32_t) (byte & 0x7f) << shift;
+    if (not (byte & 0x80))
+    {
+      *value= result;
+      return from;
+    }
+  }
+  return NULL;
+}
+
+/* Times the unit of width bytes at from repeats, at most MAX_REPEAT */
+uint32_t repeat_count(const unsigned char *from, const unsigned char *end,
+                      uint32_t width)
+{
+  uint32_t count= 1;
+  for (const unsigned char *pos= from + width;
+       count < MAX_REPEAT && pos + width <= end && not memcmp(pos, from, width);
+       pos+= width)
+    count++;
+  return count;
+}
+
+/*
+  The repeat at from worth encoding that covers the most bytes, 0 if
+  there is none. Multi byte collations pad with two byte units.
+*/
+uint32_t best_repeat(const unsigned char *from, const unsigned char *end,
+                     uint32_t *width)
+{
+  uint32_t bytes= repeat_count(from, end, 1);
+  uint32_t pairs= repeat_count(from, end, 2);
+  if (pairs >= SortRunCodec::MIN_REPEAT && pairs * 2 > bytes)
+  {
+    *width= 2;
+    return pairs;
+  }
+  if (bytes >= SortRunCodec::MIN_REPEAT)
+  {
+    *width= 1;
+    return bytes;
+  }
+  return 0;
+}
+
+unsigned char *pack_bytes(const unsigned char *from, const unsigned char *end,
+                          unsigned char *to)
+{
+  uint32_t width;
+  while (from < end)
+  {
+    uint32_t repeat= best_repeat(from, end, &width);
+    if (repeat)
+    {
+      *to++= (unsigned char) ((width == 1 ? REPEAT_BYTE : REPEAT_PAIR) +
+                              repeat - SortRunCodec::MIN_REPEAT);
+      memcpy(to, from, width);
+      to+= width;
+      from+= repeat * width;
+      continue;
+    }
+
+    /* Literal bytes up to the next repeat worth encoding */
+    const unsigned char *start= from++;
+    while (from < end && (uint32_t) (from - start) < MAX_LITERAL &&
+           not best_repeat(from, end, &width))
+      from++;
+    uint32_t literal= (uint32_t) (from - start);
+    *to++= (unsigned char) (literal - 1);
+    memcpy(to, start, literal);
+    to+= literal;
+  }
+  return to;
+}
+
+} /* namespace */
+
+size_t SortRunCodec::max_block_length(uint32_t count, uint32_t rec_length)
+{
+  size_t record= MAX_VARINT_LENGTH + rec_length + rec_length / MAX_LITERAL + 1;
+  return HEADER_LENGTH + (size_t) count * record;
+}
+
+size_t SortRunCodec::encode(const unsigned char *from, uint32_t count,
+                            uint32_t rec_length, unsigned char *to)
+{
+  size_t raw_length= (size_t) count * rec_length;
+  unsigned char *pos= to + HEADER_LENGTH;
+  const unsigned char *prev= NULL;
+
+  for (uint32_t x= 0; x < count; x++, prev= from, from+= rec_length)
+  {
+    uint32_t prefix= 0;
+    if (prev)
+    {
+      while (prefix < rec_length && from[prefix] == prev[prefix])
+        prefix++;
+    }
+    pos= store_varint(pos, prefix);
+    pos= pack_bytes(from + prefix, from + rec_length, pos);
+  }
+
+  size_t length= (size_t) (pos - to) - HEADER_LENGTH;
+  bool packed= true;
+  if (length >= raw_length)
+  {
+    /* Nothing to gain, keep the records as they are */
+    memcpy(to + HEADER_LENGTH, from - raw_length, raw_length);
+    length= raw_length;
+    packed= false;
+  }
+  int4store(to, (uint32_t) length);
+  int4store(to + 4, count);
+  to[8]= packed;
+  return HEADER_LENGTH + length;
+}
+
+size_t SortRunCodec::read_header(const unsigned char *header, uint32_t *count,
+                                 bool *packed)
+{
+  *count= uint4korr(header + 4);
+  *packed= header[8] != 0;
+  return uint4korr(header);
+}
+
+bool SortRunCodec::decode(const unsigned char *from, size_t length, bool packed,
+                          uint32_t count, uint32_t rec_length, unsigned char *to)
+{
+  if (not packed)
+  {
+    if (length != (size_t) count * rec_length)
+      return true;
+    memcpy(to, from, length);
+    return false;
+  }
+
+  const unsigned char *end= from + length;
+  for (uint32_t x= 0; x < count; x++, to+= rec_length)
+  {
+    uint32_t prefix;
+    if (not (from= read_varint(from, end, &prefix)) ||
+        prefix > rec_length || (x == 0 && prefix))
+      return true;
+    if (prefix)
+      memcpy(to, to - rec_length, prefix);
+
+    unsigned char *pos= to + prefix;
+    unsigned char *record_end= to + rec_length;
+    while (pos < record_end)
+    {
+      if (from >= end)
+        return true;
+      uint32_t control= *from++;
+      if (control < REPEAT_BYTE)
+      {
+        uint32_t literal= control + 1;
+        if (literal > (size_t) (record_end - pos) || literal > (size_t) (end - from))
+          return true;
+        memcpy(pos, from, literal);
+        from+= literal;
+        pos+= literal;
+      }
+      else if (control < REPEAT_PAIR)
+      {
+        uint32_t repeat= control - REPEAT_BYTE + MIN_REPEAT;
+        if (repeat > (size_t) (record_end - pos) || from >= end)
+          return true;
+        memset(pos, *from++, repeat);
+        pos+= repeat;
+      }
+      else
+      {
+        uint32_t repeat= control - REPEAT_PAIR + MIN_REPEAT;
+        if (repeat * 2 > (size_t) (record_end - pos) || end - from < 2)
+          return true;
+        for (; repeat--; pos+= 2)
+          memcpy(pos, from, 2);
+        from+= 2;
+      }
+    }
+  }
+  return from != end;
+}
+
+} /* namespace drizzled */
@@ -0,0 +1,88 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace drizzled {
+
+/**
+  Block format of compressed filesort runs.
+
+  A run is stored as a sequence of blocks, each holding a whole number of
+  fixed length sort records. A block starts with a header of
+  HEADER_LENGTH bytes: the length of the data that follows, the number of
+  records and whether the data is packed or the plain records.
+
+  Packed records are stored one after the other. Each starts with the
+  number of leading bytes it shares with the record before it in the
+  block, as a variable length integer, followed by the rest of the
+  record as a sequence of control bytes:
+
+  - 0 to 127: that many plus one literal bytes follow.
+  - 128 to 191: one byte follows, repeated that many minus 128 plus
+    MIN_REPEAT times.
+  - 192 to 255: two bytes follow, repeated that many minus 192 plus
+    MIN_REPEAT times.
+
+  Sorted records share long prefixes, and sort keys are padded with
+  repeats of the weight of a space, one or two bytes wide. So this removes
+  most of the bytes filesort writes and reads again, at a cost close to
+  a memcpy.
+
+  The first record of a block never shares a prefix, so a block can be
+  decoded without the blocks before it.
+*/
+class SortRunCodec
+{
+public:
+  static const size_t HEADER_LENGTH= 9;
+  static const uint32_t MIN_REPEAT= 3;
+
+  /** Upper limit of the length of a block holding count records */
+  static size_t max_block_length(uint32_t count, uint32_t rec_length);
+
+  /**
+    Encode count records of rec_length bytes, stored one after the other
+    at from, as one block in to. to must have room for
+    max_block_length(count, rec_length) bytes.
+
+    @return Length of the block, header included
+  */
+  static size_t encode(const unsigned char *from, uint32_t count,
+                       uint32_t rec_length, unsigned char *to);
+
+  /** Read a block header, returns the length of the data that follows */
+  static size_t read_header(const unsigned char *header, uint32_t *count,
+                            bool *packed);
+
+  /**
+    Decode the data of a block, without its header, into count records of
+    rec_length bytes at to.
+
+    @retval true  The data is corrupt
+    @retval false OK
+  */
+  static bool decode(const unsigned char *from, size_t length, bool packed,
+                     uint32_t count, uint32_t rec_length, unsigned char *to);
+};
+
+} /* namespace drizzled */
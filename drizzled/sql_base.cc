@@ -40,6 +40,7 @@
 #include <drizzled/sql_base.h>
 #include <drizzled/show.h>
 #include <drizzled/item/cmpfunc.h>
+#include <drizzled/item/direct_ref.h>
 #include <drizzled/replication_services.h>
 #include <drizzled/check_stack_overrun.h>
 #include <drizzled/lock.h>
@@ -1916,6 +1917,9 @@ find_field_in_table(Session *session, Table *table, const char *name, uint32_t l
   find_field_in_table_ref()
   session			   [in]  thread Cursor
   table_list		   [in]  table reference to search
+  context                [in]  name resolution context of the item that
+  is resolved, used for the references to merged
+  derived table columns
   name		   [in]  name of field
   length		   [in]  field length of name
   item_name              [in]  name of item if it will be created (VIEW)
@@ -1952,6 +1956,7 @@ find_field_in_table(Session *session, Table *table, const char *name, uint32_t l
 
 Field *
 find_field_in_table_ref(Session *session, TableList *table_list,
+                        Name_resolution_context *context,
                         const char *name, uint32_t length,
                         const char *item_name, const char *db_name,
                         const char *table_name, Item **ref,
@@ -1982,7 +1987,7 @@ find_field_in_table_ref(Session *session, TableList *table_list,
     TODO-> Ensure that table_name, db_name and tables->db always points to something !
   */
   if (/* Exclude nested joins. */
-      (!table_list->getNestedJoin()) &&
+      (!table_list->getNestedJoin() || table_list->is_merged_derived()) &&
       /* Include merge views and information schema tables. */
       /*
         Test if the field qualifiers match the table reference we plan
@@ -1996,7 +2001,29 @@ find_field_in_table_ref(Session *session, TableList *table_list,
 
   *actual_table= NULL;
 
-  if (!table_list->getNestedJoin())
+  if (table_list->is_merged_derived())
+  {
+    /* 'table_list' is a derived table merged into the outer query. */
+    for (Field_translator *transl= table_list->field_translation;
+         transl < table_list->field_translation_end;
+         transl++)
+    {
+      if (system_charset_info->strcasecmp(transl->name, name))
+        continue;
+      Item *item= new Item_direct_ref(context, &transl->item,
+                                      table_list->alias, transl->name);
+      if (not item)
+        return NULL;
+      /* Keep the alias the column was given in the outer select list */
+      if (*ref && not (*ref)->is_autogenerated_name)
+        item->set_name((*ref)->name);
+      *ref= item;
+      fld= view_ref_found;
+      *actual_table= table_list;
+      break;
+    }
+  }
+  else if (!table_list->getNestedJoin())
   {
     /* 'table_list' is a stored table. */
     assert(table_list->table);
@@ -2020,7 +2047,8 @@ find_field_in_table_ref(Session *session, TableList *table_list,
       TableList *table;
       while ((table= it++))
       {
-        if ((fld= find_field_in_table_ref(session, table, name, length, item_name,
+        if ((fld= find_field_in_table_ref(session, table, context,
+                                          name, length, item_name,
                                           db_name, table_name, ref,
                                           allow_rowid,
                                           cached_field_index_ptr,
@@ -2154,7 +2182,8 @@ find_field_in_tables(Session *session, Item_ident *item,
       found= find_field_in_table(session, table_ref->table, name, length,
                                  true, &(item->cached_field_index));
     else
-      found= find_field_in_table_ref(session, table_ref, name, length, item->name,
+      found= find_field_in_table_ref(session, table_ref, item->context,
+                                     name, length, item->name,
                                      NULL, NULL, ref,
                                      true, &(item->cached_field_index),
                                      register_tree_change,
@@ -2198,7 +2227,8 @@ find_field_in_tables(Session *session, Item_ident *item,
   for (; cur_table != last_table ;
        cur_table= cur_table->next_name_resolution_table)
   {
-    Field *cur_field= find_field_in_table_ref(session, cur_table, name, length,
+    Field *cur_field= find_field_in_table_ref(session, cur_table,
+                                              item->context, name, length,
                                               item->name, db, table_name, ref,
                                               allow_rowid,
                                               &(item->cached_field_index),
@@ -3235,6 +3265,12 @@ static TableList **make_leaves_list(TableList **list, TableList *tables)
 {
   for (TableList *table= tables; table; table= table->next_local)
   {
+    if (table->is_merged_derived())
+    {
+      /* The tables of a merged derived table are joined in its place */
+      list= make_leaves_list(list, table->derived->first_select()->get_table_list());
+    }
+    else
     {
       *list= table;
       list= &table->next_leaf;
@@ -3243,6 +3279,41 @@ static TableList **make_leaves_list(TableList **list, TableList *tables)
   return list;
 }
 
+/*
+  Refresh the tables used by the expressions of merged derived tables
+
+  SYNOPSIS
+  update_merged_derived_used_tables()
+  join_list     list of table references of a join (nest)
+
+  NOTE
+  The columns, the WHERE clause and the ON conditions of a derived SELECT
+  merged into the upper one were fixed against the table numbers of the
+  derived SELECT. Recompute what they use once the tables have their
+  numbers in the upper join.
+*/
+
+static void update_merged_derived_used_tables(List<TableList> *join_list)
+{
+  List<TableList>::iterator it(join_list->begin());
+  while (TableList *table= it++)
+  {
+    if (table->on_expr && table->on_expr->fixed)
+      table->on_expr->update_used_tables();
+    if (table->is_merged_derived())
+    {
+      for (Field_translator *transl= table->field_translation;
+           transl < table->field_translation_end;
+           transl++)
+        transl->item->update_used_tables();
+      if (Item *where= table->derived->first_select()->where)
+        where->update_used_tables();
+    }
+    if (table->getNestedJoin())
+      update_merged_derived_used_tables(&table->getNestedJoin()->join_list);
+  }
+}
+
 /*
   prepare tables
 
@@ -3308,6 +3379,15 @@ bool setup_tables(Session *session, Name_resolution_context *context,
     return 1;
   }
 
+  for (TableList *table_list= tables; table_list; table_list= table_list->next_local)
+  {
+    if (table_list->is_merged_derived())
+    {
+      update_merged_derived_used_tables(from_clause);
+      break;
+    }
+  }
+
   /* Precompute and store the row types of NATURAL/USING joins. */
   if (setup_natural_join_row_types(session, from_clause, context))
     return 1;
@@ -3433,7 +3513,7 @@ insert_fields(Session *session, Name_resolution_context *context, const char *db
       fields of a single table reference, because 'tables' is a leaf (for
       name resolution purposes).
     */
-    field_iterator.set(tables);
+    field_iterator.set(tables, context);
 
     for (; !field_iterator.end_of_fields(); field_iterator.next())
     {
@@ -24,6 +24,8 @@
 #include <drizzled/sql_select.h>
 #include <drizzled/session.h>
 #include <drizzled/open_tables_state.h>
+#include <drizzled/nested_join.h>
+#include <drizzled/item/cmpfunc.h>
 
 namespace drizzled {
 
@@ -68,6 +70,228 @@ out:
   return res;
 }
 
+/*
+  Test that all joins a list of tables takes part in are plain inner joins
+*/
+static bool only_inner_joins(TableList *tables)
+{
+  for (TableList *table= tables; table; table= table->next_local)
+  {
+    for (TableList *embedded= table; embedded; embedded= embedded->getEmbedding())
+    {
+      if (embedded->outer_join || embedded->natural_join ||
+          embedded->is_natural_join || embedded->join_using_fields)
+        return false;
+    }
+  }
+  return true;
+}
+
+/*
+  Check if a derived table can be merged into the upper SELECT
+
+  SYNOPSIS
+    derived_mergeable()
+    lex                 LEX for this thread
+    orig_table_list     TableList for the upper SELECT
+
+  DESCRIPTION
+    A derived table is merged if its SELECT is a single join with an
+    optional WHERE clause: no UNION, GROUP BY, aggregates, DISTINCT,
+    HAVING, ORDER BY, LIMIT or subqueries, no RAND() in the select list
+    and no duplicate column names (which are reported when the table is
+    materialized). Both the derived and the upper SELECT may only use
+    inner joins, as the WHERE clause of the derived table is moved to
+    the ON condition of the join nest that replaces it.
+
+  RETURN
+    true   The derived table can be merged
+    false  The derived table has to be materialized
+*/
+static bool derived_mergeable(LEX *lex, TableList *orig_table_list)
+{
+  Select_Lex_Unit *unit= orig_table_list->derived;
+  Select_Lex *first_select= unit->first_select();
+
+  if (lex->sql_command != SQLCOM_SELECT ||
+      unit->is_union() || unit->fake_select_lex ||
+      first_select->group_list.size() || first_select->with_sum_func ||
+      first_select->having || (first_select->options & SELECT_DISTINCT) ||
+      first_select->order_list.size() || first_select->explicit_limit ||
+      first_select->olap != UNSPECIFIED_OLAP_TYPE ||
+      first_select->first_inner_unit() ||
+      first_select->table_list.size() == 0 ||
+      not first_select->join)
+    return false;
+
+  List<Item>::iterator it(first_select->item_list.begin());
+  while (Item *item= it++)
+  {
+    if (item->used_tables() & RAND_TABLE_BIT)
+      return false;
+    List<Item>::iterator prev_it(first_select->item_list.begin());
+    for (Item *prev= prev_it++; prev != item; prev= prev_it++)
+    {
+      if (not system_charset_info->strcasecmp(prev->name, item->name))
+        return false;
+    }
+  }
+
+  return only_inner_joins(orig_table_list->select_lex->get_table_list()) &&
+         only_inner_joins(first_select->get_table_list());
+}
+
+/*
+  Merge the SELECT of a derived table into the upper SELECT
+
+  SYNOPSIS
+    derived_merge()
+    session             Thread handle
+    orig_table_list     TableList for the upper SELECT
+
+  IMPLEMENTATION
+    The top level tables of the derived SELECT become the members of a
+    nested join that takes the place of the derived table, and its WHERE
+    clause becomes the ON condition of that nest. The select list is kept
+    in TableList::field_translation, the upper SELECT resolves the columns
+    of the derived table against it (see find_field_in_table_ref()).
+    The derived SELECT is then removed from the tree of SELECTs, so no
+    temporary table is created or filled for it.
+*/
+static void derived_merge(Session *session, TableList *orig_table_list)
+{
+  Select_Lex_Unit *unit= orig_table_list->derived;
+  Select_Lex *first_select= unit->first_select();
+
+  NestedJoin *nested_join= new (session->mem) NestedJoin;
+  List<TableList>::iterator ti(first_select->top_join_list.begin());
+  while (TableList *table= ti++)
+  {
+    table->setEmbedding(orig_table_list);
+    table->setJoinList(&nested_join->join_list);
+    nested_join->join_list.push_back(table);
+  }
+  orig_table_list->setNestedJoin(nested_join);
+
+  Field_translator *transl=
+    new (session->mem) Field_translator[first_select->item_list.size()];
+  orig_table_list->field_translation= transl;
+  List<Item>::iterator it(first_select->item_list.begin());
+  while (Item *item= it++)
+  {
+    transl->item= item;
+    transl->name= item->name;
+    transl++;
+  }
+  orig_table_list->field_translation_end= transl;
+
+  /* The WHERE clause as fixed by Join::prepare() */
+  first_select->where= first_select->join->conds;
+  orig_table_list->on_expr= and_conds(orig_table_list->on_expr,
+                                      first_select->where);
+
+  unit->cleanup();
+  unit->exclude_level();
+}
+
+/*
+  Collect the columns of a derived table compared with '=' in a condition
+*/
+static void add_lookup_fields(Item *cond, TableList *orig_table_list,
+                              uint32_t *fields, uint32_t *count)
+{
+  if (cond->type() == Item::COND_ITEM &&
+      ((Item_cond*) cond)->functype() == Item_func::COND_AND_FUNC)
+  {
+    List<Item>::iterator li(((Item_cond*) cond)->argument_list()->begin());
+    while (Item *item= li++)
+      add_lookup_fields(item, orig_table_list, fields, count);
+    return;
+  }
+  if (cond->type() != Item::FUNC_ITEM ||
+      (((Item_func*) cond)->functype() != Item_func::EQ_FUNC &&
+       ((Item_func*) cond)->functype() != Item_func::EQUAL_FUNC))
+    return;
+
+  Item **args= ((Item_func*) cond)->arguments();
+  bool is_derived_column[2];
+  for (uint32_t i= 0; i < 2; i++)
+  {
+    is_derived_column[i]= (args[i]->type() == Item::FIELD_ITEM &&
+                           ((Item_field*) args[i])->table_name &&
+                           not table_alias_charset->strcasecmp(((Item_field*) args[i])->table_name,
+                                                               orig_table_list->alias));
+  }
+  /* Comparing two columns of the derived table can't use a lookup */
+  if (is_derived_column[0] == is_derived_column[1])
+    return;
+
+  Item_field *column= (Item_field*) args[is_derived_column[0] ? 0 : 1];
+  uint32_t position= 0;
+  List<Item>::iterator it(orig_table_list->derived->types.begin());
+  while (Item *item= it++)
+  {
+    if (not system_charset_info->strcasecmp(item->name, column->field_name))
+      break;
+    position++;
+  }
+  if (position == orig_table_list->derived->types.size())
+    return;
+
+  for (uint32_t i= 0; i < *count; i++)
+  {
+    if (fields[i] == position)
+      return;
+  }
+  if (*count < MAX_KEY)
+    fields[(*count)++]= position;
+}
+
+/*
+  Find the columns of a derived table that are worth indexing
+
+  SYNOPSIS
+    derived_lookup_fields()
+    session             Thread handle
+    orig_table_list     TableList for the upper SELECT
+    count          OUT  Number of columns found
+
+  DESCRIPTION
+    Looks for '=' comparisons of a column of the derived table with an
+    expression that does not use the derived table in the WHERE and ON
+    conditions of the upper SELECT. These are not fixed yet, so only
+    column references qualified with the alias of the derived table are
+    recognized. Each of the columns found gets an index of its own in the
+    temporary table (see create_tmp_table()), so that the derived table
+    can be read with ref access in the upper join.
+
+  RETURN
+    Array of column positions, NULL if no column was found
+*/
+static uint32_t *derived_lookup_fields(Session *session,
+                                       TableList *orig_table_list,
+                                       uint32_t *count)
+{
+  Select_Lex *select_lex= orig_table_list->select_lex;
+  size_t max_count= std::min((size_t) MAX_KEY,
+                             orig_table_list->derived->types.size());
+  uint32_t *fields= (uint32_t*) session->mem.alloc(sizeof(uint32_t) * max_count);
+
+  *count= 0;
+  if (select_lex->where)
+    add_lookup_fields(select_lex->where, orig_table_list, fields, count);
+  for (TableList *table= select_lex->get_table_list(); table; table= table->next_local)
+  {
+    for (TableList *embedded= table; embedded; embedded= embedded->getEmbedding())
+    {
+      if (embedded->on_expr)
+        add_lookup_fields(embedded->on_expr, orig_table_list, fields, count);
+    }
+  }
+
+  return *count ? fields : NULL;
+}
+
 /*
   Create temporary table structure (but do not fill it)
 
@@ -78,7 +302,9 @@ out:
     orig_table_list     TableList for the upper SELECT
 
   IMPLEMENTATION
-    Derived table is resolved with temporary table.
+    A simple derived table is merged into the upper SELECT (see
+    derived_merge()), any other derived table is resolved with temporary
+    table.
 
     After table creation, the above TableList is updated with a new table.
 
@@ -92,10 +318,12 @@ out:
     false  OK
     true   Error
 */
-bool derived_prepare(Session *session, LEX *, TableList *orig_table_list)
+bool derived_prepare(Session *session, LEX *lex, TableList *orig_table_list)
 {
   Select_Lex_Unit *unit= orig_table_list->derived;
   uint64_t create_options;
+  uint32_t *lookup_fields;
+  uint32_t lookup_field_count;
   bool res= false;
   if (unit)
   {
@@ -113,6 +341,13 @@ bool derived_prepare(Session *session, LEX *, TableList *orig_table_list)
     if ((res= unit->prepare(session, derived_result, 0)))
       goto exit;
 
+    if (derived_mergeable(lex, orig_table_list))
+    {
+      derived_merge(session, orig_table_list);
+      delete derived_result;
+      return false;
+    }
+
     create_options= (first_select->options | session->options | TMP_TABLE_ALL_COLUMNS);
     /*
       Temp table is created so that it hounours if UNION without ALL is to be
@@ -124,9 +359,13 @@ bool derived_prepare(Session *session, LEX *, TableList *orig_table_list)
       !unit->union_distinct->next_select() (i.e. it is union and last distinct
       SELECT is last SELECT of UNION).
     */
+    lookup_fields= derived_lookup_fields(session, orig_table_list,
+                                         &lookup_field_count);
     if ((res= derived_result->create_result_table(session, &unit->types, false,
                                                   create_options,
-                                                  orig_table_list->alias)))
+                                                  orig_table_list->alias,
+                                                  lookup_fields,
+                                                  lookup_field_count)))
       goto exit;
 
     table= derived_result->table;
@@ -210,6 +210,7 @@ void lex_start(Session *session)
   lex->select_lex.init_order();
   lex->select_lex.group_list.clear();
   lex->describe= 0;
+  lex->explain_analyze= NULL;
   lex->derived_tables= 0;
   lex->lock_option= TL_READ;
   lex->leaf_tables_insert= 0;
@@ -1792,6 +1793,7 @@ LEX::LEX() :
     sql_command(SQLCOM_END),
     statement(NULL),
     option_type(OPT_DEFAULT),
+    explain_analyze(NULL),
     is_lex_started(0),
     cacheable(true),
     sum_expr_used(false),
@@ -60,6 +60,7 @@
 // describe/explain types
 #define DESCRIBE_NORMAL		1
 #define DESCRIBE_EXTENDED	2
+#define DESCRIBE_ANALYZE	4
 
 #ifdef DRIZZLE_SERVER
 
@@ -349,6 +350,7 @@ public:
   bool prepare(Session *session, select_result *result,
                uint64_t additional_options);
   bool exec();
+  bool can_stream_result();
   bool cleanup();
   inline void unclean() { cleaned= 0; }
   void reinit_exec_mechanism();
@@ -863,6 +865,8 @@ public:
 
   int nest_level;
   uint8_t describe;
+  /* Collects the plan and its counters while EXPLAIN ANALYZE executes */
+  optimizer::ExplainAnalyze *explain_analyze;
   /*
     A flag that indicates what kinds of derived tables are present in the
     query (0 if no derived tables, otherwise DERIVED_SUBQUERY).
@@ -56,6 +56,7 @@
 #include <drizzled/table_ident.h>
 #include <drizzled/statistics_variables.h>
 #include <drizzled/system_variables.h>
+#include <drizzled/session/memory_usage.h>
 #include <drizzled/session/times.h>
 #include <drizzled/session/transactions.h>
 #include <drizzled/create_field.h>
@@ -195,6 +196,7 @@ bool dispatch_command(enum_server_command command, Session& session, str_ref pac
   session.command= command;
   session.lex().sql_command= SQLCOM_END; /* to avoid confusing VIEW detectors */
   session.times.set_time();
+  session.memory_usage.startStatement(session.variables.max_statement_memory);
   session.setQueryId(g_query_id.increment());
 
   if (command != COM_PING)
@@ -538,9 +540,21 @@ bool execute_sqlcom_select(Session *session, TableList *all_tables)
     }
   }
 
+  /*
+    EXPLAIN ANALYZE executes the statement for real, derived tables
+    included, so it has to be switched over before the tables are opened.
+  */
+  optimizer::ExplainAnalyze analyze(*session);
+  if (lex->describe & DESCRIBE_ANALYZE)
+    analyze.start();
+
   if (not (res= session->openTablesLock(all_tables)))
   {
-    if (lex->describe)
+    if (lex->explain_analyze)
+    {
+      res= analyze.execute();
+    }
+    else if (lex->describe)
     {
       /*
         We always use select_send for EXPLAIN, even if it's an EXPLAIN
@@ -64,8 +64,10 @@
 #include <drizzled/filesort.h>
 #include <drizzled/sql_lex.h>
 #include <drizzled/session.h>
+#include <drizzled/session/memory_usage.h>
 #include <drizzled/sort_field.h>
 #include <drizzled/select_result.h>
+#include <drizzled/statistics_variables.h>
 #include <drizzled/key.h>
 #include <drizzled/my_hash.h>
 #include <drizzled/key_part_info.h>
@@ -1283,6 +1285,7 @@ void JoinTable::cleanup()
   {
     size_t size= cache.end - cache.buff;
     global_join_buffer.sub(size);
+    join->session->memory_usage.freed(size);
     free(cache.buff);
   }
   cache.buff= 0;
@@ -3526,7 +3529,15 @@ enum_nested_loop_state sub_select(Join *join, JoinTable *join_tab, bool end_of_r
     }
     join->session->row_count= 0;
 
-    error= (*join_tab->read_first_record)(join_tab);
+    if (optimizer::AnalyzeStats *stats= join_tab->analyze)
+    {
+      uint64_t start= optimizer::AnalyzeStats::now();
+      error= (*join_tab->read_first_record)(join_tab);
+      stats->engine_usec+= optimizer::AnalyzeStats::now() - start;
+      stats->loops++;
+    }
+    else
+      error= (*join_tab->read_first_record)(join_tab);
     rc= evaluate_join_record(join, join_tab, error);
   }
 
@@ -3536,7 +3547,14 @@ enum_nested_loop_state sub_select(Join *join, JoinTable *join_tab, bool end_of_r
   */
   while (rc == NESTED_LOOP_OK && join->return_tab >= join_tab)
   {
-    error= info->read_record(info);
+    if (optimizer::AnalyzeStats *stats= join_tab->analyze)
+    {
+      uint64_t start= optimizer::AnalyzeStats::now();
+      error= info->read_record(info);
+      stats->engine_usec+= optimizer::AnalyzeStats::now() - start;
+    }
+    else
+      error= info->read_record(info);
     rc= evaluate_join_record(join, join_tab, error);
   }
 
@@ -4190,11 +4208,10 @@ enum_nested_loop_state end_write_group(Join *join, JoinTable *, bool end_of_reco
         {
           int error= table->cursor->insertRecord(table->getInsertRecord());
 
-          if (error)
-          {
-            my_error(ER_USE_SQL_BIG_RESULT, MYF(0));
+          if (error &&
+              create_myisam_from_heap(join->session, table, &join->tmp_table_param,
+                                      error, false))
             return NESTED_LOOP_ERROR;
-          }
         }
 
         if (join->rollup.getState() != Rollup::STATE_NONE)
@@ -5248,7 +5265,8 @@ check_reverse_order:
         if (quick_type == optimizer::QuickSelectInterface::QS_TYPE_INDEX_MERGE ||
             quick_type == optimizer::QuickSelectInterface::QS_TYPE_ROR_INTERSECT ||
             quick_type == optimizer::QuickSelectInterface::QS_TYPE_ROR_UNION ||
-            quick_type == optimizer::QuickSelectInterface::QS_TYPE_GROUP_MIN_MAX)
+            quick_type == optimizer::QuickSelectInterface::QS_TYPE_GROUP_MIN_MAX ||
+            quick_type == optimizer::QuickSelectInterface::QS_TYPE_SKIP_SCAN)
         {
           tab->limit= 0;
           select->quick= save_quick;
@@ -5395,10 +5413,17 @@ int create_sort_index(Session *session, Join *join, Order *order, ha_rows fileso
   if (table->getShare()->getType())
     table->cursor->info(HA_STATUS_VARIABLE);	// Get record count
 
+  uint64_t merge_passes= session->status_var.filesort_merge_passes;
   FileSort filesort(*session);
   table->sort.found_records=filesort.run(table,join->sortorder, length,
 					 select, filesort_limit, 0,
 					 examined_rows);
+  if (tab->analyze && table->sort.found_records != HA_POS_ERROR)
+  {
+    tab->analyze->sort_rows+= table->sort.found_records;
+    tab->analyze->sort_merge_passes+=
+      session->status_var.filesort_merge_passes - merge_passes;
+  }
   tab->records= table->sort.found_records;	// For SQL_CALC_ROWS
   if (select)
   {
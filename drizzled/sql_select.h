@@ -149,6 +149,9 @@ Table *create_tmp_table(Session *session,Tmp_Table_Param *param,List<Item> &fiel
 			Order *group, bool distinct, bool save_sum_fields,
 			uint64_t select_options, ha_rows rows_limit,
 			const char* alias);
+bool create_myisam_from_heap(Session *session, Table *table,
+                             Tmp_Table_Param *param, int error,
+                             bool ignore_last_dupp_key_error);
 void count_field_types(Select_Lex *select_lex, Tmp_Table_Param *param,
                        List<Item> &fields, bool reset_with_sum_func);
 bool setup_copy_fields(Session *session, Tmp_Table_Param *param,
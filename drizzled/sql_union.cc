@@ -66,19 +66,65 @@ bool select_union::send_data(List<Item> &values)
   if (session->is_error())
     return 1;
 
-  if ((error= table->cursor->insertRecord(table->getInsertRecord())))
+  if (store_rows && (error= table->cursor->insertRecord(table->getInsertRecord())))
   {
-    /* create_myisam_from_heap will generate error if needed */
-    if (table->cursor->is_fatal_error(error, HA_CHECK_DUP))
+    if (not table->cursor->is_fatal_error(error, HA_CHECK_DUP))
+      return 0;                                 // Duplicate, already sent
+
+    ha_rows records_before= 0;
+    if (stream_result)
     {
-      my_error(ER_USE_SQL_BIG_RESULT, MYF(0));
+      table->cursor->info(HA_STATUS_VARIABLE);
+      records_before= table->cursor->stats.records;
+    }
+    /* create_myisam_from_heap will generate error if needed */
+    if (create_myisam_from_heap(session, table, &tmp_table_param, error, true))
       return true;
+    if (stream_result)
+    {
+      /* The row that did not fit may still have been a duplicate */
+      table->cursor->info(HA_STATUS_VARIABLE);
+      if (table->cursor->stats.records == records_before)
+        return 0;
     }
   }
+
+  if (stream_result)
+  {
+    streamed_rows++;
+    return stream_result->send_data(*stream_items);
+  }
   return 0;
 }
 
 
+/*
+  Pass the rows of the union on to result as they arrive.
+
+  SYNOPSIS
+    select_union::start_streaming()
+      result       where to send the rows
+      items        the fields of the result table
+      is_distinct  if set, duplicates are dropped until the last UNION
+                   DISTINCT part, by writing each row to the result table
+                   and sending it only if its unique key was not there yet
+
+  DESCRIPTION
+    The rows still go through the fields of the result table, so they are
+    converted to the column types of the union exactly as when they are
+    read back from it. Rows of UNION ALL parts are not stored at all.
+*/
+
+void select_union::start_streaming(select_result *result, List<Item> *items,
+                                   bool is_distinct)
+{
+  stream_result= result;
+  stream_items= items;
+  store_rows= is_distinct;
+  streamed_rows= 0;
+}
+
+
 bool select_union::send_eof()
 {
   return 0;
@@ -108,6 +154,9 @@ bool select_union::flush()
                          duplicates on insert
       options            create options
       table_alias        name of the temporary table
+      lookup_fields      positions of columns to index for lookups by the
+                         outer query (derived tables), may be NULL
+      lookup_field_count number of elements in lookup_fields
 
   DESCRIPTION
     Create a temporary table that is used to store the result of a UNION,
@@ -121,11 +170,15 @@ bool select_union::flush()
 bool
 select_union::create_result_table(Session *session_arg, List<Item> *column_types,
                                   bool is_union_distinct, uint64_t options,
-                                  const char *table_alias)
+                                  const char *table_alias,
+                                  uint32_t *lookup_fields,
+                                  uint32_t lookup_field_count)
 {
   assert(table == NULL);
   tmp_table_param.init();
   tmp_table_param.field_count= column_types->size();
+  tmp_table_param.lookup_fields= lookup_fields;
+  tmp_table_param.lookup_field_count= lookup_field_count;
 
   if (! (table= create_tmp_table(session_arg, &tmp_table_param, *column_types,
                                  (Order*) NULL, is_union_distinct, 1,
@@ -379,6 +432,9 @@ bool Select_Lex_Unit::prepare(Session *session_arg, select_result *sel_result,
       */
       assert(false);
     }
+
+    if (can_stream_result())
+      union_result->start_streaming(sel_result, &item_list, test(union_distinct));
   }
 
   session_arg->lex().current_select= lex_select_save;
@@ -391,6 +447,42 @@ err:
 }
 
 
+/*
+  Check if the rows of the union can be sent as the selects produce them
+
+  SYNOPSIS
+    Select_Lex_Unit::can_stream_result()
+
+  DESCRIPTION
+    The rows of the outermost UNION of a SELECT statement need not be read
+    back from the result table through fake_select_lex when there is no
+    ORDER BY or LIMIT for the whole union. UNION ALL parts then skip the
+    table entirely and UNION DISTINCT parts only use its unique key to
+    drop duplicates.
+
+    Subqueries and derived tables may be executed several times or read
+    by the outer query and keep the table. SQL_CALC_FOUND_ROWS needs the
+    row count of the table.
+
+  RETURN
+    true   the rows can be streamed
+    false  they have to be stored first
+*/
+
+bool Select_Lex_Unit::can_stream_result()
+{
+  return (is_union() &&
+          ! describe &&
+          ! item &&
+          ! outer_select() &&
+          ! found_rows_for_union &&
+          session->lex().sql_command == SQLCOM_SELECT &&
+          global_parameters->order_list.size() == 0 &&
+          ! global_parameters->select_limit &&
+          ! global_parameters->offset_limit);
+}
+
+
 bool Select_Lex_Unit::exec()
 {
   Select_Lex *lex_select_save= session->lex().current_select;
@@ -402,6 +494,14 @@ bool Select_Lex_Unit::exec()
     return false;
   executed= 1;
 
+  select_result *stream_result= union_result ? union_result->stream_result : NULL;
+  if (stream_result)
+  {
+    if (stream_result->prepare(item_list, this))
+      return true;
+    stream_result->send_fields(item_list);
+  }
+
   if (uncacheable.any() || ! item || ! item->assigned() || describe)
   {
     if (item)
@@ -456,7 +556,9 @@ bool Select_Lex_Unit::exec()
       {
 	records_at_start= table->cursor->stats.records;
 	sl->join->exec();
-        if (sl == union_distinct)
+        if (sl == union_distinct && stream_result)
+          union_result->store_rows= false;
+        else if (sl == union_distinct)
 	{
 	  if (table->cursor->ha_disable_indexes(HA_KEY_SWITCH_ALL))
 	    return true;
@@ -504,6 +606,19 @@ bool Select_Lex_Unit::exec()
   }
   optimized= 1;
 
+  if (stream_result)
+  {
+    /* All rows have been sent by union_result */
+    saved_error= session->is_fatal_error || stream_result->send_eof();
+    if (!saved_error)
+    {
+      session->limit_found_rows= union_result->streamed_rows;
+      session->examined_row_count+= examined_rows;
+    }
+    session->lex().current_select= lex_select_save;
+    return saved_error;
+  }
+
   /* Send result to 'result' */
   saved_error= true;
   {
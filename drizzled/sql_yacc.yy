@@ -4677,6 +4677,7 @@ describe_command:
 opt_extended_describe:
           /* empty */ {}
         | EXTENDED_SYM   { Lex.describe|= DESCRIBE_EXTENDED; }
+        | ANALYZE_SYM    { Lex.describe|= DESCRIBE_ANALYZE; }
         ;
 
 opt_describe_column:
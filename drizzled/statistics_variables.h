@@ -77,11 +77,18 @@ typedef struct system_status_var
   uint64_t filesort_range_count;
   uint64_t filesort_rows;
   uint64_t filesort_scan_count;
+  uint64_t filesort_run_bytes;
+  uint64_t filesort_run_compressed_bytes;
+  uint64_t filesort_run_compression_usec;
   uint64_t connection_time;
   uint64_t execution_time_nsec;
   uint64_t updated_row_count;
   uint64_t deleted_row_count;
   uint64_t inserted_row_count;
+  uint64_t subquery_cache_hits;
+  uint64_t subquery_cache_misses;
+  uint64_t parallel_aggregate_queries;
+  uint64_t parallel_aggregate_ranges;
   /*
     Number of statements sent from the client
   */
@@ -24,6 +24,7 @@
 #include <drizzled/open_tables_state.h>
 #include <drizzled/set_var.h>
 #include <drizzled/drizzled.h>
+#include <drizzled/memory/block_pool.h>
 #include <plugin/myisam/myisam.h>
 #include <sstream>
 
@@ -58,12 +59,42 @@ static int show_connection_count_new(drizzle_show_var *var, char *buff)
   return 0;
 }
 
+static int show_root_block_pool_hits(drizzle_show_var *var, char *buff)
+{
+  var->type= SHOW_LONGLONG;
+  var->value= buff;
+  *((uint64_t *)buff)= memory::BlockPool::hits();
+  return 0;
+}
+
+static int show_root_block_pool_misses(drizzle_show_var *var, char *buff)
+{
+  var->type= SHOW_LONGLONG;
+  var->value= buff;
+  *((uint64_t *)buff)= memory::BlockPool::misses();
+  return 0;
+}
+
+static int show_root_block_pool_retained(drizzle_show_var *var, char *buff)
+{
+  var->type= SHOW_LONGLONG;
+  var->value= buff;
+  *((uint64_t *)buff)= memory::BlockPool::retained_bytes();
+  return 0;
+}
+
 static st_show_var_func_container show_starttime_cont_new= { &show_starttime_new };
 
 static st_show_var_func_container show_flushstatustime_cont_new= { &show_flushstatustime_new };
 
 static st_show_var_func_container show_connection_count_cont_new= { &show_connection_count_new };
 
+static st_show_var_func_container show_root_block_pool_hits_cont= { &show_root_block_pool_hits };
+
+static st_show_var_func_container show_root_block_pool_misses_cont= { &show_root_block_pool_misses };
+
+static st_show_var_func_container show_root_block_pool_retained_cont= { &show_root_block_pool_retained };
+
 string StatusHelper::fillHelper(system_status_var *status_var, const char *value, SHOW_TYPE show_type)
 {
   ostringstream oss;
@@ -140,7 +171,12 @@ drizzle_show_var StatusHelper::status_vars_defs[]=
   {"Handler_write",             (char*) offsetof(system_status_var, ha_write_count), SHOW_LONGLONG_STATUS},
   {"Last_query_cost",           (char*) offsetof(system_status_var, last_query_cost), SHOW_DOUBLE_STATUS},
   {"Max_used_connections",      (char*) &current_global_counters.max_used_connections,  SHOW_LONGLONG},
+  {"Parallel_aggregate_queries", (char*) offsetof(system_status_var, parallel_aggregate_queries), SHOW_LONGLONG_STATUS},
+  {"Parallel_aggregate_ranges", (char*) offsetof(system_status_var, parallel_aggregate_ranges), SHOW_LONGLONG_STATUS},
   {"Questions",                 (char*) offsetof(system_status_var, questions), SHOW_LONGLONG_STATUS},
+  {"Root_block_pool_hits",      (char*) &show_root_block_pool_hits_cont,      SHOW_FUNC},
+  {"Root_block_pool_misses",    (char*) &show_root_block_pool_misses_cont,    SHOW_FUNC},
+  {"Root_block_pool_retained",  (char*) &show_root_block_pool_retained_cont,  SHOW_FUNC},
   {"Select_full_join",          (char*) offsetof(system_status_var, select_full_join_count), SHOW_LONGLONG_STATUS},
   {"Select_full_range_join",    (char*) offsetof(system_status_var, select_full_range_join_count), SHOW_LONGLONG_STATUS},
   {"Select_range",              (char*) offsetof(system_status_var, select_range_count), SHOW_LONGLONG_STATUS},
@@ -151,7 +187,12 @@ drizzle_show_var StatusHelper::status_vars_defs[]=
   {"Sort_merge_passes",         (char*) offsetof(system_status_var, filesort_merge_passes), SHOW_LONGLONG_STATUS},
   {"Sort_range",                (char*) offsetof(system_status_var, filesort_range_count), SHOW_LONGLONG_STATUS},
   {"Sort_rows",                 (char*) offsetof(system_status_var, filesort_rows), SHOW_LONGLONG_STATUS},
+  {"Sort_run_bytes",            (char*) offsetof(system_status_var, filesort_run_bytes), SHOW_LONGLONG_STATUS},
+  {"Sort_run_compressed_bytes", (char*) offsetof(system_status_var, filesort_run_compressed_bytes), SHOW_LONGLONG_STATUS},
+  {"Sort_run_compression_usec", (char*) offsetof(system_status_var, filesort_run_compression_usec), SHOW_LONGLONG_STATUS},
   {"Sort_scan",                 (char*) offsetof(system_status_var, filesort_scan_count), SHOW_LONGLONG_STATUS},
+  {"Subquery_cache_hits",       (char*) offsetof(system_status_var, subquery_cache_hits), SHOW_LONGLONG_STATUS},
+  {"Subquery_cache_misses",     (char*) offsetof(system_status_var, subquery_cache_misses), SHOW_LONGLONG_STATUS},
   {"Table_locks_immediate",     (char*) &current_global_counters.locks_immediate,        SHOW_LONGLONG},
   {"Table_locks_waited",        (char*) &current_global_counters.locks_waited,           SHOW_LONGLONG},
   {"Uptime",                    (char*) &show_starttime_cont_new,         SHOW_FUNC},
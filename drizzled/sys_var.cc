@@ -48,6 +48,7 @@
 #include <drizzled/session/times.h>
 #include <drizzled/sql_base.h>
 #include <drizzled/lock.h>
+#include <drizzled/memory/block_pool.h>
 #include <drizzled/item/uint.h>
 #include <drizzled/item/null.h>
 #include <drizzled/item/float.h>
@@ -106,6 +107,7 @@ static void fix_tx_isolation(Session*, sql_var_t);
 static int check_completion_type(Session*, set_var*);
 static void fix_max_join_size(Session*, sql_var_t);
 static void fix_session_mem_root(Session*, sql_var_t);
+static void fix_root_block_pool_size(Session*, sql_var_t);
 void throw_bounds_warning(Session*, bool fixed, bool unsignd, const std::string &name, int64_t);
 static unsigned char *get_error_count(Session*);
 static unsigned char *get_warning_count(Session*);
@@ -147,12 +149,14 @@ static sys_var_session_ha_rows	sys_max_join_size("max_join_size", &drizzle_syste
 static sys_var_session_uint64_t	sys_max_seeks_for_key("max_seeks_for_key", &drizzle_system_variables::max_seeks_for_key);
 static sys_var_session_uint64_t sys_max_length_for_sort_data("max_length_for_sort_data", &drizzle_system_variables::max_length_for_sort_data);
 static sys_var_session_size_t	sys_max_sort_length("max_sort_length", &drizzle_system_variables::max_sort_length);
+static sys_var_session_uint64_t	sys_max_statement_memory("max_statement_memory", &drizzle_system_variables::max_statement_memory);
 static sys_var_uint64_t_ptr	sys_max_write_lock_count("max_write_lock_count", &max_write_lock_count);
 static sys_var_session_uint64_t sys_min_examined_row_limit("min_examined_row_limit", &drizzle_system_variables::min_examined_row_limit);
 
 static sys_var_session_bool sys_optimizer_prune_level("optimizer_prune_level", &drizzle_system_variables::optimizer_prune_level);
 static sys_var_session_uint32_t sys_optimizer_search_depth("optimizer_search_depth", &drizzle_system_variables::optimizer_search_depth);
 
+static sys_var_session_uint64_t sys_parallel_degree("parallel_degree", &drizzle_system_variables::parallel_degree);
 static sys_var_session_uint64_t sys_preload_buff_size("preload_buffer_size", &drizzle_system_variables::preload_buff_size);
 static sys_var_session_uint32_t sys_read_buff_size("read_buffer_size", &drizzle_system_variables::read_buff_size);
 static sys_var_session_uint32_t	sys_read_rnd_buff_size("read_rnd_buffer_size", &drizzle_system_variables::read_rnd_buff_size);
@@ -167,6 +171,8 @@ static sys_var_session_uint32_t	sys_query_prealloc_size("query_prealloc_size", &
 static sys_var_readonly sys_tmpdir("tmpdir", OPT_GLOBAL, SHOW_CHAR, get_tmpdir);
 
 static sys_var_fs_path sys_secure_file_priv("secure_file_priv", secure_file_priv);
+static sys_var_uint64_t_ptr	sys_root_block_pool_size("root_block_pool_size", &memory::root_block_pool_size, fix_root_block_pool_size);
+
 static sys_var_const_str_ptr sys_scheduler("scheduler", (char**)&opt_scheduler);
 
 static sys_var_uint32_t_ptr  sys_server_id("server_id", &server_id);
@@ -174,6 +180,8 @@ static sys_var_uint32_t_ptr  sys_server_id("server_id", &server_id);
 static sys_var_const_string sys_server_uuid("server_uuid", server_uuid);
 
 static sys_var_session_size_t	sys_sort_buffer("sort_buffer_size", &drizzle_system_variables::sortbuff_size);
+static sys_var_session_bool	sys_sort_run_compression("sort_run_compression", &drizzle_system_variables::sort_run_compression);
+static sys_var_session_uint64_t	sys_subquery_cache_size("subquery_cache_size", &drizzle_system_variables::subquery_cache_size);
 
 static sys_var_size_t_ptr_readonly sys_transaction_message_threshold("transaction_message_threshold", &transaction_message_threshold);
 
@@ -344,6 +352,11 @@ static void fix_session_mem_root(Session *session, sql_var_t type)
     session->mem.reset_defaults(session->variables.query_alloc_block_size, session->variables.query_prealloc_size);
 }
 
+static void fix_root_block_pool_size(Session *, sql_var_t)
+{
+  memory::BlockPool::trim();
+}
+
 
 void throw_bounds_warning(Session *session, bool fixed, bool unsignd, const std::string &name, int64_t val)
 {
@@ -1337,10 +1350,12 @@ int sys_var_init()
     add_sys_var_to_list(&sys_max_length_for_sort_data, my_long_options);
     add_sys_var_to_list(&sys_max_seeks_for_key, my_long_options);
     add_sys_var_to_list(&sys_max_sort_length, my_long_options);
+    add_sys_var_to_list(&sys_max_statement_memory, my_long_options);
     add_sys_var_to_list(&sys_max_write_lock_count, my_long_options);
     add_sys_var_to_list(&sys_min_examined_row_limit, my_long_options);
     add_sys_var_to_list(&sys_optimizer_prune_level, my_long_options);
     add_sys_var_to_list(&sys_optimizer_search_depth, my_long_options);
+    add_sys_var_to_list(&sys_parallel_degree, my_long_options);
     add_sys_var_to_list(&sys_pid_file, my_long_options);
     add_sys_var_to_list(&sys_plugin_dir, my_long_options);
     add_sys_var_to_list(&sys_preload_buff_size, my_long_options);
@@ -1354,15 +1369,18 @@ int sys_var_init()
     add_sys_var_to_list(&sys_replicate_query, my_long_options);
     add_sys_var_to_list(&sys_revid, my_long_options);
     add_sys_var_to_list(&sys_revno, my_long_options);
+    add_sys_var_to_list(&sys_root_block_pool_size, my_long_options);
     add_sys_var_to_list(&sys_scheduler, my_long_options);
     add_sys_var_to_list(&sys_secure_file_priv, my_long_options);
     add_sys_var_to_list(&sys_select_limit, my_long_options);
     add_sys_var_to_list(&sys_server_id, my_long_options);
     add_sys_var_to_list(&sys_server_uuid, my_long_options);
     add_sys_var_to_list(&sys_sort_buffer, my_long_options);
+    add_sys_var_to_list(&sys_sort_run_compression, my_long_options);
     add_sys_var_to_list(&sys_sql_notes, my_long_options);
     add_sys_var_to_list(&sys_sql_warnings, my_long_options);
     add_sys_var_to_list(&sys_storage_engine, my_long_options);
+    add_sys_var_to_list(&sys_subquery_cache_size, my_long_options);
     add_sys_var_to_list(&sys_table_cache_size, my_long_options);
     add_sys_var_to_list(&sys_table_def_size, my_long_options);
     add_sys_var_to_list(&sys_table_lock_wait_timeout, my_long_options);
@@ -51,17 +51,21 @@ struct drizzle_system_variables
   uint64_t max_error_count;
   uint64_t max_length_for_sort_data;
   size_t max_sort_length;
+  uint64_t max_statement_memory;
   uint64_t min_examined_row_limit;
   bool optimizer_prune_level;
   bool log_warnings;
 
   uint32_t optimizer_search_depth;
   uint32_t div_precincrement;
+  uint64_t parallel_degree;
   uint64_t preload_buff_size;
   uint32_t read_buff_size;
   uint32_t read_rnd_buff_size;
   bool replicate_query;
   size_t sortbuff_size;
+  bool sort_run_compression;
+  uint64_t subquery_cache_size;
   uint32_t thread_handling;
   uint32_t tx_isolation;
   uint32_t completion_type;
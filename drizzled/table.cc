@@ -970,29 +970,31 @@ create_tmp_table(Session *session,Tmp_Table_Param *param,List<Item> &fields,
   *blob_field= 0;				// End marker
   table->getMutableShare()->setFieldSize(field_count);
 
-  /* If result table is small; use a heap */
+  /*
+    If result table is small; use a heap. MEMORY keeps blobs out of the
+    row, and a unique constraint over blobs or long groups is a hash key
+    over the stored values, see hp_hash.cc.
+  */
   /* future: storage engine selection can be made dynamic? */
-  if (blob_count || using_unique_constraint || 
-      (session->lex().select_lex.options & SELECT_BIG_RESULT) ||
+  if ((session->lex().select_lex.options & SELECT_BIG_RESULT) ||
       (session->lex().current_select->olap == ROLLUP_TYPE) ||
       (select_options & (OPTION_BIG_TABLES | SELECT_SMALL_RESULT)) == OPTION_BIG_TABLES)
   {
     table->getMutableShare()->storage_engine= myisam_engine;
-    table->cursor= table->getMutableShare()->db_type()->getCursor(*table);
-    if (group &&
-	(param->group_parts > table->cursor->getEngine()->max_key_parts() ||
-	 param->group_length > table->cursor->getEngine()->max_key_length()))
-    {
-      using_unique_constraint= true;
-    }
   }
   else
   {
     table->getMutableShare()->storage_engine= heap_engine;
-    table->cursor= table->getMutableShare()->db_type()->getCursor(*table);
   }
+  table->cursor= table->getMutableShare()->db_type()->getCursor(*table);
   if (! table->cursor)
     goto err;
+  if (group &&
+      (param->group_parts > table->cursor->getEngine()->max_key_parts() ||
+       param->group_length > table->cursor->getEngine()->max_key_length()))
+  {
+    using_unique_constraint= true;
+  }
 
 
   if (! using_unique_constraint)
@@ -1160,6 +1162,8 @@ create_tmp_table(Session *session,Tmp_Table_Param *param,List<Item> &fields,
     table->key_info=keyinfo;
     keyinfo->key_part=key_part_info;
     keyinfo->flags=HA_NOSAME;
+    if (using_unique_constraint)
+      keyinfo->flags|= HA_NULL_ARE_EQUAL;	// All NULLs are one group
     keyinfo->usable_key_parts=keyinfo->key_parts= param->group_parts;
     keyinfo->key_length= 0;
     keyinfo->rec_per_key= 0;
@@ -1223,15 +1227,21 @@ create_tmp_table(Session *session,Tmp_Table_Param *param,List<Item> &fields,
     if (blob_count)
     {
       /*
-        Special mode for index creation in MyISAM used to support unique
-        indexes on blobs with arbitrary length. Such indexes cannot be
-        used for lookups.
+        Special mode for index creation used to support unique indexes
+        on blobs with arbitrary length. Such indexes cannot be used for
+        lookups.
       */
       table->getMutableShare()->uniques= 1;
     }
+    /*
+      MyISAM hashes the null bits of a unique constraint as an extra key
+      part; a MEMORY hash key gives each key part its own null bit.
+    */
+    bool null_bits_part= table->getMutableShare()->uniques &&
+      table->getShare()->db_type() == myisam_engine;
     null_pack_length-=hidden_null_pack_length;
     keyinfo->key_parts= ((field_count-param->hidden_field_count)+
-			 (table->getMutableShare()->uniques ? test(null_pack_length) : 0));
+			 (null_bits_part ? test(null_pack_length) : 0));
     table->distinct= 1;
     table->getMutableShare()->keys= 1;
     key_part_info= new (table->mem()) KeyPartInfo[keyinfo->key_parts];
@@ -1249,7 +1259,7 @@ create_tmp_table(Session *session,Tmp_Table_Param *param,List<Item> &fields,
       blobs can distinguish NULL from 0. This extra field is not needed
       when we do not use UNIQUE indexes for blobs.
     */
-    if (null_pack_length && table->getMutableShare()->uniques)
+    if (null_pack_length && null_bits_part)
     {
       key_part_info->null_bit= 0;
       key_part_info->offset=hidden_null_pack_length;
@@ -1302,6 +1312,84 @@ create_tmp_table(Session *session,Tmp_Table_Param *param,List<Item> &fields,
     }
   }
 
+  if (param->lookup_field_count && !group && !table->distinct &&
+      table->getShare()->db_type() == heap_engine)
+  {
+    /*
+      Give each column that the outer query looks up by equality a hash
+      index of its own, so that the optimizer can use ref access into the
+      materialized rows instead of scanning all of them for every row of
+      the preceding tables.
+    */
+    uint32_t key_count= 0;
+    for (i= 0; i < param->lookup_field_count && key_count < MAX_KEY; i++)
+    {
+      /* MEMORY can't index blobs */
+      if (!(table->getField(param->lookup_fields[i])->flags & BLOB_FLAG))
+        param->lookup_fields[key_count++]= param->lookup_fields[i];
+    }
+    ulong *rec_per_key= (ulong*) table->alloc(sizeof(ulong) * key_count);
+    keyinfo= new (table->mem()) KeyInfo[key_count];
+    key_part_info= new (table->mem()) KeyPartInfo[key_count];
+    memset(rec_per_key, 0, key_count * sizeof(ulong));
+    memset(keyinfo, 0, key_count * sizeof(KeyInfo));
+    memset(key_part_info, 0, key_count * sizeof(KeyPartInfo));
+    table->key_info= keyinfo;
+    table->getMutableShare()->setKeyInfo(keyinfo);
+    table->getMutableShare()->keys= key_count;
+    table->getMutableShare()->key_parts= key_count;
+
+    for (i= 0; i < key_count; i++, keyinfo++, key_part_info++)
+    {
+      Field *field= table->getField(param->lookup_fields[i]);
+
+      keyinfo->key_part= key_part_info;
+      keyinfo->usable_key_parts= keyinfo->key_parts= 1;
+      keyinfo->algorithm= message::Table::Index::UNKNOWN_INDEX;
+      keyinfo->rec_per_key= rec_per_key + i;
+      keyinfo->name= field->field_name;
+      keyinfo->table= table;
+
+      key_part_info->field= field;
+      key_part_info->fieldnr= param->lookup_fields[i] + 1;
+      key_part_info->offset= field->offset(table->getInsertRecord());
+      key_part_info->length= (uint16_t) field->key_length();
+      key_part_info->store_length= key_part_info->length;
+      key_part_info->type= (uint8_t) field->key_type();
+      key_part_info->key_type=
+	((ha_base_keytype) key_part_info->type == HA_KEYTYPE_TEXT ||
+	 (ha_base_keytype) key_part_info->type == HA_KEYTYPE_VARTEXT1 ||
+	 (ha_base_keytype) key_part_info->type == HA_KEYTYPE_VARTEXT2) ?
+	0 : 1;
+      keyinfo->key_length= key_part_info->length;
+
+      if (field->real_maybe_null())
+      {
+        key_part_info->null_bit= field->null_bit;
+        key_part_info->null_offset= (uint32_t) (field->null_ptr -
+                                                (unsigned char*) table->getInsertRecord());
+        key_part_info->store_length+= HA_KEY_NULL_LENGTH;
+        keyinfo->flags|= HA_NULL_PART_KEY;
+        keyinfo->extra_length+= HA_KEY_NULL_LENGTH;
+        keyinfo->key_length+= HA_KEY_NULL_LENGTH;
+      }
+      if (field->real_type() == DRIZZLE_TYPE_VARCHAR)
+      {
+        key_part_info->key_part_flag|= HA_VAR_LENGTH_PART;
+        key_part_info->store_length+= HA_KEY_BLOB_LENGTH;
+        keyinfo->extra_length+= HA_KEY_BLOB_LENGTH;
+        keyinfo->key_length+= HA_KEY_BLOB_LENGTH;
+      }
+
+      field->flags|= PART_KEY_FLAG | MULTIPLE_KEY_FLAG;
+      field->key_start.set(i);
+      table->getMutableShare()->keys_in_use.set(i);
+      set_if_bigger(table->getMutableShare()->max_key_length,
+                    keyinfo->key_length + keyinfo->key_parts);
+      table->getMutableShare()->total_key_length+= keyinfo->key_length;
+    }
+  }
+
   if (session->is_fatal_error)				// If end of memory
     goto err;
   table->getMutableShare()->db_record_offset= 1;
@@ -1314,6 +1402,15 @@ create_tmp_table(Session *session,Tmp_Table_Param *param,List<Item> &fields,
   assert(table->in_use);
   if (table->open_tmp_table())
     goto err;
+  if (table->getShare()->uniques && table->getShare()->db_type() == heap_engine)
+  {
+    /*
+      Like a MyISAM unique constraint, the MEMORY key only rejects
+      duplicates, it can't be searched; end_unique_update() finds the
+      group a row belongs to through the duplicate.
+    */
+    table->getMutableShare()->keys= 0;
+  }
 
   session->mem_root= mem_root_save;
 
@@ -1326,6 +1423,127 @@ err:
   return NULL;
 }
 
+/*
+  Move a full MEMORY temporary table to MyISAM
+
+  SYNOPSIS
+    create_myisam_from_heap()
+      session                     Thread handle
+      table                       Temporary table made by create_tmp_table()
+      param                       Parameters the table was made with
+      error                       Error from writing getInsertRecord()
+      ignore_last_dupp_key_error  Don't report a duplicate key on that row
+
+  DESCRIPTION
+    A MEMORY temporary table fails writes with HA_ERR_RECORD_FILE_FULL
+    once it is past tmp_table_size or max_heap_table_size. Rather than
+    failing the statement, the rows are copied to a MyISAM table with the
+    same record format, which takes the place of the MEMORY one in the
+    same Table, and the row that did not fit is written to it.
+
+    MyISAM temporary tables have at most one key, so the lookup keys of a
+    derived table (see create_tmp_table()) are dropped. The group or
+    distinct key may become a unique constraint, see
+    create_myisam_tmp_table().
+
+    Every row is copied once. Spilling only some hash partitions of the
+    table to disk would avoid that, but a temporary table is one Table
+    with one Cursor: the join writes groups through it, finds them again
+    by key (end_update(), end_unique_update()), scans it, sorts it and
+    reads derived tables through their lookup keys. That needs an engine
+    that routes every write, key lookup and scan across memory and disk
+    partitions, and rows of spilled groups still have to be found and
+    updated by key on disk, which is what MyISAM does. No such engine
+    exists, so the table is moved as a whole.
+
+  RETURN
+    false  OK
+    true   Error, it has been reported
+*/
+
+bool create_myisam_from_heap(Session *session, Table *table,
+                             Tmp_Table_Param *param, int error,
+                             bool ignore_last_dupp_key_error)
+{
+  if (table->getShare()->db_type() != heap_engine ||
+      error != HA_ERR_RECORD_FILE_FULL)
+  {
+    table->print_error(error, MYF(0));
+    return true;
+  }
+
+  /* MEMORY temporary tables are only made by create_tmp_table() */
+  table::Singular *tmp_table= static_cast<table::Singular *>(table);
+  TableShare *share= tmp_table->getMutableShare();
+  Cursor *heap_cursor= table->cursor;
+  const char *save_proc_info= session->get_proc_info();
+  session->set_proc_info("converting HEAP to MyISAM");
+
+  /* The MEMORY unique constraint becomes a MyISAM one */
+  if (share->uniques)
+    share->keys= 1;
+  else if (share->sizeKeys() && table->key_info != param->keyinfo)
+  {
+    share->keys= share->key_parts= 0;
+    share->keys_in_use.reset();
+    table->keys_in_use_for_query.reset();
+    table->keys_in_use_for_group_by.reset();
+    table->keys_in_use_for_order_by.reset();
+    table->covering_keys.reset();
+    for (Field **field= table->getFields(); *field; field++)
+    {
+      (*field)->key_start.reset();
+      (*field)->part_of_key.reset();
+      (*field)->part_of_sortkey.reset();
+      (*field)->flags&= ~(PART_KEY_FLAG | MULTIPLE_KEY_FLAG);
+    }
+  }
+
+  /*
+    From here on the table is MyISAM, also if something fails: the
+    destructor of table::Singular drops it with the engine of the share.
+  */
+  heap_cursor->ha_index_or_rnd_end();
+  share->storage_engine= myisam_engine;
+  table->cursor= myisam_engine->getCursor(*table);
+
+  if (tmp_table->create_myisam_tmp_table(param->keyinfo, param->start_recinfo,
+                                         &param->recinfo, session->options) ||
+      tmp_table->open_tmp_table())
+  {
+    error= -1;                                  // Already reported
+  }
+  else
+  {
+    if (not (error= heap_cursor->startTableScan(1)))
+    {
+      while ((error= heap_cursor->rnd_next(table->getUpdateRecord())) != HA_ERR_END_OF_FILE)
+      {
+        if (error == HA_ERR_RECORD_DELETED)
+          continue;
+        if (error || (error= table->cursor->insertRecord(table->getUpdateRecord())))
+          break;
+      }
+      heap_cursor->endTableScan();
+    }
+    if (error == HA_ERR_END_OF_FILE &&
+        (error= table->cursor->insertRecord(table->getInsertRecord())) &&
+        ignore_last_dupp_key_error &&
+        not table->cursor->is_fatal_error(error, HA_CHECK_DUP))
+    {
+      error= 0;
+    }
+    if (error)
+      table->print_error(error, MYF(0));
+  }
+
+  heap_cursor->closeMarkForDelete();
+  delete heap_cursor;
+  session->set_proc_info(save_proc_info);
+
+  return error != 0;
+}
+
 /****************************************************************************/
 
 void Table::column_bitmaps_set(boost::dynamic_bitset<>& read_set_arg,
@@ -144,6 +144,11 @@ public:
   {
     return key_info[arg];
   }
+
+  void setKeyInfo(KeyInfo *arg) /* Used only for internal temporary tables */
+  {
+    key_info= arg;
+  }
   std::vector<uint>	blob_field;			/* Index to blobs in Field arrray*/
 
 private:
@@ -39,7 +39,8 @@ void TableList::set_insert_values()
 
 bool TableList::is_leaf_for_name_resolution() const
 {
-  return is_natural_join || is_join_columns_complete || not nested_join;
+  return is_natural_join || is_join_columns_complete || not nested_join ||
+    is_merged_derived();
 }
 
 TableList *TableList::find_underlying_table(Table *table_to_find)
@@ -25,6 +25,16 @@
 
 namespace drizzled {
 
+/**
+ * Column of a merged derived table: the expression of the underlying
+ * SELECT and the name it is known by in the outer query.
+ */
+struct Field_translator
+{
+  Item *item;
+  const char *name;
+};
+
 /**
  * A Table referenced in the FROM clause.
  *
@@ -43,7 +53,11 @@ namespace drizzled {
  *
  *    for schema tables TableList::field_translation may be != NULL
  *
- * 2) Was VIEW 
+ * 2) merged subquery (was VIEW)
+ *    - the SELECT of a simple derived table has been merged into the
+ *    outer query, its tables are in the nested join and its columns
+ *    are TableList::field_translation
+ *    (TableList::derived != NULL && TableList::field_translation != NULL)
  * 3) nested table reference (TableList::nested_join != NULL)
  *     - table sequence - e.g. (t1, t2, t3)
  *     @todo how to distinguish from a JOIN?
@@ -82,6 +96,8 @@ public:
     index_hints(NULL),
     derived_result(NULL),
     derived(NULL),
+    field_translation(NULL),
+    field_translation_end(NULL),
     schema_select_lex(NULL),
     select_lex(NULL),
     next_leaf(NULL),
@@ -203,6 +219,12 @@ public:
    */
   select_union *derived_result;
   Select_Lex_Unit *derived; ///< Select_Lex_Unit of derived table */
+  /**
+   * Columns of a derived table merged into the outer query, NULL if the
+   * derived table is materialized.
+   */
+  Field_translator *field_translation;
+  Field_translator *field_translation_end; ///< end of the array above
   Select_Lex *schema_select_lex;
   /** link to select_lex where this table was used */
   Select_Lex *select_lex;
@@ -299,6 +321,14 @@ public:
    *  true if a leaf, false otherwise.
    */
   bool is_leaf_for_name_resolution() const;
+  /**
+   * Test if this is a derived table whose SELECT was merged into the
+   * outer query instead of being materialized.
+   */
+  bool is_merged_derived() const
+  {
+    return field_translation != NULL;
+  }
   inline TableList *top_table()
   { return this; }
 
@@ -64,6 +64,13 @@ public:
   /* If >0 convert all blob fields to varchar(convert_blob_length) */
   uint32_t  convert_blob_length;
 
+  /*
+    Positions of the columns that get a non-unique lookup index of their
+    own when the table is a MEMORY table (materialized derived tables).
+  */
+  uint32_t *lookup_fields;
+  uint32_t lookup_field_count;
+
   const charset_info_st *table_charset;
 
   Tmp_Table_Param() :
@@ -92,6 +99,8 @@ public:
     precomputed_group_by(false),
     force_copy_fields(false),
     convert_blob_length(0),
+    lookup_fields(0),
+    lookup_field_count(0),
     table_charset(0)
   {}
 
@@ -36,6 +36,7 @@
 #include <drizzled/session.h>
 #include <drizzled/sql_list.h>
 #include <drizzled/internal/iocache.h>
+#include <drizzled/optimizer/cost_model.h>
 #include <drizzled/unique.h>
 #include <drizzled/table.h>
 
@@ -152,7 +153,7 @@ double Unique::get_use_cost(uint32_t *, uint32_t nkeys, uint32_t key_size,
 
   /* Calculate cost of creating trees */
   result= 2*log2_n_fact(last_tree_elems + 1.0);
-  result /= TIME_FOR_COMPARE_ROWID;
+  result /= optimizer::CostModel::global().timeForCompareRowid();
 
   return result;
 }
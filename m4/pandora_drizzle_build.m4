@@ -51,6 +51,8 @@ AC_DEFUN([PANDORA_DRIZZLE_BUILD],[
   AC_CHECK_FUNC(sched_yield, [],
     [AC_CHECK_LIB(posix4, [sched_yield],
       [AC_DEFINE(HAVE_SCHED_YIELD, 1, [Have sched_yield function]) LIBS="$LIBS -lposix4"])])
+
+  AC_CHECK_FUNCS(sched_getcpu)
   
   AS_IF([test "$ac_cv_header_termio_h" = "no" -a "$ac_cv_header_termios_h" = "no"],[
     AC_CHECK_FUNC(gtty, [], [AC_CHECK_LIB(compat, gtty)])
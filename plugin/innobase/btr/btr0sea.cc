@@ -44,7 +44,7 @@ Created 2/17/1996 Heikki Tuuri
 #include "ha0ha.h"
 
 /** Flag: has the search system been enabled?
-Protected by btr_search_latch and btr_search_enabled_mutex. */
+Protected by all the partition latches and btr_search_enabled_mutex. */
 UNIV_INTERN bool		btr_search_enabled = TRUE;
 UNIV_INTERN ibool		btr_search_fully_disabled = FALSE;
 
@@ -61,28 +61,12 @@ UNIV_INTERN ulint		btr_search_n_succ	= 0;
 UNIV_INTERN ulint		btr_search_n_hash_fail	= 0;
 #endif /* UNIV_SEARCH_PERF_STAT */
 
-/** padding to prevent other memory update
-hotspots from residing on the same memory
-cache line as btr_search_latch */
-UNIV_INTERN byte		btr_sea_pad1[64];
-
-/** The latch protecting the adaptive search system: this latch protects the
-(1) positions of records on those pages where a hash index has been built.
-NOTE: It does not protect values of non-ordering fields within a record from
-being updated in-place! We can use fact (1) to perform unique searches to
-indexes. */
-
-/* We will allocate the latch from dynamic memory to get it to the
-same DRAM page as other hotspot semaphores */
-UNIV_INTERN rw_lock_t*		btr_search_latch_temp;
-
-/** padding to prevent other memory update hotspots from residing on
-the same memory cache line */
-UNIV_INTERN byte		btr_sea_pad2[64];
-
 /** The adaptive hash index */
 UNIV_INTERN btr_search_sys_t*	btr_search_sys;
 
+/** Number of adaptive hash index partitions */
+UNIV_INTERN ulint		btr_search_n_parts	= 1;
+
 #ifdef UNIV_PFS_RWLOCK
 /* Key to register btr_search_sys with performance schema */
 UNIV_INTERN mysql_pfs_key_t	btr_search_latch_key;
@@ -126,18 +110,19 @@ allocate a new node to the hash table, it will succeed. However, the check
 will not guarantee success. */
 static
 void
-btr_search_check_free_space_in_heap(void)
-/*=====================================*/
+btr_search_check_free_space_in_heap(
+/*================================*/
+	btr_search_part_t*	part)	/*!< in: partition */
 {
 	hash_table_t*	table;
 	mem_heap_t*	heap;
 
 #ifdef UNIV_SYNC_DEBUG
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_SHARED));
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_EX));
+	ut_ad(!rw_lock_own(&part->latch, RW_LOCK_SHARED));
+	ut_ad(!rw_lock_own(&part->latch, RW_LOCK_EX));
 #endif /* UNIV_SYNC_DEBUG */
 
-	table = btr_search_sys->hash_index;
+	table = part->hash_index;
 
 	heap = table->heap;
 
@@ -148,7 +133,7 @@ btr_search_check_free_space_in_heap(void)
 	if (heap->free_block == NULL) {
 		buf_block_t*	block = buf_block_alloc(NULL);
 
-		rw_lock_x_lock(&btr_search_latch);
+		rw_lock_x_lock(&part->latch);
 
 		if (heap->free_block == NULL) {
 			heap->free_block = block;
@@ -156,7 +141,7 @@ btr_search_check_free_space_in_heap(void)
 			buf_block_free(block);
 		}
 
-		rw_lock_x_unlock(&btr_search_latch);
+		rw_lock_x_unlock(&part->latch);
 	}
 }
 
@@ -166,21 +151,36 @@ UNIV_INTERN
 void
 btr_search_sys_create(
 /*==================*/
-	ulint	hash_size)	/*!< in: hash index hash table size */
+	ulint	hash_size)	/*!< in: hash index hash table size, divided
+				among the partitions */
 {
-	/* We allocate the search latch from dynamic memory:
-	see above at the global variable definition */
+	ulint	i;
 
-	btr_search_latch_temp = static_cast<rw_lock_t *>(mem_alloc(sizeof(rw_lock_t)));
+	ut_a(btr_search_n_parts > 0);
 
-	rw_lock_create(btr_search_latch_key, &btr_search_latch,
-		       SYNC_SEARCH_SYS);
 	mutex_create(btr_search_enabled_mutex_key,
 		     &btr_search_enabled_mutex, SYNC_SEARCH_SYS_CONF);
 
 	btr_search_sys = (btr_search_sys_t *)mem_alloc(sizeof(btr_search_sys_t));
 
-	btr_search_sys->hash_index = ha_create(hash_size, 0, 0);
+	/* We allocate the partitions, and with them the latches, from
+	dynamic memory to get them to the same DRAM page as other hotspot
+	semaphores */
+
+	btr_search_sys->parts = static_cast<btr_search_part_t *>(
+		mem_alloc(btr_search_n_parts * sizeof(btr_search_part_t)));
+
+	for (i = 0; i < btr_search_n_parts; i++) {
+		btr_search_part_t*	part = &btr_search_sys->parts[i];
+
+		rw_lock_create(btr_search_latch_key, &part->latch,
+			       SYNC_SEARCH_SYS);
+
+		part->hash_index = ha_create(hash_size / btr_search_n_parts,
+					     0, 0);
+		part->n_hits = 0;
+		part->n_misses = 0;
+	}
 }
 
 /*****************************************************************//**
@@ -190,15 +190,73 @@ void
 btr_search_sys_free(void)
 /*=====================*/
 {
-	rw_lock_free(&btr_search_latch);
-	mem_free(btr_search_latch_temp);
-	btr_search_latch_temp = NULL;
-	mem_heap_free(btr_search_sys->hash_index->heap);
-	hash_table_free(btr_search_sys->hash_index);
+	ulint	i;
+
+	for (i = 0; i < btr_search_n_parts; i++) {
+		btr_search_part_t*	part = &btr_search_sys->parts[i];
+
+		rw_lock_free(&part->latch);
+		mem_heap_free(part->hash_index->heap);
+		hash_table_free(part->hash_index);
+	}
+
+	mem_free(btr_search_sys->parts);
 	mem_free(btr_search_sys);
 	btr_search_sys = NULL;
 }
 
+/********************************************************************//**
+X-latches all the adaptive hash index partitions, in ascending order. */
+UNIV_INTERN
+void
+btr_search_x_lock_all(void)
+/*=======================*/
+{
+	ulint	i;
+
+	for (i = 0; i < btr_search_n_parts; i++) {
+		rw_lock_x_lock(&btr_search_sys->parts[i].latch);
+	}
+}
+
+/********************************************************************//**
+Releases the x-latches on all the adaptive hash index partitions. */
+UNIV_INTERN
+void
+btr_search_x_unlock_all(void)
+/*=========================*/
+{
+	ulint	i;
+
+	for (i = 0; i < btr_search_n_parts; i++) {
+		rw_lock_x_unlock(&btr_search_sys->parts[i].latch);
+	}
+}
+
+#ifdef UNIV_SYNC_DEBUG
+/********************************************************************//**
+Checks if the current thread holds all the adaptive hash index partition
+latches in the given mode.
+@return	TRUE if it does */
+UNIV_INTERN
+ibool
+btr_search_own_all(
+/*===============*/
+	ulint	lock_type)	/*!< in: RW_LOCK_SHARED or RW_LOCK_EX */
+{
+	ulint	i;
+
+	for (i = 0; i < btr_search_n_parts; i++) {
+		if (!rw_lock_own(&btr_search_sys->parts[i].latch,
+				 lock_type)) {
+			return(FALSE);
+		}
+	}
+
+	return(TRUE);
+}
+#endif /* UNIV_SYNC_DEBUG */
+
 /********************************************************************//**
 Disable the adaptive hash search system and empty the index. */
 UNIV_INTERN
@@ -207,7 +265,7 @@ btr_search_disable(void)
 /*====================*/
 {
 	mutex_enter(&btr_search_enabled_mutex);
-	rw_lock_x_lock(&btr_search_latch);
+	btr_search_x_lock_all();
 
 	/* Disable access to hash index, also tell ha_insert_for_fold()
 	stop adding new nodes to hash index, but still allow updating
@@ -215,7 +273,7 @@ btr_search_disable(void)
 	btr_search_enabled = FALSE;
 
 	/* Clear all block->is_hashed flags and remove all entries
-	from btr_search_sys->hash_index. */
+	from the hash indexes of the partitions. */
 	buf_pool_drop_hash_index();
 
 	/* hash index has been cleaned up, disallow any operation to
@@ -225,7 +283,7 @@ btr_search_disable(void)
 	/* btr_search_enabled_mutex should guarantee this. */
 	ut_ad(!btr_search_enabled);
 
-	rw_lock_x_unlock(&btr_search_latch);
+	btr_search_x_unlock_all();
 	mutex_exit(&btr_search_enabled_mutex);
 }
 
@@ -237,12 +295,12 @@ btr_search_enable(void)
 /*====================*/
 {
 	mutex_enter(&btr_search_enabled_mutex);
-	rw_lock_x_lock(&btr_search_latch);
+	btr_search_x_lock_all();
 
 	btr_search_enabled = TRUE;
 	btr_search_fully_disabled = FALSE;
 
-	rw_lock_x_unlock(&btr_search_latch);
+	btr_search_x_unlock_all();
 	mutex_exit(&btr_search_enabled_mutex);
 }
 
@@ -288,27 +346,32 @@ btr_search_info_create(
 }
 
 /*****************************************************************//**
-Returns the value of ref_count. The value is protected by
-btr_search_latch.
+Returns the value of ref_count. The value is protected by the latch of
+the adaptive hash index partition of the index.
 @return	ref_count value. */
 UNIV_INTERN
 ulint
 btr_search_info_get_ref_count(
 /*==========================*/
-	btr_search_t*   info)	/*!< in: search info. */
+	btr_search_t*   info,	/*!< in: search info. */
+	dict_index_t*	index)	/*!< in: index */
 {
-	ulint ret;
+	ulint		ret;
+	rw_lock_t*	latch;
 
 	ut_ad(info);
+	ut_ad(index);
+
+	latch = btr_search_get_latch(index->id);
 
 #ifdef UNIV_SYNC_DEBUG
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_SHARED));
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_EX));
+	ut_ad(!rw_lock_own(latch, RW_LOCK_SHARED));
+	ut_ad(!rw_lock_own(latch, RW_LOCK_EX));
 #endif /* UNIV_SYNC_DEBUG */
 
-	rw_lock_s_lock(&btr_search_latch);
+	rw_lock_s_lock(latch);
 	ret = info->ref_count;
-	rw_lock_s_unlock(&btr_search_latch);
+	rw_lock_s_unlock(latch);
 
 	return(ret);
 }
@@ -328,13 +391,13 @@ btr_search_info_update_hash(
 	ulint		n_unique;
 	int		cmp;
 
+	index = cursor->index;
+
 #ifdef UNIV_SYNC_DEBUG
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_SHARED));
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_EX));
+	ut_ad(!rw_lock_own(btr_search_get_latch(index->id), RW_LOCK_SHARED));
+	ut_ad(!rw_lock_own(btr_search_get_latch(index->id), RW_LOCK_EX));
 #endif /* UNIV_SYNC_DEBUG */
 
-	index = cursor->index;
-
 	if (dict_index_is_ibuf(index)) {
 		/* So many deletes are performed on an insert buffer tree
 		that we do not consider a hash index useful on it: */
@@ -448,8 +511,12 @@ btr_search_update_block_hash_info(
 				/*!< in: cursor */
 {
 #ifdef UNIV_SYNC_DEBUG
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_SHARED));
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_EX));
+	ut_ad(!rw_lock_own(btr_search_get_latch(
+				   btr_page_get_index_id(block->frame)),
+			   RW_LOCK_SHARED));
+	ut_ad(!rw_lock_own(btr_search_get_latch(
+				   btr_page_get_index_id(block->frame)),
+			   RW_LOCK_EX));
 	ut_ad(rw_lock_own(&block->lock, RW_LOCK_SHARED)
 	      || rw_lock_own(&block->lock, RW_LOCK_EX));
 #endif /* UNIV_SYNC_DEBUG */
@@ -533,7 +600,8 @@ btr_search_update_hash_ref(
 
 	ut_ad(cursor->flag == BTR_CUR_HASH_FAIL);
 #ifdef UNIV_SYNC_DEBUG
-	ut_ad(rw_lock_own(&btr_search_latch, RW_LOCK_EX));
+	ut_ad(rw_lock_own(btr_search_get_latch(cursor->index->id),
+			  RW_LOCK_EX));
 	ut_ad(rw_lock_own(&(block->lock), RW_LOCK_SHARED)
 	      || rw_lock_own(&(block->lock), RW_LOCK_EX));
 #endif /* UNIV_SYNC_DEBUG */
@@ -573,10 +641,11 @@ btr_search_update_hash_ref(
 			mem_heap_free(heap);
 		}
 #ifdef UNIV_SYNC_DEBUG
-		ut_ad(rw_lock_own(&btr_search_latch, RW_LOCK_EX));
+		ut_ad(rw_lock_own(btr_search_get_latch(index_id),
+				  RW_LOCK_EX));
 #endif /* UNIV_SYNC_DEBUG */
 
-		ha_insert_for_fold(btr_search_sys->hash_index, fold,
+		ha_insert_for_fold(btr_search_get_hash_index(index_id), fold,
 				   block, rec);
 	}
 }
@@ -590,14 +659,17 @@ btr_search_info_update_slow(
 	btr_search_t*	info,	/*!< in/out: search info */
 	btr_cur_t*	cursor)	/*!< in: cursor which was just positioned */
 {
-	buf_block_t*	block;
-	ibool		build_index;
-	ulint*		params;
-	ulint*		params2;
+	buf_block_t*		block;
+	btr_search_part_t*	part;
+	ibool			build_index;
+	ulint*			params;
+	ulint*			params2;
+
+	part = btr_search_get_part(cursor->index->id);
 
 #ifdef UNIV_SYNC_DEBUG
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_SHARED));
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_EX));
+	ut_ad(!rw_lock_own(&part->latch, RW_LOCK_SHARED));
+	ut_ad(!rw_lock_own(&part->latch, RW_LOCK_EX));
 #endif /* UNIV_SYNC_DEBUG */
 
 	block = btr_cur_get_block(cursor);
@@ -613,7 +685,7 @@ btr_search_info_update_slow(
 
 	if (build_index || (cursor->flag == BTR_CUR_HASH_FAIL)) {
 
-		btr_search_check_free_space_in_heap();
+		btr_search_check_free_space_in_heap(part);
 	}
 
 	if (cursor->flag == BTR_CUR_HASH_FAIL) {
@@ -623,11 +695,11 @@ btr_search_info_update_slow(
 		btr_search_n_hash_fail++;
 #endif /* UNIV_SEARCH_PERF_STAT */
 
-		rw_lock_x_lock(&btr_search_latch);
+		rw_lock_x_lock(&part->latch);
 
 		btr_search_update_hash_ref(info, block, cursor);
 
-		rw_lock_x_unlock(&btr_search_latch);
+		rw_lock_x_unlock(&part->latch);
 	}
 
 	if (build_index) {
@@ -670,8 +742,8 @@ btr_search_check_guess(
 	btr_cur_t*	cursor,	/*!< in: guessed cursor position */
 	ibool		can_only_compare_to_cursor_rec,
 				/*!< in: if we do not have a latch on the page
-				of cursor, but only a latch on
-				btr_search_latch, then ONLY the columns
+				of cursor, but only a latch on the
+				partition latch, then ONLY the columns
 				of the record UNDER the cursor are
 				protected, not the next or previous record
 				in the chain: we cannot look at the next or
@@ -826,15 +898,17 @@ btr_search_guess_on_hash(
 					to protect the record! */
 	btr_cur_t*	cursor,		/*!< out: tree cursor */
 	ulint		has_search_latch,/*!< in: latch mode the caller
-					currently has on btr_search_latch:
+					currently has on the adaptive hash
+					index partition latch of index:
 					RW_S_LATCH, RW_X_LATCH, or 0 */
 	mtr_t*		mtr)		/*!< in: mtr */
 {
-	buf_pool_t*	buf_pool;
-	buf_block_t*	block;
-	rec_t*		rec;
-	ulint		fold;
-	index_id_t	index_id;
+	buf_pool_t*		buf_pool;
+	buf_block_t*		block;
+	btr_search_part_t*	part;
+	rec_t*			rec;
+	ulint			fold;
+	index_id_t		index_id;
 #ifdef notdefined
 	btr_cur_t	cursor2;
 	btr_pcur_t	pcur;
@@ -861,6 +935,7 @@ btr_search_guess_on_hash(
 	}
 
 	index_id = index->id;
+	part = btr_search_get_part(index_id);
 
 #ifdef UNIV_SEARCH_PERF_STAT
 	info->n_hash_succ++;
@@ -871,17 +946,17 @@ btr_search_guess_on_hash(
 	cursor->flag = BTR_CUR_HASH;
 
 	if (UNIV_LIKELY(!has_search_latch)) {
-		rw_lock_s_lock(&btr_search_latch);
+		rw_lock_s_lock(&part->latch);
 
 		if (UNIV_UNLIKELY(!btr_search_enabled)) {
 			goto failure_unlock;
 		}
 	}
 
-	ut_ad(rw_lock_get_writer(&btr_search_latch) != RW_LOCK_EX);
-	ut_ad(rw_lock_get_reader_count(&btr_search_latch) > 0);
+	ut_ad(rw_lock_get_writer(&part->latch) != RW_LOCK_EX);
+	ut_ad(rw_lock_get_reader_count(&part->latch) > 0);
 
-	rec = (rec_t *)ha_search_and_get_data(btr_search_sys->hash_index, fold);
+	rec = (rec_t *)ha_search_and_get_data(part->hash_index, fold);
 
 	if (UNIV_UNLIKELY(!rec)) {
 		goto failure_unlock;
@@ -899,7 +974,7 @@ btr_search_guess_on_hash(
 			goto failure_unlock;
 		}
 
-		rw_lock_s_unlock(&btr_search_latch);
+		rw_lock_s_unlock(&part->latch);
 
 		buf_block_dbg_add_level(block, SYNC_TREE_NODE_FROM_HASH);
 	}
@@ -921,7 +996,7 @@ btr_search_guess_on_hash(
 
 	/* Check the validity of the guess within the page */
 
-	/* If we only have the latch on btr_search_latch, not on the
+	/* If we only have the partition latch, not the latch on the
 	page, it only protects the columns of the record the cursor
 	is positioned on. We cannot look at the next of the previous
 	record to determine if our guess for the cursor position is
@@ -976,6 +1051,7 @@ btr_search_guess_on_hash(
 	meanwhile! Thus it might not be a bug. */
 #endif
 	info->last_hash_succ = TRUE;
+	part->n_hits++;
 
 #ifdef UNIV_SEARCH_PERF_STAT
 	btr_search_n_succ++;
@@ -996,10 +1072,11 @@ btr_search_guess_on_hash(
 	/*-------------------------------------------*/
 failure_unlock:
 	if (UNIV_LIKELY(!has_search_latch)) {
-		rw_lock_s_unlock(&btr_search_latch);
+		rw_lock_s_unlock(&part->latch);
 	}
 failure:
 	cursor->flag = BTR_CUR_HASH_FAIL;
+	part->n_misses++;
 
 #ifdef UNIV_SEARCH_PERF_STAT
 	info->n_hash_fail++;
@@ -1025,6 +1102,7 @@ btr_search_drop_page_hash_index(
 				block->buf_fix_count == 0 */
 {
 	hash_table_t*		table;
+	btr_search_part_t*	part;
 	ulint			n_fields;
 	ulint			n_bytes;
 	const page_t*		page;
@@ -1040,23 +1118,32 @@ btr_search_drop_page_hash_index(
 	const dict_index_t*	index;
 	ulint*			offsets;
 
+	page = block->frame;
+
+	/* The page of a hashed block is hashed in the partition of the
+	index id stored on the page. The id cannot change as long as the
+	block is hashed, and if the block is not hashed, the partition we
+	pick does not matter: we only find out that it is not hashed. */
+
+	index_id = btr_page_get_index_id(page);
+	part = btr_search_get_part(index_id);
+
 #ifdef UNIV_SYNC_DEBUG
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_SHARED));
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_EX));
+	ut_ad(!rw_lock_own(&part->latch, RW_LOCK_SHARED));
+	ut_ad(!rw_lock_own(&part->latch, RW_LOCK_EX));
 #endif /* UNIV_SYNC_DEBUG */
 
 retry:
-	rw_lock_s_lock(&btr_search_latch);
-	page = block->frame;
+	rw_lock_s_lock(&part->latch);
 
 	if (UNIV_LIKELY(!block->is_hashed)) {
 
-		rw_lock_s_unlock(&btr_search_latch);
+		rw_lock_s_unlock(&part->latch);
 
 		return;
 	}
 
-	table = btr_search_sys->hash_index;
+	table = part->hash_index;
 
 #ifdef UNIV_SYNC_DEBUG
 	ut_ad(rw_lock_own(&(block->lock), RW_LOCK_SHARED)
@@ -1070,10 +1157,10 @@ retry:
 	ut_a(!dict_index_is_ibuf(index));
 
 	/* NOTE: The fields of block must not be accessed after
-	releasing btr_search_latch, as the index page might only
+	releasing the partition latch, as the index page might only
 	be s-latched! */
 
-	rw_lock_s_unlock(&btr_search_latch);
+	rw_lock_s_unlock(&part->latch);
 
 	ut_a(n_fields + n_bytes > 0);
 
@@ -1089,8 +1176,6 @@ retry:
 	rec = page_get_infimum_rec(page);
 	rec = page_rec_get_next_low(rec, page_is_comp(page));
 
-	index_id = btr_page_get_index_id(page);
-
 	ut_a(index_id == index->id);
 
 	prev_fold = 0;
@@ -1123,7 +1208,7 @@ next_rec:
 		mem_heap_free(heap);
 	}
 
-	rw_lock_x_lock(&btr_search_latch);
+	rw_lock_x_lock(&part->latch);
 
 	if (UNIV_UNLIKELY(!block->is_hashed)) {
 		/* Someone else has meanwhile dropped the hash index */
@@ -1139,7 +1224,7 @@ next_rec:
 		/* Someone else has meanwhile built a new hash index on the
 		page, with different parameters */
 
-		rw_lock_x_unlock(&btr_search_latch);
+		rw_lock_x_unlock(&part->latch);
 
 		mem_free(folds);
 		goto retry;
@@ -1167,14 +1252,14 @@ cleanup:
 			"InnoDB: the hash index to a page of %s,"
 			" still %lu hash nodes remain.\n",
 			index->name, (ulong) block->n_pointers);
-		rw_lock_x_unlock(&btr_search_latch);
+		rw_lock_x_unlock(&part->latch);
 
 		btr_search_validate();
 	} else {
-		rw_lock_x_unlock(&btr_search_latch);
+		rw_lock_x_unlock(&part->latch);
 	}
 #else /* UNIV_AHI_DEBUG || UNIV_DEBUG */
-	rw_lock_x_unlock(&btr_search_latch);
+	rw_lock_x_unlock(&part->latch);
 #endif /* UNIV_AHI_DEBUG || UNIV_DEBUG */
 
 	mem_free(folds);
@@ -1243,6 +1328,7 @@ btr_search_build_page_hash_index(
 	ibool		left_side)/*!< in: hash for searches from left side? */
 {
 	hash_table_t*	table;
+	btr_search_part_t*	part;
 	page_t*		page;
 	rec_t*		rec;
 	rec_t*		next_rec;
@@ -1262,26 +1348,32 @@ btr_search_build_page_hash_index(
 	ut_ad(index);
 	ut_a(!dict_index_is_ibuf(index));
 
-	table = btr_search_sys->hash_index;
 	page = buf_block_get_frame(block);
 
+	/* Use the index id on the page, like
+	btr_search_drop_page_hash_index() does */
+
+	index_id = btr_page_get_index_id(page);
+	part = btr_search_get_part(index_id);
+	table = part->hash_index;
+
 #ifdef UNIV_SYNC_DEBUG
-	ut_ad(!rw_lock_own(&btr_search_latch, RW_LOCK_EX));
+	ut_ad(!rw_lock_own(&part->latch, RW_LOCK_EX));
 	ut_ad(rw_lock_own(&(block->lock), RW_LOCK_SHARED)
 	      || rw_lock_own(&(block->lock), RW_LOCK_EX));
 #endif /* UNIV_SYNC_DEBUG */
 
-	rw_lock_s_lock(&btr_search_latch);
+	rw_lock_s_lock(&part->latch);
 
 	if (block->is_hashed && ((block->curr_n_fields != n_fields)
 				 || (block->curr_n_bytes != n_bytes)
 				 || (block->curr_left_side != left_side))) {
 
-		rw_lock_s_unlock(&btr_search_latch);
+		rw_lock_s_unlock(&part->latch);
 
 		btr_search_drop_page_hash_index(block);
 	} else {
-		rw_lock_s_unlock(&btr_search_latch);
+		rw_lock_s_unlock(&part->latch);
 	}
 
 	n_recs = page_get_n_recs(page);
@@ -1312,8 +1404,6 @@ btr_search_build_page_hash_index(
 
 	n_cached = 0;
 
-	index_id = btr_page_get_index_id(page);
-
 	rec = page_rec_get_next(page_get_infimum_rec(page));
 
 	offsets = rec_get_offsets(rec, index, offsets,
@@ -1375,9 +1465,9 @@ btr_search_build_page_hash_index(
 		fold = next_fold;
 	}
 
-	btr_search_check_free_space_in_heap();
+	btr_search_check_free_space_in_heap(part);
 
-	rw_lock_x_lock(&btr_search_latch);
+	rw_lock_x_lock(&part->latch);
 
 	if (UNIV_UNLIKELY(btr_search_fully_disabled)) {
 		goto exit_func;
@@ -1412,7 +1502,7 @@ btr_search_build_page_hash_index(
 	}
 
 exit_func:
-	rw_lock_x_unlock(&btr_search_latch);
+	rw_lock_x_unlock(&part->latch);
 
 	mem_free(folds);
 	mem_free(recs);
@@ -1438,9 +1528,10 @@ btr_search_move_or_delete_hash_entries(
 					from this page */
 	dict_index_t*	index)		/*!< in: record descriptor */
 {
-	ulint	n_fields;
-	ulint	n_bytes;
-	ibool	left_side;
+	ulint		n_fields;
+	ulint		n_bytes;
+	ibool		left_side;
+	rw_lock_t*	latch;
 
 #ifdef UNIV_SYNC_DEBUG
 	ut_ad(rw_lock_own(&(block->lock), RW_LOCK_EX));
@@ -1451,11 +1542,13 @@ btr_search_move_or_delete_hash_entries(
 	ut_a(!(new_block->is_hashed || block->is_hashed)
 	     || !dict_index_is_ibuf(index));
 
-	rw_lock_s_lock(&btr_search_latch);
+	latch = btr_search_get_latch(index->id);
+
+	rw_lock_s_lock(latch);
 
 	if (new_block->is_hashed) {
 
-		rw_lock_s_unlock(&btr_search_latch);
+		rw_lock_s_unlock(latch);
 
 		btr_search_drop_page_hash_index(block);
 
@@ -1472,7 +1565,7 @@ btr_search_move_or_delete_hash_entries(
 		new_block->n_bytes = block->curr_n_bytes;
 		new_block->left_side = left_side;
 
-		rw_lock_s_unlock(&btr_search_latch);
+		rw_lock_s_unlock(latch);
 
 		ut_a(n_fields + n_bytes > 0);
 
@@ -1484,7 +1577,7 @@ btr_search_move_or_delete_hash_entries(
 		return;
 	}
 
-	rw_lock_s_unlock(&btr_search_latch);
+	rw_lock_s_unlock(latch);
 }
 
 /********************************************************************//**
@@ -1498,6 +1591,7 @@ btr_search_update_hash_on_delete(
 				the record is not yet deleted */
 {
 	hash_table_t*	table;
+	btr_search_part_t*	part;
 	buf_block_t*	block;
 	rec_t*		rec;
 	ulint		fold;
@@ -1523,20 +1617,21 @@ btr_search_update_hash_on_delete(
 	ut_a(block->curr_n_fields + block->curr_n_bytes > 0);
 	ut_a(!dict_index_is_ibuf(cursor->index));
 
-	table = btr_search_sys->hash_index;
-
 	index_id = cursor->index->id;
+	part = btr_search_get_part(index_id);
+	table = part->hash_index;
+
 	fold = rec_fold(rec, rec_get_offsets(rec, cursor->index, offsets_,
 					     ULINT_UNDEFINED, &heap),
 			block->curr_n_fields, block->curr_n_bytes, index_id);
 	if (UNIV_LIKELY_NULL(heap)) {
 		mem_heap_free(heap);
 	}
-	rw_lock_x_lock(&btr_search_latch);
+	rw_lock_x_lock(&part->latch);
 
 	ha_search_and_delete_if_found(table, fold, rec);
 
-	rw_lock_x_unlock(&btr_search_latch);
+	rw_lock_x_unlock(&part->latch);
 }
 
 /********************************************************************//**
@@ -1551,6 +1646,7 @@ btr_search_update_hash_node_on_insert(
 				to the cursor */
 {
 	hash_table_t*	table;
+	rw_lock_t*	latch;
 	buf_block_t*	block;
 	rec_t*		rec;
 
@@ -1570,21 +1666,23 @@ btr_search_update_hash_node_on_insert(
 	ut_a(block->index == cursor->index);
 	ut_a(!dict_index_is_ibuf(cursor->index));
 
-	rw_lock_x_lock(&btr_search_latch);
+	latch = btr_search_get_latch(cursor->index->id);
+
+	rw_lock_x_lock(latch);
 
 	if ((cursor->flag == BTR_CUR_HASH)
 	    && (cursor->n_fields == block->curr_n_fields)
 	    && (cursor->n_bytes == block->curr_n_bytes)
 	    && !block->curr_left_side) {
 
-		table = btr_search_sys->hash_index;
+		table = btr_search_get_hash_index(cursor->index->id);
 
 		ha_search_and_update_if_found(table, cursor->fold, rec,
 					      block, page_rec_get_next(rec));
 
-		rw_lock_x_unlock(&btr_search_latch);
+		rw_lock_x_unlock(latch);
 	} else {
-		rw_lock_x_unlock(&btr_search_latch);
+		rw_lock_x_unlock(latch);
 
 		btr_search_update_hash_on_insert(cursor);
 	}
@@ -1602,6 +1700,7 @@ btr_search_update_hash_on_insert(
 				to the cursor */
 {
 	hash_table_t*	table;
+	btr_search_part_t*	part;
 	buf_block_t*	block;
 	rec_t*		rec;
 	rec_t*		ins_rec;
@@ -1619,9 +1718,10 @@ btr_search_update_hash_on_insert(
 	ulint*		offsets		= offsets_;
 	rec_offs_init(offsets_);
 
-	table = btr_search_sys->hash_index;
+	part = btr_search_get_part(cursor->index->id);
+	table = part->hash_index;
 
-	btr_search_check_free_space_in_heap();
+	btr_search_check_free_space_in_heap(part);
 
 	rec = btr_cur_get_rec(cursor);
 
@@ -1666,7 +1766,7 @@ btr_search_update_hash_on_insert(
 	} else {
 		if (left_side) {
 
-			rw_lock_x_lock(&btr_search_latch);
+			rw_lock_x_lock(&part->latch);
 
 			locked = TRUE;
 
@@ -1680,7 +1780,7 @@ btr_search_update_hash_on_insert(
 
 		if (!locked) {
 
-			rw_lock_x_lock(&btr_search_latch);
+			rw_lock_x_lock(&part->latch);
 
 			locked = TRUE;
 		}
@@ -1698,7 +1798,7 @@ check_next_rec:
 		if (!left_side) {
 
 			if (!locked) {
-				rw_lock_x_lock(&btr_search_latch);
+				rw_lock_x_lock(&part->latch);
 
 				locked = TRUE;
 			}
@@ -1713,7 +1813,7 @@ check_next_rec:
 
 		if (!locked) {
 
-			rw_lock_x_lock(&btr_search_latch);
+			rw_lock_x_lock(&part->latch);
 
 			locked = TRUE;
 		}
@@ -1736,18 +1836,19 @@ function_exit:
 		mem_heap_free(heap);
 	}
 	if (locked) {
-		rw_lock_x_unlock(&btr_search_latch);
+		rw_lock_x_unlock(&part->latch);
 	}
 }
 
 #if defined UNIV_AHI_DEBUG || defined UNIV_DEBUG
 /********************************************************************//**
-Validates the search system.
+Validates an adaptive hash index partition.
 @return	TRUE if ok */
-UNIV_INTERN
+static
 ibool
-btr_search_validate(void)
+btr_search_validate_part(
 /*=====================*/
+	btr_search_part_t*	part)	/*!< in: partition */
 {
 	ha_node_t*	node;
 	ulint		n_page_dumps	= 0;
@@ -1759,28 +1860,28 @@ btr_search_validate(void)
 	ulint*		offsets		= offsets_;
 
 	/* How many cells to check before temporarily releasing
-	btr_search_latch. */
+	the partition latch. */
 	ulint		chunk_size = 10000;
 
 	rec_offs_init(offsets_);
 
-	rw_lock_x_lock(&btr_search_latch);
+	rw_lock_x_lock(&part->latch);
 	buf_pool_mutex_enter_all();
 
-	cell_count = hash_get_n_cells(btr_search_sys->hash_index);
+	cell_count = hash_get_n_cells(part->hash_index);
 
 	for (i = 0; i < cell_count; i++) {
-		/* We release btr_search_latch every once in a while to
+		/* We release the partition latch every once in a while to
 		give other queries a chance to run. */
 		if ((i != 0) && ((i % chunk_size) == 0)) {
 			buf_pool_mutex_exit_all();
-			rw_lock_x_unlock(&btr_search_latch);
+			rw_lock_x_unlock(&part->latch);
 			os_thread_yield();
-			rw_lock_x_lock(&btr_search_latch);
+			rw_lock_x_lock(&part->latch);
 			buf_pool_mutex_enter_all();
 		}
 
-		node = hash_get_nth_cell(btr_search_sys->hash_index, i)->node;
+		node = hash_get_nth_cell(part->hash_index, i)->node;
 
 		for (; node != NULL; node = node->next) {
 			const buf_block_t*	block
@@ -1817,8 +1918,8 @@ btr_search_validate(void)
 				buf_LRU_block_remove_hashed_page().
 				After that, it invokes
 				btr_search_drop_page_hash_index() to
-				remove the block from
-				btr_search_sys->hash_index. */
+				remove the block from the hash
+				index of the partition. */
 
 				ut_a(buf_block_get_state(block)
 				     == BUF_BLOCK_REMOVE_HASH);
@@ -1835,7 +1936,9 @@ btr_search_validate(void)
 			page_index_id = btr_page_get_index_id(block->frame);
 
 			if (UNIV_UNLIKELY
-			    (!block->is_hashed || node->fold
+			    (!block->is_hashed
+			     || btr_search_get_part(page_index_id) != part
+			     || node->fold
 			     != rec_fold((rec_t*)(node->data),
 					 offsets,
 					 block->curr_n_fields,
@@ -1885,27 +1988,47 @@ btr_search_validate(void)
 	for (i = 0; i < cell_count; i += chunk_size) {
 		ulint end_index = ut_min(i + chunk_size - 1, cell_count - 1);
 
-		/* We release btr_search_latch every once in a while to
+		/* We release the partition latch every once in a while to
 		give other queries a chance to run. */
 		if (i != 0) {
 			buf_pool_mutex_exit_all();
-			rw_lock_x_unlock(&btr_search_latch);
+			rw_lock_x_unlock(&part->latch);
 			os_thread_yield();
-			rw_lock_x_lock(&btr_search_latch);
+			rw_lock_x_lock(&part->latch);
 			buf_pool_mutex_enter_all();
 		}
 
-		if (!ha_validate(btr_search_sys->hash_index, i, end_index)) {
+		if (!ha_validate(part->hash_index, i, end_index)) {
 			ok = FALSE;
 		}
 	}
 
 	buf_pool_mutex_exit_all();
-	rw_lock_x_unlock(&btr_search_latch);
+	rw_lock_x_unlock(&part->latch);
 	if (UNIV_LIKELY_NULL(heap)) {
 		mem_heap_free(heap);
 	}
 
 	return(ok);
 }
+
+/********************************************************************//**
+Validates the search system.
+@return	TRUE if ok */
+UNIV_INTERN
+ibool
+btr_search_validate(void)
+/*=====================*/
+{
+	ibool	ok	= TRUE;
+	ulint	i;
+
+	for (i = 0; i < btr_search_n_parts; i++) {
+		if (!btr_search_validate_part(&btr_search_sys->parts[i])) {
+			ok = FALSE;
+		}
+	}
+
+	return(ok);
+}
 #endif /* defined UNIV_AHI_DEBUG || defined UNIV_DEBUG */
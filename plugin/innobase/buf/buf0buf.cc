@@ -51,6 +51,7 @@ Created 11/5/1995 Heikki Tuuri
 #include "dict0dict.h"
 #include "log0recv.h"
 #include "page0zip.h"
+#include "ut0crc32.h"
 
 #include <drizzled/errmsg_print.h>
 
@@ -495,6 +496,87 @@ buf_calc_page_old_checksum(
 	return(checksum);
 }
 
+/********************************************************************//**
+Calculates the CRC32C checksum of a page. It covers the same bytes as
+buf_calc_page_new_checksum() and is stored to both checksum fields of the
+page when innodb_checksum_algorithm=crc32.
+@return	checksum */
+UNIV_INTERN
+ulint
+buf_calc_page_crc32(
+/*================*/
+	const byte*	page)	/*!< in: buffer page */
+{
+	ib_uint32_t	c1;
+	ib_uint32_t	c2;
+
+	/* See buf_calc_page_new_checksum() for the fields that are
+	skipped */
+
+	c1 = ut_crc32(page + FIL_PAGE_OFFSET,
+		      FIL_PAGE_FILE_FLUSH_LSN - FIL_PAGE_OFFSET);
+	c2 = ut_crc32(page + FIL_PAGE_DATA,
+		      UNIV_PAGE_SIZE - FIL_PAGE_DATA
+		      - FIL_PAGE_END_LSN_OLD_CHKSUM);
+
+	return(c1 ^ c2);
+}
+
+/********************************************************************//**
+Checks the InnoDB fold checksums of an uncompressed page.
+@return	TRUE if both checksum fields are valid */
+static
+ibool
+buf_page_innodb_checksum_ok(
+/*========================*/
+	const byte*	read_buf,		/*!< in: a database page */
+	ulint		checksum_field,		/*!< in: the checksum at
+						FIL_PAGE_SPACE_OR_CHKSUM */
+	ulint		old_checksum_field)	/*!< in: the checksum at
+						the end of the page */
+{
+	/* There are 2 valid formulas for old_checksum_field:
+
+	1. Very old versions of InnoDB only stored 8 byte lsn to the
+	start and the end of the page.
+
+	2. Newer InnoDB versions store the old formula checksum
+	there. */
+
+	if (old_checksum_field != mach_read_from_4(read_buf
+						   + FIL_PAGE_LSN)
+	    && old_checksum_field != BUF_NO_CHECKSUM_MAGIC
+	    && old_checksum_field
+	    != buf_calc_page_old_checksum(read_buf)) {
+
+		return(FALSE);
+	}
+
+	/* InnoDB versions < 4.0.14 and < 4.1.1 stored the space id
+	(always equal to 0), to FIL_PAGE_SPACE_OR_CHKSUM */
+
+	return(checksum_field == 0
+	       || checksum_field == BUF_NO_CHECKSUM_MAGIC
+	       || checksum_field == buf_calc_page_new_checksum(read_buf));
+}
+
+/********************************************************************//**
+Checks the CRC32C checksum of an uncompressed page.
+@return	TRUE if both checksum fields hold the CRC32C of the page */
+static
+ibool
+buf_page_crc32_ok(
+/*==============*/
+	const byte*	read_buf,		/*!< in: a database page */
+	ulint		checksum_field,		/*!< in: the checksum at
+						FIL_PAGE_SPACE_OR_CHKSUM */
+	ulint		old_checksum_field)	/*!< in: the checksum at
+						the end of the page */
+{
+	return(checksum_field == old_checksum_field
+	       && checksum_field == buf_calc_page_crc32(read_buf));
+}
+
 /********************************************************************//**
 Checks if a page is corrupt.
 @return	TRUE if corrupted */
@@ -562,33 +644,22 @@ buf_page_is_corrupted(
 			read_buf + UNIV_PAGE_SIZE
 			- FIL_PAGE_END_LSN_OLD_CHKSUM);
 
-		/* There are 2 valid formulas for old_checksum_field:
+		/* A page may have been written with either algorithm,
+		e.g. before innodb_checksum_algorithm was changed. Try the
+		one that this server writes first. */
 
-		1. Very old versions of InnoDB only stored 8 byte lsn to the
-		start and the end of the page.
-
-		2. Newer InnoDB versions store the old formula checksum
-		there. */
-
-		if (old_checksum_field != mach_read_from_4(read_buf
-							   + FIL_PAGE_LSN)
-		    && old_checksum_field != BUF_NO_CHECKSUM_MAGIC
-		    && old_checksum_field
-		    != buf_calc_page_old_checksum(read_buf)) {
-
-			return(TRUE);
+		if (srv_checksum_algorithm == SRV_CHECKSUM_ALGORITHM_CRC32) {
+			return(!buf_page_crc32_ok(read_buf, checksum_field,
+						  old_checksum_field)
+			       && !buf_page_innodb_checksum_ok(
+				       read_buf, checksum_field,
+				       old_checksum_field));
 		}
 
-		/* InnoDB versions < 4.0.14 and < 4.1.1 stored the space id
-		(always equal to 0), to FIL_PAGE_SPACE_OR_CHKSUM */
-
-		if (checksum_field != 0
-		    && checksum_field != BUF_NO_CHECKSUM_MAGIC
-		    && checksum_field
-		    != buf_calc_page_new_checksum(read_buf)) {
-
-			return(TRUE);
-		}
+		return(!buf_page_innodb_checksum_ok(read_buf, checksum_field,
+						    old_checksum_field)
+		       && !buf_page_crc32_ok(read_buf, checksum_field,
+					     old_checksum_field));
 	}
 
 	return(FALSE);
@@ -720,6 +791,11 @@ buf_page_print(
 		(ulong) mach_read_from_4(read_buf
 					 + FIL_PAGE_ARCH_LOG_NO_OR_SPACE_ID));
 
+	if (srv_use_checksums) {
+		fprintf(stderr, "InnoDB: Page CRC32C checksum %lu\n",
+			(ulong) buf_calc_page_crc32(read_buf));
+	}
+
 #ifndef UNIV_HOTBACKUP
 	if (mach_read_from_2(read_buf + TRX_UNDO_PAGE_HDR + TRX_UNDO_PAGE_TYPE)
 	    == TRX_UNDO_INSERT) {
@@ -1362,17 +1438,18 @@ buf_pool_drop_hash_index_instance(
 
 		for (i = chunk->size; i--; block++) {
 			/* block->is_hashed cannot be modified
-			when we have an x-latch on btr_search_latch;
-			see the comment in buf0buf.h */
+			when we have x-latches on all the partitions
+			of the adaptive hash index; see the comment
+			in buf0buf.h */
 
 			if (!block->is_hashed) {
 				continue;
 			}
 
 			/* To follow the latching order, we
-			have to release btr_search_latch
+			have to release the partition latches
 			before acquiring block->latch. */
-			rw_lock_x_unlock(&btr_search_latch);
+			btr_search_x_unlock_all();
 			/* When we release the search latch,
 			we must rescan all blocks, because
 			some may become hashed again. */
@@ -1389,7 +1466,7 @@ buf_pool_drop_hash_index_instance(
 			block by calling buf_block_get_gen(),
 			it is possible that the block has been
 			allocated for some other use after
-			btr_search_latch was released above.
+			the partition latches were released above.
 			We do not care which file page the
 			block is mapped to.  All we want to do
 			is to drop any hash entries referring
@@ -1407,7 +1484,7 @@ buf_pool_drop_hash_index_instance(
 
 			rw_lock_x_unlock(&block->lock);
 
-			rw_lock_x_lock(&btr_search_latch);
+			btr_search_x_lock_all();
 
 			ut_ad(!btr_search_enabled);
 		}
@@ -1416,8 +1493,8 @@ buf_pool_drop_hash_index_instance(
 
 /********************************************************************//**
 Drops the adaptive hash index.  To prevent a livelock, this function
-is only to be called while holding btr_search_latch and while
-btr_search_enabled == FALSE. */
+is only to be called while holding all the adaptive hash index
+partition latches and while btr_search_enabled == FALSE. */
 UNIV_INTERN
 void
 buf_pool_drop_hash_index(void)
@@ -1426,7 +1503,7 @@ buf_pool_drop_hash_index(void)
 	ibool		released_search_latch;
 
 #ifdef UNIV_SYNC_DEBUG
-	ut_ad(rw_lock_own(&btr_search_latch, RW_LOCK_EX));
+	ut_ad(btr_search_own_all(RW_LOCK_EX));
 #endif /* UNIV_SYNC_DEBUG */
 	ut_ad(!btr_search_enabled);
 
@@ -89,7 +89,8 @@ ha_create_func(
 }
 
 /*************************************************************//**
-Empties a hash table and frees the memory heaps. */
+Empties a hash table and frees the memory heaps. The caller must hold
+the latch of the adaptive hash index partition of the table in X mode. */
 UNIV_INTERN
 void
 ha_clear(
@@ -101,9 +102,6 @@ ha_clear(
 
 	ut_ad(table);
 	ut_ad(table->magic_n == HASH_TABLE_MAGIC_N);
-#ifdef UNIV_SYNC_DEBUG
-	ut_ad(rw_lock_own(&btr_search_latch, RW_LOCK_EXCLUSIVE));
-#endif /* UNIV_SYNC_DEBUG */
 
 #ifndef UNIV_HOTBACKUP
 	/* Free the memory heaps. */
@@ -26,6 +26,7 @@ St, Fifth Floor, Boston, MA 02110-1301 USA
 #include "trx0trx.h" /* for TRX_QUE_STATE_STR_MAX_LEN */
 #include "buf0buddy.h" /* for i_s_cmpmem */
 #include "buf0buf.h" /* for buf_pool and PAGE_ZIP_MIN_SIZE */
+#include "btr0sea.h" /* for btr_search_sys */
 #include "ha_prototypes.h" /* for innobase_convert_name() */
 #include "srv0start.h" /* for srv_was_started */
 #include "btr0pcur.h"	/* for file sys_tables related info. */
@@ -690,6 +691,48 @@ bool CmpmemTool::Generator::populate()
   return true;
 }
 
+/*
+ * Fill the dynamic table data_dictionary.INNODB_AHI_PARTITIONS
+ *
+ */
+AhiPartitionsTool::AhiPartitionsTool() :
+  plugin::TableFunction("DATA_DICTIONARY", "INNODB_AHI_PARTITIONS")
+{
+  add_field("PARTITION_ID", plugin::TableFunction::NUMBER, 0, false);
+  add_field("HASH_CELLS", plugin::TableFunction::NUMBER, 0, false);
+  add_field("HITS", plugin::TableFunction::NUMBER, 0, false);
+  add_field("MISSES", plugin::TableFunction::NUMBER, 0, false);
+  add_field("LATCH_WAITS", plugin::TableFunction::NUMBER, 0, false);
+}
+
+AhiPartitionsTool::Generator::Generator(Field **arg) :
+  plugin::TableFunction::Generator(arg),
+  record_number(0)
+{
+}
+
+bool AhiPartitionsTool::Generator::populate()
+{
+  if (btr_search_sys == NULL || record_number >= btr_search_n_parts)
+  {
+    return false;
+  }
+
+  btr_search_part_t* part= &btr_search_sys->parts[record_number];
+
+  /* The counters are not protected by any latch, like the
+     compression statistics above; they may be slightly off. */
+  push(static_cast<uint64_t>(record_number));
+  push(static_cast<uint64_t>(hash_get_n_cells(part->hash_index)));
+  push(static_cast<uint64_t>(part->n_hits));
+  push(static_cast<uint64_t>(part->n_misses));
+  push(static_cast<uint64_t>(part->latch.count_os_wait));
+
+  record_number++;
+
+  return true;
+}
+
 /*
  * Fill the dynamic table data_dictionary.INNODB_TRX INNODB_LOCKS INNODB_LOCK_WAITS
  *
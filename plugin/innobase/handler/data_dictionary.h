@@ -249,6 +249,28 @@ private:
   bool outer_reset;
 };
 
+class AhiPartitionsTool : public drizzled::plugin::TableFunction
+{
+public:
+
+  AhiPartitionsTool();
+
+  class Generator : public drizzled::plugin::TableFunction::Generator
+  {
+  public:
+    Generator(drizzled::Field **arg);
+
+    bool populate();
+  private:
+    uint32_t record_number;
+  };
+
+  Generator *generator(drizzled::Field **arg)
+  {
+    return new Generator(arg);
+  }
+};
+
 class InnodbTrxTool : public drizzled::plugin::TableFunction
 {
 public:
@@ -75,6 +75,7 @@ St, Fifth Floor, Boston, MA 02110-1301 USA
 #include <drizzled/session/transactions.h>
 #include <drizzled/typelib.h>
 #include <drizzled/key_part_info.h>
+#include <drizzled/optimizer/cost_model.h>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/program_options.hpp>
@@ -120,6 +121,7 @@ using namespace std;
 #include "dict0boot.h"
 #include "ha_prototypes.h"
 #include "ut0mem.h"
+#include "ut0crc32.h"
 #include "ibuf0ibuf.h"
 
 #include "ha_innodb.h"
@@ -186,6 +188,8 @@ typedef constrained_check<size_t, SIZE_MAX, 33554432, 1048576> buffer_pool_const
 static buffer_pool_constraint innobase_buffer_pool_size;
 typedef constrained_check<uint32_t, MAX_BUFFER_POOLS, 1> buffer_pool_instances_constraint;
 static buffer_pool_instances_constraint innobase_buffer_pool_instances;
+typedef constrained_check<uint32_t, BTR_SEARCH_MAX_PARTS, 1> adaptive_hash_index_partitions_constraint;
+static adaptive_hash_index_partitions_constraint innobase_adaptive_hash_index_partitions;
 typedef constrained_check<uint32_t,
 			  (1 << UNIV_PAGE_SIZE_SHIFT_MAX),
 				(1 << 12)> page_size_constraint;
@@ -261,6 +265,7 @@ static string innobase_change_buffering;
 
 static string read_ahead;
 static string adaptive_flushing_method;
+static string innobase_checksum_algorithm;
 
 /* The highest file format being used in the database. The value can be
 set by user, however, it will be adjusted to the newer file format if
@@ -370,6 +375,21 @@ static TYPELIB adaptive_flushing_method_typelib = {
   adaptive_flushing_method_names, NULL
 };
 
+/** Allowed values of checksum_algorithm, in the order of
+srv_checksum_algorithm_t */
+static const char* checksum_algorithm_names[] = {
+  "innodb",
+  "crc32",
+  "none",
+  NULL
+};
+
+static TYPELIB checksum_algorithm_typelib = {
+  array_elements(checksum_algorithm_names) - 1,
+  "checksum_algorithm_typelib",
+  checksum_algorithm_names, NULL
+};
+
 /* "GEN_CLUST_INDEX" is the name reserved for Innodb default
 system primary index. */
 static const char innobase_index_reserve_name[]= "GEN_CLUST_INDEX";
@@ -394,7 +414,8 @@ public:
                             HTON_PRIMARY_KEY_IN_READ_INDEX |
                             HTON_PARTIAL_COLUMN_READ |
                             HTON_TABLE_SCAN_ON_INDEX |
-                            HTON_HAS_FOREIGN_KEYS)
+                            HTON_HAS_FOREIGN_KEYS |
+                            HTON_SHARED_SNAPSHOT)
   {
     table_definition_ext= plugin::defaultTableDefinitionFileExt();
     addAlias("INNOBASE");
@@ -2261,6 +2282,9 @@ innobase_init(
   srv_adaptive_flushing_method = adaptive_flushing_method_typelib.find_type_or_exit(vm["adaptive-flushing-method"].as<string>().c_str(),
                                                                                     "adaptive_flushing_method_typelib") + 1;
 
+  srv_checksum_algorithm = checksum_algorithm_typelib.find_type_or_exit(vm["checksum-algorithm"].as<string>().c_str(),
+                                                                        "checksum_algorithm_typelib") - 1;
+
   /* Inverted Booleans */
 
   innobase_use_checksums= not vm.count("disable-checksums");
@@ -2508,6 +2532,8 @@ innobase_change_buffering_inited_ok:
   srv_buf_pool_size = (ulint) innobase_buffer_pool_size;
   srv_buf_pool_instances = (ulint) innobase_buffer_pool_instances;
 
+  btr_search_n_parts = (ulint) innobase_adaptive_hash_index_partitions;
+
   srv_mem_pool_size = (ulint) innobase_additional_mem_pool_size;
 
   srv_n_read_io_threads = (ulint) innobase_read_io_threads;
@@ -2519,8 +2545,21 @@ innobase_change_buffering_inited_ok:
   srv_force_recovery = (ulint) innobase_force_recovery;
 
   srv_use_doublewrite_buf = (ibool) innobase_use_doublewrite;
+
+  /* --disable-checksums is the same as --checksum-algorithm=none */
+  if (not innobase_use_checksums)
+    srv_checksum_algorithm = SRV_CHECKSUM_ALGORITHM_NONE;
+  innobase_use_checksums= srv_checksum_algorithm != SRV_CHECKSUM_ALGORITHM_NONE;
+  innobase_checksum_algorithm= checksum_algorithm_names[srv_checksum_algorithm];
   srv_use_checksums = (ibool) innobase_use_checksums;
 
+  ut_crc32_init();
+  if (srv_checksum_algorithm == SRV_CHECKSUM_ALGORITHM_CRC32)
+  {
+    errmsg_printf(error::INFO, "InnoDB: Using %s to compute CRC32C page checksums",
+                  ut_crc32_sse42_enabled ? "SSE4.2 crc32 instructions" : "slicing-by-8");
+  }
+
 #ifdef HAVE_LARGE_PAGES
   if ((os_use_large_pages = (ibool) my_use_large_pages))
     os_large_page_size = (ulint) opt_large_page_size;
@@ -2574,6 +2613,7 @@ innobase_change_buffering_inited_ok:
   context.add(new CmpTool(true));
   context.add(new CmpmemTool(false));
   context.add(new CmpmemTool(true));
+  context.add(new AhiPartitionsTool());
   context.add(new InnodbTrxTool("INNODB_TRX"));
   context.add(new InnodbTrxTool("INNODB_LOCKS"));
   context.add(new InnodbTrxTool("INNODB_LOCK_WAITS"));
@@ -2604,6 +2644,7 @@ innobase_change_buffering_inited_ok:
 
   context.registerVariable(new sys_var_bool_ptr_readonly("replication_log", &innobase_use_replication_log));
   context.registerVariable(new sys_var_bool_ptr_readonly("checksums", &innobase_use_checksums));
+  context.registerVariable(new sys_var_const_string_val("checksum_algorithm", innobase_checksum_algorithm));
   context.registerVariable(new sys_var_bool_ptr_readonly("doublewrite", &innobase_use_doublewrite));
   context.registerVariable(new sys_var_bool_ptr("file-per-table", &srv_file_per_table));
   context.registerVariable(new sys_var_bool_ptr_readonly("file-format-check", &innobase_file_format_check));
@@ -2650,6 +2691,8 @@ innobase_change_buffering_inited_ok:
   context.registerVariable(new sys_var_constrained_value_readonly<uint64_t>("max_purge_lag", innodb_max_purge_lag));
   context.registerVariable(new sys_var_constrained_value_readonly<uint64_t>("stats_sample_pages", innodb_stats_sample_pages));
   context.registerVariable(new sys_var_bool_ptr("adaptive_hash_index", &btr_search_enabled, innodb_adaptive_hash_index_update));
+  context.registerVariable(new sys_var_constrained_value_readonly<uint32_t>("adaptive_hash_index_partitions",
+                                                  innobase_adaptive_hash_index_partitions));
   context.registerVariable(new sys_var_std_string("stats_method",
 						  innodb_stats_method,
 						  innodb_stats_method_validate));
@@ -2789,6 +2832,21 @@ InnobaseEngine::doStartTransaction(
   if (options == START_TRANS_OPT_WITH_CONS_SNAPSHOT)
     trx_assign_read_view(trx);
 
+  /* Read the same snapshot as the session this one runs a part of */
+  if (options == START_TRANS_OPT_WITH_SHARED_SNAPSHOT)
+  {
+    Session *source= session->getSnapshotSource();
+    trx_t *source_trx= source ? session_to_trx(source) : NULL;
+
+    if (not source_trx || not trx_clone_read_view(trx, source_trx))
+    {
+      my_error(ER_WRONG_ARGUMENTS, MYF(0),
+               "START TRANSACTION, the session whose snapshot is shared "
+               "has no InnoDB read view");
+      return HA_ERR_UNSUPPORTED;
+    }
+  }
+
   return 0;
 }
 
@@ -3544,7 +3602,7 @@ ha_innobase::doOpen(const identifier::Table &identifier,
   session= getTable()->in_use;
 
   /* Under some cases Drizzle seems to call this function while
-  holding btr_search_latch. This breaks the latching order as
+  holding an adaptive hash index latch. This breaks the latching order as
   we acquire dict_sys->mutex below and leads to a deadlock. */
   if (session != NULL) {
     getTransactionalEngine()->releaseTemporaryLatches(session);
@@ -7208,7 +7266,8 @@ ha_innobase::scan_time()
   as a random disk read, that is, we do not divide the following
   by 10, which would be physically realistic. */
 
-  return((double) (prebuilt->table->stat_clustered_index_size));
+  return((double) (prebuilt->table->stat_clustered_index_size)
+         * getCostModel().getIOBlockReadCost());
 }
 
 /******************************************************************//**
@@ -7233,7 +7292,7 @@ ha_innobase::read_time(
 
   if (rows <= 2) {
 
-    return((double) rows);
+    return((double) rows * getCostModel().getIOSeekCost());
   }
 
   /* Assume that the read time is proportional to the scan time for all
@@ -7246,7 +7305,8 @@ ha_innobase::read_time(
     return(time_for_scan);
   }
 
-  return(ranges + (double) rows / (double) total_rows * time_for_scan);
+  return(ranges * getCostModel().getIOSeekCost()
+         + (double) rows / (double) total_rows * time_for_scan);
 }
 
 /*********************************************************************//**
@@ -9438,6 +9498,9 @@ static void init_options(drizzled::module::option_context &context)
 {
   context("disable-checksums",
           "Disable InnoDB checksums validation.");
+  context("checksum-algorithm",
+          po::value<string>(&innobase_checksum_algorithm)->default_value("innodb"),
+          "The checksum written to uncompressed pages (innodb, crc32, none). Pages with either checksum are accepted when read.");
   context("data-home-dir",
           po::value<string>(),
           "The common part for InnoDB table spaces.");
@@ -9494,6 +9557,9 @@ static void init_options(drizzled::module::option_context &context)
           "The number of index pages to sample when calculating statistics (default 8)");
   context("disable-adaptive-hash-index",
           "Enable InnoDB adaptive hash index (enabled by default)");
+  context("adaptive-hash-index-partitions",
+          po::value<adaptive_hash_index_partitions_constraint>(&innobase_adaptive_hash_index_partitions)->default_value(8),
+          "Number of partitions of the adaptive hash index. Each index is hashed in one partition, chosen by its index id, with its own latch.");
   context("replication-delay",
           po::value<uint64_constraint>(&innodb_replication_delay)->default_value(0),
           "Replication thread delay (ms) on the slave server if innodb_thread_concurrency is reached (0 by default)");
@@ -49,6 +49,29 @@ void
 btr_search_sys_free(void);
 /*=====================*/
 
+/********************************************************************//**
+X-latches all the adaptive hash index partitions, in ascending order. */
+UNIV_INTERN
+void
+btr_search_x_lock_all(void);
+/*=======================*/
+/********************************************************************//**
+Releases the x-latches on all the adaptive hash index partitions. */
+UNIV_INTERN
+void
+btr_search_x_unlock_all(void);
+/*=========================*/
+#ifdef UNIV_SYNC_DEBUG
+/********************************************************************//**
+Checks if the current thread holds all the adaptive hash index partition
+latches in the given mode.
+@return	TRUE if it does */
+UNIV_INTERN
+ibool
+btr_search_own_all(
+/*===============*/
+	ulint	lock_type);	/*!< in: RW_LOCK_SHARED or RW_LOCK_EX */
+#endif /* UNIV_SYNC_DEBUG */
 /********************************************************************//**
 Disable the adaptive hash search system and empty the index. */
 UNIV_INTERN
@@ -79,14 +102,15 @@ btr_search_info_create(
 /*===================*/
 	mem_heap_t*	heap);	/*!< in: heap where created */
 /*****************************************************************//**
-Returns the value of ref_count. The value is protected by
-btr_search_latch.
+Returns the value of ref_count. The value is protected by the latch of
+the adaptive hash index partition of the index.
 @return	ref_count value. */
 UNIV_INTERN
 ulint
 btr_search_info_get_ref_count(
 /*==========================*/
-	btr_search_t*   info);	/*!< in: search info. */
+	btr_search_t*   info,	/*!< in: search info. */
+	dict_index_t*	index);	/*!< in: index */
 /*********************************************************************//**
 Updates the search info. */
 UNIV_INLINE
@@ -112,7 +136,8 @@ btr_search_guess_on_hash(
 	ulint		latch_mode,	/*!< in: BTR_SEARCH_LEAF, ... */
 	btr_cur_t*	cursor,		/*!< out: tree cursor */
 	ulint		has_search_latch,/*!< in: latch mode the caller
-					currently has on btr_search_latch:
+					currently has on the adaptive hash
+					index partition latch of index:
 					RW_S_LATCH, RW_X_LATCH, or 0 */
 	mtr_t*		mtr);		/*!< in: mtr */
 /********************************************************************//**
@@ -194,13 +219,13 @@ btr_search_validate(void);
 #endif /* defined UNIV_AHI_DEBUG || defined UNIV_DEBUG */
 
 /** Flag: has the search system been enabled?
-Protected by btr_search_latch and btr_search_enabled_mutex. */
+Protected by all the partition latches and btr_search_enabled_mutex. */
 extern bool btr_search_enabled;
 
 /** Flag: whether the search system has completed its disabling process,
 It is set to TRUE right after buf_pool_drop_hash_index() in
 btr_search_disable(), indicating hash index entries are cleaned up.
-Protected by btr_search_latch and btr_search_enabled_mutex. */
+Protected by all the partition latches and btr_search_enabled_mutex. */
 extern ibool	btr_search_fully_disabled;
 
 /** The search info struct in an index */
@@ -208,7 +233,8 @@ struct btr_search_struct{
 	ulint	ref_count;	/*!< Number of blocks in this index tree
 				that have search index built
 				i.e. block->index points to this index.
-				Protected by btr_search_latch except
+				Protected by the partition latch of the
+				index, see btr_search_get_latch(), except
 				when during initialization in
 				btr_search_info_create(). */
 
@@ -258,36 +284,91 @@ struct btr_search_struct{
 #endif /* UNIV_DEBUG */
 };
 
+/** An adaptive hash index partition */
+typedef struct btr_search_part_struct	btr_search_part_t;
+
+/** An adaptive hash index partition. The pages of an index are hashed
+in the partition chosen by the index id, so that searches on different
+indexes mostly do not contend for the same latch. */
+struct btr_search_part_struct{
+	rw_lock_t	latch;		/*!< @brief the latch protecting the
+					partition
+
+					This latch protects the
+					(1) hash index of the partition;
+					(2) columns of a record to which we
+					have a pointer in the hash index;
+					(3) is_hashed, index and the curr_
+					fields of the blocks hashed here;
+
+					but does NOT protect:
+
+					(4) next record offset field in a
+					record;
+					(5) next or previous records on the
+					same page.
+
+					Bear in mind (4) and (5) when using
+					the hash index. */
+	hash_table_t*	hash_index;	/*!< the hash table of the partition,
+					mapping dtuple_fold values to rec_t
+					pointers on index pages */
+	ulint		n_hits;		/*!< number of successful searches
+					in the partition; not protected by
+					any latch, may be inaccurate */
+	ulint		n_misses;	/*!< number of failed searches in
+					the partition; not protected by any
+					latch, may be inaccurate */
+	byte		pad[64];	/*!< padding to prevent the counters
+					and the latch of the next partition
+					from residing on the same memory
+					cache line */
+};
+
 /** The hash index system */
 typedef struct btr_search_sys_struct	btr_search_sys_t;
 
 /** The hash index system */
 struct btr_search_sys_struct{
-	hash_table_t*	hash_index;	/*!< the adaptive hash index,
-					mapping dtuple_fold values
-					to rec_t pointers on index pages */
+	btr_search_part_t*	parts;	/*!< the adaptive hash index
+					partitions, btr_search_n_parts of
+					them */
 };
 
 /** The adaptive hash index */
 extern btr_search_sys_t*	btr_search_sys;
 
-/** @brief The latch protecting the adaptive search system
+/** Number of adaptive hash index partitions; must be set before
+btr_search_sys_create() and is not changed afterwards */
+extern ulint	btr_search_n_parts;
 
-This latch protects the
-(1) hash index;
-(2) columns of a record to which we have a pointer in the hash index;
+/** Maximum number of adaptive hash index partitions */
+#define BTR_SEARCH_MAX_PARTS	64
 
-but does NOT protect:
-
-(3) next record offset field in a record;
-(4) next or previous records on the same page.
-
-Bear in mind (3) and (4) when using the hash index.
-*/
-extern rw_lock_t*	btr_search_latch_temp;
-
-/** The latch protecting the adaptive search system */
-#define btr_search_latch	(*btr_search_latch_temp)
+/********************************************************************//**
+Returns the adaptive hash index partition of an index.
+@return	partition */
+UNIV_INLINE
+btr_search_part_t*
+btr_search_get_part(
+/*================*/
+	index_id_t	index_id);	/*!< in: index id */
+/********************************************************************//**
+Returns the latch protecting the adaptive hash index partition of an index.
+@return	partition latch */
+UNIV_INLINE
+rw_lock_t*
+btr_search_get_latch(
+/*=================*/
+	index_id_t	index_id);	/*!< in: index id */
+/********************************************************************//**
+Returns the hash table of the adaptive hash index partition of an index.
+@return	hash table */
+UNIV_INLINE
+hash_table_t*
+btr_search_get_hash_index(
+/*======================*/
+	index_id_t	index_id);	/*!< in: index id */
 
 #ifdef UNIV_SEARCH_PERF_STAT
 /** Number of successful adaptive hash index lookups */
@@ -310,8 +391,8 @@ the hash index */
 #define BTR_SEARCH_ON_HASH_LIMIT	3
 
 /** We do this many searches before trying to keep the search latch
-over calls from MySQL. If we notice someone waiting for the latch, we
-again set this much timeout. This is to reduce contention. */
+of a partition over calls from MySQL. If we notice someone waiting for
+the latch, we again set this much timeout. This is to reduce contention. */
 #define BTR_SEA_TIMEOUT			10000
 
 #ifndef UNIV_NONINL
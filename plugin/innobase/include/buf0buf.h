@@ -220,8 +220,8 @@ buf_pool_free(
 
 /********************************************************************//**
 Drops the adaptive hash index.  To prevent a livelock, this function
-is only to be called while holding btr_search_latch and while
-btr_search_enabled == FALSE. */
+is only to be called while holding all the adaptive hash index
+partition latches and while btr_search_enabled == FALSE. */
 UNIV_INTERN
 void
 buf_pool_drop_hash_index(void);
@@ -600,6 +600,16 @@ buf_calc_page_old_checksum(
 /*=======================*/
 	const byte*	 page);	/*!< in: buffer page */
 /********************************************************************//**
+Calculates the CRC32C checksum of a page. It covers the same bytes as
+buf_calc_page_new_checksum() and is stored to both checksum fields of the
+page when innodb_checksum_algorithm=crc32.
+@return	checksum */
+UNIV_INTERN
+ulint
+buf_calc_page_crc32(
+/*================*/
+	const byte*	page);	/*!< in: buffer page */
+/********************************************************************//**
 Checks if a page is corrupt.
 @return	TRUE if corrupted */
 UNIV_INTERN
@@ -1494,7 +1504,8 @@ struct buf_block_struct{
 
 	/** @name Hash search fields
 	These 6 fields may only be modified when we have
-	an x-latch on btr_search_latch AND
+	an x-latch on the adaptive hash index partition latch
+	of the index id on the page, see btr_search_get_latch(), AND
 	- we are holding an s-latch or x-latch on buf_block_struct::lock or
 	- we know that buf_block_struct::buf_fix_count == 0.
 
@@ -115,7 +115,8 @@ chosen to be a slightly bigger prime number.
 #endif /* UNIV_SYNC_DEBUG */
 
 /*************************************************************//**
-Empties a hash table and frees the memory heaps. */
+Empties a hash table and frees the memory heaps. The caller must hold
+the latch of the adaptive hash index partition of the table in X mode. */
 UNIV_INTERN
 void
 ha_clear(
@@ -71,8 +71,9 @@ typedef	byte		page_header_t;
 				in secondary indexes and in the insert buffer
 				tree; NOTE: this may be modified only
 				when the thread has an x-latch to the page,
-				and ALSO an x-latch to btr_search_latch
-				if there is a hash index to the page! */
+				and ALSO an x-latch to the adaptive hash
+				index partition latch of the index if
+				there is a hash index to the page! */
 #define PAGE_HEADER_PRIV_END 26	/* end of private data structure of the page
 				header which are set in a page create */
 /*----*/
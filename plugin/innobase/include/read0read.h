@@ -60,6 +60,21 @@ read_view_oldest_copy_or_open_new(
 	mem_heap_t*	heap);		/*!< in: memory heap from which
 					allocated */
 /*********************************************************************//**
+Makes a copy of the read view of another transaction, for a transaction
+that has to read exactly the same snapshot. The creating trx of the
+copied view is set as not visible in the copy. The view must be closed
+with ..._close.
+@return	own: read view struct */
+UNIV_INTERN
+read_view_t*
+read_view_clone(
+/*============*/
+	read_view_t*		view,		/*!< in: view to copy */
+	trx_id_t		cr_trx_id,	/*!< in: trx_id of creating
+						transaction */
+	mem_heap_t*		heap);		/*!< in: memory heap from which
+						allocated */
+/*********************************************************************//**
 Closes a read view. */
 UNIV_INTERN
 void
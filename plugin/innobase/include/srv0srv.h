@@ -222,6 +222,7 @@ extern ib_uint64_t	srv_stats_sample_pages;
 
 extern ibool	srv_use_doublewrite_buf;
 extern ibool	srv_use_checksums;
+extern ulong	srv_checksum_algorithm;
 
 extern ulong	srv_max_buf_pool_modified_pct;
 extern ulong	srv_max_purge_lag;
@@ -466,6 +467,24 @@ enum srv_stats_method_name_enum {
 
 typedef enum srv_stats_method_name_enum		srv_stats_method_name_t;
 
+/** Alternatives for srv_checksum_algorithm, which is set with
+innodb_checksum_algorithm. It only selects the checksum that is written
+to uncompressed pages; a page with either checksum is accepted when it
+is read. */
+enum srv_checksum_algorithm_enum {
+	SRV_CHECKSUM_ALGORITHM_INNODB,	/*!< the InnoDB fold checksums
+					(buf_calc_page_new_checksum() and
+					buf_calc_page_old_checksum());
+					the default */
+	SRV_CHECKSUM_ALGORITHM_CRC32,	/*!< CRC32C, in both checksum
+					fields (buf_calc_page_crc32()) */
+	SRV_CHECKSUM_ALGORITHM_NONE	/*!< write BUF_NO_CHECKSUM_MAGIC and
+					do not verify checksums; the same
+					as innodb_checksums=OFF */
+};
+
+typedef enum srv_checksum_algorithm_enum	srv_checksum_algorithm_t;
+
 #ifndef UNIV_HOTBACKUP
 /** Types of threads existing in the system. */
 enum srv_thread_type {
@@ -799,6 +818,7 @@ extern ulint	srv_n_threads_active[];
 #else /* !UNIV_HOTBACKUP */
 # define srv_use_adaptive_hash_indexes		FALSE
 # define srv_use_checksums			TRUE
+# define srv_checksum_algorithm			SRV_CHECKSUM_ALGORITHM_INNODB
 # define srv_use_native_aio			FALSE
 # define srv_force_recovery			0UL
 # define srv_set_io_thread_op_info(t,info)	((void) 0)
@@ -35,6 +35,7 @@ Created 3/26/1996 Heikki Tuuri
 #include "usr0types.h"
 #include "que0types.h"
 #include "mem0mem.h"
+#include "sync0rw.h"
 #include "read0types.h"
 #include "trx0xa.h"
 #include "ut0vec.h"
@@ -257,6 +258,18 @@ read_view_t*
 trx_assign_read_view(
 /*=================*/
 	trx_t*	trx);	/*!< in: active transaction */
+/********************************************************************//**
+Assigns to a transaction a copy of the read view of another one, so that
+both read the same snapshot. Fails if the transaction already has a read
+view or the other one has none.
+@return	consistent read view, NULL on failure */
+UNIV_INTERN
+read_view_t*
+trx_clone_read_view(
+/*================*/
+	trx_t*		trx,		/*!< in: active transaction */
+	const trx_t*	from_trx);	/*!< in: transaction whose read
+					view is copied */
 /***********************************************************//**
 The transaction must be in the TRX_QUE_LOCK_WAIT state. Puts it to
 the TRX_QUE_RUNNING state and releases query threads which were
@@ -514,6 +527,9 @@ struct trx_struct{
 	unsigned	has_search_latch;
 					/* TRUE if this trx has latched the
 					search system latch in S-mode */
+	rw_lock_t*	search_latch;	/* if has_search_latch is TRUE, the
+					adaptive hash index partition latch
+					this trx has latched in S-mode */
 	ulint		deadlock_mark;	/*!< a mark field used in deadlock
 					checking algorithm.  */
 	trx_dict_op_t	dict_operation;	/**< @see enum trx_dict_op */
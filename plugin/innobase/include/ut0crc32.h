@@ -0,0 +1,56 @@
+/*****************************************************************************
+
+Copyright (C) 2011, Drizzle Developer Group.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 51 Franklin
+St, Fifth Floor, Boston, MA 02110-1301 USA
+
+*****************************************************************************/
+
+/**************************************************//**
+@file include/ut0crc32.h
+CRC32C (Castagnoli) checksum
+
+Created 2011-10-10
+*******************************************************/
+
+#pragma once
+#ifndef ut0crc32_h
+#define ut0crc32_h
+
+#include "univ.i"
+
+/********************************************************************//**
+Computes the CRC32C checksum of a buffer.
+@return	checksum */
+typedef ib_uint32_t (*ut_crc32_func_t)(
+/*===================================*/
+	const byte*	buf,	/*!< in: data */
+	ulint		len);	/*!< in: data length */
+
+/** Pointer to the CRC32C function that ut_crc32_init() chose for this
+CPU */
+extern ut_crc32_func_t	ut_crc32;
+
+/** TRUE if ut_crc32 uses the SSE4.2 crc32 instructions */
+extern ibool		ut_crc32_sse42_enabled;
+
+/********************************************************************//**
+Initializes the CRC32C tables and chooses the implementation of ut_crc32:
+the SSE4.2 crc32 instructions if the CPU has them, else slicing-by-8 in
+software. Must be called before ut_crc32 is used. */
+UNIV_INTERN
+void
+ut_crc32_init(void);
+/*===============*/
+
+#endif /* ut0crc32_h */
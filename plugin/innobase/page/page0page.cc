@@ -214,9 +214,11 @@ page_set_max_trx_id(
 	page_t*		page		= buf_block_get_frame(block);
 #ifndef UNIV_HOTBACKUP
 	const ibool	is_hashed	= block->is_hashed;
+	rw_lock_t*	latch		= NULL;
 
 	if (is_hashed) {
-		rw_lock_x_lock(&btr_search_latch);
+		latch = btr_search_get_latch(btr_page_get_index_id(page));
+		rw_lock_x_lock(latch);
 	}
 
 	ut_ad(!mtr || mtr_memo_contains(mtr, block, MTR_MEMO_PAGE_X_FIX));
@@ -242,7 +244,7 @@ page_set_max_trx_id(
 
 #ifndef UNIV_HOTBACKUP
 	if (is_hashed) {
-		rw_lock_x_unlock(&btr_search_latch);
+		rw_lock_x_unlock(latch);
 	}
 #endif /* !UNIV_HOTBACKUP */
 }
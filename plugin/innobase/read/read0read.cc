@@ -315,6 +315,87 @@ read_view_open_now(
 	return(view);
 }
 
+/*********************************************************************//**
+Makes a copy of the read view of another transaction, for a transaction
+that has to read exactly the same snapshot. The creating trx of the
+copied view is set as not visible in the copy, like in
+read_view_oldest_copy_or_open_new(). The copy is placed next to the
+copied view in the view list, so that purge sees it as just as old. The
+view must be closed with ..._close.
+@return	own: read view struct */
+UNIV_INTERN
+read_view_t*
+read_view_clone(
+/*============*/
+	read_view_t*		view,		/*!< in: view to copy */
+	trx_id_t		cr_trx_id,	/*!< in: trx_id of creating
+						transaction */
+	mem_heap_t*		heap)		/*!< in: memory heap from which
+						allocated */
+{
+	read_view_t*	view_copy;
+	ibool		needs_insert	= TRUE;
+	ulint		insert_done	= 0;
+	ulint		n;
+	ulint		i;
+
+	ut_ad(mutex_own(&kernel_mutex));
+
+	n = view->n_trx_ids;
+
+	if (view->creator_trx_id && view->creator_trx_id != cr_trx_id) {
+		n++;
+	} else {
+		needs_insert = FALSE;
+	}
+
+	view_copy = read_view_create_low(n, heap);
+
+	/* Insert the id of the creator in the right place of the descending
+	array of ids, if needs_insert is TRUE: */
+
+	i = 0;
+	while (i < n) {
+		if (needs_insert
+		    && (i >= view->n_trx_ids
+			|| view->creator_trx_id
+			> read_view_get_nth_trx_id(view, i))) {
+
+			read_view_set_nth_trx_id(view_copy, i,
+						 view->creator_trx_id);
+			needs_insert = FALSE;
+			insert_done = 1;
+		} else {
+			read_view_set_nth_trx_id(view_copy, i,
+						 read_view_get_nth_trx_id(
+							 view,
+							 i - insert_done));
+		}
+
+		i++;
+	}
+
+	view_copy->creator_trx_id = cr_trx_id;
+	view_copy->type = VIEW_NORMAL;
+	view_copy->undo_no = 0;
+
+	view_copy->low_limit_no = view->low_limit_no;
+	view_copy->low_limit_id = view->low_limit_id;
+
+	if (n > 0) {
+		/* The last active transaction has the smallest id: */
+		view_copy->up_limit_id = read_view_get_nth_trx_id(
+			view_copy, n - 1);
+	} else {
+		view_copy->up_limit_id = view->up_limit_id;
+	}
+
+	UT_LIST_INSERT_AFTER(view_list, trx_sys->view_list,
+			     view, view_copy);
+
+	return(view_copy);
+}
+
 /*********************************************************************//**
 Closes a read view. */
 UNIV_INTERN
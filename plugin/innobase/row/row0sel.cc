@@ -1210,7 +1210,7 @@ row_sel_try_search_shortcut(
 	ut_ad(plan->unique_search);
 	ut_ad(!plan->must_get_clust);
 #ifdef UNIV_SYNC_DEBUG
-	ut_ad(rw_lock_own(&btr_search_latch, RW_LOCK_SHARED));
+	ut_ad(rw_lock_own(btr_search_get_latch(index->id), RW_LOCK_SHARED));
 #endif /* UNIV_SYNC_DEBUG */
 
 	row_sel_open_pcur(plan, TRUE, mtr);
@@ -1302,7 +1302,9 @@ row_sel(
 	rec_t*		rec;
 	rec_t*		old_vers;
 	rec_t*		clust_rec;
-	ibool		search_latch_locked;
+	rw_lock_t*	search_latch_locked;
+					/* the adaptive hash index partition
+					latch we have s-locked, or NULL */
 	ibool		consistent_read;
 
 	/* The following flag becomes TRUE when we are doing a
@@ -1330,7 +1332,7 @@ row_sel(
 
 	ut_ad(thr->run_node == node);
 
-	search_latch_locked = FALSE;
+	search_latch_locked = NULL;
 
 	if (node->read_view) {
 		/* In consistent reads, we try to do with the hash index and
@@ -1380,11 +1382,22 @@ table_loop:
 	if (consistent_read && plan->unique_search && !plan->pcur_is_open
 	    && !plan->must_get_clust
 	    && !plan->table->big_rows) {
+		rw_lock_t*	latch = btr_search_get_latch(index->id);
+
+		if (search_latch_locked && search_latch_locked != latch) {
+			/* The index of the previous table is hashed in
+			another partition of the adaptive hash index */
+
+			rw_lock_s_unlock(search_latch_locked);
+
+			search_latch_locked = NULL;
+		}
+
 		if (!search_latch_locked) {
-			rw_lock_s_lock(&btr_search_latch);
+			rw_lock_s_lock(latch);
 
-			search_latch_locked = TRUE;
-		} else if (rw_lock_get_writer(&btr_search_latch) == RW_LOCK_WAIT_EX) {
+			search_latch_locked = latch;
+		} else if (rw_lock_get_writer(latch) == RW_LOCK_WAIT_EX) {
 
 			/* There is an x-latch request waiting: release the
 			s-latch for a moment; as an s-latch here is often
@@ -1393,8 +1406,8 @@ table_loop:
 			from acquiring an s-latch for a long time, lowering
 			performance significantly in multiprocessors. */
 
-			rw_lock_s_unlock(&btr_search_latch);
-			rw_lock_s_lock(&btr_search_latch);
+			rw_lock_s_unlock(latch);
+			rw_lock_s_lock(latch);
 		}
 
 		found_flag = row_sel_try_search_shortcut(node, plan, &mtr);
@@ -1417,16 +1430,16 @@ table_loop:
 	}
 
 	if (search_latch_locked) {
-		rw_lock_s_unlock(&btr_search_latch);
+		rw_lock_s_unlock(search_latch_locked);
 
-		search_latch_locked = FALSE;
+		search_latch_locked = NULL;
 	}
 
 	if (!plan->pcur_is_open) {
 		/* Evaluate the expressions to build the search tuple and
 		open the cursor */
 
-		row_sel_open_pcur(plan, search_latch_locked, &mtr);
+		row_sel_open_pcur(plan, FALSE, &mtr);
 
 		cursor_just_opened = TRUE;
 
@@ -1998,7 +2011,7 @@ lock_wait_or_error:
 
 func_exit:
 	if (search_latch_locked) {
-		rw_lock_s_unlock(&btr_search_latch);
+		rw_lock_s_unlock(search_latch_locked);
 	}
 	if (UNIV_LIKELY_NULL(heap)) {
 		mem_heap_free(heap);
@@ -3448,16 +3461,16 @@ row_search_for_mysql(
 	/* PHASE 0: Release a possible s-latch we are holding on the
 	adaptive hash index latch if there is someone waiting behind */
 
-	if (UNIV_UNLIKELY(rw_lock_get_writer(&btr_search_latch) != RW_LOCK_NOT_LOCKED)
-	    && trx->has_search_latch) {
+	if (trx->has_search_latch
+	    && UNIV_UNLIKELY(rw_lock_get_writer(trx->search_latch)
+			     != RW_LOCK_NOT_LOCKED)) {
 
-		/* There is an x-latch request on the adaptive hash index:
-		release the s-latch to reduce starvation and wait for
-		BTR_SEA_TIMEOUT rounds before trying to keep it again over
-		calls from MySQL */
+		/* There is an x-latch request on the adaptive hash index
+		partition: release the s-latch to reduce starvation and wait
+		for BTR_SEA_TIMEOUT rounds before trying to keep it again
+		over calls from MySQL */
 
-		rw_lock_s_unlock(&btr_search_latch);
-		trx->has_search_latch = FALSE;
+		trx_search_latch_release_if_reserved(trx);
 
 		trx->search_latch_timeout = BTR_SEA_TIMEOUT;
 	}
@@ -3607,8 +3620,19 @@ row_search_for_mysql(
 			hash index semaphore! */
 
 #ifndef UNIV_SEARCH_DEBUG
+			if (trx->has_search_latch
+			    && trx->search_latch
+			    != btr_search_get_latch(index->id)) {
+				/* We kept the latch of another partition
+				of the adaptive hash index over calls */
+
+				trx_search_latch_release_if_reserved(trx);
+			}
+
 			if (!trx->has_search_latch) {
-				rw_lock_s_lock(&btr_search_latch);
+				trx->search_latch = btr_search_get_latch(
+					index->id);
+				rw_lock_s_lock(trx->search_latch);
 				trx->has_search_latch = TRUE;
 			}
 #endif
@@ -3670,8 +3694,8 @@ release_search_latch_if_needed:
 
 					trx->search_latch_timeout--;
 
-					rw_lock_s_unlock(&btr_search_latch);
-					trx->has_search_latch = FALSE;
+					trx_search_latch_release_if_reserved(
+						trx);
 				}
 
 				/* NOTE that we do NOT store the cursor
@@ -3694,8 +3718,7 @@ release_search_latch_if_needed:
 	/* PHASE 3: Open or restore index cursor position */
 
 	if (trx->has_search_latch) {
-		rw_lock_s_unlock(&btr_search_latch);
-		trx->has_search_latch = FALSE;
+		trx_search_latch_release_if_reserved(trx);
 	}
 
 	ut_ad(prebuilt->sql_stat_start || trx->conc_state == TRX_ACTIVE);
@@ -449,6 +449,9 @@ UNIV_INTERN ib_uint64_t	srv_stats_sample_pages = 8;
 
 UNIV_INTERN ibool	srv_use_doublewrite_buf	= TRUE;
 UNIV_INTERN ibool	srv_use_checksums = TRUE;
+/** The checksum written to uncompressed pages, see
+srv_checksum_algorithm_t */
+UNIV_INTERN ulong	srv_checksum_algorithm = SRV_CHECKSUM_ALGORITHM_INNODB;
 
 UNIV_INTERN ulong	srv_replication_delay		= 0;
 
@@ -1878,6 +1881,7 @@ srv_printf_innodb_monitor(
 	double	time_elapsed;
 	time_t	current_time;
 	ulint	n_reserved;
+	ulint	i;
 	ibool	ret;
 
 	mutex_enter(&srv_innodb_monitor_mutex);
@@ -1963,7 +1967,10 @@ srv_printf_innodb_monitor(
 	      "-------------------------------------\n", file);
 	ibuf_print(file);
 
-	ha_print_info(file, btr_search_sys->hash_index);
+	for (i = 0; i < btr_search_n_parts; i++) {
+		fprintf(file, "Partition %lu: ", (ulong) i);
+		ha_print_info(file, btr_search_sys->parts[i].hash_index);
+	}
 
 	fprintf(file,
 		"%.2f hash searches/s, %.2f non-hash searches/s\n",
@@ -1172,7 +1172,6 @@ sync_thread_add_level(
 	case SYNC_ANY_LATCH:
 	case SYNC_FILE_FORMAT_TAG:
 	case SYNC_DOUBLEWRITE:
-	case SYNC_SEARCH_SYS:
 	case SYNC_SEARCH_SYS_CONF:
 	case SYNC_TRX_LOCK_HEAP:
 	case SYNC_KERNEL:
@@ -1195,6 +1194,7 @@ sync_thread_add_level(
 		break;
 	case SYNC_BUF_FLUSH_LIST:
 	case SYNC_BUF_POOL:
+	case SYNC_SEARCH_SYS:
 		/* We can have multiple mutexes of this type therefore we
 		can only check whether the greater than condition holds. */
 		if (!sync_thread_levels_g(array, level-1, TRUE)) {
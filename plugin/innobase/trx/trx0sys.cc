@@ -512,7 +512,8 @@ trx_sys_doublewrite_init_or_restore_pages(
 					+ FIL_PAGE_ARCH_LOG_NO_OR_SPACE_ID, 0);
 			/* We do not need to calculate new checksums for the
 			pages because the field .._SPACE_ID does not affect
-			them. Write the page back to where we read it from. */
+			them, with either innodb_checksum_algorithm. Write
+			the page back to where we read it from. */
 
 			if (i < TRX_SYS_DOUBLEWRITE_BLOCK_SIZE) {
 				source_page_no = block1 + i;
@@ -167,6 +167,7 @@ trx_create(
 
 	trx->dict_operation_lock_mode = 0;
 	trx->has_search_latch = FALSE;
+	trx->search_latch = NULL;
 	trx->search_latch_timeout = BTR_SEA_TIMEOUT;
 
 	trx->declared_to_be_inside_innodb = FALSE;
@@ -246,9 +247,10 @@ trx_search_latch_release_if_reserved(
 	trx_t*	   trx) /*!< in: transaction */
 {
 	if (trx->has_search_latch) {
-		rw_lock_s_unlock(&btr_search_latch);
+		rw_lock_s_unlock(trx->search_latch);
 
 		trx->has_search_latch = FALSE;
+		trx->search_latch = NULL;
 	}
 }
 
@@ -1048,6 +1050,38 @@ trx_assign_read_view(
 	return(trx->read_view);
 }
 
+/********************************************************************//**
+Assigns to a transaction a copy of the read view of another one, so that
+both read the same snapshot. Fails if the transaction already has a read
+view or the other one has none.
+@return	consistent read view, NULL on failure */
+UNIV_INTERN
+read_view_t*
+trx_clone_read_view(
+/*================*/
+	trx_t*		trx,		/*!< in: active transaction */
+	const trx_t*	from_trx)	/*!< in: transaction whose read
+					view is copied */
+{
+	ut_ad(trx->conc_state == TRX_ACTIVE);
+
+	mutex_enter(&kernel_mutex);
+
+	if (trx->read_view || !from_trx->read_view) {
+		mutex_exit(&kernel_mutex);
+
+		return(NULL);
+	}
+
+	trx->read_view = read_view_clone(from_trx->read_view, trx->id,
+					 trx->global_read_view_heap);
+	trx->global_read_view = trx->read_view;
+
+	mutex_exit(&kernel_mutex);
+
+	return(trx->read_view);
+}
+
 /****************************************************************//**
 Commits a transaction. NOTE that the kernel mutex is temporarily released. */
 static
@@ -0,0 +1,199 @@
+/*****************************************************************************
+
+Copyright (C) 2011, Drizzle Developer Group.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 51 Franklin
+St, Fifth Floor, Boston, MA 02110-1301 USA
+
+*****************************************************************************/
+
+/***************************************************************//**
+@file ut/ut0crc32.cc
+CRC32C (Castagnoli) checksum
+
+The software implementation processes 8 bytes per step with 8 lookup
+tables ("slicing-by-8"): table k holds the CRC of a byte followed by k
+zero bytes, so the CRCs of the 8 bytes of a step can be looked up
+independently and combined with XOR.
+
+On x86-64 CPUs with SSE4.2 the crc32 instruction, which computes the
+same polynomial, is used instead.
+
+Created 2011-10-10
+********************************************************************/
+
+#include "ut0crc32.h"
+
+/** The CRC32C polynomial, bit-reversed */
+#define UT_CRC32C_POLY	0x82F63B78UL
+
+/** Lookup tables of the software implementation; ut_crc32_slice8_table[k][n]
+is the CRC of the byte n followed by k zero bytes */
+static ib_uint32_t	ut_crc32_slice8_table[8][256];
+
+/** Pointer to the CRC32C function that ut_crc32_init() chose */
+UNIV_INTERN ut_crc32_func_t	ut_crc32;
+
+/** TRUE if ut_crc32 uses the SSE4.2 crc32 instructions */
+UNIV_INTERN ibool		ut_crc32_sse42_enabled = FALSE;
+
+#if defined(__GNUC__) && defined(__x86_64__)
+/********************************************************************//**
+Checks whether the CPU supports the SSE4.2 crc32 instructions.
+@return	TRUE if it does */
+static
+ibool
+ut_crc32_sse42_supported(void)
+/*==========================*/
+{
+	ib_uint32_t	eax;
+	ib_uint32_t	ebx;
+	ib_uint32_t	ecx;
+	ib_uint32_t	edx;
+
+	__asm__("cpuid"
+		: "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx)
+		: "a" (1), "c" (0));
+
+	/* CPUID.01H:ECX.SSE42[bit 20] */
+	return((ecx >> 20) & 1);
+}
+
+/********************************************************************//**
+Computes the CRC32C checksum of a buffer with the SSE4.2 crc32
+instructions.
+@return	checksum */
+static
+ib_uint32_t
+ut_crc32_sse42(
+/*===========*/
+	const byte*	buf,	/*!< in: data */
+	ulint		len)	/*!< in: data length */
+{
+	ib_uint64_t	crc = 0xFFFFFFFFUL;
+
+	/* Process single bytes until buf is aligned for the 8-byte
+	instruction */
+	while (len > 0 && ((ulint) buf & 7)) {
+		__asm__("crc32b %1, %0" : "+r" (crc) : "rm" (*buf));
+		buf++;
+		len--;
+	}
+
+	while (len >= 8) {
+		__asm__("crc32q %1, %0"
+			: "+r" (crc) : "rm" (*(const ib_uint64_t*) buf));
+		buf += 8;
+		len -= 8;
+	}
+
+	while (len > 0) {
+		__asm__("crc32b %1, %0" : "+r" (crc) : "rm" (*buf));
+		buf++;
+		len--;
+	}
+
+	return((ib_uint32_t) ~crc);
+}
+#endif /* __GNUC__ && __x86_64__ */
+
+/********************************************************************//**
+Computes the CRC32C checksum of a buffer in software, 8 bytes at a time.
+@return	checksum */
+static
+ib_uint32_t
+ut_crc32_slice8(
+/*============*/
+	const byte*	buf,	/*!< in: data */
+	ulint		len)	/*!< in: data length */
+{
+	const ib_uint32_t	(*t)[256] = ut_crc32_slice8_table;
+	ib_uint32_t		crc = 0xFFFFFFFFUL;
+
+	while (len > 0 && ((ulint) buf & 7)) {
+		crc = t[0][(crc ^ *buf) & 0xFF] ^ (crc >> 8);
+		buf++;
+		len--;
+	}
+
+	while (len >= 8) {
+		/* The bytes are combined in little-endian order by hand so
+		that big-endian hosts compute the same checksum */
+		crc ^= (ib_uint32_t) buf[0]
+			| ((ib_uint32_t) buf[1] << 8)
+			| ((ib_uint32_t) buf[2] << 16)
+			| ((ib_uint32_t) buf[3] << 24);
+
+		crc = t[7][crc & 0xFF]
+			^ t[6][(crc >> 8) & 0xFF]
+			^ t[5][(crc >> 16) & 0xFF]
+			^ t[4][crc >> 24]
+			^ t[3][buf[4]]
+			^ t[2][buf[5]]
+			^ t[1][buf[6]]
+			^ t[0][buf[7]];
+		buf += 8;
+		len -= 8;
+	}
+
+	while (len > 0) {
+		crc = t[0][(crc ^ *buf) & 0xFF] ^ (crc >> 8);
+		buf++;
+		len--;
+	}
+
+	return(~crc);
+}
+
+/********************************************************************//**
+Initializes the CRC32C tables and chooses the implementation of ut_crc32:
+the SSE4.2 crc32 instructions if the CPU has them, else slicing-by-8 in
+software. Must be called before ut_crc32 is used. */
+UNIV_INTERN
+void
+ut_crc32_init(void)
+/*===============*/
+{
+	ulint	n;
+	ulint	k;
+
+	for (n = 0; n < 256; n++) {
+		ib_uint32_t	crc = (ib_uint32_t) n;
+
+		for (k = 0; k < 8; k++) {
+			crc = (crc & 1)
+				? (crc >> 1) ^ UT_CRC32C_POLY : crc >> 1;
+		}
+
+		ut_crc32_slice8_table[0][n] = crc;
+	}
+
+	for (n = 0; n < 256; n++) {
+		ib_uint32_t	crc = ut_crc32_slice8_table[0][n];
+
+		for (k = 1; k < 8; k++) {
+			crc = ut_crc32_slice8_table[0][crc & 0xFF]
+				^ (crc >> 8);
+			ut_crc32_slice8_table[k][n] = crc;
+		}
+	}
+
+	ut_crc32 = ut_crc32_slice8;
+
+#if defined(__GNUC__) && defined(__x86_64__)
+	ut_crc32_sse42_enabled = ut_crc32_sse42_supported();
+
+	if (ut_crc32_sse42_enabled) {
+		ut_crc32 = ut_crc32_sse42;
+	}
+#endif /* __GNUC__ && __x86_64__ */
+}
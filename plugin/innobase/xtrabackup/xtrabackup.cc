@@ -71,6 +71,7 @@ typedef drizzled::charset_info_st CHARSET_INFO;
 #include <sync0sync.h>
 #include <fil0fil.h>
 #include <trx0xa.h>
+#include <ut0crc32.h>
 
 #ifdef INNODB_VERSION_SHORT
 #include <ibuf0ibuf.h>
@@ -446,6 +447,7 @@ ulong	innobase_fast_shutdown			= 1;
 bool innobase_log_archive			= FALSE;/* unused */
 bool innobase_use_doublewrite    = TRUE;
 bool innobase_use_checksums      = TRUE;
+std::string innobase_checksum_algorithm;
 bool innobase_use_large_pages    = FALSE;
 bool	innobase_file_per_table			= FALSE;
 bool innobase_locks_unsafe_for_binlog        = FALSE;
@@ -1384,7 +1386,32 @@ mem_free_and_error:
 	srv_force_recovery = (ulint) innobase_force_recovery;
 
 	srv_use_doublewrite_buf = (ibool) innobase_use_doublewrite;
-	srv_use_checksums = (ibool) innobase_use_checksums;
+	/* Pages are accepted with either checksum, so this only matters
+	for the pages that --prepare writes */
+	if (!innobase_strcasecmp(innobase_checksum_algorithm.c_str(),
+				 "innodb")) {
+		srv_checksum_algorithm = SRV_CHECKSUM_ALGORITHM_INNODB;
+	} else if (!innobase_strcasecmp(innobase_checksum_algorithm.c_str(),
+					"crc32")) {
+		srv_checksum_algorithm = SRV_CHECKSUM_ALGORITHM_CRC32;
+	} else if (!innobase_strcasecmp(innobase_checksum_algorithm.c_str(),
+					"none")) {
+		srv_checksum_algorithm = SRV_CHECKSUM_ALGORITHM_NONE;
+	} else {
+		fprintf(stderr,
+			"xtrabackup: Error: %s is not valid value for "
+			"innodb_checksum_algorithm.\n",
+			innobase_checksum_algorithm.c_str());
+		goto error;
+	}
+
+	if (!innobase_use_checksums) {
+		srv_checksum_algorithm = SRV_CHECKSUM_ALGORITHM_NONE;
+	}
+	srv_use_checksums = srv_checksum_algorithm
+		!= SRV_CHECKSUM_ALGORITHM_NONE;
+
+	ut_crc32_init();
 
 	btr_search_enabled = innobase_adaptive_hash_index ? true : false;
 
@@ -4761,6 +4788,7 @@ int main(int argc, char **argv)
 	("innodb-autoextend-increment", po::value<uint32_t>(&srv_auto_extend_increment)->default_value(8), _("Data file autoextend increment in megabytes"))
 	("innodb-buffer-pool-size", po::value<uint64_t>(&innobase_buffer_pool_size)->default_value(8*1024*1024), _("The size of the memory buffer InnoDB uses to cache data and indexes of its tables."))
 	("innodb-checksums", po::value<bool>(&innobase_use_checksums)->default_value(true), _("Enable InnoDB checksums validation (enabled by default). Disable with --skip-innodb-checksums."))
+	("innodb-checksum-algorithm", po::value<std::string>(&innobase_checksum_algorithm)->default_value("innodb"), _("The checksum written to uncompressed pages (innodb, crc32, none). Pages with either checksum are accepted when read."))
 	  ("innodb-data-file-path", po::value<std::string>(), _("Path to individual files and their sizes."))
 	  ("innodb-data-home-dir", po::value<std::string>(), _("The common part for InnoDB table spaces."))
 	("innodb-doublewrite", po::value<bool>(&innobase_use_doublewrite)->default_value(true), _("Enable InnoDB doublewrite buffer (enabled by default). Disable with --skip-innodb-doublewrite."))
@@ -17,6 +17,7 @@
 #include <drizzled/error.h>
 #include <drizzled/table.h>
 #include <drizzled/session.h>
+#include <drizzled/session/memory_usage.h>
 #include <drizzled/field/varstring.h>
 #include <drizzled/plugin/daemon.h>
 #include <drizzled/plugin/storage_engine.h>
@@ -26,8 +27,6 @@
 #include <drizzled/system_variables.h>
 #include <drizzled/key_part_info.h>
 
-#include <boost/thread/mutex.hpp>
-
 #include "heap.h"
 #include "ha_heap.h"
 
@@ -38,8 +37,6 @@ using namespace std;
 
 static const string engine_name("MEMORY");
 
-boost::mutex THR_LOCK_heap;
-
 static const char *ha_heap_exts[] = {
   NULL
 };
@@ -106,9 +103,11 @@ public:
   uint32_t max_supported_keys()          const { return MAX_KEY; }
   uint32_t max_supported_key_part_length() const { return MAX_KEY_LENGTH; }
 
-  uint32_t index_flags(drizzled::message::Table::Index::IndexType) const
+  uint32_t index_flags(drizzled::message::Table::Index::IndexType type) const
   {
-    return ( HA_ONLY_WHOLE_INDEX | HA_KEY_SCAN_NOT_ROR);
+    return (type == message::Table::Index::BTREE ?
+            HA_READ_NEXT | HA_READ_PREV | HA_READ_ORDER | HA_READ_RANGE :
+            HA_ONLY_WHOLE_INDEX | HA_KEY_SCAN_NOT_ROR);
   }
 
   bool doDoesTableExist(Session& session, const identifier::Table &identifier);
@@ -170,7 +169,7 @@ static int heap_init(module::Context &context)
 ha_heap::ha_heap(plugin::StorageEngine &engine_arg,
                  Table &table_arg)
   :Cursor(engine_arg, table_arg), file(0), records_changed(0), key_stat_version(0),
-  internal_table(0)
+  internal_table(0), bulk_keys_disabled(0)
 {}
 
 /*
@@ -186,6 +185,9 @@ ha_heap::ha_heap(plugin::StorageEngine &engine_arg,
 */
 #define MEMORY_STATS_UPDATE_THRESHOLD 10
 
+/* Build non-unique hash keys after inserting at least this many rows */
+#define MEMORY_MIN_ROWS_TO_DISABLE_INDEXES 100
+
 int ha_heap::doOpen(const drizzled::identifier::Table &identifier, int mode, uint32_t test_if_locked)
 {
   if ((test_if_locked & HA_OPEN_INTERNAL_TABLE) || (!(file= heap_open(identifier.getPath().c_str(), mode)) && errno == ENOENT))
@@ -208,9 +210,10 @@ int ha_heap::doOpen(const drizzled::identifier::Table &identifier, int mode, uin
       if (!file)
       {
          /* Couldn't open table; Remove the newly created table */
-        THR_LOCK_heap.lock();
-        hp_free(internal_share);
-        THR_LOCK_heap.unlock();
+        if (internal_table)
+          hp_free(internal_share);
+        else
+          heap_delete_table(internal_share->name.c_str());
       }
     }
   }
@@ -234,7 +237,7 @@ int ha_heap::doOpen(const drizzled::identifier::Table &identifier, int mode, uin
 
 int ha_heap::close(void)
 {
-  return internal_table ? hp_close(file) : heap_close(file);
+  return heap_close(file);
 }
 
 
@@ -260,9 +263,10 @@ Cursor *ha_heap::clone(memory::Root *)
 }
 
 
-const char *ha_heap::index_type(uint32_t )
+const char *ha_heap::index_type(uint32_t inx)
 {
-  return ("HASH");
+  return (getTable()->key_info[inx].algorithm == message::Table::Index::BTREE ?
+          "BTREE" : "HASH");
 }
 
 
@@ -284,6 +288,12 @@ const char *ha_heap::index_type(uint32_t )
 
 void ha_heap::set_keys_for_scanning(void)
 {
+  btree_keys.reset();
+  for (uint32_t i= 0 ; i < getTable()->getShare()->sizeKeys() ; i++)
+  {
+    if (getTable()->key_info[i].algorithm == message::Table::Index::BTREE)
+      btree_keys.set(i);
+  }
 }
 
 
@@ -296,6 +306,7 @@ void ha_heap::update_key_stats()
     if (!key->rec_per_key)
       continue;
 
+    if (key->algorithm != message::Table::Index::BTREE)
     {
       if (key->flags & HA_NOSAME)
         key->rec_per_key[key->key_parts-1]= 1;
@@ -473,6 +484,9 @@ int ha_heap::info(uint32_t flag)
   (void) heap_info(file,&hp_info,flag);
 
   errkey=                     hp_info.errkey;
+  /* Lets end_unique_update() find the row a duplicate collided with */
+  if (flag & HA_STATUS_ERRKEY)
+    memcpy(dup_ref, &file->dupp_key_pos, sizeof(HEAP_PTR));
   stats.records=              hp_info.records;
   stats.deleted=              hp_info.deleted;
   stats.mean_rec_length=      hp_info.reclength;
@@ -625,6 +639,45 @@ int ha_heap::indexes_are_disabled()
   return heap_indexes_are_disabled(file);
 }
 
+
+/*
+  Prepare for a many-rows insert operation
+
+  SYNOPSIS
+    start_bulk_insert(rows)
+    rows        Rows to be inserted
+                0 if we don't know
+
+  DESCRIPTION
+    If the table is empty, its non-unique hash keys are built by
+    end_bulk_insert() in one pass instead of row by row.
+*/
+
+void ha_heap::start_bulk_insert(ha_rows rows)
+{
+  bulk_keys_disabled= ((!rows || rows >= MEMORY_MIN_ROWS_TO_DISABLE_INDEXES) &&
+                       !heap_start_bulk_insert(file));
+}
+
+
+/*
+  End a many-rows insert operation started by start_bulk_insert()
+
+  RETURN
+    0     OK
+    != 0  Error
+*/
+
+int ha_heap::end_bulk_insert()
+{
+  if (!bulk_keys_disabled)
+    return 0;
+  bulk_keys_disabled= false;
+  /* The number of hash buckets changed all at once */
+  file->getShare()->key_stat_version++;
+  return heap_end_bulk_insert(file);
+}
+
 void ha_heap::drop_table()
 {
   file->getShare()->delete_on_close= 1;
@@ -644,6 +697,9 @@ ha_rows ha_heap::records_in_range(uint32_t inx, key_range *min_key,
 {
   KeyInfo *key= &getTable()->key_info[inx];
 
+  if (key->algorithm == message::Table::Index::BTREE)
+    return heap_records_in_range(file, inx, min_key, max_key);
+
   if (!min_key || !max_key ||
       min_key->length != max_key->length ||
       min_key->length != key->key_length ||
@@ -724,13 +780,18 @@ int HeapEngine::heap_create_table(Session *session, const char *table_name,
     keydef[key].keysegs=   (uint) pos->key_parts;
     keydef[key].flag=      (pos->flags & (HA_NOSAME | HA_NULL_ARE_EQUAL));
     keydef[key].seg=       seg;
+    keydef[key].algorithm= (pos->algorithm == message::Table::Index::BTREE ?
+                            HP_KEY_ALG_BTREE : HP_KEY_ALG_HASH);
 
-    mem_per_row_keys+= sizeof(char*) * 2; // = sizeof(HASH_INFO)
+    mem_per_row_keys+= sizeof(HASH_INFO);
 
     for (; key_part != key_part_end; key_part++, seg++)
     {
       Field *field= key_part->field;
 
+      if (keydef[key].algorithm == HP_KEY_ALG_BTREE)
+        seg->type= field->key_type();
+      else
       {
         if ((seg->type = field->key_type()) != (int) HA_KEYTYPE_TEXT &&
             seg->type != HA_KEYTYPE_VARTEXT1 &&
@@ -742,6 +803,18 @@ int HeapEngine::heap_create_table(Session *session, const char *table_name,
       seg->start=   (uint) key_part->offset;
       seg->length=  (uint) key_part->length;
       seg->flag=    key_part->key_part_flag;
+      /*
+        Blobs are stored out of the row, see hp_record.cc. A hash key
+        hashes the value they point to; the unique key of a GROUP BY or
+        DISTINCT over blobs is such a key.
+      */
+      if (field->flags & BLOB_FLAG)
+      {
+        if (keydef[key].algorithm == HP_KEY_ALG_BTREE)
+          return HA_ERR_UNSUPPORTED;
+        seg->flag|= HA_BLOB_PART;
+        seg->length= field->pack_length();
+      }
 
       next_field_pos= seg->start + seg->length;
       if (field->type() == DRIZZLE_TYPE_VARCHAR)
@@ -807,8 +880,25 @@ int HeapEngine::heap_create_table(Session *session, const char *table_name,
   hp_create_info.max_table_size=session->variables.max_heap_table_size;
   hp_create_info.with_auto_increment= found_real_auto_increment;
   hp_create_info.internal_table= internal_table;
+  /* Internal temporary tables count against the memory of their session */
+  hp_create_info.tracker= internal_table ? &session->memory_usage : NULL;
   hp_create_info.max_chunk_size= table_arg->getShare()->block_size;
 
+  /*
+    HTON_NO_BLOBS keeps blobs out of user tables, internal temporary
+    tables may have them.
+  */
+  for (uint32_t x= 0; x < table_arg->getShare()->blob_fields; x++)
+  {
+    Field *field= table_arg->getField(table_arg->getShare()->blob_field[x]);
+    HP_BLOBDEF blob;
+    blob.offset= field->offset(table_arg->getInsertRecord());
+    blob.null_bit= field->null_ptr ? field->null_bit : 0;
+    blob.null_pos= field->null_ptr ?
+      (uint32_t) (field->null_ptr - table_arg->getInsertRecord()) : 0;
+    hp_create_info.blobs.push_back(blob);
+  }
+
   error= heap_create(table_name,
                      keys, &keydef[0],
                      column_count,
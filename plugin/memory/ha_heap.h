@@ -20,6 +20,7 @@
 #pragma once
 
 #include <drizzled/cursor.h>
+#include <drizzled/optimizer/cost_model.h>
 #include <drizzled/thr_lock.h>
 
 typedef struct st_heap_info HP_INFO;
@@ -31,7 +32,9 @@ class ha_heap : public drizzled::Cursor
   /* number of records changed since last statistics update */
   uint32_t    records_changed;
   uint32_t    key_stat_version;
+  drizzled::key_map btree_keys;
   bool internal_table;
+  bool bulk_keys_disabled;              /* By start_bulk_insert() */
 public:
   ha_heap(drizzled::plugin::StorageEngine &engine, drizzled::Table &table);
   ~ha_heap() {}
@@ -40,14 +43,15 @@ public:
   const char *index_type(uint32_t inx);
 
   double scan_time()
-  { return (double) (stats.records+stats.deleted) / 20.0+10; }
+  { return (double) (stats.records+stats.deleted) / getCostModel().memoryRowsPerRead()+10; }
   double read_time(uint32_t, uint32_t,
                    drizzled::ha_rows rows)
-  { return (double) rows /  20.0+1; }
+  { return (double) rows / getCostModel().memoryRowsPerRead()+1; }
 
   int doOpen(const drizzled::identifier::Table &identifier, int mode, uint32_t test_if_locked);
   int close(void);
   void set_keys_for_scanning(void);
+  const drizzled::key_map *keys_to_use_for_scanning() { return &btree_keys; }
   int doInsertRecord(unsigned char * buf);
   int doUpdateRecord(const unsigned char * old_data, unsigned char * new_data);
   int doDeleteRecord(const unsigned char * buf);
@@ -79,6 +83,8 @@ public:
   int disable_indexes(uint32_t mode);
   int enable_indexes(uint32_t mode);
   int indexes_are_disabled(void);
+  void start_bulk_insert(drizzled::ha_rows rows);
+  int end_bulk_insert();
   drizzled::ha_rows records_in_range(uint32_t inx,
                                      drizzled::key_range *min_key,
                                      drizzled::key_range *max_key);
@@ -21,6 +21,7 @@
 #pragma once
 
 #include <drizzled/base.h>
+#include <drizzled/memory/root.h>
 #include <drizzled/thr_lock.h>
 
 #include <plugin/myisam/my_handler.h>
@@ -32,6 +33,9 @@
 #define HP_MAX_LEVELS	4		/* 128^5 records is enough */
 #define HP_PTRS_IN_NOD	128
 
+#define HP_KEY_ALG_HASH		0	/* HP_KEYDEF::algorithm */
+#define HP_KEY_ALG_BTREE	1
+
 	/* struct used with heap_funktions */
 
 typedef struct st_heapinfo		/* Struct from heap_info */
@@ -116,17 +120,46 @@ typedef struct st_heap_block
   uint32_t records_in_block;		/* Records in one heap-block */
   uint32_t recbuffer;			/* Length of one saved record */
   uint32_t last_allocated; /* number of records there is allocated space for */
+  drizzled::memory::Tracker *tracker;   /* Told about allocated blocks, if set */
+  size_t allocated_length;              /* Bytes in all blocks */
 
   st_heap_block() :
     root(NULL),
     levels(0),
     records_in_block(0),
     recbuffer(0),
-    last_allocated(0)
+    last_allocated(0),
+    tracker(NULL),
+    allocated_length(0)
   {
   }
 } HP_BLOCK;
 
+/*
+  Ordered index, a B+tree of HP_BTREE_NODEs kept by hp_btree.cc.
+  Every entry is the key of a record, normalized so that memcmp() orders
+  it, followed by the record pointer, so that all entries are unique.
+*/
+
+struct st_hp_btree_node;
+
+typedef struct st_hp_btree
+{
+  struct st_hp_btree_node *root;        /* NULL until the first write */
+  uint32_t height;                      /* Levels of inner nodes */
+  uint32_t key_length;                  /* Length of a normalized key */
+  uint32_t entry_length;                /* key_length + record pointer */
+  uint32_t node_length;                 /* Bytes in one node */
+  uint32_t leaf_capacity;               /* Entries in a leaf */
+  uint32_t inner_capacity;              /* Children of an inner node */
+  uint32_t children_offset;             /* Of the children in an inner node */
+  uint32_t counts_offset;               /* Of the subtree sizes in an inner node */
+  uint64_t version;                     /* Incremented by every change */
+  uint64_t entries;
+  drizzled::memory::Tracker *tracker;   /* Told about allocated nodes, if set */
+  size_t allocated_length;              /* Bytes in all nodes */
+} HP_BTREE;
+
 struct st_heap_info;			/* For referense */
 
 typedef struct st_hp_keydef		/* Key definition with open */
@@ -134,8 +167,11 @@ typedef struct st_hp_keydef		/* Key definition with open */
   uint32_t flag;				/* HA_NOSAME | HA_NULL_PART_KEY */
   uint32_t keysegs;				/* Number of key-segment */
   uint32_t length;				/* Length of key (automatic) */
+  uint32_t algorithm;                   /* HP_KEY_ALG_HASH or HP_KEY_ALG_BTREE */
   HA_KEYSEG *seg;
   HP_BLOCK block;			/* Where keys are saved */
+  HP_BTREE btree;                       /* Where keys are saved for BTREE */
+  bool disabled;                        /* Not maintained, see hp_bulk.cc */
   /*
     Number of buckets used in hash table. Used only to provide
     #records estimates for heap key scans.
@@ -143,6 +179,13 @@ typedef struct st_hp_keydef		/* Key definition with open */
   drizzled::ha_rows hash_buckets;
 } HP_KEYDEF;
 
+typedef struct st_hp_blobdef     /* A blob column of an internal table */
+{
+  uint32_t offset;                 /* Start of the length, the data pointer follows */
+  uint32_t null_pos;               /* Position of the null flag in the record */
+  unsigned char null_bit;          /* Null flag, 0 if the column is NOT NULL */
+} HP_BLOBDEF;
+
 typedef struct st_heap_dataspace   /* control data for data space */
 {
   HP_BLOCK block;
@@ -186,10 +229,11 @@ typedef struct st_heap_share
   uint32_t column_count;
   uint32_t currently_disabled_keys;    /* saved value from "keys" when disabled */
   uint32_t open_count;
-
+  std::vector<HP_BLOBDEF> blobs;  /* Blob columns, see hp_record.cc */
 
   std::string name;			/* Name of "memory-file" */
   bool delete_on_close;
+  bool internal_table;			/* Not registered by name */
   uint32_t auto_key;
   uint32_t auto_key_type;			/* real type of the auto key segment */
   uint64_t auto_increment;
@@ -212,6 +256,7 @@ typedef struct st_heap_share
     currently_disabled_keys(0),
     open_count(0),
     delete_on_close(0),
+    internal_table(0),
     auto_key(0),
     auto_key_type(0),
     auto_increment(0)
@@ -221,6 +266,14 @@ typedef struct st_heap_share
 
 struct st_hp_hash_info;
 
+typedef struct st_hp_btree_cursor	/* Position in an HP_BTREE */
+{
+  struct st_hp_btree_node *node;        /* Leaf of the current entry */
+  uint32_t pos;                         /* Of the current entry in node */
+  uint64_t version;                     /* HP_BTREE::version when node was set */
+  std::vector<unsigned char> entry;     /* Current entry, empty if none */
+} HP_BTREE_CURSOR;
+
 typedef struct st_heap_info
 {
 private:
@@ -238,6 +291,7 @@ public:
   }
 
   unsigned char *current_ptr;
+  unsigned char *dupp_key_pos;          /* Row of the last hash key duplicate */
   struct st_hp_hash_info *current_hash_ptr;
   uint32_t current_record,next_block;
   int lastinx,errkey;
@@ -246,6 +300,8 @@ public:
   std::vector <unsigned char> lastkey;			/* Last used key with rkey */
   enum drizzled::ha_rkey_function last_find_flag;
   uint32_t lastkey_len;
+  HP_BTREE_CURSOR btree_cursor;         /* For BTREE keys */
+  std::vector<unsigned char> btree_key; /* Normalized key being searched */
   drizzled::THR_LOCK_DATA lock;
 } HP_INFO;
 
@@ -259,6 +315,8 @@ typedef struct st_heap_create_info
   uint64_t auto_increment;
   bool with_auto_increment;
   bool internal_table;
+  std::vector<HP_BLOBDEF> blobs;            /* Blob columns */
+  drizzled::memory::Tracker *tracker;       /* Memory accounting, or NULL */
 } HP_CREATE_INFO;
 
 	/* Prototypes for heap-functions */
@@ -295,10 +353,15 @@ extern void heap_clear(HP_INFO *info);
 extern int heap_disable_indexes(HP_INFO *info);
 extern int heap_enable_indexes(HP_INFO *info);
 extern int heap_indexes_are_disabled(HP_INFO *info);
+extern int heap_start_bulk_insert(HP_INFO *info);
+extern int heap_end_bulk_insert(HP_INFO *info);
 extern void heap_update_auto_increment(HP_INFO *info, const unsigned char *record);
 int hp_panic(enum drizzled::ha_panic_function flag);
 int heap_rkey(HP_INFO *info, unsigned char *record, int inx, const unsigned char *key,
               drizzled::key_part_map keypart_map,
               enum drizzled::ha_rkey_function find_flag);
 extern unsigned char * heap_find(HP_INFO *info,int inx,const unsigned char *key);
+extern drizzled::ha_rows heap_records_in_range(HP_INFO *info, int inx,
+                                               drizzled::key_range *min_key,
+                                               drizzled::key_range *max_key);
 extern unsigned char *heap_position(HP_INFO *info);
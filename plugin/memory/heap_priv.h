@@ -21,12 +21,10 @@
 
 #include "heap.h"			/* Structs & some defines */
 
-#include <list>
-
-
-namespace boost {
-  class mutex;
-}
+#include <string>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
 
 /*
   When allocating keys /rows in the internal block structure, do it
@@ -39,10 +37,26 @@ namespace boost {
 #define CHUNK_STATUS_DELETED 0    /* this chunk has been deleted and can be reused */
 #define CHUNK_STATUS_ACTIVE  1    /* this chunk represents the first part of a live record */
 
+/*
+  Tables that are not internal can be found by name. They are spread over
+  HP_SHARE_PARTITIONS partitions by the hash of their name, each with its
+  own mutex, so sessions creating, opening and closing their temporary
+  tables only wait for the few others whose tables hash to the same
+  partition. Internal tables are not registered and take no mutex at all.
+*/
+
+#define HP_SHARE_PARTITIONS 32
+
+typedef struct st_hp_share_partition
+{
+  boost::mutex lock;
+  boost::unordered_map<std::string, HP_SHARE *> shares;
+  boost::unordered_set<HP_INFO *> open_list;	/* Opened by name */
+} HP_SHARE_PARTITION;
+
 	/* Some extern variables */
 
-extern std::list<HP_SHARE *> heap_share_list;
-extern std::list<HP_INFO *> heap_open_list;
+extern HP_SHARE_PARTITION heap_share_partitions[HP_SHARE_PARTITIONS];
 
 #define test_active(info) \
 if (!(info->update & HA_STATE_AKTIV))\
@@ -58,22 +72,28 @@ typedef struct st_hp_hash_info
 {
   struct st_hp_hash_info *next_key;
   unsigned char *ptr_to_rec;
+  uint32_t hash;			/* hp_rec_hashnr() of ptr_to_rec */
 } HASH_INFO;
 
 	/* Prototypes for intern functions */
 
-extern HP_SHARE *hp_find_named_heap(const char *name);
+extern HP_SHARE_PARTITION *hp_share_partition(const std::string &name);
+extern HP_SHARE *hp_find_named_heap(HP_SHARE_PARTITION *partition,
+                                    const char *name);
 extern int hp_rectest(HP_INFO *info,const unsigned char *old);
 extern unsigned char *hp_find_block(HP_BLOCK *info,uint32_t pos);
 extern int hp_get_new_block(HP_BLOCK *info, size_t* alloc_length);
 extern void hp_free(HP_SHARE *info);
 extern unsigned char *hp_free_level(HP_BLOCK *block,uint32_t level,HP_PTRS *pos,
                                     unsigned char *last_pos);
+extern void hp_free_blocks(HP_BLOCK *block);
 extern int hp_write_key(HP_INFO *info, HP_KEYDEF *keyinfo,
 			const unsigned char *record, unsigned char *recpos);
 extern int hp_delete_key(HP_INFO *info,HP_KEYDEF *keyinfo,
 			 const unsigned char *record,unsigned char *recpos,int flag);
 extern HASH_INFO *_heap_find_hash(HP_BLOCK *block,uint32_t pos);
+extern HASH_INFO *hp_find_free_hash(HP_SHARE *info, HP_BLOCK *block,
+                                    uint32_t records);
 extern unsigned char *hp_search(HP_INFO *info,HP_KEYDEF *keyinfo,const unsigned char *key,
 		       uint32_t nextflag);
 extern unsigned char *hp_search_next(HP_INFO *info, HP_KEYDEF *keyinfo,
@@ -90,6 +110,26 @@ extern bool hp_if_null_in_key(HP_KEYDEF *keyinfo, const unsigned char *record);
 extern int hp_close(HP_INFO *info);
 extern void hp_clear(HP_SHARE *info);
 
+   /* Ordered (BTREE) index functions, see hp_btree.cc */
+
+extern void hp_btree_init(HP_KEYDEF *keyinfo, drizzled::memory::Tracker *tracker);
+extern void hp_btree_clear(HP_SHARE *share, HP_KEYDEF *keyinfo);
+extern int hp_btree_write_key(HP_INFO *info, HP_KEYDEF *keyinfo,
+                              const unsigned char *record, unsigned char *recpos);
+extern int hp_btree_delete_key(HP_INFO *info, HP_KEYDEF *keyinfo,
+                               const unsigned char *record, unsigned char *recpos);
+extern unsigned char *hp_btree_search(HP_INFO *info, HP_KEYDEF *keyinfo,
+                                      const unsigned char *key,
+                                      drizzled::key_part_map keypart_map,
+                                      enum drizzled::ha_rkey_function find_flag);
+extern unsigned char *hp_btree_first(HP_INFO *info, HP_KEYDEF *keyinfo);
+extern unsigned char *hp_btree_last(HP_INFO *info, HP_KEYDEF *keyinfo);
+extern unsigned char *hp_btree_next(HP_INFO *info, HP_KEYDEF *keyinfo);
+extern unsigned char *hp_btree_prev(HP_INFO *info, HP_KEYDEF *keyinfo);
+extern unsigned char *hp_btree_same(HP_INFO *info, HP_KEYDEF *keyinfo,
+                                    const unsigned char *record,
+                                    unsigned char *recpos);
+
    /* Chunkset management (alloc/free/encode/decode) functions */
 
 extern unsigned char *hp_allocate_chunkset(HP_DATASPACE *info, uint32_t chunk_count);
@@ -97,9 +137,9 @@ extern void hp_free_chunks(HP_DATASPACE *info, unsigned char *pos);
 extern void hp_clear_dataspace(HP_DATASPACE *info);
 
 extern uint32_t hp_get_encoded_data_length(HP_SHARE *info, const unsigned char *record, uint32_t *chunk_count);
-extern void hp_copy_record_data_to_chunkset(HP_SHARE *info, const unsigned char *record, unsigned char *pos);
+extern int hp_copy_record_data_to_chunkset(HP_SHARE *info, const unsigned char *record, unsigned char *pos,
+                                           const unsigned char *old= NULL);
+extern void hp_free_blobs(HP_SHARE *info, const unsigned char *pos, const unsigned char *keep= NULL);
 extern void hp_extract_record(HP_SHARE *info, unsigned char *record, const unsigned char *pos);
 extern bool hp_compare_record_data_to_chunkset(HP_SHARE *info, const unsigned char *record, unsigned char *pos);
 
-extern boost::mutex THR_LOCK_heap;
-
@@ -16,6 +16,7 @@
 /* functions on blocks; Keys and records are saved in blocks */
 
 #include "heap_priv.h"
+#include <drizzled/error_t.h>
 
 #include <cstdlib>
 
@@ -78,7 +79,15 @@ int hp_get_new_block(HP_BLOCK *block, size_t *alloc_length)
     and my_default_record_cache_size we get about 1/128 unused memory.
    */
   *alloc_length=sizeof(HP_PTRS)*i+block->records_in_block* block->recbuffer;
+  if (block->tracker && not block->tracker->allocated(*alloc_length))
+  {
+    /* Over the memory limit of the statement */
+    block->tracker->freed(*alloc_length);
+    errno= drizzled::HA_ERR_OUT_OF_MEM;
+    return 1;
+  }
   root=(HP_PTRS*) malloc(*alloc_length);
+  block->allocated_length+= *alloc_length;
 
   if (i == 0)
   {
@@ -149,3 +158,16 @@ unsigned char *hp_free_level(HP_BLOCK *block, uint32_t level, HP_PTRS *pos, unsi
   }
   return next_ptr;			/* next memory position */
 }
+
+
+	/* free all blocks of block and forget about them */
+
+void hp_free_blocks(HP_BLOCK *block)
+{
+  if (block->levels)
+    hp_free_level(block,block->levels,block->root,(unsigned char*) 0);
+  block->levels=0;
+  if (block->tracker)
+    block->tracker->freed(block->allocated_length);
+  block->allocated_length= 0;
+}
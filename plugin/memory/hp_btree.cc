@@ -0,0 +1,930 @@
+/* Copyright (C) 2011 Drizzle Developer Group
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA */
+
+/*
+  Ordered (BTREE) indexes of MEMORY tables.
+
+  An HP_BTREE is a B+tree with wide nodes: a node is at least
+  HP_BTREE_MIN_NODE_LENGTH bytes, so a search reads few nodes and scans
+  each of them sequentially. Every entry is the key of one record,
+  normalized so that memcmp() gives the index order, followed by the
+  pointer to the record. With the pointer all entries are different, and
+  records with the same key are in the order of ha_heap::cmp_ref().
+
+  Leaves hold the entries and are linked to their neighbours. Inner nodes
+  hold, for every child, the first entry of the child when it was split
+  off, the pointer to the child and the number of entries below it. The
+  first of these entries is never looked at. The entry counts make
+  heap_records_in_range() exact. Full nodes are split, empty nodes are
+  freed, but nodes are never merged.
+
+  A cursor remembers its leaf and position together with the version of
+  the tree and a copy of its entry. When the tree changed since, the
+  entry is searched for again.
+*/
+
+#include "heap_priv.h"
+#include <drizzled/error_t.h>
+#include <drizzled/charset.h>
+
+#include <string.h>
+#include <cassert>
+
+using namespace drizzled;
+
+#define HP_BTREE_MIN_NODE_LENGTH 1024
+#define HP_BTREE_MIN_CHILDREN    8	/* Of an inner node, when keys are long */
+#define HP_BTREE_MAX_HEIGHT      30	/* Every level has at least twice the entries */
+
+typedef struct st_hp_btree_node
+{
+  uint32_t count;                       /* Entries in the node */
+  uint32_t level;                       /* 0 for leaves */
+  struct st_hp_btree_node *prev, *next; /* Neighbour leaves */
+} HP_BTREE_NODE;
+
+#define HP_BTREE_HEADER ALIGN_SIZE(sizeof(HP_BTREE_NODE))
+
+typedef struct st_hp_btree_path         /* Nodes passed by a search */
+{
+  HP_BTREE_NODE *node[HP_BTREE_MAX_HEIGHT + 1]; /* node[0] is the leaf */
+  uint32_t pos[HP_BTREE_MAX_HEIGHT + 1];        /* Child taken, or entry found */
+} HP_BTREE_PATH;
+
+
+static inline unsigned char *hp_btree_entry(HP_BTREE *tree, HP_BTREE_NODE *node,
+                                            uint32_t pos)
+{
+  return (unsigned char*) node + HP_BTREE_HEADER + pos * tree->entry_length;
+}
+
+static inline HP_BTREE_NODE **hp_btree_children(HP_BTREE *tree, HP_BTREE_NODE *node)
+{
+  return (HP_BTREE_NODE**) ((unsigned char*) node + tree->children_offset);
+}
+
+static inline uint32_t *hp_btree_counts(HP_BTREE *tree, HP_BTREE_NODE *node)
+{
+  return (uint32_t*) ((unsigned char*) node + tree->counts_offset);
+}
+
+static inline unsigned char *hp_btree_record(HP_BTREE *tree, const unsigned char *entry)
+{
+  unsigned char *recpos;
+  memcpy(&recpos, entry + tree->key_length, sizeof(recpos));
+  return recpos;
+}
+
+
+/* Length of a key segment when normalized */
+
+static uint32_t hp_btree_seg_length(HA_KEYSEG *seg)
+{
+  uint32_t length= seg->length;
+
+  if ((seg->type == HA_KEYTYPE_TEXT || seg->type == HA_KEYTYPE_VARTEXT1) &&
+      seg->charset != &my_charset_bin)
+    length= seg->charset->coll->strnxfrmlen(seg->charset, seg->length);
+  else if (seg->type == HA_KEYTYPE_VARTEXT1)
+    length+= 2;                                 /* Length after the bytes */
+  if (seg->null_bit)
+    length++;
+  return length;
+}
+
+
+/*
+  Normalize the value of a key segment
+
+  Strings become their weights, binary strings are padded with zeros and
+  followed by their length. Numbers, which are stored low byte first, are
+  reversed like _mi_make_key() does for HA_SWAP_KEY, and get their sign
+  bit flipped, doubles all bits when negative.
+*/
+
+static unsigned char *hp_btree_store(HA_KEYSEG *seg, unsigned char *to,
+                                     const unsigned char *pos, uint32_t length)
+{
+  const charset_info_st * const cs= seg->charset;
+
+  if (seg->type == HA_KEYTYPE_TEXT || seg->type == HA_KEYTYPE_VARTEXT1)
+  {
+    if (cs->mbmaxlen > 1)
+    {
+      uint32_t char_length= my_charpos(cs, pos, pos + length,
+                                       seg->length / cs->mbmaxlen);
+      set_if_smaller(length, char_length);
+    }
+    set_if_smaller(length, (uint32_t) seg->length);
+    if (cs != &my_charset_bin)
+    {
+      uint32_t weights_length= cs->coll->strnxfrmlen(cs, seg->length);
+      memset(to, 0, weights_length);
+      cs->strnxfrm(to, weights_length, pos, length);
+      return to + weights_length;
+    }
+    memcpy(to, pos, length);
+    memset(to + length, 0, seg->length - length);
+    to+= seg->length;
+    if (seg->type == HA_KEYTYPE_VARTEXT1)
+    {
+      *to++= (unsigned char) (length >> 8);
+      *to++= (unsigned char) length;
+    }
+    return to;
+  }
+
+  memcpy(to, pos, length);
+  if (seg->flag & HA_SWAP_KEY)
+  {
+    for (uint32_t i= 0; i < length; i++)
+      to[i]= pos[length - 1 - i];
+    switch (seg->type) {
+    case HA_KEYTYPE_DOUBLE:
+      if (to[0] & 128)
+      {
+        bool negative_zero= to[0] == 128;
+        for (uint32_t i= 1; i < length; i++)
+          negative_zero&= !to[i];
+        if (negative_zero)
+        {
+          to[0]= 128;                           /* Same as 0.0 */
+          break;
+        }
+        for (uint32_t i= 0; i < length; i++)
+          to[i]= (unsigned char) ~to[i];
+      }
+      else
+        to[0]^= 128;
+      break;
+    case HA_KEYTYPE_LONG_INT:
+    case HA_KEYTYPE_LONGLONG:
+      to[0]^= 128;
+      break;
+    default:
+      break;
+    }
+  }
+  return to + length;
+}
+
+
+/* Make the entry of a record in info->btree_key */
+
+static unsigned char *hp_btree_make_entry(HP_INFO *info, HP_KEYDEF *keyinfo,
+                                          const unsigned char *record,
+                                          unsigned char *recpos)
+{
+  HP_BTREE *tree= &keyinfo->btree;
+  HA_KEYSEG *seg, *endseg;
+
+  if (info->btree_key.size() < tree->entry_length)
+    info->btree_key.resize(tree->entry_length);
+  unsigned char *to= &info->btree_key[0];
+
+  for (seg= keyinfo->seg, endseg= seg + keyinfo->keysegs; seg < endseg; seg++)
+  {
+    const unsigned char *pos= record + seg->start;
+    uint32_t length= seg->length;
+
+    if (seg->null_bit)
+    {
+      if (record[seg->null_pos] & seg->null_bit)
+      {
+        /* NULL sorts first */
+        memset(to, 0, hp_btree_seg_length(seg));
+        to+= hp_btree_seg_length(seg);
+        continue;
+      }
+      *to++= 1;
+    }
+    if (seg->type == HA_KEYTYPE_VARTEXT1)
+    {
+      length= seg->bit_start == 1 ? (uint32_t) *pos : uint2korr(pos);
+      pos+= seg->bit_start;
+    }
+    to= hp_btree_store(seg, to, pos, length);
+  }
+  memcpy(to, &recpos, sizeof(recpos));
+  return &info->btree_key[0];
+}
+
+
+/*
+  Normalize the key parts of keypart_map in info->btree_key
+
+  RETURN
+    Length of the normalized key
+*/
+
+static uint32_t hp_btree_pack_key(HP_INFO *info, HP_KEYDEF *keyinfo,
+                                  const unsigned char *key,
+                                  key_part_map keypart_map)
+{
+  HP_BTREE *tree= &keyinfo->btree;
+  HA_KEYSEG *seg, *endseg;
+
+  if (info->btree_key.size() < tree->entry_length)
+    info->btree_key.resize(tree->entry_length);
+  unsigned char *to= &info->btree_key[0];
+
+  for (seg= keyinfo->seg, endseg= seg + keyinfo->keysegs;
+       seg < endseg && (keypart_map & 1);
+       seg++, keypart_map>>= 1)
+  {
+    /* Key segments are always packed with 2 bytes of length */
+    uint32_t pack_length= seg->type == HA_KEYTYPE_VARTEXT1 ? 2 : 0;
+    uint32_t length= seg->length;
+
+    if (seg->null_bit)
+    {
+      if (*key++)
+      {
+        memset(to, 0, hp_btree_seg_length(seg));
+        to+= hp_btree_seg_length(seg);
+        key+= pack_length + seg->length;
+        continue;
+      }
+      *to++= 1;
+    }
+    if (pack_length)
+      length= uint2korr(key);
+    to= hp_btree_store(seg, to, key + pack_length, length);
+    key+= pack_length + seg->length;
+  }
+  return (uint32_t) (to - &info->btree_key[0]);
+}
+
+
+void hp_btree_init(HP_KEYDEF *keyinfo, memory::Tracker *tracker)
+{
+  HP_BTREE *tree= &keyinfo->btree;
+  HA_KEYSEG *seg, *endseg;
+  uint32_t child_length;
+
+  tree->key_length= 0;
+  for (seg= keyinfo->seg, endseg= seg + keyinfo->keysegs; seg < endseg; seg++)
+    tree->key_length+= hp_btree_seg_length(seg);
+  tree->entry_length= tree->key_length + sizeof(unsigned char*);
+
+  /* An inner node has an entry, a pointer and a count for every child */
+  child_length= tree->entry_length + sizeof(HP_BTREE_NODE*) + sizeof(uint32_t);
+  tree->node_length= HP_BTREE_HEADER + HP_BTREE_MIN_CHILDREN * child_length +
+                     sizeof(double);
+  set_if_bigger(tree->node_length, (uint32_t) HP_BTREE_MIN_NODE_LENGTH);
+  tree->leaf_capacity= (tree->node_length - HP_BTREE_HEADER) / tree->entry_length;
+  tree->inner_capacity= (tree->node_length - HP_BTREE_HEADER - sizeof(double)) /
+                        child_length;
+  tree->children_offset= ALIGN_SIZE(HP_BTREE_HEADER +
+                                    tree->inner_capacity * tree->entry_length);
+  tree->counts_offset= tree->children_offset +
+                       tree->inner_capacity * sizeof(HP_BTREE_NODE*);
+  assert(tree->counts_offset + tree->inner_capacity * sizeof(uint32_t) <=
+         tree->node_length);
+
+  tree->root= NULL;
+  tree->height= 0;
+  tree->version= 0;
+  tree->entries= 0;
+  tree->tracker= tracker;
+  tree->allocated_length= 0;
+}
+
+
+static HP_BTREE_NODE *hp_btree_alloc(HP_SHARE *share, HP_BTREE *tree)
+{
+  HP_BTREE_NODE *node;
+
+  if (tree->tracker && not tree->tracker->allocated(tree->node_length))
+  {
+    /* Over the memory limit of the statement */
+    tree->tracker->freed(tree->node_length);
+    errno= HA_ERR_OUT_OF_MEM;
+    return NULL;
+  }
+  if (!(node= (HP_BTREE_NODE*) malloc(tree->node_length)))
+  {
+    if (tree->tracker)
+      tree->tracker->freed(tree->node_length);
+    errno= HA_ERR_OUT_OF_MEM;
+    return NULL;
+  }
+  node->count= node->level= 0;
+  node->prev= node->next= NULL;
+  tree->allocated_length+= tree->node_length;
+  share->index_length+= tree->node_length;
+  return node;
+}
+
+
+static void hp_btree_free(HP_SHARE *share, HP_BTREE *tree, HP_BTREE_NODE *node)
+{
+  free(node);
+  tree->allocated_length-= tree->node_length;
+  share->index_length-= tree->node_length;
+  if (tree->tracker)
+    tree->tracker->freed(tree->node_length);
+}
+
+
+static void hp_btree_free_level(HP_SHARE *share, HP_BTREE *tree,
+                                HP_BTREE_NODE *node)
+{
+  if (node->level)
+  {
+    for (uint32_t i= 0; i < node->count; i++)
+      hp_btree_free_level(share, tree, hp_btree_children(tree, node)[i]);
+  }
+  hp_btree_free(share, tree, node);
+}
+
+
+void hp_btree_clear(HP_SHARE *share, HP_KEYDEF *keyinfo)
+{
+  HP_BTREE *tree= &keyinfo->btree;
+
+  if (tree->root)
+    hp_btree_free_level(share, tree, tree->root);
+  tree->root= NULL;
+  tree->height= 0;
+  tree->entries= 0;
+  tree->version++;
+}
+
+
+/*
+  Find the first entry in the leaves that is not below key
+
+  DESCRIPTION
+    Compared on their first length bytes, an entry is below key if it
+    is smaller, or with after_key also if it is equal.
+    Entries of inner nodes are where their child starts, so the child
+    taken is the last one that starts below key.
+
+  RETURN
+    Number of entries before the one found
+*/
+
+static uint64_t hp_btree_descend(HP_BTREE *tree, const unsigned char *key,
+                                 uint32_t length, bool after_key,
+                                 HP_BTREE_PATH *path)
+{
+  HP_BTREE_NODE *node= tree->root;
+  uint64_t rank= 0;
+
+  for (uint32_t level= tree->height; ; level--)
+  {
+    uint32_t low= node->level ? 1 : 0, high= node->count;
+
+    while (low < high)
+    {
+      uint32_t middle= (low + high) / 2;
+      int cmp= memcmp(hp_btree_entry(tree, node, middle), key, length);
+      if (cmp < 0 || (cmp == 0 && after_key))
+        low= middle + 1;
+      else
+        high= middle;
+    }
+    path->node[level]= node;
+    if (!level)
+    {
+      path->pos[0]= low;
+      return rank + low;
+    }
+    path->pos[level]= --low;
+    uint32_t *counts= hp_btree_counts(tree, node);
+    for (uint32_t i= 0; i < low; i++)
+      rank+= counts[i];
+    node= hp_btree_children(tree, node)[low];
+  }
+}
+
+
+/* Number of entries below a node */
+
+static uint32_t hp_btree_total(HP_BTREE *tree, HP_BTREE_NODE *node)
+{
+  if (!node->level)
+    return node->count;
+
+  uint32_t *counts= hp_btree_counts(tree, node);
+  uint32_t total= 0;
+  for (uint32_t i= 0; i < node->count; i++)
+    total+= counts[i];
+  return total;
+}
+
+
+static void hp_btree_insert_entry(HP_BTREE *tree, HP_BTREE_NODE *node,
+                                  uint32_t pos, const unsigned char *entry)
+{
+  unsigned char *to= hp_btree_entry(tree, node, pos);
+
+  memmove(to + tree->entry_length, to, (node->count - pos) * tree->entry_length);
+  memcpy(to, entry, tree->entry_length);
+  node->count++;
+}
+
+
+static void hp_btree_insert_child(HP_BTREE *tree, HP_BTREE_NODE *node,
+                                  uint32_t pos, const unsigned char *entry,
+                                  HP_BTREE_NODE *child, uint32_t count)
+{
+  HP_BTREE_NODE **children= hp_btree_children(tree, node);
+  uint32_t *counts= hp_btree_counts(tree, node);
+
+  memmove(children + pos + 1, children + pos,
+          (node->count - pos) * sizeof(*children));
+  memmove(counts + pos + 1, counts + pos, (node->count - pos) * sizeof(*counts));
+  children[pos]= child;
+  counts[pos]= count;
+  hp_btree_insert_entry(tree, node, pos, entry);
+}
+
+
+static void hp_btree_remove(HP_BTREE *tree, HP_BTREE_NODE *node, uint32_t pos)
+{
+  unsigned char *to= hp_btree_entry(tree, node, pos);
+  uint32_t after= node->count - pos - 1;
+
+  memmove(to, to + tree->entry_length, after * tree->entry_length);
+  if (node->level)
+  {
+    HP_BTREE_NODE **children= hp_btree_children(tree, node);
+    uint32_t *counts= hp_btree_counts(tree, node);
+    memmove(children + pos, children + pos + 1, after * sizeof(*children));
+    memmove(counts + pos, counts + pos + 1, after * sizeof(*counts));
+  }
+  node->count--;
+}
+
+
+/* Move the entries of node from pos on to the empty node right */
+
+static void hp_btree_move(HP_BTREE *tree, HP_BTREE_NODE *node, uint32_t pos,
+                          HP_BTREE_NODE *right)
+{
+  uint32_t moved= node->count - pos;
+
+  memcpy(hp_btree_entry(tree, right, 0), hp_btree_entry(tree, node, pos),
+         moved * tree->entry_length);
+  if (node->level)
+  {
+    memcpy(hp_btree_children(tree, right), hp_btree_children(tree, node) + pos,
+           moved * sizeof(HP_BTREE_NODE*));
+    memcpy(hp_btree_counts(tree, right), hp_btree_counts(tree, node) + pos,
+           moved * sizeof(uint32_t));
+  }
+  right->level= node->level;
+  right->count= moved;
+  node->count= pos;
+}
+
+
+/* Test if a record with the key of entry is next to pos in leaf */
+
+static bool hp_btree_duplicate(HP_KEYDEF *keyinfo, HP_BTREE_NODE *leaf,
+                               uint32_t pos, const unsigned char *entry,
+                               const unsigned char *record)
+{
+  HP_BTREE *tree= &keyinfo->btree;
+  HP_BTREE_NODE *node;
+  uint32_t i;
+
+  for (node= leaf, i= pos; ; )
+  {
+    if (!i)
+    {
+      if (!(node= node->prev))
+        break;
+      i= node->count;
+    }
+    const unsigned char *other= hp_btree_entry(tree, node, --i);
+    if (memcmp(other, entry, tree->key_length))
+      break;
+    if (!hp_rec_key_cmp(keyinfo, record, hp_btree_record(tree, other), 1))
+      return true;
+  }
+  for (node= leaf, i= pos; ; )
+  {
+    if (i == node->count)
+    {
+      if (!(node= node->next))
+        break;
+      i= 0;
+    }
+    const unsigned char *other= hp_btree_entry(tree, node, i++);
+    if (memcmp(other, entry, tree->key_length))
+      break;
+    if (!hp_rec_key_cmp(keyinfo, record, hp_btree_record(tree, other), 1))
+      return true;
+  }
+  return false;
+}
+
+
+/*
+  Write a key to a BTREE index
+
+  RETURN
+    0  - OK
+    -1 - Out of memory, the index is unchanged
+    HA_ERR_FOUND_DUPP_KEY - Duplicate record on unique key. The record was
+    still added and the caller must call hp_delete_key for it.
+*/
+
+int hp_btree_write_key(HP_INFO *info, HP_KEYDEF *keyinfo,
+                       const unsigned char *record, unsigned char *recpos)
+{
+  HP_SHARE *share= info->getShare();
+  HP_BTREE *tree= &keyinfo->btree;
+  HP_BTREE_PATH path;
+  HP_BTREE_NODE *spare[HP_BTREE_MAX_HEIGHT + 1];
+  uint32_t level, spares;
+  bool duplicate= false;
+  const unsigned char *entry= hp_btree_make_entry(info, keyinfo, record, recpos);
+
+  if (!tree->root && !(tree->root= hp_btree_alloc(share, tree)))
+    return -1;
+  hp_btree_descend(tree, entry, tree->entry_length, true, &path);
+
+  if ((keyinfo->flag & HA_NOSAME) &&
+      (!(keyinfo->flag & HA_NULL_PART_KEY) ||
+       !hp_if_null_in_key(keyinfo, record)))
+    duplicate= hp_btree_duplicate(keyinfo, path.node[0], path.pos[0],
+                                  entry, record);
+
+  /* Allocate the nodes of all splits first, so that failing changes nothing */
+  for (level= 0;
+       level <= tree->height &&
+       path.node[level]->count == (level ? tree->inner_capacity :
+                                   tree->leaf_capacity);
+       level++)
+  {}
+  if (level > tree->height)
+    level++;                                    /* A new root */
+  assert(tree->height + 1 < HP_BTREE_MAX_HEIGHT);
+  for (spares= 0; spares < level; spares++)
+  {
+    if (!(spare[spares]= hp_btree_alloc(share, tree)))
+    {
+      while (spares)
+        hp_btree_free(share, tree, spare[--spares]);
+      return -1;
+    }
+  }
+
+  for (level= 1; level <= tree->height; level++)
+    hp_btree_counts(tree, path.node[level])[path.pos[level]]++;
+
+  /*
+    Insert the entry into the leaf. When a node is full, split it and
+    insert its right half into the parent.
+  */
+  HP_BTREE_NODE *child= NULL;
+  uint32_t child_count= 0;
+  for (level= 0; ; level++)
+  {
+    HP_BTREE_NODE *node= path.node[level], *right;
+    uint32_t pos= level ? path.pos[level] + 1 : path.pos[0];
+    uint32_t capacity= level ? tree->inner_capacity : tree->leaf_capacity;
+    uint32_t half= (capacity + 1) / 2;
+
+    if (node->count < capacity)
+    {
+      if (level)
+        hp_btree_insert_child(tree, node, pos, entry, child, child_count);
+      else
+        hp_btree_insert_entry(tree, node, pos, entry);
+      break;
+    }
+
+    right= spare[--spares];
+    if (pos < half)
+      hp_btree_move(tree, node, half - 1, right);
+    else
+    {
+      hp_btree_move(tree, node, half, right);
+      pos-= half;
+    }
+    HP_BTREE_NODE *target= node->count < half ? node : right;
+    if (level)
+      hp_btree_insert_child(tree, target, pos, entry, child, child_count);
+    else
+    {
+      hp_btree_insert_entry(tree, target, pos, entry);
+      right->next= node->next;
+      if (right->next)
+        right->next->prev= right;
+      right->prev= node;
+      node->next= right;
+    }
+
+    if (level == tree->height)
+    {
+      HP_BTREE_NODE *root= spare[--spares];
+      root->level= level + 1;
+      hp_btree_insert_child(tree, root, 0, hp_btree_entry(tree, node, 0),
+                            node, hp_btree_total(tree, node));
+      hp_btree_insert_child(tree, root, 1, hp_btree_entry(tree, right, 0),
+                            right, hp_btree_total(tree, right));
+      tree->root= root;
+      tree->height++;
+      break;
+    }
+    hp_btree_counts(tree, path.node[level + 1])[path.pos[level + 1]]=
+      hp_btree_total(tree, node);
+    entry= hp_btree_entry(tree, right, 0);
+    child= right;
+    child_count= hp_btree_total(tree, right);
+  }
+  assert(!spares);
+
+  tree->entries++;
+  tree->version++;
+  if (duplicate)
+    return(errno= HA_ERR_FOUND_DUPP_KEY);
+  return 0;
+}
+
+
+/* Remove the key of a record from a BTREE index */
+
+int hp_btree_delete_key(HP_INFO *info, HP_KEYDEF *keyinfo,
+                        const unsigned char *record, unsigned char *recpos)
+{
+  HP_SHARE *share= info->getShare();
+  HP_BTREE *tree= &keyinfo->btree;
+  HP_BTREE_PATH path;
+  uint32_t level;
+  const unsigned char *entry= hp_btree_make_entry(info, keyinfo, record, recpos);
+
+  if (!tree->root)
+    return(errno= HA_ERR_CRASHED);
+  hp_btree_descend(tree, entry, tree->entry_length, true, &path);
+  if (!path.pos[0] ||
+      memcmp(hp_btree_entry(tree, path.node[0], path.pos[0] - 1), entry,
+             tree->entry_length))
+    return(errno= HA_ERR_CRASHED);		/* This shouldn't happend */
+
+  hp_btree_remove(tree, path.node[0], path.pos[0] - 1);
+  for (level= 1; level <= tree->height; level++)
+    hp_btree_counts(tree, path.node[level])[path.pos[level]]--;
+
+  /* Free the nodes that ran empty */
+  for (level= 0; level < tree->height && !path.node[level]->count; level++)
+  {
+    HP_BTREE_NODE *node= path.node[level];
+    if (!level)
+    {
+      if (node->prev)
+        node->prev->next= node->next;
+      if (node->next)
+        node->next->prev= node->prev;
+    }
+    hp_btree_free(share, tree, node);
+    hp_btree_remove(tree, path.node[level + 1], path.pos[level + 1]);
+  }
+
+  /* A root with one child is replaced by it */
+  while (tree->height && tree->root->count == 1)
+  {
+    HP_BTREE_NODE *root= tree->root;
+    tree->root= hp_btree_children(tree, root)[0];
+    tree->height--;
+    hp_btree_free(share, tree, root);
+  }
+
+  tree->entries--;
+  tree->version++;
+  return 0;
+}
+
+
+/* Make an entry of a leaf the current one, the one after the leaf is the next */
+
+static unsigned char *hp_btree_set_cursor(HP_INFO *info, HP_BTREE *tree,
+                                          HP_BTREE_NODE *node, uint32_t pos)
+{
+  HP_BTREE_CURSOR *cursor= &info->btree_cursor;
+
+  if (node && pos == node->count)
+  {
+    node= node->next;
+    pos= 0;
+  }
+  if (!node)
+  {
+    cursor->node= NULL;
+    cursor->entry.clear();
+    errno= HA_ERR_KEY_NOT_FOUND;
+    return(info->current_ptr= NULL);
+  }
+  unsigned char *entry= hp_btree_entry(tree, node, pos);
+  cursor->node= node;
+  cursor->pos= pos;
+  cursor->version= tree->version;
+  cursor->entry.assign(entry, entry + tree->entry_length);
+  return(info->current_ptr= hp_btree_record(tree, entry));
+}
+
+
+/* Make the entry before pos the current one */
+
+static unsigned char *hp_btree_set_prev(HP_INFO *info, HP_BTREE *tree,
+                                        HP_BTREE_NODE *node, uint32_t pos)
+{
+  if (!pos)
+  {
+    if (!(node= node->prev))
+      return hp_btree_set_cursor(info, tree, NULL, 0);
+    pos= node->count;
+  }
+  return hp_btree_set_cursor(info, tree, node, pos - 1);
+}
+
+
+/*
+  Search a BTREE index
+
+  RETURN
+    The record found, which is also in info->current_ptr
+    NULL and errno= HA_ERR_KEY_NOT_FOUND if there is none
+*/
+
+unsigned char *hp_btree_search(HP_INFO *info, HP_KEYDEF *keyinfo,
+                               const unsigned char *key,
+                               key_part_map keypart_map,
+                               enum ha_rkey_function find_flag)
+{
+  HP_BTREE *tree= &keyinfo->btree;
+  HP_BTREE_PATH path;
+  unsigned char *pos;
+  uint32_t length= hp_btree_pack_key(info, keyinfo, key, keypart_map);
+  const unsigned char *packed= &info->btree_key[0];
+
+  if (!tree->root)
+    return hp_btree_set_cursor(info, tree, NULL, 0);
+
+  switch (find_flag) {
+  case HA_READ_AFTER_KEY:
+    hp_btree_descend(tree, packed, length, true, &path);
+    return hp_btree_set_cursor(info, tree, path.node[0], path.pos[0]);
+  case HA_READ_BEFORE_KEY:
+    hp_btree_descend(tree, packed, length, false, &path);
+    return hp_btree_set_prev(info, tree, path.node[0], path.pos[0]);
+  case HA_READ_KEY_OR_PREV:
+  case HA_READ_PREFIX_LAST_OR_PREV:
+    hp_btree_descend(tree, packed, length, true, &path);
+    return hp_btree_set_prev(info, tree, path.node[0], path.pos[0]);
+  case HA_READ_PREFIX_LAST:
+    hp_btree_descend(tree, packed, length, true, &path);
+    pos= hp_btree_set_prev(info, tree, path.node[0], path.pos[0]);
+    break;
+  case HA_READ_KEY_EXACT:
+  case HA_READ_PREFIX:
+    hp_btree_descend(tree, packed, length, false, &path);
+    pos= hp_btree_set_cursor(info, tree, path.node[0], path.pos[0]);
+    break;
+  default:                                      /* HA_READ_KEY_OR_NEXT */
+    hp_btree_descend(tree, packed, length, false, &path);
+    return hp_btree_set_cursor(info, tree, path.node[0], path.pos[0]);
+  }
+
+  /* The entry found must start with the key */
+  if (pos && memcmp(&info->btree_cursor.entry[0], packed, length))
+  {
+    errno= HA_ERR_KEY_NOT_FOUND;
+    return(info->current_ptr= NULL);
+  }
+  return pos;
+}
+
+
+unsigned char *hp_btree_first(HP_INFO *info, HP_KEYDEF *keyinfo)
+{
+  HP_BTREE *tree= &keyinfo->btree;
+  HP_BTREE_NODE *node= tree->root;
+
+  if (!node)
+    return hp_btree_set_cursor(info, tree, NULL, 0);
+  while (node->level)
+    node= hp_btree_children(tree, node)[0];
+  return hp_btree_set_cursor(info, tree, node, 0);
+}
+
+
+unsigned char *hp_btree_last(HP_INFO *info, HP_KEYDEF *keyinfo)
+{
+  HP_BTREE *tree= &keyinfo->btree;
+  HP_BTREE_NODE *node= tree->root;
+
+  if (!node)
+    return hp_btree_set_cursor(info, tree, NULL, 0);
+  while (node->level)
+    node= hp_btree_children(tree, node)[node->count - 1];
+  return hp_btree_set_prev(info, tree, node, node->count);
+}
+
+
+unsigned char *hp_btree_next(HP_INFO *info, HP_KEYDEF *keyinfo)
+{
+  HP_BTREE *tree= &keyinfo->btree;
+  HP_BTREE_CURSOR *cursor= &info->btree_cursor;
+  HP_BTREE_PATH path;
+
+  if (cursor->entry.empty() || !tree->root)
+    return hp_btree_set_cursor(info, tree, NULL, 0);
+  if (cursor->version == tree->version)
+    return hp_btree_set_cursor(info, tree, cursor->node, cursor->pos + 1);
+
+  /* The tree changed, continue after the current entry */
+  hp_btree_descend(tree, &cursor->entry[0], tree->entry_length, true, &path);
+  return hp_btree_set_cursor(info, tree, path.node[0], path.pos[0]);
+}
+
+
+unsigned char *hp_btree_prev(HP_INFO *info, HP_KEYDEF *keyinfo)
+{
+  HP_BTREE *tree= &keyinfo->btree;
+  HP_BTREE_CURSOR *cursor= &info->btree_cursor;
+  HP_BTREE_PATH path;
+
+  if (cursor->entry.empty() || !tree->root)
+    return hp_btree_set_cursor(info, tree, NULL, 0);
+  if (cursor->version == tree->version)
+    return hp_btree_set_prev(info, tree, cursor->node, cursor->pos);
+
+  /* The tree changed, continue before the current entry */
+  hp_btree_descend(tree, &cursor->entry[0], tree->entry_length, false, &path);
+  return hp_btree_set_prev(info, tree, path.node[0], path.pos[0]);
+}
+
+
+/* Make the entry of the record at recpos the current one */
+
+unsigned char *hp_btree_same(HP_INFO *info, HP_KEYDEF *keyinfo,
+                             const unsigned char *record, unsigned char *recpos)
+{
+  HP_BTREE *tree= &keyinfo->btree;
+  HP_BTREE_PATH path;
+  const unsigned char *entry= hp_btree_make_entry(info, keyinfo, record, recpos);
+
+  if (!tree->root)
+    return hp_btree_set_cursor(info, tree, NULL, 0);
+  hp_btree_descend(tree, entry, tree->entry_length, false, &path);
+  if (path.pos[0] == path.node[0]->count ||
+      memcmp(hp_btree_entry(tree, path.node[0], path.pos[0]), entry,
+             tree->entry_length))
+    return hp_btree_set_cursor(info, tree, NULL, 0);
+  return hp_btree_set_cursor(info, tree, path.node[0], path.pos[0]);
+}
+
+
+/*
+  Number of records between two keys of a BTREE index
+
+  NOTES
+    Exact, from the entry counts of the inner nodes. Like
+    mi_records_in_range() an empty range gives 1.
+*/
+
+ha_rows heap_records_in_range(HP_INFO *info, int inx, key_range *min_key,
+                              key_range *max_key)
+{
+  HP_KEYDEF *keyinfo= info->getShare()->keydef + inx;
+  HP_BTREE *tree= &keyinfo->btree;
+  HP_BTREE_PATH path;
+  uint64_t start= 0, end= tree->entries;
+  uint32_t length;
+
+  if (!tree->root)
+    return 0;
+  if (min_key)
+  {
+    length= hp_btree_pack_key(info, keyinfo, min_key->key, min_key->keypart_map);
+    start= hp_btree_descend(tree, &info->btree_key[0], length,
+                            min_key->flag == HA_READ_AFTER_KEY, &path);
+  }
+  if (max_key)
+  {
+    length= hp_btree_pack_key(info, keyinfo, max_key->key, max_key->keypart_map);
+    end= hp_btree_descend(tree, &info->btree_key[0], length,
+                          max_key->flag == HA_READ_AFTER_KEY, &path);
+  }
+  if (end < start)
+    return 0;
+  return end == start ? 1 : (ha_rows) (end - start);
+}
@@ -0,0 +1,185 @@
+/* Copyright (C) 2011 Drizzle Developer Group
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA */
+
+/*
+  Bulk loading of MEMORY tables.
+
+  While an empty table is filled, its non-unique hash keys are not
+  maintained. Adding a row to a hash key moves the entries of one bucket
+  around to make room for the next, so the key is built afterwards
+  instead, in one pass over the rows: every entry that is the first of its
+  bucket is put at the position of its bucket, the others at the
+  positions no entry hashes to.
+*/
+
+#include "heap_priv.h"
+#include <drizzled/error_t.h>
+
+#include <vector>
+#include <cassert>
+
+using namespace drizzled;
+using namespace std;
+
+static int hp_build_hash_key(HP_SHARE *share, HP_KEYDEF *keyinfo);
+
+
+/*
+  Start a bulk insert
+
+  SYNOPSIS
+    heap_start_bulk_insert()
+    info      A pointer to the heap storage engine HP_INFO struct.
+
+  DESCRIPTION
+    If the table is empty, stop maintaining its non-unique hash keys
+    until heap_end_bulk_insert(). Unique keys are still checked and
+    BTREE keys are still maintained.
+
+  RETURN
+    0  keys were disabled
+    1  the table is not empty or has no such keys; nothing done
+*/
+
+int heap_start_bulk_insert(HP_INFO *info)
+{
+  HP_SHARE *share= info->getShare();
+  int error= 1;
+
+  if (share->records)
+    return error;
+
+  for (uint32_t key= 0; key < share->keys; key++)
+  {
+    HP_KEYDEF *keyinfo= share->keydef + key;
+    if (keyinfo->algorithm == HP_KEY_ALG_HASH && !(keyinfo->flag & HA_NOSAME))
+    {
+      keyinfo->disabled= true;
+      error= 0;
+    }
+  }
+  return error;
+}
+
+
+/*
+  End a bulk insert
+
+  SYNOPSIS
+    heap_end_bulk_insert()
+    info      A pointer to the heap storage engine HP_INFO struct.
+
+  DESCRIPTION
+    Build the keys disabled by heap_start_bulk_insert() from the rows
+    of the table.
+
+  RETURN
+    0  ok
+    HA_ERR_OUT_OF_MEM  a key could not be built and is left disabled
+*/
+
+int heap_end_bulk_insert(HP_INFO *info)
+{
+  HP_SHARE *share= info->getShare();
+  int error= 0;
+
+  for (uint32_t key= 0; key < share->keys; key++)
+  {
+    HP_KEYDEF *keyinfo= share->keydef + key;
+    if (keyinfo->disabled)
+    {
+      if (hp_build_hash_key(share, keyinfo))
+        error= errno= HA_ERR_OUT_OF_MEM;
+      else
+        keyinfo->disabled= false;
+    }
+  }
+  return error;
+}
+
+
+/*
+  Build an empty hash key from all rows of the table
+
+  RETURN
+    0  ok
+    1  out of memory; the key is left empty
+*/
+
+static int hp_build_hash_key(HP_SHARE *share, HP_KEYDEF *keyinfo)
+{
+  HP_DATASPACE *space= &share->recordspace;
+  HP_BLOCK *block= &keyinfo->block;
+  uint32_t records= share->records;
+  vector<unsigned char *> rows;
+  vector<uint32_t> hashes;
+  HASH_INFO *pos, *gpos;
+
+  rows.reserve(records);
+  hashes.reserve(records);
+  for (uint32_t chunk= 0; chunk < space->chunk_count; chunk++)
+  {
+    unsigned char *row= hp_find_block(&space->block, chunk);
+    if (get_chunk_status(space, row) == CHUNK_STATUS_ACTIVE)
+    {
+      rows.push_back(row);
+      hashes.push_back(hp_rec_hashnr(keyinfo, row));
+    }
+  }
+  assert(rows.size() == records);
+
+  for (uint32_t i= 0; i < records; i++)
+  {
+    if (!(pos= hp_find_free_hash(share, block, i)))
+    {
+      size_t length= block->allocated_length;
+      hp_free_blocks(block);
+      block->last_allocated= 0;
+      share->index_length-= length;
+      return 1;
+    }
+    pos->ptr_to_rec= 0;
+    pos->next_key= 0;
+  }
+
+  /* The first entry of every bucket goes to the position of the bucket */
+  keyinfo->hash_buckets= 0;
+  for (uint32_t i= 0; i < records; i++)
+  {
+    pos= hp_find_hash(block, hp_mask(hashes[i], share->blength, records));
+    if (!pos->ptr_to_rec)
+    {
+      pos->ptr_to_rec= rows[i];
+      pos->hash= hashes[i];
+      keyinfo->hash_buckets++;
+    }
+  }
+
+  /* The others are linked in after it from the positions left free */
+  uint32_t empty= 0;
+  for (uint32_t i= 0; i < records; i++)
+  {
+    gpos= hp_find_hash(block, hp_mask(hashes[i], share->blength, records));
+    if (gpos->ptr_to_rec == rows[i])
+      continue;
+    while ((pos= hp_find_hash(block, empty))->ptr_to_rec)
+      empty++;
+    pos->ptr_to_rec= rows[i];
+    pos->hash= hashes[i];
+    pos->next_key= gpos->next_key;
+    gpos->next_key= pos;
+  }
+  return 0;
+}
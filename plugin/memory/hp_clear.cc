@@ -25,6 +25,7 @@
 using namespace drizzled;
 
 static void hp_clear_keys(HP_SHARE *info);
+static void hp_clear_blobs(HP_SHARE *info);
 
 void heap_clear(HP_INFO *info)
 {
@@ -33,6 +34,7 @@ void heap_clear(HP_INFO *info)
 
 void hp_clear(HP_SHARE *info)
 {
+  hp_clear_blobs(info);
   hp_clear_dataspace(&info->recordspace);
   hp_clear_keys(info);
   info->records= 0;
@@ -41,6 +43,22 @@ void hp_clear(HP_SHARE *info)
   return;
 }
 
+/* Free the blob data of all rows before their chunks go */
+
+static void hp_clear_blobs(HP_SHARE *info)
+{
+  if (info->blobs.empty())
+    return;
+
+  for (uint32_t pos= 0; pos < info->recordspace.chunk_count; pos++)
+  {
+    unsigned char *chunk= hp_find_block(&info->recordspace.block, pos);
+    if (get_chunk_status(&info->recordspace, chunk) == CHUNK_STATUS_ACTIVE)
+      hp_free_blobs(info, chunk);
+  }
+}
+
+
 /*
   Clear all keys.
 
@@ -60,11 +78,12 @@ static void hp_clear_keys(HP_SHARE *info)
   for (uint32_t key=0 ; key < info->keys ; key++)
   {
     HP_KEYDEF *keyinfo = info->keydef + key;
+    if (keyinfo->algorithm == HP_KEY_ALG_BTREE)
+      hp_btree_clear(info, keyinfo);
+    else
     {
       HP_BLOCK *block= &keyinfo->block;
-      if (block->levels)
-        hp_free_level(block,block->levels,block->root,(unsigned char*) 0);
-      block->levels=0;
+      hp_free_blocks(block);
       block->last_allocated=0;
       keyinfo->hash_buckets= 0;
     }
@@ -25,20 +25,26 @@ using namespace std;
 
 int heap_close(HP_INFO *info)
 {
+  if (info->getShare()->internal_table)
+    return hp_close(info);			/* Not registered, no mutex */
+
+  HP_SHARE_PARTITION *partition= hp_share_partition(info->getShare()->name);
   int tmp;
-  THR_LOCK_heap.lock();
+  partition->lock.lock();
+  partition->open_list.erase(info);
   tmp= hp_close(info);
-  THR_LOCK_heap.unlock();
+  partition->lock.unlock();
 
   return(tmp);
 }
 
 
+	/* Close a table not registered by name, or already unregistered */
+
 int hp_close(HP_INFO *info)
 {
   int error=0;
   info->getShare()->changed=0;
-  heap_open_list.remove(info);
   if (!--info->getShare()->open_count && info->getShare()->delete_on_close)
     hp_free(info->getShare());				/* Table was deleted */
   delete info;
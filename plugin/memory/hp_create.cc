@@ -49,11 +49,15 @@ int heap_create(const char *name, uint32_t keys, HP_KEYDEF *keydef,
   HP_SHARE *share= 0;
   HA_KEYSEG *keyseg;
 
+  HP_SHARE_PARTITION *partition= NULL;
+
   if (not create_info->internal_table)
   {
-    THR_LOCK_heap.lock();
-    if ((share= hp_find_named_heap(name)) && share->open_count == 0)
+    partition= hp_share_partition(name);
+    partition->lock.lock();
+    if ((share= hp_find_named_heap(partition, name)) && share->open_count == 0)
     {
+      partition->shares.erase(share->name);
       hp_free(share);
       share= 0;
     }
@@ -77,7 +81,8 @@ int heap_create(const char *name, uint32_t keys, HP_KEYDEF *keydef,
         /* Eventual chunk_size cannot be smaller than key data,
           which allows all keys to fit into the first chunk */
         my_error(ER_CANT_USE_OPTION_HERE, MYF(0), "block_size");
-        THR_LOCK_heap.unlock();
+        if (partition)
+          partition->lock.unlock();
         return(ER_CANT_USE_OPTION_HERE);
       }
 
@@ -184,6 +189,7 @@ int heap_create(const char *name, uint32_t keys, HP_KEYDEF *keydef,
     keyseg= keys ? share->keydef->seg : NULL;
 
     init_block(&share->recordspace.block, chunk_length, min_records, max_records);
+    share->recordspace.block.tracker= create_info->tracker;
     /* Fix keys */
     memcpy(share->keydef, keydef, (size_t) (sizeof(keydef[0]) * keys));
     for (i= 0, keyinfo= share->keydef; i < keys; i++, keyinfo++)
@@ -192,11 +198,16 @@ int heap_create(const char *name, uint32_t keys, HP_KEYDEF *keydef,
       memcpy(keyseg, keydef[i].seg,
 	     (size_t) (sizeof(keyseg[0]) * keydef[i].keysegs));
       keyseg+= keydef[i].keysegs;
+      if (keyinfo->algorithm == HP_KEY_ALG_BTREE)
+        hp_btree_init(keyinfo, create_info->tracker);
+      else
       {
 	init_block(&keyinfo->block, sizeof(HASH_INFO), min_records,
 		   max_records);
+        keyinfo->block.tracker= create_info->tracker;
         keyinfo->hash_buckets= 0;
       }
+      keyinfo->disabled= false;
       if ((keyinfo->flag & HA_AUTO_KEY) && create_info->with_auto_increment)
         share->auto_key= i + 1;
     }
@@ -215,6 +226,7 @@ int heap_create(const char *name, uint32_t keys, HP_KEYDEF *keydef,
 
     share->fixed_data_length= fixed_data_length;
     share->fixed_column_count= fixed_column_count;
+    share->blobs= create_info->blobs;
 
     share->recordspace.chunk_length= chunk_length;
     share->recordspace.chunk_dataspace_length= chunk_dataspace_length;
@@ -229,13 +241,16 @@ int heap_create(const char *name, uint32_t keys, HP_KEYDEF *keydef,
     share->name.append(name);
     if (!create_info->internal_table)
     {
-      heap_share_list.push_front(share);
+      partition->shares[share->name]= share;
     }
     else
+    {
+      share->internal_table= 1;
       share->delete_on_close= 1;
+    }
   }
-  if (!create_info->internal_table)
-    THR_LOCK_heap.unlock();
+  if (partition)
+    partition->lock.unlock();
 
   *res= share;
   return(0);
@@ -246,8 +261,8 @@ err:
   if (share)
     delete[] share->keydef;
   delete share;
-  if (not create_info->internal_table)
-    THR_LOCK_heap.unlock();
+  if (partition)
+    partition->lock.unlock();
   return(1);
 } /* heap_create */
 
@@ -294,12 +309,15 @@ static inline void heap_try_free(HP_SHARE *share)
 
 int heap_delete_table(const char *name)
 {
+  HP_SHARE_PARTITION *partition= hp_share_partition(name);
   int result;
   register HP_SHARE *share;
 
-  THR_LOCK_heap.lock();
-  if ((share= hp_find_named_heap(name)))
+  partition->lock.lock();
+  if ((share= hp_find_named_heap(partition, name)))
   {
+    /* The name is free for a new table even if this one is still open */
+    partition->shares.erase(share->name);
     heap_try_free(share);
     result= 0;
   }
@@ -307,14 +325,15 @@ int heap_delete_table(const char *name)
   {
     result= errno=ENOENT;
   }
-  THR_LOCK_heap.unlock();
+  partition->lock.unlock();
   return(result);
 }
 
 
+	/* Free a table, which must not be registered by name */
+
 void hp_free(HP_SHARE *share)
 {
-  heap_share_list.remove(share);        /* If not internal table */
   hp_clear(share);			/* Remove blocks from memory */
   if (share->keydef)
     delete[] share->keydef->seg;
@@ -43,6 +43,7 @@ int heap_delete(HP_INFO *info, const unsigned char *record)
   }
 
   info->update=HA_STATE_DELETED;
+  hp_free_blobs(share, pos);
   hp_free_chunks(&share->recordspace, pos);
   info->current_hash_ptr=0;
 
@@ -73,10 +74,15 @@ err:
 int hp_delete_key(HP_INFO *info, register HP_KEYDEF *keyinfo,
 		  const unsigned char *record, unsigned char *recpos, int flag)
 {
-  uint32_t blength,pos2,pos_hashnr,lastpos_hashnr;
+  uint32_t blength,pos2,pos_hashnr,lastpos_hashnr,rec_hashnr;
   HASH_INFO *lastpos,*gpos,*pos,*pos3,*empty,*last_ptr;
   HP_SHARE *share=info->getShare();
 
+  if (keyinfo->algorithm == HP_KEY_ALG_BTREE)
+    return hp_btree_delete_key(info, keyinfo, record, recpos);
+  if (keyinfo->disabled)
+    return(0);
+
   blength=share->blength;
   if (share->records+1 == blength)
     blength+= blength;
@@ -87,14 +93,15 @@ int hp_delete_key(HP_INFO *info, register HP_KEYDEF *keyinfo,
   last_ptr=0;
 
   /* Search after record with key */
+  rec_hashnr= hp_rec_hashnr(keyinfo, record);
   pos= hp_find_hash(&keyinfo->block,
-		    hp_mask(hp_rec_hashnr(keyinfo, record), blength,
-			    share->records + 1));
+		    hp_mask(rec_hashnr, blength, share->records + 1));
   gpos = pos3 = 0;
 
   while (pos->ptr_to_rec != recpos)
   {
-    if (flag && !hp_rec_key_cmp(keyinfo, record, pos->ptr_to_rec, 0))
+    if (flag && pos->hash == rec_hashnr &&
+        !hp_rec_key_cmp(keyinfo, record, pos->ptr_to_rec, 0))
       last_ptr=pos;				/* Previous same key */
     gpos=pos;
     if (!(pos=pos->next_key))
@@ -123,6 +130,7 @@ int hp_delete_key(HP_INFO *info, register HP_KEYDEF *keyinfo,
     /* remember next pos as "empty", nobody refers to "empty" at this point */
     empty=pos->next_key;
     pos->ptr_to_rec=empty->ptr_to_rec;
+    pos->hash=empty->hash;
     pos->next_key=empty->next_key;
   }
   else
@@ -135,7 +143,7 @@ int hp_delete_key(HP_INFO *info, register HP_KEYDEF *keyinfo,
     return (0);
 
   /* Move the last key (lastpos) */
-  lastpos_hashnr = hp_rec_hashnr(keyinfo, lastpos->ptr_to_rec);
+  lastpos_hashnr = lastpos->hash;
   /* pos is where lastpos should be */
   pos=hp_find_hash(&keyinfo->block, hp_mask(lastpos_hashnr, share->blength,
 					    share->records));
@@ -144,7 +152,7 @@ int hp_delete_key(HP_INFO *info, register HP_KEYDEF *keyinfo,
     empty[0]=lastpos[0];
     return(0);
   }
-  pos_hashnr = hp_rec_hashnr(keyinfo, pos->ptr_to_rec);
+  pos_hashnr = pos->hash;
   /* pos3 is where the pos should be */
   pos3= hp_find_hash(&keyinfo->block,
 		     hp_mask(pos_hashnr, share->blength, share->records));
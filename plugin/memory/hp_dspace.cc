@@ -133,12 +133,11 @@
        issues such as orphans, cycles, and bad links. However,
        Heap Engine today does not do similar things even for
        free list.
-    3. With new HP_DATASPACE allocation mechaism, BLOB will become
-       increasingly simple to implement, but I may not have time
-       for that. In one approach, BLOB data can be placed at
-       the end of the same record. In another approach (which I
-       prefer) BLOB data would have its own HP_DATASPACE with
-       variable-size entries.
+    3. BLOB columns are only supported for internal temporary
+       tables, and their data is allocated separately for each
+       value (see hp_record.cc). BLOB data could be placed at
+       the end of the same record, or have its own HP_DATASPACE
+       with variable-size entries.
     4. In a more sophisticated implementation, some space can
        be saved even with all fixed-size columns if many of them
        have NULL value, as long as these columns are not used
@@ -166,12 +165,7 @@ static unsigned char *hp_allocate_one_chunk(HP_DATASPACE *info);
 
 void hp_clear_dataspace(HP_DATASPACE *info)
 {
-  if (info->block.levels)
-  {
-    hp_free_level(&info->block,info->block.levels,info->block.root,
-                  (unsigned char*) 0);
-  }
-  info->block.levels=0;
+  hp_free_blocks(&info->block);
   info->del_chunk_count= info->chunk_count= 0;
   info->del_link=0;
   info->total_data_length= 0;
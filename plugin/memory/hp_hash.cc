@@ -31,6 +31,56 @@ using namespace std;
 static uint32_t hp_hashnr(register HP_KEYDEF *keydef, register const unsigned char *key);
 static int hp_key_cmp(HP_KEYDEF *keydef, const unsigned char *rec, const unsigned char *key);
 
+#define HP_HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL
+
+/*
+  Blob key parts, which only the unique keys of internal temporary
+  tables have, hash and compare the value the row points to (see
+  hp_record.cc). Such keys are never searched, so only the record
+  functions below know about them.
+*/
+
+static inline uint32_t hp_blob_value(const unsigned char *pos,
+                                     const unsigned char **data)
+{
+  memcpy(data, pos + sizeof(uint32_t), sizeof(*data));
+  return uint4korr(pos);
+}
+
+/*
+  Add binary key bytes to a hash value
+
+  DESCRIPTION
+    Used for the key segments that are compared with memcmp(): numbers,
+    and strings of the binary character set. Takes eight bytes at a time,
+    instead of the one at a time of my_hash_sort_bin(), and mixes the
+    result so that its low bits, which hp_mask() uses, depend on all of
+    them.
+*/
+
+static inline uint32_t hp_hash_bytes(uint32_t nr, const unsigned char *pos,
+                                     size_t length)
+{
+  uint64_t hash= nr ^ (length * HP_HASH_MULTIPLIER);
+  uint64_t word;
+
+  for (; length >= sizeof(word); pos+= sizeof(word), length-= sizeof(word))
+  {
+    memcpy(&word, pos, sizeof(word));
+    hash= (hash ^ word) * HP_HASH_MULTIPLIER;
+    hash^= hash >> 32;
+  }
+  if (length)
+  {
+    word= 0;
+    memcpy(&word, pos, length);
+    hash= (hash ^ word) * HP_HASH_MULTIPLIER;
+    hash^= hash >> 32;
+  }
+  hash*= HP_HASH_MULTIPLIER;
+  return (uint32_t) (hash ^ (hash >> 29));
+}
+
 
 	/* Search after a record based on a key */
 	/* Sets info->current_ptr to found record */
@@ -41,7 +91,7 @@ unsigned char *hp_search(HP_INFO *info, HP_KEYDEF *keyinfo, const unsigned char
 {
   register HASH_INFO *pos,*prev_ptr;
   int flag;
-  uint32_t old_nextflag;
+  uint32_t old_nextflag, hashnr;
   HP_SHARE *share=info->getShare();
   old_nextflag=nextflag;
   flag=1;
@@ -49,11 +99,13 @@ unsigned char *hp_search(HP_INFO *info, HP_KEYDEF *keyinfo, const unsigned char
 
   if (share->records)
   {
-    pos=hp_find_hash(&keyinfo->block, hp_mask(hp_hashnr(keyinfo, key),
+    hashnr= hp_hashnr(keyinfo, key);
+    pos=hp_find_hash(&keyinfo->block, hp_mask(hashnr,
 					      share->blength, share->records));
     do
     {
-      if (!hp_key_cmp(keyinfo, pos->ptr_to_rec, key))
+      /* Only records with the same hash can have the same key */
+      if (pos->hash == hashnr && !hp_key_cmp(keyinfo, pos->ptr_to_rec, key))
       {
 	switch (nextflag) {
 	case 0:					/* Search after key */
@@ -84,7 +136,7 @@ unsigned char *hp_search(HP_INFO *info, HP_KEYDEF *keyinfo, const unsigned char
       {
 	flag=0;					/* Reset flag */
 	if (hp_find_hash(&keyinfo->block,
-			 hp_mask(hp_rec_hashnr(keyinfo, pos->ptr_to_rec),
+			 hp_mask(pos->hash,
 				  share->blength, share->records)) != pos)
 	  break;				/* Wrong link */
       }
@@ -108,15 +160,18 @@ unsigned char *hp_search(HP_INFO *info, HP_KEYDEF *keyinfo, const unsigned char
 
 /*
   Search next after last read;  Assumes that the table hasn't changed
-  since last read !
+  since last read ! pos is the entry last read, so its hash is the one of
+  the key.
 */
 
 unsigned char *hp_search_next(HP_INFO *info, HP_KEYDEF *keyinfo, const unsigned char *key,
 		      HASH_INFO *pos)
 {
+  uint32_t hashnr= pos->hash;
+
   while ((pos= pos->next_key))
   {
-    if (! hp_key_cmp(keyinfo, pos->ptr_to_rec, key))
+    if (pos->hash == hashnr && ! hp_key_cmp(keyinfo, pos->ptr_to_rec, key))
     {
       info->current_hash_ptr=pos;
       return (info->current_ptr= pos->ptr_to_rec);
@@ -192,7 +247,19 @@ static uint32_t hp_hashnr(register HP_KEYDEF *keydef, register const unsigned ch
       }
       pos++;
     }
-    if (seg->type == HA_KEYTYPE_TEXT)
+    if (seg->charset == &my_charset_bin &&
+        (seg->type == HA_KEYTYPE_TEXT || seg->type == HA_KEYTYPE_VARTEXT1))
+    {
+      uint32_t length= seg->length;
+      if (seg->type == HA_KEYTYPE_VARTEXT1)
+      {
+        length= uint2korr(pos);
+        pos+= 2;
+        key+= 2;
+      }
+      nr= hp_hash_bytes(nr, pos, length);
+    }
+    else if (seg->type == HA_KEYTYPE_TEXT)
     {
        const charset_info_st * const cs= seg->charset;
        uint32_t length= seg->length;
@@ -221,13 +288,7 @@ static uint32_t hp_hashnr(register HP_KEYDEF *keydef, register const unsigned ch
        key+= pack_length;
     }
     else
-    {
-      for (; pos < (unsigned char*) key ; pos++)
-      {
-	nr^=(uint32_t) ((((uint) nr & 63)+nr2)*((uint) *pos)) + (nr << 8);
-	nr2+=3;
-      }
-    }
+      nr= hp_hash_bytes(nr, pos, seg->length);
   }
   return((uint32_t) nr);
 }
@@ -241,7 +302,7 @@ uint32_t hp_rec_hashnr(register HP_KEYDEF *keydef, register const unsigned char
 
   for (seg=keydef->seg,endseg=seg+keydef->keysegs ; seg < endseg ; seg++)
   {
-    unsigned char *pos=(unsigned char*) rec+seg->start,*end=pos+seg->length;
+    unsigned char *pos=(unsigned char*) rec+seg->start;
     if (seg->null_bit)
     {
       if (rec[seg->null_pos] & seg->null_bit)
@@ -250,7 +311,25 @@ uint32_t hp_rec_hashnr(register HP_KEYDEF *keydef, register const unsigned char
 	continue;
       }
     }
-    if (seg->type == HA_KEYTYPE_TEXT)
+    if (seg->flag & HA_BLOB_PART)
+    {
+      const unsigned char *data;
+      uint32_t length= hp_blob_value(pos, &data);
+      seg->charset->coll->hash_sort(seg->charset, data, length, &nr, &nr2);
+    }
+    else if (seg->charset == &my_charset_bin &&
+        (seg->type == HA_KEYTYPE_TEXT || seg->type == HA_KEYTYPE_VARTEXT1))
+    {
+      uint32_t length= seg->length;
+      if (seg->type == HA_KEYTYPE_VARTEXT1)
+      {
+        uint32_t pack_length= seg->bit_start;
+        length= (pack_length == 1 ? (uint) *(unsigned char*) pos : uint2korr(pos));
+        pos+= pack_length;
+      }
+      nr= hp_hash_bytes(nr, pos, length);
+    }
+    else if (seg->type == HA_KEYTYPE_TEXT)
     {
       const charset_info_st * const cs= seg->charset;
       uint32_t char_length= seg->length;
@@ -278,13 +357,7 @@ uint32_t hp_rec_hashnr(register HP_KEYDEF *keydef, register const unsigned char
       cs->coll->hash_sort(cs, pos+pack_length, length, &nr, &nr2);
     }
     else
-    {
-      for (; pos < end ; pos++)
-      {
-	nr^=(uint32_t) ((((uint) nr & 63)+nr2)*((uint) *pos))+ (nr << 8);
-	nr2+=3;
-      }
-    }
+      nr= hp_hash_bytes(nr, pos, seg->length);
   }
   return(nr);
 }
@@ -324,7 +397,17 @@ int hp_rec_key_cmp(HP_KEYDEF *keydef, const unsigned char *rec1, const unsigned
       if (rec1[seg->null_pos] & seg->null_bit)
 	continue;
     }
-    if (seg->type == HA_KEYTYPE_TEXT)
+    if (seg->flag & HA_BLOB_PART)
+    {
+      const unsigned char *data1, *data2;
+      uint32_t length1= hp_blob_value(rec1 + seg->start, &data1);
+      uint32_t length2= hp_blob_value(rec2 + seg->start, &data2);
+      /* Like the MyISAM unique constraint: end space is never significant */
+      if (seg->charset->coll->strnncollsp(seg->charset, data1, length1,
+                                          data2, length2, 0))
+        return 1;
+    }
+    else if (seg->type == HA_KEYTYPE_TEXT)
     {
       const charset_info_st * const cs= seg->charset;
       uint32_t char_length1;
@@ -39,6 +39,8 @@ HP_INFO *heap_open_from_share(HP_SHARE *share, int mode)
   info->mode= mode;
   info->current_record= UINT32_MAX;		/* No current record */
   info->lastinx= info->errkey= -1;
+  info->dupp_key_pos= NULL;
+  info->btree_cursor.node= NULL;
   return info;
 }
 
@@ -49,14 +51,15 @@ HP_INFO *heap_open_from_share(HP_SHARE *share, int mode)
 
 HP_INFO *heap_open_from_share_and_register(HP_SHARE *share, int mode)
 {
+  HP_SHARE_PARTITION *partition= hp_share_partition(share->name);
   HP_INFO *info;
 
-  THR_LOCK_heap.lock();
+  partition->lock.lock();
   if ((info= heap_open_from_share(share, mode)))
   {
-    heap_open_list.push_front(info);
+    partition->open_list.insert(info);
   }
-  THR_LOCK_heap.unlock();
+  partition->lock.unlock();
   return(info);
 }
 
@@ -71,39 +74,45 @@ HP_INFO *heap_open_from_share_and_register(HP_SHARE *share, int mode)
 
 HP_INFO *heap_open(const char *name, int mode)
 {
+  HP_SHARE_PARTITION *partition= hp_share_partition(name);
   HP_INFO *info;
   HP_SHARE *share;
 
-  THR_LOCK_heap.lock();
-  if (!(share= hp_find_named_heap(name)))
+  partition->lock.lock();
+  if (!(share= hp_find_named_heap(partition, name)))
   {
     errno= ENOENT;
-    THR_LOCK_heap.unlock();
+    partition->lock.unlock();
     return(0);
   }
   if ((info= heap_open_from_share(share, mode)))
   {
-    heap_open_list.push_front(info);
+    partition->open_list.insert(info);
   }
-  THR_LOCK_heap.unlock();
+  partition->lock.unlock();
   return(info);
 }
 
 
-/* map name to a heap-nr. If name isn't found return 0 */
+/* The partition a table of this name is registered in */
 
-HP_SHARE *hp_find_named_heap(const char *name)
+HP_SHARE_PARTITION *hp_share_partition(const string &name)
 {
-  list<HP_SHARE *>::iterator it= heap_share_list.begin();
-  while (it != heap_share_list.end())
-  {
-    if (not (*it)->name.compare(name))
-    {
-      return (*it);
-    }
-    ++it;
-  }
-  return((HP_SHARE *) 0);
+  return heap_share_partitions +
+    boost::hash<string>()(name) % HP_SHARE_PARTITIONS;
+}
+
+
+/*
+  map name to a heap-nr. If name isn't found return 0
+  The caller must hold the mutex of the partition.
+*/
+
+HP_SHARE *hp_find_named_heap(HP_SHARE_PARTITION *partition, const char *name)
+{
+  boost::unordered_map<string, HP_SHARE *>::iterator it=
+    partition->shares.find(name);
+  return it == partition->shares.end() ? (HP_SHARE *) 0 : it->second;
 }
 
 
@@ -23,36 +23,41 @@ using namespace drizzled;
 
 int hp_panic(enum ha_panic_function flag)
 {
-  THR_LOCK_heap.lock();
-  list<HP_INFO *>::iterator info_it= heap_open_list.begin();
-  while (info_it != heap_open_list.end())
+  for (uint32_t i= 0; i < HP_SHARE_PARTITIONS; i++)
   {
-    HP_INFO *info= *info_it;
-    switch (flag) {
-    case HA_PANIC_CLOSE:
-      hp_close(info);
-      break;
-    default:
-      break;
-    }
-    ++info_it;
-  }
-  list<HP_SHARE *>::iterator share_it= heap_share_list.begin();
-  while (share_it != heap_share_list.end())
-  {
-    HP_SHARE *share= *share_it;
+    HP_SHARE_PARTITION *partition= heap_share_partitions + i;
+
+    partition->lock.lock();
     switch (flag) {
     case HA_PANIC_CLOSE:
     {
-      if (!share->open_count)
-	hp_free(share);
+      boost::unordered_set<HP_INFO *>::iterator info_it=
+        partition->open_list.begin();
+      while (info_it != partition->open_list.end())
+      {
+        HP_INFO *info= *info_it;
+        info_it= partition->open_list.erase(info_it);
+        hp_close(info);
+      }
+      boost::unordered_map<string, HP_SHARE *>::iterator share_it=
+        partition->shares.begin();
+      while (share_it != partition->shares.end())
+      {
+        HP_SHARE *share= share_it->second;
+        if (!share->open_count)
+        {
+          share_it= partition->shares.erase(share_it);
+          hp_free(share);
+        }
+        else
+          ++share_it;
+      }
       break;
     }
     default:
       break;
     }
-    ++share_it;
+    partition->lock.unlock();
   }
-  THR_LOCK_heap.unlock();
   return(0);
 } /* hp_panic */
@@ -19,7 +19,10 @@
 #include "heap_priv.h"
 
 #include <drizzled/common.h>
+#include <drizzled/error_t.h>
 
+#include <errno.h>
+#include <stdlib.h>
 #include <string.h>
 #include <algorithm>
 
@@ -48,11 +51,74 @@ uint32_t hp_get_encoded_data_length(HP_SHARE *info, const unsigned char *, uint3
   return dst_offset;
 }
 
+/*
+  Blob columns, which only internal temporary tables have, are stored the
+  way Field_blob keeps them in the record: a 4 byte length followed by a
+  pointer to the data. When a row is stored the data is copied to memory
+  owned by the chunk, so the caller may reuse its buffers, and counted in
+  total_data_length so that max_table_size covers it.
+*/
+
+static inline bool hp_blob_is_null(const HP_BLOBDEF *blob, const unsigned char *record)
+{
+  return blob->null_bit && (record[blob->null_pos] & blob->null_bit);
+}
+
+static inline uint32_t hp_blob_length(const HP_BLOBDEF *blob, const unsigned char *record)
+{
+  return uint4korr(record + blob->offset);
+}
+
+static inline unsigned char *hp_blob_data(const HP_BLOBDEF *blob, const unsigned char *record)
+{
+  unsigned char *data;
+  memcpy(&data, record + blob->offset + sizeof(uint32_t), sizeof(data));
+  return data;
+}
+
+/* keep, if not NULL, is a row whose blob data is still in use */
+
+static void hp_free_blob_columns(HP_SHARE *info, const unsigned char *pos,
+                                 size_t count, const unsigned char *keep)
+{
+  for (size_t x= 0; x < count; x++)
+  {
+    const HP_BLOBDEF *blob= &info->blobs[x];
+    unsigned char *data= hp_blob_data(blob, pos);
+
+    if (data && not (keep && data == hp_blob_data(blob, keep)))
+    {
+      info->recordspace.total_data_length-= hp_blob_length(blob, pos);
+      free(data);
+    }
+  }
+}
+
+
 bool hp_compare_record_data_to_chunkset(HP_SHARE *info, const unsigned char *record, unsigned char *pos)
 {
   unsigned char* curr_chunk= pos;
+  uint32_t start= 0;
 
-  if (memcmp(curr_chunk, record, (size_t) info->fixed_data_length))
+  /* Compare the data of the blobs instead of the pointers to it */
+  for (std::vector<HP_BLOBDEF>::const_iterator blob= info->blobs.begin();
+       blob != info->blobs.end(); ++blob)
+  {
+    if (memcmp(curr_chunk + start, record + start, blob->offset - start))
+      return 1;
+    start= blob->offset + sizeof(uint32_t) + sizeof(unsigned char*);
+
+    if (hp_blob_is_null(&*blob, record))
+      continue;
+    uint32_t length= hp_blob_length(&*blob, record);
+    if (length != hp_blob_length(&*blob, curr_chunk) ||
+        (length && memcmp(hp_blob_data(&*blob, curr_chunk),
+                          hp_blob_data(&*blob, record), length)))
+      return 1;
+  }
+
+  if (memcmp(curr_chunk + start, record + start,
+             (size_t) info->fixed_data_length - start))
   {
     return 1;
   }
@@ -68,19 +134,75 @@ bool hp_compare_record_data_to_chunkset(HP_SHARE *info, const unsigned char *rec
   @param  info         the hosting table
   @param  record       the record in standard unpacked format
   @param  pos          the target chunkset
+  @param  old          on update, a copy of the data of the row being
+                       replaced. Blobs the record still points to are
+                       kept instead of copied again, which is what an
+                       aggregate update of a GROUP BY row does.
+
+  @return 0 on success, HA_ERR_RECORD_FILE_FULL or HA_ERR_OUT_OF_MEM if the
+          blobs could not be stored. The chunk does not own any new blob
+          data then.
 */
 
-void hp_copy_record_data_to_chunkset(HP_SHARE *info, const unsigned char *record, unsigned char *pos)
+int hp_copy_record_data_to_chunkset(HP_SHARE *info, const unsigned char *record,
+                                    unsigned char *pos, const unsigned char *old)
 {
   unsigned char* curr_chunk= pos;
 
   memcpy(curr_chunk, record, (size_t) info->fixed_data_length);
+
+  for (size_t x= 0; x < info->blobs.size(); x++)
+  {
+    const HP_BLOBDEF *blob= &info->blobs[x];
+    uint32_t length= hp_blob_is_null(blob, record) ? 0 : hp_blob_length(blob, record);
+    unsigned char *data= NULL;
+
+    if (length && old && hp_blob_data(blob, record) == hp_blob_data(blob, old) &&
+        length == hp_blob_length(blob, old))
+    {
+      data= hp_blob_data(blob, old);
+    }
+    else if (length)
+    {
+      if (info->recordspace.total_data_length + info->index_length + length >=
+          info->max_table_size)
+        errno= HA_ERR_RECORD_FILE_FULL;
+      else if (not (data= (unsigned char*) malloc(length)))
+        errno= HA_ERR_OUT_OF_MEM;
+
+      if (not data)
+      {
+        hp_free_blob_columns(info, curr_chunk, x, old);
+        return errno;
+      }
+      memcpy(data, hp_blob_data(blob, record), length);
+      info->recordspace.total_data_length+= length;
+    }
+    int4store(curr_chunk + blob->offset, length);
+    memcpy(curr_chunk + blob->offset + sizeof(uint32_t), &data, sizeof(data));
+  }
+
+  return 0;
+}
+
+/**
+  Frees the blob data owned by a stored record
+
+  @param  info         the hosting table
+  @param  pos          the chunkset, or a copy of its data
+  @param  keep         a row sharing some of that data, which is not freed
+*/
+
+void hp_free_blobs(HP_SHARE *info, const unsigned char *pos, const unsigned char *keep)
+{
+  hp_free_blob_columns(info, pos, info->blobs.size(), keep);
 }
 
 /**
   Copies record data from storage to unpacked record format
 
-  Copies data from chunkset into its original unpacked record
+  Copies data from chunkset into its original unpacked record. Blobs are
+  not copied, the record points to the data owned by the chunkset.
 
   @param       info         the hosting table
   @param[out]  record       the target record in standard unpacked format
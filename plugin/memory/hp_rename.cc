@@ -20,17 +20,49 @@
 #include "heap_priv.h"
 #include <string.h>
 #include <cstdlib>
+#include <algorithm>
+
+using namespace std;
 
 int heap_rename(const char *old_name, const char *new_name)
 {
+  HP_SHARE_PARTITION *from= hp_share_partition(old_name);
+  HP_SHARE_PARTITION *to= hp_share_partition(new_name);
   HP_SHARE *info;
 
-  THR_LOCK_heap.lock();
-  if ((info = hp_find_named_heap(old_name)))
+  /* Lock both partitions, always in the same order */
+  if (from == to)
+    from->lock.lock();
+  else
+  {
+    min(from, to)->lock.lock();
+    max(from, to)->lock.lock();
+  }
+  if ((info = hp_find_named_heap(from, old_name)))
   {
+    from->shares.erase(info->name);
     info->name.clear();
     info->name.append(new_name);
+    to->shares[info->name]= info;
+
+    /* Its open instances are found through the partition of its name */
+    if (from != to)
+    {
+      boost::unordered_set<HP_INFO *>::iterator it= from->open_list.begin();
+      while (it != from->open_list.end())
+      {
+        if ((*it)->getShare() == info)
+        {
+          to->open_list.insert(*it);
+          it= from->open_list.erase(it);
+        }
+        else
+          ++it;
+      }
+    }
   }
-  THR_LOCK_heap.unlock();
+  from->lock.unlock();
+  if (from != to)
+    to->lock.unlock();
   return(0);
 }
@@ -26,7 +26,16 @@ using namespace drizzled;
 
 int heap_rfirst(HP_INFO *info, unsigned char *record, int inx)
 {
+  HP_SHARE *share= info->getShare();
+  HP_KEYDEF *keyinfo= share->keydef + inx;
+
   info->lastinx= inx;
+  if (keyinfo->algorithm == HP_KEY_ALG_BTREE)
+  {
+    info->update= HA_STATE_PREV_FOUND;
+    return(heap_rnext(info,record));
+  }
+  else
   {
     if (!(info->getShare()->records))
     {
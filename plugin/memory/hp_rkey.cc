@@ -21,18 +21,27 @@
 using namespace drizzled;
 
 int heap_rkey(HP_INFO *info, unsigned char *record, int inx, const unsigned char *key,
-              key_part_map , enum ha_rkey_function )
+              key_part_map keypart_map, enum ha_rkey_function find_flag)
 {
   unsigned char *pos;
   HP_SHARE *share= info->getShare();
   HP_KEYDEF *keyinfo= share->keydef + inx;
 
-  if ((uint) inx >= share->keys)
+  if ((uint) inx >= share->keys || keyinfo->disabled)
   {
     return(errno= HA_ERR_WRONG_INDEX);
   }
   info->lastinx= inx;
   info->current_record= UINT32_MAX;		/* For heap_rrnd() */
+  if (keyinfo->algorithm == HP_KEY_ALG_BTREE)
+  {
+    if (!(pos= hp_btree_search(info, keyinfo, key, keypart_map, find_flag)))
+    {
+      info->update= 0;
+      return(errno);
+    }
+  }
+  else
   {
     if (!(pos= hp_search(info, share->keydef + inx, key, 0)))
     {
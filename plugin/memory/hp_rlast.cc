@@ -24,6 +24,12 @@ using namespace drizzled;
 int heap_rlast(HP_INFO *info, unsigned char *record, int inx)
 {
   info->lastinx= inx;
+  if (info->getShare()->keydef[inx].algorithm == HP_KEY_ALG_BTREE)
+  {
+    info->update= HA_STATE_NEXT_FOUND;
+    return(heap_rprev(info,record));
+  }
+  else
   {
     info->current_ptr=0;
     info->current_hash_ptr=0;
@@ -32,6 +32,16 @@ int heap_rnext(HP_INFO *info, unsigned char *record)
     return(errno=HA_ERR_WRONG_INDEX);
 
   keyinfo = share->keydef + info->lastinx;
+  if (keyinfo->algorithm == HP_KEY_ALG_BTREE)
+  {
+    /* heap_rfirst(), or heap_rprev() read before the first record */
+    if ((info->update & (HA_STATE_AKTIV | HA_STATE_PREV_FOUND)) ==
+        HA_STATE_PREV_FOUND)
+      pos= hp_btree_first(info, keyinfo);
+    else
+      pos= hp_btree_next(info, keyinfo);
+  }
+  else
   {
     if (info->current_hash_ptr)
       pos= hp_search_next(info, keyinfo, &info->lastkey[0],
@@ -27,9 +27,21 @@ int heap_rprev(HP_INFO *info, unsigned char *record)
 {
   unsigned char *pos;
   HP_SHARE *share=info->getShare();
+  HP_KEYDEF *keyinfo;
 
   if (info->lastinx < 0)
     return(errno=HA_ERR_WRONG_INDEX);
+  keyinfo= share->keydef + info->lastinx;
+  if (keyinfo->algorithm == HP_KEY_ALG_BTREE)
+  {
+    /* heap_rlast(), or heap_rnext() read after the last record */
+    if ((info->update & (HA_STATE_AKTIV | HA_STATE_NEXT_FOUND)) ==
+        HA_STATE_NEXT_FOUND)
+      pos= hp_btree_last(info, keyinfo);
+    else
+      pos= hp_btree_prev(info, keyinfo);
+  }
+  else
   {
     if (info->current_ptr || (info->update & HA_STATE_NEXT_FOUND))
     {
@@ -39,12 +39,24 @@ int heap_rsame(register HP_INFO *info, unsigned char *record, int inx)
     }
     else if (inx != -1)
     {
+      HP_KEYDEF *keyinfo= share->keydef + inx;
       info->lastinx=inx;
-      hp_make_key(share->keydef + inx, &info->lastkey[0], record);
-      if (!hp_search(info, share->keydef + inx, &info->lastkey[0], 3))
+      if (keyinfo->algorithm == HP_KEY_ALG_BTREE)
       {
-	info->update=0;
-	return(errno);
+        if (!hp_btree_same(info, keyinfo, record, info->current_ptr))
+        {
+          info->update=0;
+          return(errno);
+        }
+      }
+      else
+      {
+        hp_make_key(keyinfo, &info->lastkey[0], record);
+        if (!hp_search(info, keyinfo, &info->lastkey[0], 3))
+        {
+          info->update=0;
+          return(errno);
+        }
       }
     }
     hp_extract_record(share, record, info->current_ptr);
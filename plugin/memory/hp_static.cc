@@ -18,12 +18,7 @@
   a shared library
 */
 
-#include <config.h>
-#include "heap.h"
-#include <list>
+#include "heap_priv.h"
 
-using namespace std;
-
-list<HP_INFO *> heap_open_list;
-list<HP_SHARE *> heap_share_list;
+HP_SHARE_PARTITION heap_share_partitions[HP_SHARE_PARTITIONS];
 
@@ -18,6 +18,8 @@
 #include "heap_priv.h"
 #include <drizzled/error_t.h>
 
+#include <string.h>
+
 using namespace drizzled;
 
 int heap_update(HP_INFO *info, const unsigned char *old_record, const unsigned char *new_record)
@@ -25,6 +27,7 @@ int heap_update(HP_INFO *info, const unsigned char *old_record, const unsigned c
   HP_KEYDEF *keydef, *end, *p_lastinx;
   unsigned char *pos;
   bool auto_key_changed= 0;
+  bool blobs_not_stored= 0;
   HP_SHARE *share= info->getShare();
 
   test_active(info);
@@ -50,7 +53,24 @@ int heap_update(HP_INFO *info, const unsigned char *old_record, const unsigned c
         auto_key_changed= 1;
     }
   }
-  hp_copy_record_data_to_chunkset(share, new_record, pos);
+  if (share->blobs.empty())
+    hp_copy_record_data_to_chunkset(share, new_record, pos);
+  else
+  {
+    /*
+      new_record may point to the blobs of the stored row. Those are kept,
+      the others are freed only after the new ones are copied.
+    */
+    std::vector<unsigned char> old_data(pos, pos + share->fixed_data_length);
+    if (hp_copy_record_data_to_chunkset(share, new_record, pos, &old_data[0]))
+    {
+      memcpy(pos, &old_data[0], share->fixed_data_length);
+      blobs_not_stored= 1;
+      keydef= end - 1;
+      goto err;
+    }
+    hp_free_blobs(share, &old_data[0], pos);
+  }
   if (++(share->records) == share->blength) share->blength+= share->blength;
 
   if (auto_key_changed)
@@ -58,9 +78,10 @@ int heap_update(HP_INFO *info, const unsigned char *old_record, const unsigned c
   return(0);
 
  err:
-  if (errno == HA_ERR_FOUND_DUPP_KEY)
+  if (errno == HA_ERR_FOUND_DUPP_KEY || blobs_not_stored)
   {
-    info->errkey = (int) (keydef - share->keydef);
+    if (errno == HA_ERR_FOUND_DUPP_KEY)
+      info->errkey = (int) (keydef - share->keydef);
     while (keydef >= share->keydef)
     {
       if (hp_rec_key_cmp(keydef, old_record, new_record, 0))
@@ -29,9 +29,6 @@
 
 using namespace drizzled;
 
-static HASH_INFO *hp_find_free_hash(HP_SHARE *info, HP_BLOCK *block,
-				     uint32_t records);
-
 int heap_write(HP_INFO *info, const unsigned char *record)
 {
   HP_KEYDEF *keydef, *end;
@@ -46,6 +43,11 @@ int heap_write(HP_INFO *info, const unsigned char *record)
 
   if (!(pos=hp_allocate_chunkset(&share->recordspace, 1)))
     return(errno);
+  if (hp_copy_record_data_to_chunkset(share, record, pos))
+  {
+    hp_free_chunks(&share->recordspace, pos);
+    return(errno);
+  }
   share->changed=1;
 
   for (keydef = share->keydef, end = keydef + share->keys; keydef < end;
@@ -55,8 +57,6 @@ int heap_write(HP_INFO *info, const unsigned char *record)
       goto err;
   }
 
-  hp_copy_record_data_to_chunkset(share, record, pos);
-
   if (++share->records == share->blength)
     share->blength+= share->blength;
 
@@ -69,6 +69,9 @@ int heap_write(HP_INFO *info, const unsigned char *record)
 
 err:
   info->errkey= keydef - share->keydef;
+  /* A BTREE key that failed for other reasons than a duplicate wasn't added */
+  if (keydef->algorithm == HP_KEY_ALG_BTREE && errno != HA_ERR_FOUND_DUPP_KEY)
+    keydef--;
   while (keydef >= share->keydef)
   {
     if (hp_delete_key(info, keydef, record, pos, 0))
@@ -76,6 +79,7 @@ err:
     keydef--;
   }
 
+  hp_free_blobs(share, pos);
   hp_free_chunks(&share->recordspace, pos);
 
   return(errno);
@@ -111,10 +115,16 @@ int hp_write_key(HP_INFO *info, HP_KEYDEF *keyinfo,
 {
   HP_SHARE *share = info->getShare();
   int flag;
-  uint32_t halfbuff,hashnr,first_index;
+  uint32_t halfbuff,hashnr,first_index,rec_hashnr;
+  uint32_t hash_of_rec= 0,hash_of_rec2= 0;
   unsigned char *ptr_to_rec= NULL,*ptr_to_rec2= NULL;
   HASH_INFO *empty, *gpos= NULL, *gpos2= NULL, *pos;
 
+  if (keyinfo->algorithm == HP_KEY_ALG_BTREE)
+    return hp_btree_write_key(info, keyinfo, record, recpos);
+  if (keyinfo->disabled)
+    return(0);
+
   flag=0;
   if (!(empty= hp_find_free_hash(share,&keyinfo->block,share->records)))
     return(-1);				/* No more memory */
@@ -141,7 +151,7 @@ int hp_write_key(HP_INFO *info, HP_KEYDEF *keyinfo,
   {
     do
     {
-      hashnr = hp_rec_hashnr(keyinfo, pos->ptr_to_rec);
+      hashnr = pos->hash;
       if (flag == 0)
       {
         /*
@@ -174,6 +184,7 @@ int hp_write_key(HP_INFO *info, HP_KEYDEF *keyinfo,
 	    /* key shall be moved to the current empty position */
 	    gpos=empty;
 	    ptr_to_rec=pos->ptr_to_rec;
+	    hash_of_rec=hashnr;
 	    empty=pos;				/* This place is now free */
 	  }
 	  else
@@ -185,6 +196,7 @@ int hp_write_key(HP_INFO *info, HP_KEYDEF *keyinfo,
 	    flag=LOWFIND | LOWUSED;
 	    gpos=pos;
 	    ptr_to_rec=pos->ptr_to_rec;
+	    hash_of_rec=hashnr;
 	  }
 	}
 	else
@@ -194,11 +206,13 @@ int hp_write_key(HP_INFO *info, HP_KEYDEF *keyinfo,
 	  {
 	    /* Change link of previous lower-list key */
 	    gpos->ptr_to_rec=ptr_to_rec;
+	    gpos->hash=hash_of_rec;
 	    gpos->next_key=pos;
 	    flag= (flag & HIGHFIND) | (LOWFIND | LOWUSED);
 	  }
 	  gpos=pos;
 	  ptr_to_rec=pos->ptr_to_rec;
+	  hash_of_rec=hashnr;
 	}
       }
       else
@@ -211,6 +225,7 @@ int hp_write_key(HP_INFO *info, HP_KEYDEF *keyinfo,
 	  gpos2= empty;
           empty= pos;
 	  ptr_to_rec2=pos->ptr_to_rec;
+	  hash_of_rec2=hashnr;
 	}
 	else
 	{
@@ -218,11 +233,13 @@ int hp_write_key(HP_INFO *info, HP_KEYDEF *keyinfo,
 	  {
 	    /* Change link of previous upper-list key and save */
 	    gpos2->ptr_to_rec=ptr_to_rec2;
+	    gpos2->hash=hash_of_rec2;
 	    gpos2->next_key=pos;
 	    flag= (flag & LOWFIND) | (HIGHFIND | HIGHUSED);
 	  }
 	  gpos2=pos;
 	  ptr_to_rec2=pos->ptr_to_rec;
+	  hash_of_rec2=hashnr;
 	}
       }
     }
@@ -240,21 +257,25 @@ int hp_write_key(HP_INFO *info, HP_KEYDEF *keyinfo,
     if ((flag & (LOWFIND | LOWUSED)) == LOWFIND)
     {
       gpos->ptr_to_rec=ptr_to_rec;
+      gpos->hash=hash_of_rec;
       gpos->next_key=0;
     }
     if ((flag & (HIGHFIND | HIGHUSED)) == HIGHFIND)
     {
       gpos2->ptr_to_rec=ptr_to_rec2;
+      gpos2->hash=hash_of_rec2;
       gpos2->next_key=0;
     }
   }
   /* Check if we are at the empty position */
 
-  pos=hp_find_hash(&keyinfo->block, hp_mask(hp_rec_hashnr(keyinfo, record),
+  rec_hashnr= hp_rec_hashnr(keyinfo, record);
+  pos=hp_find_hash(&keyinfo->block, hp_mask(rec_hashnr,
 					 share->blength, share->records + 1));
   if (pos == empty)
   {
     pos->ptr_to_rec=recpos;
+    pos->hash=rec_hashnr;
     pos->next_key=0;
     keyinfo->hash_buckets++;
   }
@@ -263,17 +284,18 @@ int hp_write_key(HP_INFO *info, HP_KEYDEF *keyinfo,
     /* Check if more records in same hash-nr family */
     empty[0]=pos[0];
     gpos=hp_find_hash(&keyinfo->block,
-		      hp_mask(hp_rec_hashnr(keyinfo, pos->ptr_to_rec),
-			      share->blength, share->records + 1));
+		      hp_mask(pos->hash, share->blength, share->records + 1));
     if (pos == gpos)
     {
       pos->ptr_to_rec=recpos;
+      pos->hash=rec_hashnr;
       pos->next_key=empty;
     }
     else
     {
       keyinfo->hash_buckets++;
       pos->ptr_to_rec=recpos;
+      pos->hash=rec_hashnr;
       pos->next_key=0;
       hp_movelink(pos, gpos, empty);
     }
@@ -286,8 +308,10 @@ int hp_write_key(HP_INFO *info, HP_KEYDEF *keyinfo,
       pos=empty;
       do
       {
-	if (! hp_rec_key_cmp(keyinfo, record, pos->ptr_to_rec, 1))
+	if (pos->hash == rec_hashnr &&
+            ! hp_rec_key_cmp(keyinfo, record, pos->ptr_to_rec, 1))
 	{
+          info->dupp_key_pos= pos->ptr_to_rec;
 	  return(errno=HA_ERR_FOUND_DUPP_KEY);
 	}
       } while ((pos=pos->next_key));
@@ -298,8 +322,8 @@ int hp_write_key(HP_INFO *info, HP_KEYDEF *keyinfo,
 
 	/* Returns ptr to block, and allocates block if neaded */
 
-static HASH_INFO *hp_find_free_hash(HP_SHARE *info,
-				     HP_BLOCK *block, uint32_t records)
+HASH_INFO *hp_find_free_hash(HP_SHARE *info,
+			      HP_BLOCK *block, uint32_t records)
 {
   uint32_t block_pos;
   size_t length;
@@ -35,6 +35,7 @@
 #include <drizzled/plugin/daemon.h>
 #include <drizzled/session/table_messages.h>
 #include <drizzled/plugin/storage_engine.h>
+#include <drizzled/plugin/table_function.h>
 #include <drizzled/key.h>
 #include <drizzled/statistics_variables.h>
 #include <drizzled/system_variables.h>
@@ -61,9 +62,13 @@ static const string engine_name("MyISAM");
 boost::mutex THR_LOCK_myisam;
 
 static uint32_t myisam_key_cache_block_size= KEY_CACHE_BLOCK_SIZE;
+typedef constrained_check<size_t, SIZE_MAX, 0, 1024> key_cache_size_constraint;
+static key_cache_size_constraint key_cache_size;
 static uint64_t max_sort_file_size;
 typedef constrained_check<size_t, SIZE_MAX, 1024, 1024> sort_buffer_constraint;
 static sort_buffer_constraint sort_buffer_size;
+typedef constrained_check<uint32_t, 64, 1> repair_threads_constraint;
+static repair_threads_constraint repair_threads;
 
 /*****************************************************************************
 ** MyISAM tables
@@ -94,6 +99,7 @@ public:
   virtual ~MyisamEngine()
   { 
     mi_panic(HA_PANIC_CLOSE);
+    mi_key_cache_end();
   }
 
   virtual Cursor *create(Table &table)
@@ -548,7 +554,8 @@ ha_myisam::ha_myisam(plugin::StorageEngine &engine_arg,
   : Cursor(engine_arg, table_arg),
   file(0),
   can_enable_indexes(true),
-  is_ordered(true)
+  is_ordered(true),
+  compress_rows(false)
 { }
 
 Cursor *ha_myisam::clone(memory::Root *mem_root)
@@ -573,19 +580,10 @@ int ha_myisam::doOpen(const drizzled::identifier::Table &identifier, int mode, u
   uint32_t i;
 
   /*
-    If the user wants to have memory mapped data files, add an
-    open_flag. Do not memory map temporary tables because they are
-    expected to be inserted and thus extended a lot. Memory mapping is
-    efficient for files that keep their size, but very inefficient for
-    growing files. Using an open_flag instead of calling mi_extra(...
-    HA_EXTRA_MMAP ...) after mi_open() has the advantage that the
-    mapping is not repeated for every open, but just done on the initial
-    open, when the MyISAM share is created. Everytime the server
-    requires to open a new instance of a table it calls this method. We
-    will always supply HA_OPEN_MMAP for a permanent table. However, the
-    MyISAM storage engine will ignore this flag if this is a secondary
-    open of a table that is in use by other threads already (if the
-    MyISAM share exists already).
+    With --myisam.use-mmap the data file is not mapped here but when a
+    scan starts (see mi_mmap_data_file()). The tables are temporary and
+    are mostly filled after they are opened; mapping a growing file
+    would only mean mapping it again and again.
   */
   if (!(file= mi_open(identifier, mode, test_if_locked)))
     return (errno ? errno : -1);
@@ -615,6 +613,20 @@ int ha_myisam::doOpen(const drizzled::identifier::Table &identifier, int mode, u
   if (!getTable()->getShare()->db_record_offset)
     is_ordered= false;
 
+  /*
+    ROW_FORMAT=COMPRESSED tables are packed at the end of the statement
+    that fills them, see end_bulk_insert().
+  */
+  compress_rows= false;
+  if (message::Table *table_message= getTable()->getShare()->getTableMessage())
+  {
+    for (int32_t x= 0; x < table_message->engine().options_size(); x++)
+    {
+      if (boost::iequals(table_message->engine().options(x).name(), "ROW_FORMAT"))
+        compress_rows= boost::iequals(table_message->engine().options(x).state(),
+                                      "COMPRESSED");
+    }
+  }
 
   keys_with_parts.reset();
   for (i= 0; i < getTable()->getShare()->sizeKeys(); i++)
@@ -702,6 +714,7 @@ int ha_myisam::repair(Session *session, MI_CHECK &param, bool do_optimize)
   param.session= session;
   param.out_flag= 0;
   param.sort_buffer_length= static_cast<size_t>(sort_buffer_size);
+  param.repair_threads= static_cast<uint32_t>(repair_threads);
   strcpy(fixed_name,file->filename);
 
   // Don't lock tables if we have used LOCK Table
@@ -726,6 +739,13 @@ int ha_myisam::repair(Session *session, MI_CHECK &param, bool do_optimize)
       local_testflag|= T_STATISTICS;
       param.testflag|= T_STATISTICS;		// We get this for free
       statistics_done=1;
+      if (param.repair_threads > 1)
+      {
+        session->set_proc_info("Parallel repair");
+        error = mi_repair_parallel(&param, file, fixed_name,
+            param.testflag & T_QUICK);
+      }
+      else
       {
         session->set_proc_info("Repair by sorting");
         error = mi_repair_by_sort(&param, file, fixed_name,
@@ -1025,11 +1045,67 @@ int ha_myisam::end_bulk_insert()
 {
   mi_end_bulk_insert(file);
   int err=mi_extra(file, HA_EXTRA_NO_CACHE, 0);
+  if (!err && compress_rows && file->state->records &&
+      !(file->s->options & HA_OPTION_COMPRESS_RECORD))
+  {
+    /* Packing drops the keys; they are built again from the packed rows */
+    if ((err= pack_records(getTable()->in_use)))
+      return err;
+    return enable_indexes(HA_KEY_SWITCH_NONUNIQ_SAVE);
+  }
   return err ? err : can_enable_indexes ?
                      enable_indexes(HA_KEY_SWITCH_NONUNIQ_SAVE) : 0;
 }
 
 
+/*
+  Pack the rows of a ROW_FORMAT=COMPRESSED table
+
+  SYNOPSIS
+    pack_records()
+    session     Thread that filled the table
+
+  DESCRIPTION
+    Rewrite the data file in the packed record format (see mi_pack.cc).
+    The table is read-only afterwards and all of its keys are disabled;
+    the caller builds them again with enable_indexes().
+
+  RETURN
+    0     OK
+    != 0  Error, the table is left as it was
+*/
+
+int ha_myisam::pack_records(Session *session)
+{
+  boost::scoped_ptr<MI_CHECK> param_ap(new MI_CHECK);
+  MI_CHECK &param= *param_ap.get();
+  const char *old_proc_info= session->get_proc_info();
+  int error;
+
+  myisamchk_init(&param);
+  param.op_name= "compress";
+  param.testflag= T_SILENT;
+  param.db_name=    getTable()->getShare()->getSchemaName();
+  param.table_name= getTable()->getAlias();
+  param.tmpfile_createflag= O_RDWR | O_TRUNC;
+  param.session= session;
+  param.out_flag= 0;
+  param.sort_buffer_length= static_cast<size_t>(sort_buffer_size);
+
+  if (mi_lock_database(file, getTable()->getShare()->getType() ? F_EXTRA_LCK : F_WRLCK))
+  {
+    mi_check_print_error(&param,ER(ER_CANT_LOCK),errno);
+    return errno;
+  }
+  session->set_proc_info("Compressing table");
+  error= mi_pack_records(&param, file, file->filename);
+  session->set_proc_info(old_proc_info);
+  mi_lock_database(file,F_UNLCK);
+  info(HA_STATUS_NO_LOCK | HA_STATUS_VARIABLE | HA_STATUS_CONST);
+  return error;
+}
+
+
 
 int ha_myisam::doUpdateRecord(const unsigned char *old_data, unsigned char *new_data)
 {
@@ -1471,14 +1547,88 @@ uint32_t ha_myisam::checksum() const
   return (uint)file->state->checksum;
 }
 
+/* DATA_DICTIONARY.MYISAM_KEY_CACHE: the counters of the key cache */
+
+class MyisamKeyCacheTool : public plugin::TableFunction
+{
+public:
+  MyisamKeyCacheTool() :
+    plugin::TableFunction("DATA_DICTIONARY", "MYISAM_KEY_CACHE")
+  {
+    add_field("VARIABLE_NAME");
+    add_field("VARIABLE_VALUE", plugin::TableFunction::NUMBER, 0, false);
+  }
+
+  class Generator : public plugin::TableFunction::Generator
+  {
+    MI_KEY_CACHE_STATUS status;
+    uint32_t position;
+
+  public:
+    Generator(Field **arg) :
+      plugin::TableFunction::Generator(arg),
+      position(0)
+    {
+      mi_key_cache_status(&status);
+    }
+
+    bool populate()
+    {
+      switch (position++)
+      {
+      case 0:
+        push("BLOCKS_NOT_FLUSHED");
+        push(status.blocks_not_flushed);
+        return true;
+      case 1:
+        push("BLOCKS_USED");
+        push(status.blocks_used);
+        return true;
+      case 2:
+        push("READ_REQUESTS");
+        push(status.read_requests);
+        return true;
+      case 3:
+        push("READS");
+        push(status.reads);
+        return true;
+      case 4:
+        push("WRITE_REQUESTS");
+        push(status.write_requests);
+        return true;
+      case 5:
+        push("WRITES");
+        push(status.writes);
+        return true;
+      }
+      return false;
+    }
+  };
+
+  Generator *generator(Field **arg)
+  {
+    return new Generator(arg);
+  }
+};
+
 static int myisam_init(module::Context &context)
 { 
+  mi_key_cache_init(key_cache_size);
   context.add(new MyisamEngine(engine_name));
+  context.add(new MyisamKeyCacheTool);
+  context.registerVariable(new sys_var_constrained_value_readonly<size_t>("key_cache_size",
+                                                                          key_cache_size));
   context.registerVariable(new sys_var_constrained_value<size_t>("sort-buffer-size",
                                                                  sort_buffer_size));
+  context.registerVariable(new sys_var_constrained_value<uint32_t>("repair_threads",
+                                                                   repair_threads));
   context.registerVariable(new sys_var_uint64_t_ptr("max_sort_file_size",
                                                     &max_sort_file_size,
                                                     context.getOptions()["max-sort-file-size"].as<uint64_t>()));
+  context.registerVariable(new sys_var_bool_ptr_readonly("use_mmap", &myisam_use_mmap));
+  context.registerVariable(new sys_var_uint64_t_ptr("mmap_size",
+                                                    &myisam_mmap_size,
+                                                    context.getOptions()["mmap-size"].as<uint64_t>()));
 
   return 0;
 }
@@ -1489,6 +1639,18 @@ static void init_options(drizzled::module::option_context &context)
   context("max-sort-file-size",
           po::value<uint64_t>(&max_sort_file_size)->default_value(INT32_MAX),
           _("Don't use the fast sort index method to created index if the temporary file would get bigger than this."));
+  context("key-cache-size",
+          po::value<key_cache_size_constraint>(&key_cache_size)->default_value(KEY_CACHE_SIZE),
+          _("Memory shared by all MyISAM tables for caching index pages. 0 disables the cache."));
+  context("use-mmap",
+          po::value<bool>(&myisam_use_mmap)->default_value(false)->zero_tokens(),
+          _("Read and write the data files of MyISAM tables through memory maps."));
+  context("mmap-size",
+          po::value<uint64_t>(&myisam_mmap_size)->default_value(MMAP_SIZE),
+          _("Data files larger than this are not memory mapped, but read with pread()."));
+  context("repair-threads",
+          po::value<repair_threads_constraint>(&repair_threads)->default_value(1),
+          _("Number of indexes built at a time, each in a thread of its own, from one read of the data file when keys are enabled again after a bulk insert or ALTER TABLE ... ENABLE KEYS. 1 builds them one after another."));
   context("sort-buffer-size",
           po::value<sort_buffer_constraint>(&sort_buffer_size)->default_value(8192*1024),
           _("The buffer that is allocated when sorting the index when doing a REPAIR or when creating indexes with CREATE INDEX or ALTER TABLE."));
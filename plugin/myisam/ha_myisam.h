@@ -28,7 +28,9 @@ class ha_myisam: public drizzled::Cursor
   MI_INFO *file;
   bool can_enable_indexes;
   bool is_ordered;
+  bool compress_rows;
   int repair(drizzled::Session *session, MI_CHECK &param, bool optimize);
+  int pack_records(drizzled::Session *session);
 
  public:
   ha_myisam(drizzled::plugin::StorageEngine &engine,
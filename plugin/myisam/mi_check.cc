@@ -56,6 +56,12 @@
 #include <drizzled/error.h>
 
 #include <algorithm>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/thread.hpp>
 
 using namespace std;
 using namespace drizzled;
@@ -73,6 +79,7 @@ static int chk_index(MI_CHECK *param, MI_INFO *info,MI_KEYDEF *keyinfo,
 static uint32_t isam_key_length(MI_INFO *info,MI_KEYDEF *keyinfo);
 static ha_checksum calc_checksum(ha_rows count);
 static int writekeys(MI_SORT_PARAM *sort_param);
+static uint32_t sort_key_length(MYISAM_SHARE *share, HA_KEYSEG *keyseg);
 static int sort_one_index(MI_CHECK *param, MI_INFO *info,MI_KEYDEF *keyinfo,
 			  my_off_t pagepos, int new_file);
 int sort_key_read(MI_SORT_PARAM *sort_param,void *key);
@@ -87,6 +94,8 @@ int sort_insert_key(MI_SORT_PARAM  *sort_param,
 int sort_delete_record(MI_SORT_PARAM *sort_param);
 
 /*static int flush_pending_blocks(MI_CHECK *param);*/
+static my_off_t sort_write_key_block(MI_SORT_PARAM *sort_param,
+                                     unsigned char *buff);
 static SORT_KEY_BLOCKS	*alloc_key_blocks(MI_CHECK *param, uint32_t blocks,
 					  uint32_t buffer_length);
 static ha_checksum mi_byte_checksum(const unsigned char *buf, uint32_t length);
@@ -109,6 +118,7 @@ void myisamchk_init(MI_CHECK *param)
   param->start_check_pos=0;
   param->max_record_length= INT64_MAX;
   param->key_cache_block_size= KEY_CACHE_BLOCK_SIZE;
+  param->repair_threads= 1;
   param->stats_method= MI_STATS_METHOD_NULLS_NOT_EQUAL;
 }
 
@@ -320,6 +330,9 @@ int chk_size(MI_CHECK *param, register MI_INFO *info)
 
   if (!(param->testflag & T_SILENT)) puts("- check file-size");
 
+  /* The key cache may have pages that are not written yet */
+  mi_flush_key_blocks(info->s->kfile, FLUSH_KEEP);
+
   size= lseek(info->s->kfile, 0, SEEK_END);
   if ((skr=(my_off_t) info->state->key_file_length) != size)
   {
@@ -1084,6 +1097,38 @@ int chk_data_link(MI_CHECK *param, MI_INFO *info,int extend)
 	pos=block_info.filepos+block_info.block_len;
       break;
     case COMPRESSED_RECORD:
+      if (_mi_read_cache(&param->read_cache,(unsigned char*) block_info.header,
+                         pos, info->s->pack.ref_length, READING_NEXT))
+	goto err;
+      start_recpos=pos;
+      splits++;
+      if (_mi_pack_get_block_info(info, &info->bit_buff, &block_info,
+                                  &info->rec_buff, -1, start_recpos) ||
+          block_info.rec_len < (uint) info->s->min_pack_length ||
+	  block_info.rec_len > (uint) info->s->max_pack_length)
+      {
+	mi_check_print_error(param,
+			     "Found block with wrong recordlength: %lu at %s",
+			     block_info.rec_len, llstr(start_recpos,llbuff));
+	got_error=1;
+	break;
+      }
+      pos=block_info.filepos+block_info.rec_len;
+      if (block_info.rec_len &&
+          _mi_read_cache(&param->read_cache,(unsigned char*) info->rec_buff,
+                         block_info.filepos, block_info.rec_len, READING_NEXT))
+	goto err;
+      if (_mi_pack_rec_unpack(info, &info->bit_buff, record, info->rec_buff,
+                              block_info.rec_len))
+      {
+	mi_check_print_error(param,"Found wrong record at %s",
+			     llstr(start_recpos,llbuff));
+	got_error=1;
+      }
+      param->glob_crc+= mi_checksum(info,record);
+      link_used+= (block_info.filepos - start_recpos);
+      used+= (pos-start_recpos);
+      break;
     case BLOCK_RECORD:
       assert(0);                                /* Impossible */
     } /* switch */
@@ -1332,6 +1377,7 @@ static void mi_drop_all_indexes(MI_CHECK *param, MI_INFO *info, bool force)
         Flush dirty blocks of this index file from key cache and remove
         all blocks of this index file from key cache.
       */
+      mi_flush_key_blocks(share->kfile, FLUSH_RELEASE);
       return;
     }
     /*
@@ -1342,6 +1388,9 @@ static void mi_drop_all_indexes(MI_CHECK *param, MI_INFO *info, bool force)
     mi_clear_all_keys_active(state->key_map);
   }
 
+  /* Remove all key blocks of this index file from key cache. */
+  mi_flush_key_blocks(share->kfile, FLUSH_IGNORE_CHANGED);
+
   /* Clear index root block pointers. */
   for (i= 0; i < share->base.keys; i++)
     state->key_root[i]= HA_OFFSET_ERROR;
@@ -1389,17 +1438,20 @@ int mi_repair(MI_CHECK *param, register MI_INFO *info,
   if (info->s->options & (HA_OPTION_COMPRESS_RECORD))
     param->testflag|=T_CALC_CHECKSUM;
 
+  /* The data file may be replaced or truncated; it is mapped again later */
+  mi_munmap_file(info);
+
   if (!param->using_global_keycache)
     assert(0);
 
-  if (param->read_cache.init_io_cache(info->dfile, (uint) param->read_buffer_length, READ_CACHE,share->pack.header_length,1,MYF(MY_WME)))
+  if (param->read_cache.init_io_cache(info->dfile, (uint) param->read_buffer_length, READ_CACHE,share->pack.header_length,0,MYF(MY_WME)))
   {
     memset(&info->rec_cache, 0, sizeof(info->rec_cache));
     goto err;
   }
   if (not rep_quick)
   {
-    if (info->rec_cache.init_io_cache(-1, (uint) param->write_buffer_length, WRITE_CACHE, new_header_length, 1, MYF(MY_WME | MY_WAIT_IF_FULL)))
+    if (info->rec_cache.init_io_cache(-1, (uint) param->write_buffer_length, WRITE_CACHE, new_header_length, 0, MYF(MY_WME | MY_WAIT_IF_FULL)))
     {
       goto err;
     }
@@ -1771,6 +1823,7 @@ int mi_sort_index(MI_CHECK *param, register MI_INFO *info, char * name)
 	/* Put same locks as old file */
   share->r_locks= share->w_locks= share->tot_locks= 0;
   (void) _mi_writeinfo(info,WRITEINFO_UPDATE_KEYFILE);
+  mi_flush_key_blocks(share->kfile, FLUSH_IGNORE_CHANGED);
   internal::my_close(share->kfile,MYF(MY_WME));
   share->kfile = -1;
   internal::my_close(new_file,MYF(MY_WME));
@@ -1950,14 +2003,12 @@ int mi_repair_by_sort(MI_CHECK *param, register MI_INFO *info,
 		      const char * name, int rep_quick)
 {
   int got_error;
-  uint32_t i;
   ulong length;
   ha_rows start_records;
   my_off_t new_header_length,del;
   int new_file;
   MI_SORT_PARAM sort_param;
   MYISAM_SHARE *share=info->s;
-  HA_KEYSEG *keyseg;
   ulong   *rec_per_key_part;
   char llbuff[22];
   SORT_INFO sort_info;
@@ -1978,12 +2029,15 @@ int mi_repair_by_sort(MI_CHECK *param, register MI_INFO *info,
   if (info->s->options & (HA_OPTION_COMPRESS_RECORD))
     param->testflag|=T_CALC_CHECKSUM;
 
+  /* The data file may be replaced or truncated; it is mapped again later */
+  mi_munmap_file(info);
+
   memset(&sort_info, 0, sizeof(sort_info));
   memset(&sort_param, 0, sizeof(sort_param));
   if (!(sort_info.key_block=
         alloc_key_blocks(param, (uint) param->sort_key_blocks, share->base.max_key_block_length))
-      || param->read_cache.init_io_cache(info->dfile, (uint) param->read_buffer_length, READ_CACHE,share->pack.header_length,1,MYF(MY_WME))
-      || (! rep_quick && info->rec_cache.init_io_cache(info->dfile, (uint) param->write_buffer_length, WRITE_CACHE,new_header_length,1, MYF(MY_WME | MY_WAIT_IF_FULL) & param->myf_rw)))
+      || param->read_cache.init_io_cache(info->dfile, (uint) param->read_buffer_length, READ_CACHE,share->pack.header_length,0,MYF(MY_WME))
+      || (! rep_quick && info->rec_cache.init_io_cache(info->dfile, (uint) param->write_buffer_length, WRITE_CACHE,new_header_length,0, MYF(MY_WME | MY_WAIT_IF_FULL) & param->myf_rw)))
   {
     goto err;
   }
@@ -2091,19 +2145,8 @@ int mi_repair_by_sort(MI_CHECK *param, register MI_INFO *info,
     if ((!(param->testflag & T_SILENT)))
       printf ("- Fixing index %d\n",sort_param.key+1);
     sort_param.max_pos=sort_param.pos=share->pack.header_length;
-    keyseg=sort_param.seg;
     memset(sort_param.unique, 0, sizeof(sort_param.unique));
-    sort_param.key_length=share->rec_reflength;
-    for (i=0 ; keyseg[i].type != HA_KEYTYPE_END; i++)
-    {
-      sort_param.key_length+=keyseg[i].length;
-      if (keyseg[i].flag & HA_SPACE_PACK)
-	sort_param.key_length+=get_pack_length(keyseg[i].length);
-      if (keyseg[i].flag & (HA_BLOB_PART | HA_VAR_LENGTH_PART))
-	sort_param.key_length+=2 + test(keyseg[i].length >= 127);
-      if (keyseg[i].flag & HA_NULL_PART)
-	sort_param.key_length++;
-    }
+    sort_param.key_length=sort_key_length(share, sort_param.seg);
     info->state->records=info->state->del=share->state.split=0;
     info->state->empty=0;
 
@@ -2272,6 +2315,584 @@ err:
   return(got_error);
 }
 
+/*
+  Keys of the records read by mi_repair_parallel(), handed from the
+  thread reading the data file to the threads sorting them. There are
+  two batches, so that one is filled while the keys of the other are
+  taken.
+*/
+
+#define SORT_BATCH_RECORDS 1024
+
+typedef struct st_sort_key_batches
+{
+  boost::mutex lock;
+  boost::condition_variable cond;
+  uint32_t count[2];                    /* Records in the batch */
+  uint32_t readers[2];                  /* Sort threads still reading it */
+  uint64_t filled;                      /* Batches filled so far */
+  uint64_t last;                        /* Number of the last batch */
+  uint32_t active;                      /* Sort threads taking keys */
+  bool failed;                          /* The data file could not be read */
+} SORT_KEY_BATCHES;
+
+typedef struct st_sort_key_reader
+{
+  SORT_KEY_BATCHES *batches;
+  unsigned char *keys[2];               /* key_length bytes for every record */
+  uint32_t *lengths[2];                 /* real_key_length of every key */
+  uint64_t batch;                       /* Batch the keys are taken from */
+  uint32_t pos;                         /* Next key in it */
+  bool taken;                           /* The batch has been waited for */
+} SORT_KEY_READER;
+
+
+	/* Length of a key in the sort buffer */
+
+static uint32_t sort_key_length(MYISAM_SHARE *share, HA_KEYSEG *keyseg)
+{
+  uint32_t length= share->rec_reflength;
+
+  for (; keyseg->type != HA_KEYTYPE_END; keyseg++)
+  {
+    length+=keyseg->length;
+    if (keyseg->flag & HA_SPACE_PACK)
+      length+=get_pack_length(keyseg->length);
+    if (keyseg->flag & (HA_BLOB_PART | HA_VAR_LENGTH_PART))
+      length+=2 + test(keyseg->length >= 127);
+    if (keyseg->flag & HA_NULL_PART)
+      length++;
+  }
+  return length;
+} /* sort_key_length */
+
+
+/*
+  Take the next key of a parallel repair
+
+  Used as key_read by the sort threads of mi_repair_parallel().
+
+  RETURN
+    -1	no more keys
+    0	ok
+    1	the data file could not be read
+*/
+
+static int sort_key_read_batch(MI_SORT_PARAM *sort_param, void *key)
+{
+  SORT_KEY_READER *reader= sort_param->reader;
+  SORT_KEY_BATCHES *batches= reader->batches;
+
+  for (;;)
+  {
+    uint32_t idx= (uint32_t) (reader->batch % 2);
+
+    if (!reader->taken)
+    {
+      boost::mutex::scoped_lock scopedLock(batches->lock);
+      while (batches->filled <= reader->batch && !batches->failed)
+        batches->cond.wait(scopedLock);
+      if (batches->failed)
+        return 1;
+      reader->taken= true;
+      reader->pos= 0;
+    }
+    if (reader->pos < batches->count[idx])
+    {
+      sort_param->real_key_length= reader->lengths[idx][reader->pos];
+      memcpy(key, reader->keys[idx] + reader->pos * sort_param->key_length,
+             sort_param->key_length);
+      reader->pos++;
+      return 0;
+    }
+
+    /* Let the reading thread fill the batch again */
+    boost::mutex::scoped_lock scopedLock(batches->lock);
+    bool last= reader->batch == batches->last;
+    if (--batches->readers[idx] == 0)
+      batches->cond.notify_all();
+    reader->batch++;
+    reader->taken= false;
+    if (last)
+      return -1;
+  }
+} /* sort_key_read_batch */
+
+
+	/* Stop taking keys, giving up the batches not read to the end */
+
+static void sort_key_reader_end(SORT_KEY_READER *reader)
+{
+  SORT_KEY_BATCHES *batches= reader->batches;
+  boost::mutex::scoped_lock scopedLock(batches->lock);
+
+  for (; reader->batch < batches->filled; reader->batch++)
+    batches->readers[reader->batch % 2]--;
+  batches->active--;
+  batches->cond.notify_all();
+}
+
+
+	/* Sort the keys of one index and write its B-tree */
+
+static void sort_key_thread(MI_SORT_PARAM *sort_param, size_t sortbuff_size,
+                            int *error)
+{
+  MI_CHECK *param= sort_param->sort_info->param;
+
+  *error= _create_index_by_sort(sort_param,
+                                (bool) (!(param->testflag & T_VERBOSE)),
+                                sortbuff_size);
+  sort_key_reader_end(sort_param->reader);
+}
+
+
+/*
+  Read the records and make their keys for the sort threads
+
+  RETURN
+    0	ok
+    1	error
+*/
+
+static int sort_fill_batches(MI_SORT_PARAM *sort_param,
+                             MI_SORT_PARAM *key_param, uint32_t keys,
+                             SORT_KEY_BATCHES *batches,
+                             uint32_t batch_records)
+{
+  SORT_INFO *sort_info=sort_param->sort_info;
+  MI_INFO *info=sort_info->info;
+  int error= 0;
+
+  for (uint64_t batch= 0; !error; batch++)
+  {
+    uint32_t idx= (uint32_t) (batch % 2), count= 0;
+    {
+      boost::mutex::scoped_lock scopedLock(batches->lock);
+      while (batches->readers[idx])
+        batches->cond.wait(scopedLock);
+      if (!batches->active)
+        return(1);                              /* All sort threads failed */
+    }
+
+    while (count < batch_records && !(error=sort_get_next_record(sort_param)))
+    {
+      if (info->state->records == sort_info->max_records)
+      {
+        mi_check_print_error(sort_info->param,
+                             "Found too many records; Can't continue");
+        error= 1;
+        break;
+      }
+      for (uint32_t i= 0; i < keys; i++)
+      {
+        MI_SORT_PARAM *sinfo= key_param + i;
+        unsigned char *key= (sinfo->reader->keys[idx] +
+                             count * sinfo->key_length);
+        uint32_t length= (info->s->rec_reflength +
+                          _mi_make_key(info, sinfo->key, key,
+                                       sort_param->record,
+                                       sort_param->filepos));
+#ifdef HAVE_VALGRIND
+        memset(key+length, 0, sinfo->key_length-length);
+#endif
+        sinfo->reader->lengths[idx][count]= length;
+      }
+      count++;
+      if ((error=sort_write_record(sort_param)))
+        break;
+    }
+
+    boost::mutex::scoped_lock scopedLock(batches->lock);
+    batches->count[idx]= count;
+    batches->readers[idx]= batches->active;
+    if (error)
+    {
+      batches->last= batch;
+      batches->failed= error > 0;
+    }
+    batches->filled++;
+    batches->cond.notify_all();
+  }
+  return(error > 0);
+} /* sort_fill_batches */
+
+
+/*
+  Build several indexes from one read of the data file
+
+  SYNOPSIS
+    sort_keys_in_parallel()
+    sort_param		Reads the records of the table
+    key_nr		Indexes to build
+    rec_per_key_part	Where to store the statistics of each index
+    keys		Number of indexes
+
+  DESCRIPTION
+    The calling thread reads the records and makes their keys. Every
+    index gets a thread of its own, which sorts the keys in the part of
+    the sort buffer the index is given, merges the sorted runs and writes
+    the B-tree. The threads report errors into copies of param, which are
+    added to param once they are joined.
+
+  RESULT
+    0	ok
+    <>0	Error
+*/
+
+static int sort_keys_in_parallel(MI_SORT_PARAM *sort_param,
+                                 const uint32_t *key_nr,
+                                 ulong **rec_per_key_part, uint32_t keys)
+{
+  SORT_INFO *sort_info=sort_param->sort_info;
+  MI_CHECK *param=sort_info->param;
+  MI_INFO *info=sort_info->info;
+  MYISAM_SHARE *share=info->s;
+  boost::scoped_array<MI_SORT_PARAM> key_param(new MI_SORT_PARAM[keys]);
+  boost::scoped_array<SORT_INFO> key_info(new SORT_INFO[keys]);
+  boost::scoped_array<MI_CHECK> key_check(new MI_CHECK[keys]);
+  boost::scoped_array<SORT_KEY_READER> readers(new SORT_KEY_READER[keys]);
+  boost::scoped_array<int> errors(new int[keys]);
+  boost::mutex key_file_lock;
+  boost::thread_group threads;
+  SORT_KEY_BATCHES batches;
+  size_t keys_length= 0, batch_length, sortbuff_size;
+  uint32_t i, started= 0, batch_records;
+  int error= 0;
+
+  for (i= 0; i < keys; i++)
+    keys_length+= sort_key_length(share, share->keyinfo[key_nr[i]].seg) +
+                  sizeof(uint32_t);
+
+  /* The batches and the sort buffers of the keys share the sort memory */
+  batch_records= (uint32_t) (param->sort_buffer_length / 8 /
+                             (2 * keys_length));
+  set_if_smaller(batch_records, (uint32_t) SORT_BATCH_RECORDS);
+  set_if_bigger(batch_records, 1U);
+  batch_length= 2 * batch_records * keys_length;
+  sortbuff_size= (param->sort_buffer_length > batch_length ?
+                  param->sort_buffer_length - batch_length : 0) / keys;
+
+  for (i= 0; i < keys; i++)
+  {
+    MI_SORT_PARAM *sinfo= &key_param[i];
+    SORT_KEY_READER *reader= &readers[i];
+
+    memset(sinfo, 0, sizeof(*sinfo));
+    sinfo->key= key_nr[i];
+    sinfo->keyinfo= share->keyinfo+sinfo->key;
+    sinfo->seg= sinfo->keyinfo->seg;
+    sinfo->key_length= sort_key_length(share, sinfo->seg);
+    sinfo->key_cmp= sort_key_cmp;
+    sinfo->key_read= sort_key_read_batch;
+    sinfo->key_write= sort_key_write;
+    sinfo->lock_in_memory= lock_memory;
+    sinfo->sort_info= &key_info[i];
+    sinfo->reader= reader;
+    sinfo->key_file_lock= &key_file_lock;
+
+    /*
+      Every key has its own blocks for the B-tree levels being written,
+      and its own check parameters for the errors its thread reports
+    */
+    key_check[i]= *param;
+    key_info[i]= *sort_info;
+    key_info[i].param= &key_check[i];
+    key_info[i].dupp= 0;
+    key_info[i].key_block= alloc_key_blocks(param,
+                                            (uint) param->sort_key_blocks,
+                                            share->base.max_key_block_length);
+    key_info[i].key_block_end= key_info[i].key_block+param->sort_key_blocks;
+
+    memset(reader, 0, sizeof(*reader));
+    reader->batches= &batches;
+    reader->keys[0]= (unsigned char*) malloc(2 * batch_records *
+                                             (sinfo->key_length +
+                                              sizeof(uint32_t)));
+    reader->keys[1]= reader->keys[0] + batch_records * sinfo->key_length;
+    reader->lengths[0]= (uint32_t*) (reader->keys[1] +
+                                     batch_records * sinfo->key_length);
+    reader->lengths[1]= reader->lengths[0] + batch_records;
+    errors[i]= 1;
+
+    if (!key_info[i].key_block)
+      error= 1;
+    else if (!reader->keys[0])
+    {
+      mi_check_print_error(param,"Not enough memory for sorting keys");
+      error= 1;
+    }
+  }
+
+  batches.count[0]= batches.count[1]= 0;
+  batches.readers[0]= batches.readers[1]= 0;
+  batches.filled= 0;
+  batches.last= UINT64_MAX;
+  batches.active= keys;
+  batches.failed= false;
+
+  if (!error)
+  {
+    try
+    {
+      for (; started < keys; started++)
+        threads.create_thread(boost::bind(sort_key_thread,
+                                          &key_param[started],
+                                          sortbuff_size, &errors[started]));
+    }
+    catch (std::exception&)
+    {
+      mi_check_print_error(param,"Can't create threads for sorting keys");
+      boost::mutex::scoped_lock scopedLock(batches.lock);
+      batches.active-= keys - started;
+      batches.failed= true;
+      batches.cond.notify_all();
+      error= 1;
+    }
+    if (!error)
+      error= sort_fill_batches(sort_param, key_param.get(), keys, &batches,
+                               batch_records);
+    threads.join_all();
+  }
+
+  for (i= 0; i < keys; i++)
+  {
+    MI_SORT_PARAM *sinfo= &key_param[i];
+
+    /* Report what the sort thread found now that it is done */
+    param->error_printed|= key_check[i].error_printed;
+    param->warning_printed|= key_check[i].warning_printed;
+    param->out_flag|= key_check[i].out_flag;
+    param->testflag|= key_check[i].testflag & T_RETRY_WITHOUT_QUICK;
+
+    if (i >= started || errors[i])
+      error= 1;
+    else
+    {
+      if (param->testflag & T_STATISTICS)
+        update_key_parts(sinfo->keyinfo, rec_per_key_part[i], sinfo->unique,
+                         param->stats_method == MI_STATS_METHOD_IGNORE_NULLS?
+                         sinfo->notnull: NULL,
+                         (uint64_t) info->state->records);
+      /* Enable this index in the permanent key_map. */
+      mi_set_key_active(share->state.key_map, sinfo->key);
+    }
+    sort_info->dupp+= key_info[i].dupp;
+    free((unsigned char*) key_info[i].key_block);
+    free(readers[i].keys[0]);
+  }
+  return(error);
+} /* sort_keys_in_parallel */
+
+
+/*
+  Repair table or given index using sorting, several indexes at a time
+
+  SYNOPSIS
+    mi_repair_parallel()
+    param		Repair parameters
+    info		MyISAM handler to repair
+    name		Name of table (for warnings)
+    rep_quick		set to <> 0 if we should not change data file
+
+  DESCRIPTION
+    Like mi_repair_by_sort(), but the data file is read once for every
+    param->repair_threads indexes and their keys are sorted and written
+    in threads of their own, see sort_keys_in_parallel().
+
+    The data file is only read here. A repair that writes a new data
+    file, or removes the records with duplicate keys, is left to
+    mi_repair_by_sort().
+
+  RESULT
+    0	ok
+    <>0	Error
+*/
+
+int mi_repair_parallel(MI_CHECK *param, register MI_INFO *info,
+                       const char * name, int rep_quick)
+{
+  int got_error;
+  uint32_t i, keys;
+  ulong length;
+  ha_rows start_records;
+  my_off_t del;
+  MI_SORT_PARAM sort_param;
+  MYISAM_SHARE *share=info->s;
+  ulong *rec_per_key_part;
+  char llbuff[22];
+  SORT_INFO sort_info;
+  uint64_t key_map= 0;
+  vector<uint32_t> key_nr;
+  vector<ulong*> key_parts;
+
+  if (!rep_quick || (param->testflag & T_FORCE_UNIQUENESS))
+    return mi_repair_by_sort(param, info, name, rep_quick);
+
+  start_records=info->state->records;
+  got_error=1;
+  if (!(param->testflag & T_SILENT))
+  {
+    printf("- parallel recovering (with sort) MyISAM-table '%s'\n",name);
+    printf("Data records: %s\n", llstr(start_records,llbuff));
+  }
+  param->testflag|=T_REP; /* for easy checking */
+
+  if (info->s->options & (HA_OPTION_COMPRESS_RECORD))
+    param->testflag|=T_CALC_CHECKSUM;
+
+  /* The records are read through the read cache */
+  mi_munmap_file(info);
+
+  memset(&sort_info, 0, sizeof(sort_info));
+  memset(&sort_param, 0, sizeof(sort_param));
+  if (param->read_cache.init_io_cache(info->dfile, (uint) param->read_buffer_length, READ_CACHE,share->pack.header_length,0,MYF(MY_WME)))
+    goto err;
+
+  if (!mi_alloc_rec_buff(info, SIZE_MAX, &sort_param.record) ||
+      !mi_alloc_rec_buff(info, SIZE_MAX, &sort_param.rec_buff))
+  {
+    mi_check_print_error(param, "Not enough memory for extra record");
+    goto err;
+  }
+
+  info->update= (short) (HA_STATE_CHANGED | HA_STATE_ROW_CHANGED);
+
+  /* Optionally drop indexes and optionally modify the key_map. */
+  mi_drop_all_indexes(param, info, false);
+  key_map= share->state.key_map;
+  if (param->testflag & T_CREATE_MISSING_KEYS)
+  {
+    /* Invert the copied key_map to recreate all disabled indexes. */
+    key_map= ~key_map;
+  }
+
+  sort_info.info=info;
+  sort_info.param = param;
+
+  set_data_file_type(&sort_info, share);
+  sort_param.filepos=share->pack.header_length;
+  sort_info.dupp=0;
+  sort_info.buff=0;
+  param->read_cache.end_of_file=sort_info.filelength=
+    lseek(param->read_cache.file,0L,SEEK_END);
+
+  if (share->data_file_type == DYNAMIC_RECORD)
+    length=max(share->base.min_pack_length+1,share->base.min_block_length);
+  else if (share->data_file_type == COMPRESSED_RECORD)
+    length=share->base.min_block_length;
+  else
+    length=share->base.pack_reclength;
+  sort_info.max_records=
+    ((param->testflag & T_CREATE_MISSING_KEYS) ? info->state->records :
+     (ha_rows) (sort_info.filelength/length+1));
+  sort_param.sort_info=&sort_info;
+  sort_param.master =1;
+
+  del=info->state->del;
+  param->glob_crc=0;
+  if (param->testflag & T_CALC_CHECKSUM)
+    sort_param.calc_checksum= 1;
+
+  rec_per_key_part= param->rec_per_key_part;
+  for (i=0 ; i < share->base.keys ;
+       rec_per_key_part+=share->keyinfo[i].keysegs, i++)
+  {
+    /*
+      Skip this index if it is marked disabled in the copied
+      (and possibly inverted) key_map.
+    */
+    if (mi_is_key_active(key_map, i))
+    {
+      key_nr.push_back(i);
+      key_parts.push_back(rec_per_key_part);
+      continue;
+    }
+    /* Remember old statistics for key */
+    memcpy(rec_per_key_part,
+           (share->state.rec_per_key_part +
+            (rec_per_key_part - param->rec_per_key_part)),
+           share->keyinfo[i].keysegs*sizeof(*rec_per_key_part));
+  }
+
+  for (i=0 ; i < key_nr.size() ; i+=keys)
+  {
+    keys= min((uint32_t) key_nr.size() - i, max(param->repair_threads, 1U));
+    if ((!(param->testflag & T_SILENT)))
+      printf ("- Fixing %u indexes from index %d\n", keys, key_nr[i]+1);
+
+    sort_param.read_cache=param->read_cache;
+    sort_param.max_pos=sort_param.pos=share->pack.header_length;
+    info->state->records=info->state->del=share->state.split=0;
+    info->state->empty=0;
+
+    if (sort_keys_in_parallel(&sort_param, &key_nr[i], &key_parts[i], keys))
+    {
+      param->retry_repair=1;
+      goto err;
+    }
+    /* No need to calculate checksum again. */
+    sort_param.calc_checksum= 0;
+
+    /* Set for next loop */
+    sort_info.max_records= (ha_rows) info->state->records;
+    info->state->data_file_length=sort_param.max_pos;
+
+    param->read_cache.reinit_io_cache(READ_CACHE,share->pack.header_length, 1,1);
+  }
+
+  if (param->testflag & T_WRITE_LOOP)
+  {
+    fputs("          \r",stdout); fflush(stdout);
+  }
+
+  if (del+sort_info.dupp != info->state->del)
+  {
+    mi_check_print_error(param,"Couldn't fix table with quick recovery: Found wrong number of deleted records");
+    mi_check_print_error(param,"Run recovery again without -q");
+    param->retry_repair=1;
+    param->testflag|=T_RETRY_WITHOUT_QUICK;
+    goto err;
+  }
+
+  if (param->testflag & T_CALC_CHECKSUM)
+    info->state->checksum=param->glob_crc;
+
+  if (ftruncate(share->kfile, info->state->key_file_length))
+    mi_check_print_warning(param,
+			   "Can't change size of indexfile, error: %d",
+			   errno);
+
+  if (!(param->testflag & T_SILENT))
+  {
+    if (start_records != info->state->records)
+      printf("Data records: %s\n", llstr(info->state->records,llbuff));
+  }
+  got_error=0;
+
+  if (&share->state.state != info->state)
+    memcpy( &share->state.state, info->state, sizeof(*info->state));
+
+err:
+  if (got_error)
+  {
+    if (! param->error_printed)
+      mi_check_print_error(param,"%d when fixing table",errno);
+    mi_mark_crashed_on_repair(info);
+  }
+  else if (key_map == share->state.key_map)
+    share->state.changed&= ~STATE_NOT_OPTIMIZED_KEYS;
+  share->state.changed|=STATE_NOT_SORTED_PAGES;
+
+  free(mi_get_rec_buff_ptr(info, sort_param.rec_buff));
+  free(mi_get_rec_buff_ptr(info, sort_param.record));
+
+  param->read_cache.end_io_cache();
+  info->opt_flag&= ~READ_CACHE_USED;
+  return(got_error);
+} /* mi_repair_parallel */
+
+
 	/* Read next record and return next key */
 
 int sort_key_read(MI_SORT_PARAM *sort_param, void *key)
@@ -2675,6 +3296,69 @@ int sort_get_next_record(MI_SORT_PARAM *sort_param)
       searching=1;
     }
   case COMPRESSED_RECORD:
+    for (searching=0 ;; searching=1, sort_param->pos++)
+    {
+      if (_mi_read_cache(&sort_param->read_cache,
+                         (unsigned char*) block_info.header, sort_param->pos,
+                         share->pack.ref_length, READING_NEXT))
+	return(-1);
+      if (searching && ! sort_param->fix_datafile)
+      {
+	param->error_printed=1;
+        param->retry_repair=1;
+        param->testflag|=T_RETRY_WITHOUT_QUICK;
+	return(1);		/* Something wrong with data */
+      }
+      sort_param->start_recpos=sort_param->pos;
+      if (_mi_pack_get_block_info(info, &sort_param->bit_buff, &block_info,
+                                  &sort_param->rec_buff, -1, sort_param->pos))
+	return(-1);
+      /* The zeros at the end of the file */
+      if (!block_info.rec_len &&
+          sort_param->pos + MEMMAP_EXTRA_MARGIN == sort_info->filelength)
+	return(-1);
+      if (block_info.rec_len < (uint) share->min_pack_length ||
+          block_info.rec_len > (uint) share->max_pack_length)
+      {
+	if (! searching)
+	  mi_check_print_info(param,
+                              "Found block with wrong recordlength: %lu at %s\n",
+                              block_info.rec_len,
+                              llstr(sort_param->pos,llbuff));
+	continue;
+      }
+      if (block_info.rec_len &&
+          _mi_read_cache(&sort_param->read_cache,
+                         (unsigned char*) sort_param->rec_buff,
+                         block_info.filepos, block_info.rec_len, READING_NEXT))
+      {
+	if (! searching)
+	  mi_check_print_info(param,"Couldn't read whole record from %s",
+			      llstr(sort_param->pos,llbuff));
+	continue;
+      }
+      if (_mi_pack_rec_unpack(info, &sort_param->bit_buff, sort_param->record,
+                              sort_param->rec_buff, block_info.rec_len))
+      {
+	if (! searching)
+	  mi_check_print_info(param,"Found wrong record at %s",
+			      llstr(sort_param->pos,llbuff));
+	continue;
+      }
+      if (!sort_param->fix_datafile)
+      {
+	sort_param->filepos=sort_param->pos;
+        if (sort_param->master)
+	  share->state.split++;
+      }
+      sort_param->max_pos=(sort_param->pos=block_info.filepos+
+			   block_info.rec_len);
+      info->packed_length=block_info.rec_len;
+      if (sort_param->calc_checksum)
+	param->glob_crc+= (info->checksum=
+			   mi_checksum(info, sort_param->record));
+      return(0);
+    }
   case BLOCK_RECORD:
     assert(0);                                  /* Impossible */
   }
@@ -2776,6 +3460,24 @@ int sort_write_record(MI_SORT_PARAM *sort_param)
       /* sort_info->param->glob_crc+=info->checksum; */
       break;
     case COMPRESSED_RECORD:
+    {
+      unsigned char block_buff[8];
+      uint32_t length;
+
+      reclength=info->packed_length;
+      length= _mi_store_pack_length(block_buff, reclength);
+      if (info->s->base.blobs)
+	length+= _mi_store_pack_length(block_buff + length, info->blob_length);
+      if (info->rec_cache.write(block_buff, length) ||
+	  info->rec_cache.write(sort_param->rec_buff, reclength))
+      {
+	mi_check_print_error(param,"%d when writing to datafile",errno);
+	return(1);
+      }
+      sort_param->filepos+=reclength+length;
+      info->s->state.split++;
+      break;
+    }
     case BLOCK_RECORD:
       assert(0);                                  /* Impossible */
     }
@@ -2805,10 +3507,34 @@ int sort_key_cmp(MI_SORT_PARAM *sort_param, const void *a, const void *b)
 } /* sort_key_cmp */
 
 
+	/* Remove the record of a duplicate key */
+
+static int sort_key_duplicate(MI_SORT_PARAM *sort_param, const void *a)
+{
+  char llbuff[22],llbuff2[22];
+  SORT_INFO *sort_info=sort_param->sort_info;
+  MI_CHECK *param= sort_info->param;
+
+  sort_info->dupp++;
+  sort_info->info->lastpos=get_record_for_key(sort_info->info,
+                                              sort_param->keyinfo,
+                                              (unsigned char*) a);
+  mi_check_print_warning(param,
+                         "Duplicate key for record at %10s against record at %10s",
+                         llstr(sort_info->info->lastpos,llbuff),
+                         llstr(get_record_for_key(sort_info->info,
+                                                  sort_param->keyinfo,
+                                                  sort_info->key_block->
+                                                  lastkey),
+                               llbuff2));
+  param->testflag|=T_RETRY_WITHOUT_QUICK;
+  return (sort_delete_record(sort_param));
+} /* sort_key_duplicate */
+
+
 int sort_key_write(MI_SORT_PARAM *sort_param, const void *a)
 {
   uint32_t diff_pos[2];
-  char llbuff[22],llbuff2[22];
   SORT_INFO *sort_info=sort_param->sort_info;
   MI_CHECK *param= sort_info->param;
   int cmp;
@@ -2840,20 +3566,13 @@ int sort_key_write(MI_SORT_PARAM *sort_param, const void *a)
   }
   if ((sort_param->keyinfo->flag & HA_NOSAME) && cmp == 0)
   {
-    sort_info->dupp++;
-    sort_info->info->lastpos=get_record_for_key(sort_info->info,
-						sort_param->keyinfo,
-						(unsigned char*) a);
-    mi_check_print_warning(param,
-			   "Duplicate key for record at %10s against record at %10s",
-			   llstr(sort_info->info->lastpos,llbuff),
-			   llstr(get_record_for_key(sort_info->info,
-						    sort_param->keyinfo,
-						    sort_info->key_block->
-						    lastkey),
-				 llbuff2));
-    param->testflag|=T_RETRY_WITHOUT_QUICK;
-    return (sort_delete_record(sort_param));
+    if (sort_param->key_file_lock)
+    {
+      /* The table is shared by the key threads */
+      boost::mutex::scoped_lock scopedLock(*sort_param->key_file_lock);
+      return sort_key_duplicate(sort_param, a);
+    }
+    return sort_key_duplicate(sort_param, a);
   }
   return (sort_insert_key(sort_param,sort_info->key_block,
 			  (unsigned char*) a, HA_OFFSET_ERROR));
@@ -2875,7 +3594,7 @@ int sort_insert_key(MI_SORT_PARAM *sort_param,
                     my_off_t prev_block)
 {
   uint32_t a_length,t_length,nod_flag;
-  my_off_t filepos,key_file_length;
+  my_off_t filepos;
   unsigned char *anc_buff,*lastkey;
   MI_KEY_PARAM s_temp;
   MI_INFO *info;
@@ -2926,18 +3645,7 @@ int sort_insert_key(MI_SORT_PARAM *sort_param,
   mi_putint(anc_buff,key_block->last_length,nod_flag);
   memset(anc_buff+key_block->last_length, 0,
          keyinfo->block_length - key_block->last_length);
-  key_file_length=info->state->key_file_length;
-  if ((filepos=_mi_new(info,keyinfo,DFLT_INIT_HITS)) == HA_OFFSET_ERROR)
-    return(1);
-
-  /* If we read the page from the key cache, we have to write it back to it */
-  if (key_file_length == info->state->key_file_length)
-  {
-    if (_mi_write_keypage(info, keyinfo, filepos, DFLT_INIT_HITS, anc_buff))
-      return(1);
-  }
-  else if (my_pwrite(info->s->kfile,(unsigned char*) anc_buff,
-		     (uint) keyinfo->block_length,filepos, param->myf_rw))
+  if ((filepos=sort_write_key_block(sort_param,anc_buff)) == HA_OFFSET_ERROR)
     return(1);
 
 	/* Write separator-key to block in next level */
@@ -3006,15 +3714,50 @@ int sort_delete_record(MI_SORT_PARAM *sort_param)
   return(error);
 } /* sort_delete_record */
 
+/*
+  Write a filled key block to a new page of the index file
+
+  RETURN
+    position of the page, HA_OFFSET_ERROR on error
+*/
+
+static my_off_t sort_write_key_block(MI_SORT_PARAM *sort_param,
+                                     unsigned char *buff)
+{
+  MI_INFO *info= sort_param->sort_info->info;
+  MI_KEYDEF *keyinfo= sort_param->keyinfo;
+  my_off_t filepos, key_file_length;
+
+  /* mi_repair_parallel() writes several keys into the index file at once */
+  if (sort_param->key_file_lock)
+    sort_param->key_file_lock->lock();
+  key_file_length=info->state->key_file_length;
+  if ((filepos=_mi_new(info,keyinfo,DFLT_INIT_HITS)) != HA_OFFSET_ERROR)
+  {
+    /* If we read the page from the key cache, we have to write it back */
+    if (key_file_length == info->state->key_file_length)
+    {
+      if (_mi_write_keypage(info, keyinfo, filepos, DFLT_INIT_HITS, buff))
+        filepos= HA_OFFSET_ERROR;
+    }
+    else if (my_pwrite(info->s->kfile, buff, (uint) keyinfo->block_length,
+                       filepos, sort_param->sort_info->param->myf_rw))
+      filepos= HA_OFFSET_ERROR;
+  }
+  if (sort_param->key_file_lock)
+    sort_param->key_file_lock->unlock();
+  return(filepos);
+} /* sort_write_key_block */
+
+
 	/* Fix all pending blocks and flush everything to disk */
 
 int flush_pending_blocks(MI_SORT_PARAM *sort_param)
 {
   uint32_t nod_flag,length;
-  my_off_t filepos,key_file_length;
+  my_off_t filepos;
   SORT_KEY_BLOCKS *key_block;
   SORT_INFO *sort_info= sort_param->sort_info;
-  myf myf_rw=sort_info->param->myf_rw;
   MI_INFO *info=sort_info->info;
   MI_KEYDEF *keyinfo=sort_param->keyinfo;
 
@@ -3026,20 +3769,9 @@ int flush_pending_blocks(MI_SORT_PARAM *sort_param)
     length=mi_getint(key_block->buff);
     if (nod_flag)
       _mi_kpointer(info,key_block->end_pos,filepos);
-    key_file_length=info->state->key_file_length;
     memset(key_block->buff+length, 0, keyinfo->block_length-length);
-    if ((filepos=_mi_new(info,keyinfo,DFLT_INIT_HITS)) == HA_OFFSET_ERROR)
-      return(1);
-
-    /* If we read the page from the key cache, we have to write it back */
-    if (key_file_length == info->state->key_file_length)
-    {
-      if (_mi_write_keypage(info, keyinfo, filepos,
-                            DFLT_INIT_HITS, key_block->buff))
-	return(1);
-    }
-    else if (my_pwrite(info->s->kfile,(unsigned char*) key_block->buff,
-		       (uint) keyinfo->block_length,filepos, myf_rw))
+    if ((filepos=sort_write_key_block(sort_param,key_block->buff)) ==
+        HA_OFFSET_ERROR)
       return(1);
     nod_flag=1;
   }
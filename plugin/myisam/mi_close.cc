@@ -71,9 +71,13 @@ int mi_close(MI_INFO *info)
       */
       if (share->mode != O_RDONLY && mi_is_crashed(info))
 	mi_state_info_write(share->kfile, &share->state, 1);
+      if (mi_flush_key_blocks(share->kfile, FLUSH_RELEASE))
+        error= errno;
       if (internal::my_close(share->kfile,MYF(0)))
         error = errno;
     }
+    if (share->file_map)
+      mi_munmap_file(info);
     if (share->decode_trees)
     {
       free((unsigned char*) share->decode_trees);
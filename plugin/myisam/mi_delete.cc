@@ -53,6 +53,10 @@ int mi_delete(MI_INFO *info,const unsigned char *record)
   {
     return(errno=EACCES);
   }
+  if (share->options & HA_OPTION_COMPRESS_RECORD)
+  {
+    return(errno=HA_ERR_TABLE_READONLY);
+  }
   if (_mi_readinfo(info,F_WRLCK,1))
     return(errno);
   if (info->s->calc_checksum)
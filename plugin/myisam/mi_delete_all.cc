@@ -28,6 +28,10 @@ int mi_delete_all_rows(MI_INFO *info)
   {
     return(errno=EACCES);
   }
+  if (share->options & HA_OPTION_COMPRESS_RECORD)
+  {
+    return(errno=drizzled::HA_ERR_TABLE_READONLY);
+  }
   if (_mi_readinfo(info,F_WRLCK,1))
     return(errno);
   if (_mi_mark_file_changed(info))
@@ -50,6 +54,8 @@ int mi_delete_all_rows(MI_INFO *info)
     If we are using delayed keys or if the user has done changes to the tables
     since it was locked then there may be key blocks in the key cache
   */
+  mi_flush_key_blocks(share->kfile, FLUSH_IGNORE_CHANGED);
+  mi_munmap_file(info);
   if (ftruncate(info->dfile, 0) || ftruncate(share->kfile, share->base.keystart))
     goto err;
   _mi_writeinfo(info,WRITEINFO_UPDATE_KEYFILE);
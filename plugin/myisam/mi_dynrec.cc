@@ -53,6 +53,8 @@ static int delete_dynamic_record(MI_INFO *info,internal::my_off_t filepos,
 				 uint32_t second_read);
 static int _mi_cmp_buffer(int file, const unsigned char *buff, internal::my_off_t filepos,
 			  uint32_t length);
+static uint32_t _mi_read_block_info(MI_INFO *info, MI_BLOCK_INFO *block_info,
+                                    internal::my_off_t filepos);
 
 	/* Interface function from MI_INFO */
 
@@ -115,12 +117,92 @@ bool mi_dynmap_file(MI_INFO *info, internal::my_off_t size)
 
 void mi_remap_file(MI_INFO *info, internal::my_off_t size)
 {
-  if (info->s->file_map)
+  MYISAM_SHARE *share= info->s;
+
+  if (share->file_map)
+  {
+    mi_munmap_file(info);
+    /* A file that has grown past myisam_mmap_size is read with pread() */
+    if (size <= myisam_mmap_size && !mi_dynmap_file(info, size))
+    {
+      share->file_read= mi_mmap_pread;
+      share->file_write= mi_mmap_pwrite;
+      info->opt_flag|= MEMMAP_USED;
+    }
+  }
+}
+
+
+/*
+  Remove the mmaped area of the data file
+
+  SYNOPSIS
+    mi_munmap_file()
+    info		MyISAM handler
+
+  NOTES
+    Must be called before the data file is truncated or replaced, as
+    reading a mapped page past the end of the file is fatal.
+*/
+
+void mi_munmap_file(MI_INFO *info)
+{
+  MYISAM_SHARE *share= info->s;
+
+  if (share->file_map)
   {
-    munmap((char*) info->s->file_map,
-           (size_t) info->s->mmaped_length + MEMMAP_EXTRA_MARGIN);
-    mi_dynmap_file(info, size);
+    munmap((char*) share->file_map,
+           (size_t) share->mmaped_length + MEMMAP_EXTRA_MARGIN);
+    share->file_map= NULL;
   }
+  share->mmaped_length= 0;
+  share->nonmmaped_inserts= 0;
+  share->file_read= mi_nommap_pread;
+  share->file_write= mi_nommap_pwrite;
+  info->opt_flag&= ~MEMMAP_USED;
+}
+
+
+/*
+  Read and write the data file through a mmaped area, if enabled
+
+  SYNOPSIS
+    mi_mmap_data_file()
+    info		MyISAM handler
+
+  DESCRIPTION
+    Does nothing unless myisam_use_mmap is set. The data file is mapped
+    if it is not larger than myisam_mmap_size, and mapped again if it
+    has grown since it was mapped; the rows written after that are
+    read with pread() until then. Called when a scan starts, so that
+    no pointer into the old area is in use.
+*/
+
+void mi_mmap_data_file(MI_INFO *info)
+{
+  MYISAM_SHARE *share= info->s;
+  internal::my_off_t size;
+
+  if (!myisam_use_mmap || share->data_file_type == COMPRESSED_RECORD)
+    return;
+
+  /* Rows may still be in the write cache, and not in the file yet */
+  size= min(share->state.state.data_file_length,
+            (internal::my_off_t) lseek(info->dfile, 0L, SEEK_END));
+  info->rec_cache.seek_not_done=1;
+
+  if (share->file_map)
+  {
+    if (share->mmaped_length != size)
+      mi_remap_file(info, size);
+  }
+  else if (size && size <= myisam_mmap_size && !mi_dynmap_file(info, size))
+  {
+    share->file_read= mi_mmap_pread;
+    share->file_write= mi_mmap_pwrite;
+  }
+  if (share->file_map)
+    info->opt_flag|= MEMMAP_USED;
 }
 
 
@@ -1390,11 +1472,9 @@ int _mi_read_dynamic_record(MI_INFO *info, internal::my_off_t filepos, unsigned
   uint32_t b_type, left_length= 0;
   unsigned char *to= NULL;
   MI_BLOCK_INFO block_info;
-  int file;
 
   if (filepos != HA_OFFSET_ERROR)
   {
-    file=info->dfile;
     block_of_record= 0;   /* First block of record is numbered as zero. */
     block_info.second_read= 0;
     do
@@ -1407,7 +1487,7 @@ int _mi_read_dynamic_record(MI_INFO *info, internal::my_off_t filepos, unsigned
 	  info->rec_cache.flush())
 	goto err;
       info->rec_cache.seek_not_done=1;
-      if ((b_type= _mi_get_block_info(&block_info, file, filepos))
+      if ((b_type= _mi_read_block_info(info, &block_info, filepos))
 	  & (BLOCK_DELETED | BLOCK_ERROR | BLOCK_SYNC_ERROR |
 	     BLOCK_FATAL_ERROR))
       {
@@ -1706,7 +1786,7 @@ int _mi_read_rnd_dynamic_record(MI_INFO *info, unsigned char *buf,
 	  info->rec_cache.flush())
 	return(errno);
       info->rec_cache.seek_not_done=1;
-      b_type=_mi_get_block_info(&block_info,info->dfile,filepos);
+      b_type=_mi_read_block_info(info, &block_info, filepos);
     }
 
     if (b_type & (BLOCK_DELETED | BLOCK_ERROR | BLOCK_SYNC_ERROR |
@@ -1780,8 +1860,8 @@ int _mi_read_rnd_dynamic_record(MI_INFO *info, unsigned char *buf,
             block_info.filepos + block_info.data_len &&
             info->rec_cache.flush())
           goto err;
-	/* lseek(info->dfile,filepos,SEEK_SET); */
-	if (internal::my_read(info->dfile,(unsigned char*) to,block_info.data_len,MYF(MY_NABP)))
+	if (info->s->file_read(info, (unsigned char*) to, block_info.data_len,
+                               filepos, MYF(MY_NABP)))
 	{
 	  if (errno == -1)
 	    errno= HA_ERR_WRONG_IN_RECORD;	/* Unexpected end of file */
@@ -1819,6 +1899,25 @@ err:
 }
 
 
+/*
+  Read the header of a block, from the mmaped area if it covers it
+*/
+
+static uint32_t _mi_read_block_info(MI_INFO *info, MI_BLOCK_INFO *block_info,
+                                    internal::my_off_t filepos)
+{
+  MYISAM_SHARE *share= info->s;
+
+  if (share->mmaped_length >= filepos + sizeof(block_info->header))
+  {
+    memcpy(block_info->header, share->file_map + filepos,
+           sizeof(block_info->header));
+    return _mi_get_block_info(block_info, -1, filepos);
+  }
+  return _mi_get_block_info(block_info, info->dfile, filepos);
+}
+
+
 	/* Read and process header from a dynamic-record-file */
 
 uint32_t _mi_get_block_info(MI_BLOCK_INFO *info, int file, internal::my_off_t filepos)
@@ -72,8 +72,14 @@ int mi_extra(MI_INFO *info, enum ha_extra_function function, void *extra_arg)
       errno=EACCES;
       break;
     }
+    mi_mmap_data_file(info);
     if (info->s->file_map) /* Don't use cache if mmap */
+    {
+#if !defined(TARGET_OS_SOLARIS)
+      madvise((char*) share->file_map, share->mmaped_length, MADV_SEQUENTIAL);
+#endif
       break;
+    }
     if (info->opt_flag & WRITE_CACHE_USED)
     {
       info->opt_flag&= ~WRITE_CACHE_USED;
@@ -86,7 +92,7 @@ int mi_extra(MI_INFO *info, enum ha_extra_function function, void *extra_arg)
       cache_size= (extra_arg ? *(uint32_t*) extra_arg :
 		   internal::my_default_record_cache_size);
       if (!(info->rec_cache.init_io_cache(info->dfile, (uint) min((uint32_t)info->state->data_file_length+1, cache_size),
-                                          internal::READ_CACHE,0L,(bool) (info->lock_type != F_UNLCK),
+                                          internal::READ_CACHE,0L,false,
                                           MYF(share->write_flag & MY_WAIT_IF_FULL))))
       {
 	info->opt_flag|=READ_CACHE_USED;
@@ -120,7 +126,7 @@ int mi_extra(MI_INFO *info, enum ha_extra_function function, void *extra_arg)
     {
       if (not (info->rec_cache.init_io_cache(info->dfile, cache_size,
                                              internal::WRITE_CACHE,info->state->data_file_length,
-                                             (bool) (info->lock_type != F_UNLCK),
+                                             false,
                                              MYF(share->write_flag & MY_WAIT_IF_FULL))))
       {
         info->opt_flag|=WRITE_CACHE_USED;
@@ -244,6 +250,8 @@ int mi_extra(MI_INFO *info, enum ha_extra_function function, void *extra_arg)
   case HA_EXTRA_PREPARE_FOR_DROP:
     THR_LOCK_myisam.lock();
     share->last_version= 0L;			/* Impossible version */
+    /* The index is dropped, its changed pages need not be written */
+    mi_flush_key_blocks(share->kfile, FLUSH_IGNORE_CHANGED);
 #ifdef __WIN__REMOVE_OBSOLETE_WORKAROUND
     /* Close the isam and data files as Win32 can't drop an open table */
     if (info->opt_flag & (READ_CACHE_USED | WRITE_CACHE_USED))
@@ -281,6 +289,8 @@ int mi_extra(MI_INFO *info, enum ha_extra_function function, void *extra_arg)
     THR_LOCK_myisam.unlock();
     break;
   case HA_EXTRA_FLUSH:
+    if (mi_flush_key_blocks(share->kfile, FLUSH_KEEP))
+      error=errno;
 #ifdef HAVE_PWRITE
     _mi_decrement_open_count(info);
 #endif
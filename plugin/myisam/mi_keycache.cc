@@ -0,0 +1,451 @@
+/* Copyright (C) 2011 Drizzle Developer Group
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA */
+
+/*
+  Key cache: index pages of all MyISAM tables, shared by all sessions.
+
+  A page is cached by index file and position. The cache is split into
+  KEY_CACHE_PARTITIONS partitions, each with its own mutex and its share
+  of the size, and a page always goes to the same partition.
+
+  Each partition keeps its pages in two LRU lists. A page read from disk
+  goes to the head of the warm list; only a page that is used again moves
+  to the head of the hot list. Pages are evicted from the tail of the warm
+  list, so a scan that reads many pages once does not push out the pages
+  every lookup goes through. The hot list is not allowed to take more
+  than (100 - KEY_CACHE_DIVISION_LIMIT) percent of the partition; pages
+  falling off its tail go back to the head of the warm list.
+
+  Written pages stay in the cache, marked dirty, until they are evicted or
+  mi_flush_key_blocks() is called for their file.
+*/
+
+#include "myisam_priv.h"
+
+#include <boost/unordered_map.hpp>
+
+#include <list>
+#include <set>
+#include <unistd.h>
+
+using namespace drizzled;
+using namespace std;
+
+namespace
+{
+
+struct KeyCacheBlock
+{
+  int file;
+  internal::my_off_t pos;
+  uint32_t length;
+  bool dirty;
+  bool hot;                                     /* In the hot list */
+  unsigned char *buffer;
+};
+
+typedef list<KeyCacheBlock> KeyCacheList;
+typedef pair<int, internal::my_off_t> KeyCacheKey;
+
+struct KeyCachePartition
+{
+  boost::mutex lock;
+  KeyCacheList hot;                             /* Most recently used first */
+  KeyCacheList warm;
+  boost::unordered_map<KeyCacheKey, KeyCacheList::iterator> blocks;
+  /* Positions of the cached pages of every file, for flushing a file */
+  boost::unordered_map<int, set<internal::my_off_t> > files;
+  size_t limit;                                 /* Bytes this partition may use */
+  size_t size;
+  size_t hot_size;
+  uint64_t blocks_not_flushed;
+  uint64_t read_requests;
+  uint64_t reads;
+  uint64_t write_requests;
+  uint64_t writes;
+
+  KeyCachePartition() :
+    limit(0), size(0), hot_size(0), blocks_not_flushed(0),
+    read_requests(0), reads(0), write_requests(0), writes(0)
+  {}
+};
+
+KeyCachePartition key_cache_partitions[KEY_CACHE_PARTITIONS];
+
+}
+
+static KeyCachePartition &key_cache_partition(int file, internal::my_off_t pos)
+{
+  return key_cache_partitions[(pos / MI_MIN_KEY_BLOCK_LENGTH + (uint64_t) file * 31) %
+                              KEY_CACHE_PARTITIONS];
+}
+
+
+/* Write a dirty page to its file. The partition is locked. */
+
+static int key_cache_write_block(KeyCachePartition &part, KeyCacheBlock &block)
+{
+  if (pwrite(block.file, block.buffer, block.length, block.pos) !=
+      (ssize_t) block.length)
+  {
+    if (!errno)
+      errno= HA_ERR_CRASHED;
+    return 1;
+  }
+  block.dirty= false;
+  part.blocks_not_flushed--;
+  part.writes++;
+  return 0;
+}
+
+
+/* Remove a page from the cache without writing it. The partition is locked. */
+
+static void key_cache_free_block(KeyCachePartition &part,
+                                 KeyCacheList::iterator block)
+{
+  KeyCacheList &list= block->hot ? part.hot : part.warm;
+
+  part.blocks.erase(KeyCacheKey(block->file, block->pos));
+  boost::unordered_map<int, set<internal::my_off_t> >::iterator file=
+    part.files.find(block->file);
+  file->second.erase(block->pos);
+  if (file->second.empty())
+    part.files.erase(file);
+
+  part.size-= block->length;
+  if (block->hot)
+    part.hot_size-= block->length;
+  if (block->dirty)
+    part.blocks_not_flushed--;
+  delete [] block->buffer;
+  list.erase(block);
+}
+
+
+/*
+  Evict pages until one of length bytes fits. The partition is locked.
+
+  RETURN
+    0  ok
+    1  a dirty page could not be written
+*/
+
+static int key_cache_make_room(KeyCachePartition &part, uint32_t length)
+{
+  while (part.size + length > part.limit)
+  {
+    KeyCacheList &list= part.warm.empty() ? part.hot : part.warm;
+    if (list.empty())
+      break;
+    KeyCacheList::iterator block= --list.end();
+
+    if (block->dirty && key_cache_write_block(part, *block))
+      return 1;
+    key_cache_free_block(part, block);
+  }
+  return 0;
+}
+
+
+/* Move a page that was used again to the head of the hot list */
+
+static void key_cache_touch(KeyCachePartition &part,
+                            KeyCacheList::iterator block)
+{
+  if (block->hot)
+    part.hot.splice(part.hot.begin(), part.hot, block);
+  else
+  {
+    part.hot.splice(part.hot.begin(), part.warm, block);
+    block->hot= true;
+    part.hot_size+= block->length;
+  }
+
+  while (part.hot_size > part.limit / 100 * (100 - KEY_CACHE_DIVISION_LIMIT))
+  {
+    KeyCacheList::iterator last= --part.hot.end();
+    last->hot= false;
+    part.hot_size-= last->length;
+    part.warm.splice(part.warm.begin(), part.hot, last);
+  }
+}
+
+
+/* Add a page at the head of the warm list. The partition is locked. */
+
+static KeyCacheList::iterator key_cache_add_block(KeyCachePartition &part,
+                                                  int file,
+                                                  internal::my_off_t pos,
+                                                  uint32_t length)
+{
+  KeyCacheBlock block;
+
+  block.file= file;
+  block.pos= pos;
+  block.length= length;
+  block.dirty= false;
+  block.hot= false;
+  block.buffer= new unsigned char[length];
+
+  part.warm.push_front(block);
+  part.blocks[KeyCacheKey(file, pos)]= part.warm.begin();
+  part.files[file].insert(pos);
+  part.size+= length;
+  return part.warm.begin();
+}
+
+
+/*
+  Find a page in the cache
+
+  A cached page of another length than the one asked for is written if
+  dirty and dropped, so that the caller reads the file.
+*/
+
+static KeyCacheList::iterator key_cache_find(KeyCachePartition &part,
+                                             int file, internal::my_off_t pos,
+                                             uint32_t length, bool *found,
+                                             int *error)
+{
+  boost::unordered_map<KeyCacheKey, KeyCacheList::iterator>::iterator it=
+    part.blocks.find(KeyCacheKey(file, pos));
+
+  *found= false;
+  *error= 0;
+  if (it == part.blocks.end())
+    return KeyCacheList::iterator();
+
+  KeyCacheList::iterator block= it->second;
+  if (block->length == length)
+  {
+    *found= true;
+    return block;
+  }
+  if (block->dirty && (*error= key_cache_write_block(part, *block)))
+    return KeyCacheList::iterator();
+  key_cache_free_block(part, block);
+  return KeyCacheList::iterator();
+}
+
+
+void mi_key_cache_init(size_t size)
+{
+  for (uint32_t i= 0; i < KEY_CACHE_PARTITIONS; i++)
+  {
+    KeyCachePartition &part= key_cache_partitions[i];
+    boost::mutex::scoped_lock scopedLock(part.lock);
+    part.limit= size / KEY_CACHE_PARTITIONS;
+  }
+}
+
+
+void mi_key_cache_end()
+{
+  for (uint32_t i= 0; i < KEY_CACHE_PARTITIONS; i++)
+  {
+    KeyCachePartition &part= key_cache_partitions[i];
+    boost::mutex::scoped_lock scopedLock(part.lock);
+
+    while (!part.warm.empty())
+      key_cache_free_block(part, part.warm.begin());
+    while (!part.hot.empty())
+      key_cache_free_block(part, part.hot.begin());
+    part.limit= 0;
+  }
+}
+
+
+/*
+  Read a page through the key cache
+
+  RETURN
+    0  ok
+    1  error; errno is set
+*/
+
+int mi_key_cache_read(int file, internal::my_off_t pos, unsigned char *buff,
+                      uint32_t length)
+{
+  KeyCachePartition &part= key_cache_partition(file, pos);
+  boost::mutex::scoped_lock scopedLock(part.lock);
+  KeyCacheList::iterator block;
+  bool found;
+  int error;
+
+  part.read_requests++;
+  block= key_cache_find(part, file, pos, length, &found, &error);
+  if (error)
+    return 1;
+  if (found)
+  {
+    key_cache_touch(part, block);
+    memcpy(buff, block->buffer, length);
+    return 0;
+  }
+
+  part.reads++;
+  if (length > part.limit)
+  {
+    scopedLock.unlock();
+    return pread(file, buff, length, pos) <= 0;
+  }
+
+  if (key_cache_make_room(part, length))
+    return 1;
+  block= key_cache_add_block(part, file, pos, length);
+  if (pread(file, block->buffer, length, pos) <= 0)
+  {
+    key_cache_free_block(part, block);
+    return 1;
+  }
+  memcpy(buff, block->buffer, length);
+  return 0;
+}
+
+
+/*
+  Write a page through the key cache
+
+  DESCRIPTION
+    The page is only written to the file when it is evicted or flushed.
+
+  RETURN
+    0  ok
+    1  error; errno is set
+*/
+
+int mi_key_cache_write(int file, internal::my_off_t pos,
+                       const unsigned char *buff, uint32_t length)
+{
+  KeyCachePartition &part= key_cache_partition(file, pos);
+  boost::mutex::scoped_lock scopedLock(part.lock);
+  KeyCacheList::iterator block;
+  bool found;
+  int error;
+
+  part.write_requests++;
+  block= key_cache_find(part, file, pos, length, &found, &error);
+  if (error)
+    return 1;
+  if (found)
+    key_cache_touch(part, block);
+  else
+  {
+    if (length > part.limit)
+    {
+      part.writes++;
+      scopedLock.unlock();
+      return pwrite(file, buff, length, pos) != (ssize_t) length;
+    }
+    if (key_cache_make_room(part, length))
+      return 1;
+    block= key_cache_add_block(part, file, pos, length);
+  }
+
+  memcpy(block->buffer, buff, length);
+  if (!block->dirty)
+  {
+    block->dirty= true;
+    part.blocks_not_flushed++;
+  }
+  return 0;
+}
+
+
+/* Drop a page from the cache without writing it, if it is cached */
+
+void mi_key_cache_discard(int file, internal::my_off_t pos)
+{
+  KeyCachePartition &part= key_cache_partition(file, pos);
+  boost::mutex::scoped_lock scopedLock(part.lock);
+  boost::unordered_map<KeyCacheKey, KeyCacheList::iterator>::iterator it=
+    part.blocks.find(KeyCacheKey(file, pos));
+
+  if (it != part.blocks.end())
+    key_cache_free_block(part, it->second);
+}
+
+
+/*
+  Write and/or drop the cached pages of a file
+
+  SYNOPSIS
+    mi_flush_key_blocks()
+    file      Index file
+    type      FLUSH_KEEP            write dirty pages, keep all pages
+              FLUSH_RELEASE         write dirty pages, drop all pages
+              FLUSH_IGNORE_CHANGED  drop all pages without writing them
+
+  NOTES
+    Must be called with FLUSH_RELEASE or FLUSH_IGNORE_CHANGED before the
+    file is closed or truncated; pages are found by file descriptor, and a
+    file opened later may get the same one.
+
+  RETURN
+    0  ok
+    1  a dirty page could not be written; errno is set
+*/
+
+int mi_flush_key_blocks(int file, enum flush_type type)
+{
+  int error= 0;
+
+  for (uint32_t i= 0; i < KEY_CACHE_PARTITIONS; i++)
+  {
+    KeyCachePartition &part= key_cache_partitions[i];
+    boost::mutex::scoped_lock scopedLock(part.lock);
+
+    boost::unordered_map<int, set<internal::my_off_t> >::iterator it=
+      part.files.find(file);
+    if (it == part.files.end())
+      continue;
+
+    /* A copy, as freeing the pages erases them from the set */
+    set<internal::my_off_t> positions(it->second);
+
+    /* In file order, so that writing is mostly sequential */
+    for (set<internal::my_off_t>::iterator pos= positions.begin();
+         pos != positions.end(); ++pos)
+    {
+      KeyCacheList::iterator block= part.blocks[KeyCacheKey(file, *pos)];
+
+      if (block->dirty && type != FLUSH_IGNORE_CHANGED &&
+          key_cache_write_block(part, *block))
+        error= 1;
+      if (type != FLUSH_KEEP)
+        key_cache_free_block(part, block);
+    }
+  }
+  return error;
+}
+
+
+void mi_key_cache_status(MI_KEY_CACHE_STATUS *status)
+{
+  memset(status, 0, sizeof(*status));
+  for (uint32_t i= 0; i < KEY_CACHE_PARTITIONS; i++)
+  {
+    KeyCachePartition &part= key_cache_partitions[i];
+    boost::mutex::scoped_lock scopedLock(part.lock);
+
+    status->blocks_used+= part.blocks.size();
+    status->blocks_not_flushed+= part.blocks_not_flushed;
+    status->read_requests+= part.read_requests;
+    status->reads+= part.reads;
+    status->write_requests+= part.write_requests;
+    status->writes+= part.writes;
+  }
+}
@@ -396,7 +396,14 @@ MI_INFO *mi_open(const drizzled::identifier::Table &identifier, int mode, uint32
 					 share->blocksize * keys : 0));
     share->blocksize=min((uint32_t)IO_SIZE,myisam_block_size);
     share->data_file_type=STATIC_RECORD;
-    if (share->options & HA_OPTION_PACK_RECORD)
+    if (share->options & HA_OPTION_COMPRESS_RECORD)
+    {
+      share->data_file_type = COMPRESSED_RECORD;
+      info.s=share;
+      if (_mi_read_pack_info(&info))
+        goto err;
+    }
+    else if (share->options & HA_OPTION_PACK_RECORD)
       share->data_file_type = DYNAMIC_RECORD;
     free(disk_cache);
     disk_cache= NULL;
@@ -454,6 +461,8 @@ MI_INFO *mi_open(const drizzled::identifier::Table &identifier, int mode, uint32
   info.lastpos= HA_OFFSET_ERROR;
   info.update= (short) (HA_STATE_NEXT_FOUND+HA_STATE_PREV_FOUND);
   info.opt_flag=READ_CHECK_USED;
+  if (share->file_map)
+    info.opt_flag|= MEMMAP_USED;
   info.this_unique= (ulong) info.dfile; /* Uniq number in process */
   if (share->data_file_type == COMPRESSED_RECORD)
     info.this_unique= share->state.unique;
@@ -527,6 +536,8 @@ err:
       break;					/* Don't remove open table */
     /* fall through */
   case 4:
+    free((unsigned char*) share->decode_trees);
+    free((unsigned char*) share->decode_tables);
     free((unsigned char*) share);
     /* fall through */
   case 3:
@@ -628,6 +639,11 @@ void mi_setup_functions(register MYISAM_SHARE *share)
     share->compare_unique=_mi_cmp_static_unique;
     share->calc_checksum= mi_static_checksum;
   }
+  if (share->options & HA_OPTION_COMPRESS_RECORD)
+  {
+    share->read_record=_mi_read_pack_record;
+    share->read_rnd=_mi_read_rnd_pack_record;
+  }
   share->file_read= mi_nommap_pread;
   share->file_write= mi_nommap_pwrite;
   share->calc_checksum=0;
@@ -0,0 +1,583 @@
+/* Copyright (C) 2011 Drizzle Developer Group
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA */
+
+/*
+  Compress the data file of a table
+
+  The rows are read twice. The first time the values and the bytes of
+  each column are counted, the second time the rows are written to a
+  new data file with the codes made from the counts. A column is coded
+  by its values if there are few of them and that is shorter, and else
+  by its bytes. See mi_packrec.cc for the format of the file.
+
+  The new file replaces the data file, and the table can then only be
+  read. The rows have moved, so all keys are disabled; the caller
+  creates them again from the new file.
+*/
+
+#include "myisam_priv.h"
+#include <drizzled/internal/m_string.h>
+
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <queue>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace drizzled;
+using namespace drizzled::internal;
+
+#define MI_PACK_MAX_VALUES	4096	/* Distinct values coded per column */
+#define MI_PACK_MAX_VALUE_BYTES	(1024L*1024L)	/* Of those in the header */
+
+typedef struct st_mi_pack_column
+{
+  uint64_t byte_count[256];
+  map<string, uint64_t> values;		/* Count, then symbol */
+  uint64_t value_bytes;
+  uint64_t not_null;
+  uint32_t max_length;
+  bool skip_null;
+  bool count_values;
+  uint32_t pack_type, length_bits, symbols;
+  vector<unsigned char> code_length;	/* Length of the codes plus one */
+  vector<uint32_t> code;
+} MI_PACK_COLUMN;
+
+/* Collects the codes of a record, first bit first */
+
+class BitWriter
+{
+public:
+  vector<unsigned char> buff;
+
+  BitWriter() : bits(0), current(0) {}
+
+  void clear()
+  {
+    buff.clear();
+    bits= 0;
+  }
+
+  void put(uint32_t value, uint32_t count)
+  {
+    if (!count)
+      return;
+    current= (current << count) | value;
+    for (bits+= count; bits >= 8; )
+    {
+      bits-= 8;
+      buff.push_back((unsigned char) (current >> bits));
+    }
+  }
+
+  void flush()
+  {
+    if (bits)
+      buff.push_back((unsigned char) (current << (8 - bits)));
+    bits= 0;
+  }
+
+private:
+  uint32_t bits;
+  uint64_t current;
+};
+
+static uint32_t column_value(MI_COLUMNDEF *rec, const unsigned char *record,
+                             const unsigned char **pos);
+static void make_code_lengths(const vector<uint64_t> &count,
+                              unsigned char *code_length);
+static uint64_t code_bits(const vector<uint64_t> &count,
+                          const unsigned char *code_length);
+static void choose_coding(MI_COLUMNDEF *rec, MI_PACK_COLUMN *column);
+static void pack_record(MI_INFO *info, MI_PACK_COLUMN *columns,
+                        const unsigned char *record, BitWriter *bits,
+                        ulong *blob_length);
+
+
+/*
+  Compress the data file of a table
+
+  SYNOPSIS
+    mi_pack_records()
+    param               Check parameters, for the name of the new file
+    info                MyISAM handler, with the table locked
+    name                Name of the table, for messages
+
+  DESCRIPTION
+    On success the table reads the new file, all its keys are disabled,
+    and HA_OPTION_COMPRESS_RECORD is set so that it can't be changed.
+
+  RETURN
+    0  ok
+    #  error, the table is unchanged
+*/
+
+int mi_pack_records(MI_CHECK *param, MI_INFO *info, const char *name)
+{
+  MYISAM_SHARE *share= info->s;
+  uint32_t fields= share->base.fields;
+  vector<MI_PACK_COLUMN> columns(fields);
+  vector<unsigned char> record(share->base.reclength), header;
+  MI_COLUMNDEF *rec;
+  BitWriter bits;
+  io_cache_st cache;
+  unsigned char length_buff[8];
+  char llbuff[22];
+  ulong min_pack_length= ~0UL, max_pack_length= 0, max_blob_length= 0;
+  my_off_t filepos;
+  ha_checksum checksum= 0;
+  uint32_t i, ref_length;
+  int new_file= -1;
+  int error;
+
+  for (i= 0, rec= share->rec ; i < fields ; i++, rec++)
+  {
+    MI_PACK_COLUMN *column= &columns[i];
+    memset(column->byte_count, 0, sizeof(column->byte_count));
+    column->value_bytes= column->not_null= 0;
+    column->max_length= 0;
+    /* The null bit must be unpacked before the column */
+    column->skip_null= rec->null_bit && rec->null_pos < rec->offset;
+    column->count_values= true;
+  }
+
+  /* Count the values and the bytes of each column */
+  (void) mi_extra(info, HA_EXTRA_CACHE, 0);
+  if ((error= mi_scan_init(info)))
+    goto err;
+  while (!(error= mi_scan(info, &record[0])) ||
+         error == HA_ERR_RECORD_DELETED)
+  {
+    if (error)
+      continue;
+    for (i= 0, rec= share->rec ; i < fields ; i++, rec++)
+    {
+      MI_PACK_COLUMN *column= &columns[i];
+      const unsigned char *pos;
+      uint32_t length;
+
+      if (column->skip_null && record[rec->null_pos] & rec->null_bit)
+        continue;
+      length= column_value(rec, &record[0], &pos);
+      column->not_null++;
+      column->max_length= max(column->max_length, length);
+      for (uint32_t j= 0 ; j < length ; j++)
+        column->byte_count[pos[j]]++;
+      if (column->count_values)
+      {
+        map<string, uint64_t>::iterator it;
+        it= column->values.insert(make_pair(string((const char*) pos, length),
+                                            (uint64_t) 0)).first;
+        if (!it->second++)
+          column->value_bytes+= length;
+        if (column->values.size() > MI_PACK_MAX_VALUES ||
+            column->value_bytes > MI_PACK_MAX_VALUE_BYTES)
+        {
+          column->values.clear();
+          column->count_values= false;
+        }
+      }
+    }
+  }
+  if (error != HA_ERR_END_OF_FILE)
+    goto err;
+
+  /* The header, up to the lengths that are known after the rows */
+  header.resize(MI_PACK_HEADER_LENGTH + fields * MI_PACK_COLUMN_LENGTH);
+  for (i= 0, rec= share->rec ; i < fields ; i++, rec++)
+  {
+    MI_PACK_COLUMN *column= &columns[i];
+    unsigned char *pos= &header[MI_PACK_HEADER_LENGTH +
+                                i * MI_PACK_COLUMN_LENGTH];
+
+    choose_coding(rec, column);
+    pos[0]= (unsigned char) column->pack_type;
+    pos[1]= (unsigned char) column->length_bits;
+    mi_int4store(pos + 2, column->symbols);
+    header.insert(header.end(), column->code_length.begin(),
+                  column->code_length.end());
+    if (column->pack_type & PACK_TYPE_VALUES)
+    {
+      map<string, uint64_t>::iterator it;
+      for (it= column->values.begin() ; it != column->values.end() ; ++it)
+      {
+        unsigned char buff[4];
+        mi_int4store(buff, it->first.length());
+        header.insert(header.end(), buff, buff + 4);
+      }
+      for (it= column->values.begin() ; it != column->values.end() ; ++it)
+        header.insert(header.end(), it->first.begin(), it->first.end());
+    }
+  }
+
+  if ((new_file= my_create(fn_format(param->temp_filename,
+                                     share->data_file_name, "",
+                                     DATA_TMP_EXT, 2+4),
+                           0, param->tmpfile_createflag, MYF(0))) < 0)
+  {
+    mi_check_print_error(param, "Can't create new tempfile: '%s'",
+                         param->temp_filename);
+    error= errno;
+    goto err;
+  }
+  if (cache.init_io_cache(new_file, param->write_buffer_length, WRITE_CACHE,
+                          header.size(), 0, MYF(MY_WME | MY_WAIT_IF_FULL)))
+  {
+    error= errno;
+    goto err;
+  }
+
+  /* Write the rows */
+  filepos= header.size();
+  (void) mi_extra(info, HA_EXTRA_NO_CACHE, 0);
+  (void) mi_extra(info, HA_EXTRA_CACHE, 0);
+  if ((error= mi_scan_init(info)))
+    goto err_cache;
+  while (!(error= mi_scan(info, &record[0])) ||
+         error == HA_ERR_RECORD_DELETED)
+  {
+    ulong blob_length= 0;
+    uint32_t length;
+
+    if (error)
+      continue;
+    pack_record(info, &columns[0], &record[0], &bits, &blob_length);
+    if (bits.buff.size() > (size_t) MI_PACK_MAX_LENGTH ||
+        blob_length > (ulong) MI_PACK_MAX_LENGTH)
+    {
+      mi_check_print_error(param, "Found too long record at %s",
+                           llstr(info->lastpos, llbuff));
+      error= HA_ERR_TO_BIG_ROW;
+      goto err_cache;
+    }
+    min_pack_length= min(min_pack_length, (ulong) bits.buff.size());
+    max_pack_length= max(max_pack_length, (ulong) bits.buff.size());
+    max_blob_length= max(max_blob_length, blob_length);
+    length= _mi_store_pack_length(length_buff, bits.buff.size());
+    if (share->base.blobs)
+      length+= _mi_store_pack_length(length_buff + length, blob_length);
+    if (cache.write(length_buff, length) ||
+        (bits.buff.size() && cache.write(&bits.buff[0], bits.buff.size())))
+    {
+      error= errno;
+      goto err_cache;
+    }
+    filepos+= length + bits.buff.size();
+
+    /* Columns that are NULL are read back as zeros */
+    for (i= 0, rec= share->rec ; i < fields ; i++, rec++)
+      if (columns[i].skip_null && record[rec->null_pos] & rec->null_bit)
+        memset(&record[rec->offset], 0, rec->length);
+    checksum+= mi_checksum(info, &record[0]);
+  }
+  if (error != HA_ERR_END_OF_FILE)
+    goto err_cache;
+  (void) mi_extra(info, HA_EXTRA_NO_CACHE, 0);
+
+  if (filepos > (my_off_t) (((uint64_t) 1 << (share->base.rec_reflength*8))-1))
+  {
+    error= HA_ERR_RECORD_FILE_FULL;
+    goto err_cache;
+  }
+  if (min_pack_length > max_pack_length)
+    min_pack_length= 0;				/* No rows */
+  ref_length= _mi_store_pack_length(length_buff, max_pack_length);
+  if (share->base.blobs)
+    ref_length+= _mi_store_pack_length(length_buff, max_blob_length);
+
+  /* The reads of the lengths of the last row may go into these */
+  memset(length_buff, 0, sizeof(length_buff));
+  if (cache.write(length_buff, MEMMAP_EXTRA_MARGIN) || cache.end_io_cache())
+  {
+    error= errno;
+    goto err_cache;
+  }
+  memcpy(&header[0], myisam_pack_file_magic, 4);
+  mi_int4store(&header[4], header.size());
+  mi_int4store(&header[8], min_pack_length);
+  mi_int4store(&header[12], max_pack_length);
+  mi_int2store(&header[16], fields);
+  header[18]= (unsigned char) ref_length;
+  header[19]= MI_PACK_VERSION;
+  if (my_pwrite(new_file, &header[0], header.size(), 0L,
+                MYF(MY_NABP | MY_WME)))
+  {
+    error= errno;
+    goto err;
+  }
+
+  /* Read the new file from now on */
+  mi_munmap_file(info);
+  my_close(new_file, MYF(0));
+  new_file= -1;
+  my_close(info->dfile, MYF(0));
+  info->dfile= -1;
+  if (change_to_newfile(share->data_file_name, MI_NAME_DEXT, DATA_TMP_EXT,
+                        share->base.raid_chunks, MYF(0)) ||
+      mi_open_datafile(info, share, -1))
+  {
+    mi_check_print_error(param, "%d when replacing the data file of '%s'",
+                         errno, name);
+    return errno ? errno : HA_ERR_CRASHED;
+  }
+  share->options|= HA_OPTION_COMPRESS_RECORD;
+  mi_int2store(share->state.header.options, share->options);
+  share->data_file_type= COMPRESSED_RECORD;
+  if (_mi_read_pack_info(info))
+  {
+    error= errno;
+    mi_check_print_error(param, "%d when reading the compressed '%s'",
+                         error, name);
+    return error;
+  }
+  mi_setup_functions(share);
+  info->read_record= share->read_record;
+  if (!mi_alloc_rec_buff(info, SIZE_MAX, &info->rec_buff))
+    return errno= HA_ERR_OUT_OF_MEM;
+
+  info->state->data_file_length= filepos;
+  info->state->del= 0;
+  info->state->empty= 0;
+  info->state->checksum= checksum;
+  share->state.dellink= HA_OFFSET_ERROR;
+  share->state.split= info->state->records;
+  share->base.max_data_file_length=
+    (my_off_t) (((uint64_t) 1 << (share->base.rec_reflength*8))-1);
+  if (info->state != &share->state.state)
+    share->state.state= *info->state;
+  /* The keys point to where the rows were */
+  mi_clear_all_keys_active(share->state.key_map);
+  share->state.changed|= STATE_CHANGED;
+  info->update|= HA_STATE_CHANGED | HA_STATE_ROW_CHANGED;
+  info->lastpos= HA_OFFSET_ERROR;
+  return 0;
+
+err_cache:
+  (void) cache.end_io_cache();
+err:
+  (void) mi_extra(info, HA_EXTRA_NO_CACHE, 0);
+  if (new_file >= 0)
+  {
+    my_close(new_file, MYF(0));
+    my_delete(param->temp_filename, MYF(MY_WME));
+  }
+  if (!error)
+    error= HA_ERR_CRASHED;
+  mi_check_print_error(param, "%d when compressing '%s'", error, name);
+  return errno= error;
+}
+
+
+/* The bytes of a column that are coded */
+
+static uint32_t column_value(MI_COLUMNDEF *rec, const unsigned char *record,
+                             const unsigned char **pos)
+{
+  const unsigned char *field= record + rec->offset;
+
+  if (rec->type == FIELD_BLOB)
+  {
+    uint32_t pack_length= rec->length - portable_sizeof_char_ptr;
+    uint32_t length= _mi_calc_blob_length(pack_length, field);
+    memcpy(pos, field + pack_length, sizeof(char*));
+    if (!length)
+      *pos= field;
+    return length;
+  }
+  if (rec->type == FIELD_VARCHAR)
+  {
+    uint32_t pack_length= ha_varchar_packlength(rec->length - 1);
+    *pos= field + pack_length;
+    return pack_length == 1 ? (uint32_t) *field : uint2korr(field);
+  }
+  *pos= field;
+  return rec->length;
+}
+
+
+/*
+  Find the length of the Huffman code of each symbol
+
+  SYNOPSIS
+    make_code_lengths()
+    count               How often each symbol is used
+    code_length         Store the length of each code plus one here, 0
+                        for symbols not used
+
+  DESCRIPTION
+    A symbol used alone has a code of no bits. If a code would be
+    longer than MI_PACK_MAX_CODE_BITS, the counts are made more even
+    and the codes made again.
+*/
+
+static void make_code_lengths(const vector<uint64_t> &count,
+                              unsigned char *code_length)
+{
+  typedef pair<uint64_t, uint32_t> node;
+  vector<uint64_t> weight(count);
+  vector<uint32_t> used;
+
+  memset(code_length, 0, count.size());
+  for (uint32_t symbol= 0 ; symbol < count.size() ; symbol++)
+    if (count[symbol])
+      used.push_back(symbol);
+  if (used.size() <= 1)
+  {
+    code_length[used.empty() ? 0 : used[0]]= 1;
+    return;
+  }
+
+  for (;;)
+  {
+    priority_queue<node, vector<node>, greater<node> > queue;
+    vector<uint32_t> parent(2 * used.size() - 1), depth(2 * used.size() - 1);
+    uint32_t nodes= used.size(), max_depth= 0, i;
+
+    for (i= 0 ; i < used.size() ; i++)
+      queue.push(node(weight[used[i]], i));
+    while (queue.size() > 1)
+    {
+      node first= queue.top();
+      queue.pop();
+      node second= queue.top();
+      queue.pop();
+      parent[first.second]= parent[second.second]= nodes;
+      queue.push(node(first.first + second.first, nodes++));
+    }
+    /* A node is numbered after its children; the last is the root */
+    depth[nodes - 1]= 0;
+    for (i= nodes - 1 ; i-- > 0 ; )
+      depth[i]= depth[parent[i]] + 1;
+    for (i= 0 ; i < used.size() ; i++)
+      max_depth= max(max_depth, depth[i]);
+    if (max_depth <= MI_PACK_MAX_CODE_BITS)
+    {
+      for (i= 0 ; i < used.size() ; i++)
+        code_length[used[i]]= (unsigned char) (depth[i] + 1);
+      return;
+    }
+    for (i= 0 ; i < used.size() ; i++)
+      weight[used[i]]= (weight[used[i]] >> 1) | 1;
+  }
+}
+
+
+static uint64_t code_bits(const vector<uint64_t> &count,
+                          const unsigned char *code_length)
+{
+  uint64_t bits= 0;
+  for (uint32_t symbol= 0 ; symbol < count.size() ; symbol++)
+    if (code_length[symbol])
+      bits+= count[symbol] * (code_length[symbol] - 1);
+  return bits;
+}
+
+
+/*
+  Code a column by its values or by its bytes, whichever is shorter
+  with the header, and make its codes
+*/
+
+static void choose_coding(MI_COLUMNDEF *rec, MI_PACK_COLUMN *column)
+{
+  vector<uint64_t> byte_count(column->byte_count, column->byte_count + 256);
+  unsigned char byte_length[256];
+  uint64_t byte_bits;
+  bool var_length= rec->type == FIELD_BLOB || rec->type == FIELD_VARCHAR;
+
+  column->length_bits= 0;
+  if (var_length)
+    while (column->length_bits < 32 &&
+           column->max_length >> column->length_bits)
+      column->length_bits++;
+  make_code_lengths(byte_count, byte_length);
+  byte_bits= code_bits(byte_count, byte_length) + 256 * 8 +
+    (var_length ? column->not_null * column->length_bits : 0);
+
+  column->pack_type= column->skip_null ? PACK_TYPE_SKIP_NULL : 0;
+  if (column->count_values && !column->values.empty())
+  {
+    vector<uint64_t> value_count;
+    map<string, uint64_t>::iterator it;
+    uint64_t value_bits;
+
+    for (it= column->values.begin() ; it != column->values.end() ; ++it)
+      value_count.push_back(it->second);
+    column->code_length.resize(value_count.size());
+    make_code_lengths(value_count, &column->code_length[0]);
+    value_bits= code_bits(value_count, &column->code_length[0]) +
+      value_count.size() * (8 + 32) + column->value_bytes * 8;
+    if (value_bits <= byte_bits)
+    {
+      uint64_t symbol= 0;
+      for (it= column->values.begin() ; it != column->values.end() ; ++it)
+        it->second= symbol++;
+      column->pack_type|= PACK_TYPE_VALUES;
+      column->length_bits= 0;
+    }
+  }
+  if (!(column->pack_type & PACK_TYPE_VALUES))
+  {
+    column->pack_type|= PACK_TYPE_BYTES;
+    column->code_length.assign(byte_length, byte_length + 256);
+    column->values.clear();
+  }
+  column->symbols= column->code_length.size();
+  column->code.resize(column->symbols);
+  _mi_make_pack_codes(&column->code_length[0], column->symbols,
+                      &column->code[0]);
+}
+
+
+/* Code the columns of a record */
+
+static void pack_record(MI_INFO *info, MI_PACK_COLUMN *columns,
+                        const unsigned char *record, BitWriter *bits,
+                        ulong *blob_length)
+{
+  MYISAM_SHARE *share= info->s;
+  MI_COLUMNDEF *rec, *end;
+  MI_PACK_COLUMN *column;
+
+  bits->clear();
+  for (rec= share->rec, end= rec + share->base.fields, column= columns ;
+       rec < end ; rec++, column++)
+  {
+    const unsigned char *pos;
+    uint32_t length;
+
+    if (column->skip_null && record[rec->null_pos] & rec->null_bit)
+      continue;
+    length= column_value(rec, record, &pos);
+    if (column->pack_type & PACK_TYPE_VALUES)
+    {
+      uint32_t symbol= (uint32_t)
+        column->values.find(string((const char*) pos, length))->second;
+      bits->put(column->code[symbol], column->code_length[symbol] - 1);
+      continue;
+    }
+    if (rec->type == FIELD_BLOB || rec->type == FIELD_VARCHAR)
+      bits->put(length, column->length_bits);
+    for (uint32_t i= 0 ; i < length ; i++)
+      bits->put(column->code[pos[i]], column->code_length[pos[i]] - 1);
+    if (rec->type == FIELD_BLOB)
+      *blob_length+= length;
+  }
+  bits->flush();
+}
@@ -0,0 +1,775 @@
+/* Copyright (C) 2011 Drizzle Developer Group
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA */
+
+/*
+  Functions to read compressed records
+
+  A compressed data file is written by mi_pack_records(). Each column
+  has a canonical Huffman code, either of its whole values, which are
+  then kept in the file header, or of the single bytes of its values.
+  A record is its length in bytes, the length of its blobs if the table
+  has any, and then the codes of its columns. Nothing is stored for a
+  column that is NULL.
+
+  The header of the file:
+    0   myisam_pack_file_magic
+    4   length of the header
+    8   length of the shortest record
+   12   length of the longest record
+   16   number of columns
+   18   bytes before a record holding its lengths
+   19   MI_PACK_VERSION
+   20   unused
+  Then MI_PACK_COLUMN_LENGTH bytes for each column:
+    0   pack_type
+    1   bits used for the length of a VARCHAR or BLOB coded by bytes
+    2   number of symbols
+  Then for each column the length of each code plus one, 0 for symbols
+  without a code, and if the values are coded the length of each value
+  followed by the values.
+*/
+
+#include "myisam_priv.h"
+
+#include <cstring>
+#include <algorithm>
+
+using namespace drizzled;
+using namespace std;
+
+static void unpack_values_fixed(MI_COLUMNDEF *rec, MI_BIT_BUFF *bit_buff,
+                                unsigned char *to, unsigned char *end);
+static void unpack_values_varchar(MI_COLUMNDEF *rec, MI_BIT_BUFF *bit_buff,
+                                  unsigned char *to, unsigned char *end);
+static void unpack_values_blob(MI_COLUMNDEF *rec, MI_BIT_BUFF *bit_buff,
+                               unsigned char *to, unsigned char *end);
+static void unpack_bytes_fixed(MI_COLUMNDEF *rec, MI_BIT_BUFF *bit_buff,
+                               unsigned char *to, unsigned char *end);
+static void unpack_bytes_varchar(MI_COLUMNDEF *rec, MI_BIT_BUFF *bit_buff,
+                                 unsigned char *to, unsigned char *end);
+static void unpack_bytes_blob(MI_COLUMNDEF *rec, MI_BIT_BUFF *bit_buff,
+                              unsigned char *to, unsigned char *end);
+static uint32_t decode_table_length(const unsigned char *code_length,
+                                    uint32_t symbols, uint32_t *max_code_bits);
+static void make_decode_tree(MI_DECODE_TREE *tree,
+                             const unsigned char *code_length,
+                             uint32_t symbols, uint32_t *table);
+static uint32_t read_pack_length(const unsigned char *pos, ulong *length);
+
+
+/*
+  Read the header of a compressed data file
+
+  SYNOPSIS
+    _mi_read_pack_info()
+    info                MyISAM handler, with the data file open
+
+  DESCRIPTION
+    Build the decode trees of the columns, and set up the columns to
+    be unpacked with them.
+
+  RETURN
+    0  ok
+    1  error, errno is set
+*/
+
+bool _mi_read_pack_info(MI_INFO *info)
+{
+  MYISAM_SHARE *share= info->s;
+  unsigned char header[MI_PACK_HEADER_LENGTH];
+  unsigned char *buff, *pos, *end, *trees;
+  uint32_t fields= share->base.fields;
+  uint32_t i, max_code_bits;
+  ulong header_length, table_length, value_length, column_values;
+  MI_DECODE_TREE *tree;
+  uint32_t *table;
+  unsigned char *values;
+
+  if (my_pread(info->dfile, header, sizeof(header), 0L, MYF(MY_NABP)))
+  {
+    if (!errno)
+      errno= HA_ERR_END_OF_FILE;
+    return 1;
+  }
+  header_length= mi_uint4korr(header + 4);
+  if (memcmp(header, myisam_pack_file_magic, 4) ||
+      header[19] != MI_PACK_VERSION ||
+      mi_uint2korr(header + 16) != fields ||
+      !header[18] || header[18] > 8 ||
+      header_length < MI_PACK_HEADER_LENGTH + fields * MI_PACK_COLUMN_LENGTH ||
+      mi_uint4korr(header + 12) > (ulong) MI_PACK_MAX_LENGTH)
+  {
+    errno= HA_ERR_WRONG_IN_RECORD;
+    return 1;
+  }
+  header_length-= MI_PACK_HEADER_LENGTH;
+  if (!(buff= (unsigned char*) malloc(header_length)))
+  {
+    errno= HA_ERR_OUT_OF_MEM;
+    return 1;
+  }
+  if (my_pread(info->dfile, buff, header_length, MI_PACK_HEADER_LENGTH,
+               MYF(MY_NABP)))
+  {
+    if (!errno)
+      errno= HA_ERR_END_OF_FILE;
+    free(buff);
+    return 1;
+  }
+  end= buff + header_length;
+  trees= buff + fields * MI_PACK_COLUMN_LENGTH;
+
+  /* Check the columns, and find the space for their decode trees */
+  table_length= value_length= 0;
+  for (i= 0, pos= trees ; i < fields ; i++)
+  {
+    MI_COLUMNDEF *rec= share->rec + i;
+    unsigned char *column= buff + i * MI_PACK_COLUMN_LENGTH;
+    uint32_t pack_type= column[0], symbols= mi_uint4korr(column + 2);
+    uint32_t coding= pack_type & ~PACK_TYPE_SKIP_NULL;
+    uint32_t words;
+
+    if ((coding != PACK_TYPE_VALUES && coding != PACK_TYPE_BYTES) ||
+        (pack_type & PACK_TYPE_SKIP_NULL && !rec->null_bit) ||
+        (coding == PACK_TYPE_BYTES && symbols != 256) ||
+        !symbols || symbols >= (1L << 24) || column[1] > 32 ||
+        (ulong) (end - pos) < symbols ||
+        !(words= decode_table_length(pos, symbols, &max_code_bits)))
+      goto err;
+    table_length+= words;
+    pos+= symbols;
+    if (pack_type & PACK_TYPE_VALUES)
+    {
+      uint32_t pack_length= 0;
+      column_values= 0;
+      if ((ulong) (end - pos) / 4 < symbols)
+        goto err;
+      if (rec->type == FIELD_VARCHAR)
+        pack_length= ha_varchar_packlength(rec->length - 1);
+      for (uint32_t symbol= 0 ; symbol < symbols ; symbol++, pos+= 4)
+      {
+        ulong length= mi_uint4korr(pos);
+        if (rec->type == FIELD_BLOB ?
+            (rec->length - portable_sizeof_char_ptr < 4 &&
+             length >= (1UL << ((rec->length - portable_sizeof_char_ptr) * 8)))
+            : rec->type == FIELD_VARCHAR ?
+            length > (ulong) rec->length - pack_length :
+            length != rec->length)
+          goto err;
+        column_values+= length;
+      }
+      table_length+= symbols + 1;
+      if ((ulong) (end - pos) < column_values)
+        goto err;
+      pos+= column_values;
+      value_length+= column_values;
+    }
+  }
+  if (pos != end)
+    goto err;
+
+  free(share->decode_trees);
+  free(share->decode_tables);
+  share->decode_trees= (MI_DECODE_TREE*) malloc(fields * sizeof(MI_DECODE_TREE));
+  share->decode_tables= (uint32_t*) malloc(table_length * sizeof(uint32_t) +
+                                           value_length);
+  if (!share->decode_trees || !share->decode_tables)
+  {
+    free(share->decode_trees);
+    free(share->decode_tables);
+    share->decode_trees= 0;
+    share->decode_tables= 0;
+    free(buff);
+    errno= HA_ERR_OUT_OF_MEM;
+    return 1;
+  }
+  table= share->decode_tables;
+  values= (unsigned char*) (share->decode_tables + table_length);
+
+  for (i= 0, pos= trees, tree= share->decode_trees ; i < fields ; i++, tree++)
+  {
+    MI_COLUMNDEF *rec= share->rec + i;
+    unsigned char *column= buff + i * MI_PACK_COLUMN_LENGTH;
+    uint32_t symbols= mi_uint4korr(column + 2);
+
+    make_decode_tree(tree, pos, symbols, table);
+    table+= decode_table_length(pos, symbols, &max_code_bits);
+    pos+= symbols;
+    tree->intervalls= 0;
+    tree->values= 0;
+    if (column[0] & PACK_TYPE_VALUES)
+    {
+      unsigned char *lengths= pos;
+      tree->intervalls= table;
+      tree->values= values;
+      table[0]= 0;
+      for (uint32_t symbol= 0 ; symbol < symbols ; symbol++)
+        table[symbol + 1]= table[symbol] + mi_uint4korr(lengths + symbol * 4);
+      pos+= symbols * 4;
+      memcpy(values, pos, table[symbols]);
+      pos+= table[symbols];
+      values+= table[symbols];
+      table+= symbols + 1;
+    }
+
+    rec->pack_type= column[0];
+    rec->space_length_bits= column[1];
+    rec->base_type= (enum en_fieldtype) rec->type;
+    rec->huff_tree= tree;
+    if (rec->type == FIELD_BLOB)
+      rec->unpack= (rec->pack_type & PACK_TYPE_VALUES) ?
+        unpack_values_blob : unpack_bytes_blob;
+    else if (rec->type == FIELD_VARCHAR)
+      rec->unpack= (rec->pack_type & PACK_TYPE_VALUES) ?
+        unpack_values_varchar : unpack_bytes_varchar;
+    else
+      rec->unpack= (rec->pack_type & PACK_TYPE_VALUES) ?
+        unpack_values_fixed : unpack_bytes_fixed;
+  }
+  free(buff);
+
+  share->pack.header_length= mi_uint4korr(header + 4);
+  share->pack.ref_length= header[18];
+  share->pack.version= header[19];
+  share->min_pack_length= mi_uint4korr(header + 8);
+  share->max_pack_length= mi_uint4korr(header + 12);
+  share->base.min_block_length= share->min_pack_length + 1;
+  return 0;
+
+err:
+  free(buff);
+  errno= HA_ERR_WRONG_IN_RECORD;
+  return 1;
+}
+
+
+/*
+  Find the space needed for a decode tree
+
+  SYNOPSIS
+    decode_table_length()
+    code_length         Length of the code of each symbol plus one
+    symbols             Number of symbols
+    max_code_bits       Store the length of the longest code here
+
+  RETURN
+    0  the lengths are not those of a complete prefix code
+    #  number of words in the decode tables of the tree
+*/
+
+static uint32_t decode_table_length(const unsigned char *code_length,
+                                    uint32_t symbols, uint32_t *max_code_bits)
+{
+  uint64_t kraft= 0;
+  uint32_t max_bits= 0, quick_bits;
+
+  for (uint32_t symbol= 0 ; symbol < symbols ; symbol++)
+  {
+    uint32_t length= code_length[symbol];
+    if (!length)
+      continue;
+    if (--length > MI_PACK_MAX_CODE_BITS)
+      return 0;
+    kraft+= 1UL << (MI_PACK_MAX_CODE_BITS - length);
+    max_bits= max(max_bits, length);
+  }
+  /* Every string of bits must start with exactly one of the codes */
+  if (kraft != (1UL << MI_PACK_MAX_CODE_BITS))
+    return 0;
+  *max_code_bits= max_bits;
+  quick_bits= min(max_bits, (uint32_t) myisam_quick_table_bits);
+  return (1L << quick_bits) + 2 * (MI_PACK_MAX_CODE_BITS + 1) + symbols;
+}
+
+
+/*
+  Give each symbol its code
+
+  SYNOPSIS
+    _mi_make_pack_codes()
+    code_length         Length of the code of each symbol plus one
+    symbols             Number of symbols
+    code                Store the code of each symbol here
+
+  DESCRIPTION
+    The codes are canonical: the codes of one length are consecutive
+    numbers in the order of their symbols, and follow the codes of the
+    shorter lengths. Only the lengths need to be stored.
+*/
+
+void _mi_make_pack_codes(const unsigned char *code_length, uint32_t symbols,
+                         uint32_t *code)
+{
+  uint32_t count[MI_PACK_MAX_CODE_BITS + 1], next[MI_PACK_MAX_CODE_BITS + 1];
+  uint32_t start= 0;
+
+  memset(count, 0, sizeof(count));
+  for (uint32_t symbol= 0 ; symbol < symbols ; symbol++)
+    if (code_length[symbol])
+      count[code_length[symbol] - 1]++;
+  count[0]= 0;
+  for (uint32_t length= 1 ; length <= MI_PACK_MAX_CODE_BITS ; length++)
+  {
+    start= (start + count[length - 1]) << 1;
+    next[length]= start;
+  }
+  for (uint32_t symbol= 0 ; symbol < symbols ; symbol++)
+    if (code_length[symbol])
+      code[symbol]= code_length[symbol] > 1 ? next[code_length[symbol] - 1]++ : 0;
+}
+
+
+/*
+  Build the decode tree of a column
+
+  DESCRIPTION
+    Codes of up to quick_table_bits are decoded with one look up of
+    that many bits in table. Longer codes have 255 as length there, and
+    are found from the first code of each length.
+*/
+
+static void make_decode_tree(MI_DECODE_TREE *tree,
+                             const unsigned char *code_length,
+                             uint32_t symbols, uint32_t *table)
+{
+  uint32_t count[MI_PACK_MAX_CODE_BITS + 1], first[MI_PACK_MAX_CODE_BITS + 1];
+  uint32_t index[MI_PACK_MAX_CODE_BITS + 1];
+  uint32_t max_bits, quick_bits, code, length, i;
+
+  decode_table_length(code_length, symbols, &max_bits);
+  quick_bits= min(max_bits, (uint32_t) myisam_quick_table_bits);
+  tree->table= table;
+  tree->quick_table_bits= quick_bits;
+  tree->max_code_bits= max_bits;
+  tree->limit= table + (1L << quick_bits);
+  tree->offset= tree->limit + MI_PACK_MAX_CODE_BITS + 1;
+  tree->symbols= tree->offset + MI_PACK_MAX_CODE_BITS + 1;
+
+  memset(count, 0, sizeof(count));
+  for (i= 0 ; i < symbols ; i++)
+    if (code_length[i])
+      count[code_length[i] - 1]++;
+
+  /* The symbols in the order of their codes */
+  index[0]= 0;
+  for (length= 1 ; length <= max_bits ; length++)
+    index[length]= index[length - 1] + count[length - 1];
+  for (i= 0 ; i < symbols ; i++)
+    if (code_length[i])
+      tree->symbols[index[code_length[i] - 1]++]= i;
+  for (length= max_bits + 1 ; length-- > 0 ; )
+    index[length]-= count[length];
+
+  first[0]= 0;
+  for (length= 1 ; length <= max_bits ; length++)
+  {
+    first[length]= (first[length - 1] + count[length - 1]) << 1;
+    tree->limit[length]= (first[length] + count[length]) << (max_bits - length);
+    tree->offset[length]= index[length] - first[length];
+  }
+
+  for (i= 0 ; i < (1U << quick_bits) ; i++)
+    table[i]= 255;
+  if (!max_bits)
+  {
+    table[0]= tree->symbols[0] << 8;
+    return;
+  }
+  for (length= 1 ; length <= quick_bits ; length++)
+  {
+    for (i= 0, code= first[length] ; i < count[length] ; i++, code++)
+    {
+      uint32_t entry= (tree->symbols[index[length] + i] << 8) | length;
+      uint32_t *pos= table + (code << (quick_bits - length));
+      uint32_t *pos_end= pos + (1U << (quick_bits - length));
+      while (pos < pos_end)
+        *pos++= entry;
+    }
+  }
+}
+
+
+/* Read the bits of a record, first bit first */
+
+static inline void init_bit_buffer(MI_BIT_BUFF *bit_buff, unsigned char *buffer,
+                                   ulong length)
+{
+  bit_buff->pos= buffer;
+  bit_buff->end= buffer + length;
+  bit_buff->bits= 0;
+  bit_buff->current_byte= 0;
+  bit_buff->error= 0;
+  bit_buff->overrun= 0;
+}
+
+/* Have at least 49 bits in current_byte; zeros after the end */
+
+static inline void fill_buffer(MI_BIT_BUFF *bit_buff)
+{
+  while (bit_buff->bits <= 48)
+  {
+    bit_buff->current_byte<<= 8;
+    if (bit_buff->pos < bit_buff->end)
+      bit_buff->current_byte|= *bit_buff->pos++;
+    else
+      bit_buff->overrun++;
+    bit_buff->bits+= 8;
+  }
+}
+
+static inline uint32_t get_bits(MI_BIT_BUFF *bit_buff, uint32_t count)
+{
+  if (bit_buff->bits < count)
+    fill_buffer(bit_buff);
+  bit_buff->bits-= count;
+  return (uint32_t) ((bit_buff->current_byte >> bit_buff->bits) &
+                     ((((mi_bit_type) 1) << count) - 1));
+}
+
+static inline uint32_t decode_symbol(MI_DECODE_TREE *tree,
+                                     MI_BIT_BUFF *bit_buff)
+{
+  uint32_t entry, code, length;
+
+  if (bit_buff->bits < MI_PACK_MAX_CODE_BITS)
+    fill_buffer(bit_buff);
+  entry= tree->table[(bit_buff->current_byte >>
+                      (bit_buff->bits - tree->quick_table_bits)) &
+                     ((1U << tree->quick_table_bits) - 1)];
+  if ((entry & 255) != 255)
+  {
+    bit_buff->bits-= entry & 255;
+    return entry >> 8;
+  }
+  code= (uint32_t) ((bit_buff->current_byte >>
+                     (bit_buff->bits - tree->max_code_bits)) &
+                    ((1U << tree->max_code_bits) - 1));
+  for (length= tree->quick_table_bits + 1 ; code >= tree->limit[length] ;
+       length++) ;
+  bit_buff->bits-= length;
+  return tree->symbols[(code >> (tree->max_code_bits - length)) +
+                       tree->offset[length]];
+}
+
+static void decode_bytes(MI_DECODE_TREE *tree, MI_BIT_BUFF *bit_buff,
+                         unsigned char *to, unsigned char *end)
+{
+  while (to < end)
+    *to++= (unsigned char) decode_symbol(tree, bit_buff);
+}
+
+
+	/* Functions to unpack a column */
+
+static void unpack_values_fixed(MI_COLUMNDEF *rec, MI_BIT_BUFF *bit_buff,
+                                unsigned char *to, unsigned char *end)
+{
+  MI_DECODE_TREE *tree= rec->huff_tree;
+  uint32_t symbol= decode_symbol(tree, bit_buff);
+  memcpy(to, tree->values + tree->intervalls[symbol], (size_t) (end - to));
+}
+
+static void unpack_values_varchar(MI_COLUMNDEF *rec, MI_BIT_BUFF *bit_buff,
+                                  unsigned char *to, unsigned char *)
+{
+  MI_DECODE_TREE *tree= rec->huff_tree;
+  uint32_t symbol= decode_symbol(tree, bit_buff);
+  uint32_t length= tree->intervalls[symbol + 1] - tree->intervalls[symbol];
+
+  if (ha_varchar_packlength(rec->length - 1) == 1)
+    *to++= (unsigned char) length;
+  else
+  {
+    int2store(to, length);
+    to+= 2;
+  }
+  memcpy(to, tree->values + tree->intervalls[symbol], length);
+}
+
+static void unpack_values_blob(MI_COLUMNDEF *rec, MI_BIT_BUFF *bit_buff,
+                               unsigned char *to, unsigned char *)
+{
+  MI_DECODE_TREE *tree= rec->huff_tree;
+  uint32_t symbol= decode_symbol(tree, bit_buff);
+  uint32_t pack_length= rec->length - portable_sizeof_char_ptr;
+  unsigned char *pos= tree->values + tree->intervalls[symbol];
+
+  _my_store_blob_length(to, pack_length,
+                        tree->intervalls[symbol + 1] - tree->intervalls[symbol]);
+  memcpy(to + pack_length, &pos, sizeof(char*));
+}
+
+static void unpack_bytes_fixed(MI_COLUMNDEF *rec, MI_BIT_BUFF *bit_buff,
+                               unsigned char *to, unsigned char *end)
+{
+  decode_bytes(rec->huff_tree, bit_buff, to, end);
+}
+
+static void unpack_bytes_varchar(MI_COLUMNDEF *rec, MI_BIT_BUFF *bit_buff,
+                                 unsigned char *to, unsigned char *end)
+{
+  uint32_t length= get_bits(bit_buff, rec->space_length_bits);
+  uint32_t pack_length= ha_varchar_packlength(rec->length - 1);
+
+  if (length > rec->length - pack_length)
+  {
+    bit_buff->error= 1;
+    memset(to, 0, (size_t) (end - to));
+    return;
+  }
+  if (pack_length == 1)
+    *to++= (unsigned char) length;
+  else
+  {
+    int2store(to, length);
+    to+= 2;
+  }
+  decode_bytes(rec->huff_tree, bit_buff, to, to + length);
+}
+
+static void unpack_bytes_blob(MI_COLUMNDEF *rec, MI_BIT_BUFF *bit_buff,
+                              unsigned char *to, unsigned char *end)
+{
+  uint32_t length= get_bits(bit_buff, rec->space_length_bits);
+  uint32_t pack_length= rec->length - portable_sizeof_char_ptr;
+
+  if (length > (ulong) (bit_buff->blob_end - bit_buff->blob_pos))
+  {
+    bit_buff->error= 1;
+    memset(to, 0, (size_t) (end - to));
+    return;
+  }
+  decode_bytes(rec->huff_tree, bit_buff, bit_buff->blob_pos,
+               bit_buff->blob_pos + length);
+  _my_store_blob_length(to, pack_length, length);
+  memcpy(to + pack_length, &bit_buff->blob_pos, sizeof(char*));
+  bit_buff->blob_pos+= length;
+}
+
+
+/*
+  Unpack a compressed record
+
+  SYNOPSIS
+    _mi_pack_rec_unpack()
+    info                MyISAM handler
+    bit_buff            Bit buffer, with blob_pos set if there are blobs
+    to                  Store the record here
+    from                The packed record, after its lengths
+    reclength           Length of the packed record
+
+  RETURN
+    0                       ok
+    HA_ERR_WRONG_IN_RECORD  the record does not decode to its length
+*/
+
+int _mi_pack_rec_unpack(MI_INFO *info, MI_BIT_BUFF *bit_buff,
+                        unsigned char *to, unsigned char *from, ulong reclength)
+{
+  MYISAM_SHARE *share= info->s;
+  MI_COLUMNDEF *rec, *end;
+  uint64_t used_bits;
+
+  init_bit_buffer(bit_buff, from, reclength);
+  for (rec= share->rec, end= rec + share->base.fields ; rec < end ; rec++)
+  {
+    unsigned char *field= to + rec->offset;
+    if (rec->pack_type & PACK_TYPE_SKIP_NULL &&
+        to[rec->null_pos] & rec->null_bit)
+    {
+      memset(field, 0, rec->length);
+      continue;
+    }
+    (*rec->unpack)(rec, bit_buff, field, field + rec->length);
+  }
+
+  /* All bytes, but no more, are used, up to the padding of the last one */
+  used_bits= ((uint64_t) (bit_buff->pos - from) + bit_buff->overrun) * 8 -
+    bit_buff->bits;
+  if (!bit_buff->error && used_bits <= (uint64_t) reclength * 8 &&
+      used_bits + 8 > (uint64_t) reclength * 8 &&
+      (!share->base.blobs || bit_buff->blob_pos == bit_buff->blob_end))
+    return 0;
+  info->update&= ~HA_STATE_AKTIV;
+  return(errno=HA_ERR_WRONG_IN_RECORD);
+}
+
+
+/* Length in front of a record, as stored by _mi_store_pack_length() */
+
+static uint32_t read_pack_length(const unsigned char *pos, ulong *length)
+{
+  if (*pos < 254)
+  {
+    *length= *pos;
+    return 1;
+  }
+  if (*pos == 254)
+  {
+    *length= uint2korr(pos + 1);
+    return 3;
+  }
+  *length= uint3korr(pos + 1);
+  return 4;
+}
+
+uint32_t _mi_store_pack_length(unsigned char *pos, ulong length)
+{
+  if (length < 254)
+  {
+    *pos= (unsigned char) length;
+    return 1;
+  }
+  if (length < 65536)
+  {
+    *pos= 254;
+    int2store(pos + 1, length);
+    return 3;
+  }
+  *pos= 255;
+  int3store(pos + 1, length);
+  return 4;
+}
+
+
+/*
+  Read the lengths in front of a compressed record
+
+  SYNOPSIS
+    _mi_pack_get_block_info()
+    myisam              MyISAM handler
+    bit_buff            Set blob_pos and blob_end here
+    info                Store the lengths here
+    rec_buff_p          Record buffer, grown to hold the record and blobs
+    file                Read the lengths from here, or -1 if they are
+                        already in info->header
+    filepos             Position of the record
+
+  RETURN
+    0                  ok; info->filepos is the position of the bits
+    BLOCK_ERROR        the lengths are wrong
+    BLOCK_FATAL_ERROR  read error or out of memory
+*/
+
+uint32_t _mi_pack_get_block_info(MI_INFO *myisam, MI_BIT_BUFF *bit_buff,
+                                 MI_BLOCK_INFO *info, unsigned char **rec_buff_p,
+                                 int file, internal::my_off_t filepos)
+{
+  MYISAM_SHARE *share= myisam->s;
+  unsigned char *header= info->header;
+  uint32_t head_length;
+
+  if (file >= 0 &&
+      my_pread(file, header, share->pack.ref_length, filepos, MYF(MY_NABP)))
+    return BLOCK_FATAL_ERROR;
+  head_length= read_pack_length(header, &info->rec_len);
+  info->blob_len= 0;
+  if (share->base.blobs)
+    head_length+= read_pack_length(header + head_length, &info->blob_len);
+  if (head_length > share->pack.ref_length ||
+      info->rec_len > share->max_pack_length)
+  {
+    errno= HA_ERR_WRONG_IN_RECORD;
+    return BLOCK_ERROR;
+  }
+  if (!mi_alloc_rec_buff(myisam, info->rec_len + info->blob_len, rec_buff_p))
+    return BLOCK_FATAL_ERROR;
+  if (share->base.blobs)
+  {
+    bit_buff->blob_pos= *rec_buff_p + info->rec_len;
+    bit_buff->blob_end= bit_buff->blob_pos + info->blob_len;
+    myisam->blob_length= info->blob_len;
+  }
+  info->filepos= filepos + head_length;
+  return 0;
+}
+
+
+	/* Read a compressed record from the position given */
+
+int _mi_read_pack_record(MI_INFO *info, internal::my_off_t filepos,
+                         unsigned char *buf)
+{
+  MI_BLOCK_INFO block_info;
+
+  if (filepos == HA_OFFSET_ERROR)
+    return(-1);			/* _search() didn't find record */
+
+  if (_mi_pack_get_block_info(info, &info->bit_buff, &block_info,
+                              &info->rec_buff, info->dfile, filepos))
+    return(-1);
+  if (block_info.rec_len &&
+      info->s->file_read(info, info->rec_buff, block_info.rec_len,
+                         block_info.filepos, MYF(MY_NABP)))
+  {
+    if (!errno)
+      errno= HA_ERR_WRONG_IN_RECORD;
+    return(-1);
+  }
+  info->update|= HA_STATE_AKTIV;
+  return(_mi_pack_rec_unpack(info, &info->bit_buff, buf, info->rec_buff,
+                             block_info.rec_len) ? -1 : 0);
+}
+
+
+/*
+  Read the compressed record at filepos, for a scan
+
+  RETURN
+    0                   ok
+    HA_ERR_END_OF_FILE  no more records
+    #                   error
+*/
+
+int _mi_read_rnd_pack_record(MI_INFO *info, unsigned char *buf,
+                             internal::my_off_t filepos,
+                             bool skip_deleted_blocks)
+{
+  MYISAM_SHARE *share= info->s;
+  MI_BLOCK_INFO block_info;
+
+  if (filepos >= info->state->data_file_length)
+    return(errno= HA_ERR_END_OF_FILE);
+
+  if (info->opt_flag & READ_CACHE_USED)
+  {
+    if (_mi_read_cache(&info->rec_cache, block_info.header, filepos,
+                       share->pack.ref_length,
+                       skip_deleted_blocks ? READING_NEXT : 0) ||
+        _mi_pack_get_block_info(info, &info->bit_buff, &block_info,
+                                &info->rec_buff, -1, filepos) ||
+        (block_info.rec_len &&
+         _mi_read_cache(&info->rec_cache, info->rec_buff, block_info.filepos,
+                        block_info.rec_len,
+                        skip_deleted_blocks ? READING_NEXT : 0)))
+      return(errno);
+  }
+  else
+  {
+    if (_mi_pack_get_block_info(info, &info->bit_buff, &block_info,
+                                &info->rec_buff, info->dfile, filepos))
+      return(errno);
+    if (block_info.rec_len &&
+        share->file_read(info, info->rec_buff, block_info.rec_len,
+                         block_info.filepos, MYF(MY_NABP)))
+      return(errno ? errno : (errno= HA_ERR_WRONG_IN_RECORD));
+  }
+  info->packed_length= block_info.rec_len;
+  info->lastpos= filepos;
+  info->nextpos= block_info.filepos + block_info.rec_len;
+  info->update|= HA_STATE_AKTIV | HA_STATE_KEY_CHANGED;
+  return(_mi_pack_rec_unpack(info, &info->bit_buff, buf, info->rec_buff,
+                             block_info.rec_len));
+}
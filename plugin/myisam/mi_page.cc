@@ -24,7 +24,7 @@ using namespace drizzled;
 unsigned char *_mi_fetch_keypage(MI_INFO *info, MI_KEYDEF *keyinfo,
 			 internal::my_off_t page, int, unsigned char *buff, int)
 {
-  if (not pread(info->s->kfile, buff, keyinfo->block_length, page))
+  if (mi_key_cache_read(info->s->kfile, page, buff, keyinfo->block_length))
   {
     info->last_keypage=HA_OFFSET_ERROR;
     mi_print_error(info->s, HA_ERR_CRASHED);
@@ -52,8 +52,6 @@ unsigned char *_mi_fetch_keypage(MI_INFO *info, MI_KEYDEF *keyinfo,
 int _mi_write_keypage(MI_INFO *info, MI_KEYDEF *keyinfo,
 		      internal::my_off_t page, int, unsigned char *buff)
 {
-  uint32_t length;
-
 #ifndef FAST					/* Safety check */
   if (page < info->s->base.keystart ||
       page+keyinfo->block_length > info->state->key_file_length ||
@@ -64,17 +62,14 @@ int _mi_write_keypage(MI_INFO *info, MI_KEYDEF *keyinfo,
   }
 #endif
 
-  if ((length=keyinfo->block_length) > IO_SIZE*2 &&
-      info->state->key_file_length != page+length)
-    length= ((mi_getint(buff)+IO_SIZE-1) & (uint) ~(IO_SIZE-1));
 #ifdef HAVE_VALGRIND
   {
-    length=mi_getint(buff);
+    uint32_t length=mi_getint(buff);
     memset(buff+length, 0, keyinfo->block_length-length);
-    length=keyinfo->block_length;
   }
 #endif
-  return not pwrite(info->s->kfile, buff, length, page);
+  return mi_key_cache_write(info->s->kfile, page, buff,
+                            keyinfo->block_length);
 } /* mi_write_keypage */
 
 
@@ -89,6 +84,8 @@ int _mi_dispose(MI_INFO *info, MI_KEYDEF *keyinfo, internal::my_off_t pos, int)
   info->s->state.key_del[keyinfo->block_size_index]= pos;
   mi_sizestore(buff,old_link);
   info->s->state.changed|= STATE_NOT_SORTED_PAGES;
+  /* Only the link is read again, by _mi_new(), and it reads the file */
+  mi_key_cache_discard(info->s->kfile, pos);
   return not pwrite(info->s->kfile, buff, sizeof(buff), pos);
 } /* _mi_dispose */
 
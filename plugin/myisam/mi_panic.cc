@@ -48,6 +48,8 @@ int mi_panic(enum ha_panic_function flag)
       if (info->s->options & HA_OPTION_READ_ONLY_DATA)
 	break;
 #endif
+      if (mi_flush_key_blocks(info->s->kfile, FLUSH_KEEP))
+	error=errno;
       if (info->opt_flag & WRITE_CACHE_USED)
 	if (info->rec_cache.flush())
 	  error=errno;
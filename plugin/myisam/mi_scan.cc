@@ -17,12 +17,20 @@
 
 #include "myisam_priv.h"
 
+#include <sys/mman.h>
+
 int mi_scan_init(register MI_INFO *info)
 {
   info->nextpos=info->s->pack.header_length;	/* Read first record */
   info->lastinx= -1;				/* Can't forward or backward */
   if (info->opt_flag & WRITE_CACHE_USED && info->rec_cache.flush())
     return(errno);
+  mi_mmap_data_file(info);
+#if !defined(TARGET_OS_SOLARIS)
+  if (info->opt_flag & MEMMAP_USED)
+    madvise((char*) info->s->file_map, info->s->mmaped_length,
+            MADV_SEQUENTIAL);
+#endif
   return(0);
 }
 
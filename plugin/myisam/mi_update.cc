@@ -39,6 +39,10 @@ int mi_update(register MI_INFO *info, const unsigned char *oldrec, unsigned char
   {
     return(errno=EACCES);
   }
+  if (share->options & HA_OPTION_COMPRESS_RECORD)
+  {
+    return(errno=HA_ERR_TABLE_READONLY);
+  }
   if (info->state->key_file_length >= share->base.margin_key_file_length)
   {
     return(errno=HA_ERR_INDEX_FILE_FULL);
@@ -58,6 +58,10 @@ int mi_write(MI_INFO *info, unsigned char *record)
   {
     return(errno=EACCES);
   }
+  if (share->options & HA_OPTION_COMPRESS_RECORD)
+  {
+    return(errno=HA_ERR_TABLE_READONLY);
+  }
   if (_mi_readinfo(info,F_WRLCK,1))
     return(errno);
   filepos= ((share->state.dellink != HA_OFFSET_ERROR &&
@@ -222,9 +222,14 @@ typedef struct st_unique_def		/* Segment definition of unique */
 
 typedef struct st_mi_decode_tree	/* Decode huff-table */
 {
-  uint16_t *table;
-  uint	 quick_table_bits;
-  unsigned char	 *intervalls;
+  uint32_t *table;			/* symbol << 8 | code length */
+  uint32_t quick_table_bits;		/* Bits looked up in table */
+  uint32_t max_code_bits;
+  uint32_t *limit;			/* End of the codes of each length */
+  uint32_t *offset;			/* From code to index in symbols */
+  uint32_t *symbols;			/* Symbols in code order */
+  uint32_t *intervalls;			/* Start of each value */
+  unsigned char *values;		/* Values of the symbols, if not bytes */
 } MI_DECODE_TREE;
 
 
@@ -264,6 +269,8 @@ extern uint32_t myisam_block_size;
 extern uint32_t myisam_concurrent_insert;
 extern uint32_t myisam_bulk_insert_tree_size; 
 extern uint32_t data_pointer_size;
+extern bool myisam_use_mmap;
+extern uint64_t myisam_mmap_size;
 
 	/* Prototypes for myisam-functions */
 
@@ -404,6 +411,7 @@ typedef struct st_mi_check_param
   uint32_t out_flag,warning_printed,error_printed,verbose;
   uint32_t opt_sort_key,total_files,max_level;
   uint32_t testflag, key_cache_block_size;
+  uint32_t repair_threads;
   uint8_t language;
   bool using_global_keycache, opt_lock_memory, opt_follow_links;
   bool retry_repair, force_sort;
@@ -456,6 +464,9 @@ int mi_repair(MI_CHECK *param, register MI_INFO *info,
 int mi_sort_index(MI_CHECK *param, register MI_INFO *info, char * name);
 int mi_repair_by_sort(MI_CHECK *param, register MI_INFO *info,
 		      const char * name, int rep_quick);
+int mi_repair_parallel(MI_CHECK *param, register MI_INFO *info,
+                       const char * name, int rep_quick);
+int mi_pack_records(MI_CHECK *param, MI_INFO *info, const char * name);
 int change_to_newfile(const char * filename, const char * old_ext,
 		      const char * new_ext, uint32_t raid_chunks,
 		      drizzled::myf myflags);
@@ -51,6 +51,29 @@ static const uint32_t KEY_CACHE_SIZE= 8*1024*1024;
 /* Default size of a key cache block  */
 static const uint32_t KEY_CACHE_BLOCK_SIZE= 1024;
 
+/* Key cache partitions, each with its own mutex */
+static const uint32_t KEY_CACHE_PARTITIONS= 16;
+
+/* Part of each key cache partition, in percent, kept for pages read once */
+static const uint32_t KEY_CACHE_DIVISION_LIMIT= 25;
+
+enum flush_type
+{
+  FLUSH_KEEP,                           /* Write dirty pages, keep them cached */
+  FLUSH_RELEASE,                        /* Write dirty pages, drop all */
+  FLUSH_IGNORE_CHANGED                  /* Drop all pages without writing */
+};
+
+typedef struct st_mi_key_cache_status
+{
+  uint64_t blocks_used;
+  uint64_t blocks_not_flushed;
+  uint64_t read_requests;
+  uint64_t reads;
+  uint64_t write_requests;
+  uint64_t writes;
+} MI_KEY_CACHE_STATUS;
+
 typedef struct st_mi_status_info
 {
   drizzled::ha_rows records;			/* Rows in table */
@@ -175,6 +198,7 @@ typedef struct st_mi_isam_pack {
 } MI_PACK;
 
 #define MAX_NONMAPPED_INSERTS 1000
+#define MMAP_SIZE (1024*1024*1024)	/* Largest data file to memory map */
 
 typedef struct st_mi_isam_share {	/* Shared between opens */
   MI_STATE_INFO state;
@@ -192,7 +216,7 @@ typedef struct st_mi_isam_share {	/* Shared between opens */
         *index_file_name;
   unsigned char *file_map;			/* mem-map of file if possible */
   MI_DECODE_TREE *decode_trees;
-  uint16_t *decode_tables;
+  uint32_t *decode_tables;
   int (*read_record)(struct st_myisam_info*, drizzled::internal::my_off_t, unsigned char*);
   int (*write_record)(struct st_myisam_info*, const unsigned char*);
   int (*update_record)(struct st_myisam_info*, drizzled::internal::my_off_t, const unsigned char*);
@@ -236,13 +260,14 @@ typedef struct st_mi_isam_share {	/* Shared between opens */
 } MYISAM_SHARE;
 
 
-typedef uint32_t mi_bit_type;
+typedef uint64_t mi_bit_type;
 
 typedef struct st_mi_bit_buff {		/* Used for packing of record */
   mi_bit_type current_byte;
   uint32_t bits;
   unsigned char *pos,*end,*blob_pos,*blob_end;
   uint32_t error;
+  uint32_t overrun;			/* Bytes read past end */
 } MI_BIT_BUFF;
 
 
@@ -344,6 +369,8 @@ typedef struct st_mi_sort_param
   MI_KEYDEF *keyinfo;
   HA_KEYSEG *seg;
   SORT_INFO *sort_info;
+  struct st_sort_key_reader *reader;     /* For mi_repair_parallel() */
+  boost::mutex *key_file_lock;           /* Set when keys are written at once */
   unsigned char **sort_keys;
   unsigned char *rec_buff;
   void *wordlist, *wordptr;
@@ -448,9 +475,15 @@ typedef struct st_mi_sort_param
 
 #define MEMMAP_EXTRA_MARGIN	7	/* Write this as a suffix for file */
 
-#define PACK_TYPE_SELECTED	1	/* Bits in field->pack_type */
-#define PACK_TYPE_SPACE_FIELDS	2
-#define PACK_TYPE_ZERO_FILL	4
+#define PACK_TYPE_VALUES	1	/* Bits in field->pack_type */
+#define PACK_TYPE_BYTES		2	/* Each byte has a code */
+#define PACK_TYPE_SKIP_NULL	4	/* Nothing stored for NULL */
+
+#define MI_PACK_HEADER_LENGTH	32	/* Fixed part of packed file header */
+#define MI_PACK_COLUMN_LENGTH	6	/* Header of each column */
+#define MI_PACK_VERSION		1
+#define MI_PACK_MAX_CODE_BITS	24
+#define MI_PACK_MAX_LENGTH	((1L << 24) - 1)  /* Of a packed record */
 #define MI_FOUND_WRONG_KEY 32738	/* Impossible value from ha_key_cmp */
 
 #define MI_MAX_KEY_BLOCK_SIZE	(MI_MAX_KEY_BLOCK_LENGTH/MI_MIN_KEY_BLOCK_LENGTH)
@@ -597,6 +630,15 @@ extern int _mi_write_keypage(MI_INFO *info,MI_KEYDEF *keyinfo,drizzled::internal
 extern int _mi_dispose(MI_INFO *info,MI_KEYDEF *keyinfo,drizzled::internal::my_off_t pos,
                       int level);
 extern drizzled::internal::my_off_t _mi_new(MI_INFO *info,MI_KEYDEF *keyinfo,int level);
+void mi_key_cache_init(size_t size);
+void mi_key_cache_end();
+int mi_key_cache_read(int file, drizzled::internal::my_off_t pos,
+                      unsigned char *buff, uint32_t length);
+int mi_key_cache_write(int file, drizzled::internal::my_off_t pos,
+                       const unsigned char *buff, uint32_t length);
+void mi_key_cache_discard(int file, drizzled::internal::my_off_t pos);
+int mi_flush_key_blocks(int file, enum flush_type type);
+void mi_key_cache_status(MI_KEY_CACHE_STATUS *status);
 extern uint32_t _mi_make_key(MI_INFO *info,uint32_t keynr,unsigned char *key,
 			 const unsigned char *record,drizzled::internal::my_off_t filepos);
 extern uint32_t _mi_pack_key(register MI_INFO *info, uint32_t keynr, unsigned char *key,
@@ -623,11 +665,14 @@ extern int _mi_write_part_record(MI_INFO *info,drizzled::internal::my_off_t file
 				 ulong *reclength,int *flag);
 extern void _mi_print_key(FILE *stream,HA_KEYSEG *keyseg,const unsigned char *key,
 			  uint32_t length);
-extern bool _mi_read_pack_info(MI_INFO *info,bool fix_keys);
+extern bool _mi_read_pack_info(MI_INFO *info);
 extern int _mi_read_pack_record(MI_INFO *info,drizzled::internal::my_off_t filepos,unsigned char *buf);
 extern int _mi_read_rnd_pack_record(MI_INFO*, unsigned char *,drizzled::internal::my_off_t, bool);
 extern int _mi_pack_rec_unpack(MI_INFO *info, MI_BIT_BUFF *bit_buff,
                                unsigned char *to, unsigned char *from, ulong reclength);
+extern void _mi_make_pack_codes(const unsigned char *code_length,
+                                uint32_t symbols, uint32_t *code);
+extern uint32_t _mi_store_pack_length(unsigned char *pos, ulong length);
 
 struct st_sort_info;
 
@@ -722,6 +767,8 @@ int mi_open_keyfile(MYISAM_SHARE *share);
 void mi_setup_functions(register MYISAM_SHARE *share);
 bool mi_dynmap_file(MI_INFO *info, drizzled::internal::my_off_t size);
 void mi_remap_file(MI_INFO *info, drizzled::internal::my_off_t size);
+void mi_munmap_file(MI_INFO *info);
+void mi_mmap_data_file(MI_INFO *info);
 
 int mi_check_index_cond(register MI_INFO *info, uint32_t keynr, unsigned char *record);
 
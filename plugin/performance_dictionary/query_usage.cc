@@ -23,7 +23,8 @@
 
 namespace performance_dictionary {
 
-  void QueryUsage::push(drizzled::Session::QueryString query_string, const struct rusage &arg)
+  void QueryUsage::push(drizzled::Session::QueryString query_string, const struct rusage &arg,
+                        uint64_t memory_peak)
   {
     if (not query_string)
       return;
@@ -31,7 +32,7 @@ namespace performance_dictionary {
     Query_list::iterator it= query_list.end();
     it--;
     query_list.splice(query_list.begin(), query_list, it);
-    query_list.front().set(*query_string, arg);
+    query_list.front().set(*query_string, arg, memory_peak);
   }
 
 } // performance_dictionary namespace
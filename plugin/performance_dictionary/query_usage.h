@@ -31,14 +31,16 @@ struct query_usage {
   std::string query;
   struct rusage start;
   struct rusage buffer;
+  uint64_t memory_peak;
 
-  query_usage()
+  query_usage() :
+    memory_peak(0)
   {
     memset(&start, 0, sizeof(struct rusage));
     memset(&buffer, 0, sizeof(struct rusage));
   }
 
-  void set(const std::string &sql, const struct rusage &arg)
+  void set(const std::string &sql, const struct rusage &arg, uint64_t memory_peak_arg)
   {
     if (getrusage(RUSAGE_THREAD, &buffer))
     {
@@ -48,6 +50,7 @@ struct query_usage {
     }
     query= sql.substr(0, 512);
     start= arg;
+    memory_peak= memory_peak_arg;
 
     buffer.ru_utime.tv_sec -= start.ru_utime.tv_sec;
     buffer.ru_utime.tv_usec -= start.ru_utime.tv_usec;
@@ -92,7 +95,8 @@ public:
     query_list.resize(USAGE_MAX_KEPT);
   }
 
-  void push(drizzled::Session::QueryString query_string, const struct rusage &arg);
+  void push(drizzled::Session::QueryString query_string, const struct rusage &arg,
+            uint64_t memory_peak);
 
   Query_list &list(void)
   {
@@ -54,6 +54,7 @@ performance_dictionary::SessionUsage::SessionUsage() :
   add_field("SIGNALS_RECEIVED", plugin::TableFunction::NUMBER, 0, false);
   add_field("VOLUNTARY_CONTEXT_SWITCHES", plugin::TableFunction::NUMBER, 0, false);
   add_field("INVOLUNTARY_CONTEXT_SWITCHES", plugin::TableFunction::NUMBER, 0, false);
+  add_field("STATEMENT_MEMORY_PEAK", plugin::TableFunction::NUMBER, 0, false);
 }
 
 
@@ -74,13 +75,14 @@ bool performance_dictionary::SessionUsage::Generator::populate()
   if (query_iter == usage_cache->list().rend())
     return false;
 
-  publish(query_iter->query, query_iter->delta());
+  publish(query_iter->query, query_iter->delta(), query_iter->memory_peak);
   query_iter++;
 
   return true;
 }
 
-void performance_dictionary::SessionUsage::Generator::publish(const std::string &sql, const struct rusage &usage_arg)
+void performance_dictionary::SessionUsage::Generator::publish(const std::string &sql, const struct rusage &usage_arg,
+                                                              uint64_t memory_peak)
 {
   /* SQL */
   push(sql.substr(0, FUNCTION_NAME_LEN));
@@ -138,4 +140,7 @@ void performance_dictionary::SessionUsage::Generator::publish(const std::string
 
   /* INVOLUNTARY_CONTEXT_SWITCHES */
   push(static_cast<int64_t>(usage_arg.ru_nivcsw));
+
+  /* STATEMENT_MEMORY_PEAK */
+  push(memory_peak);
 }
@@ -33,7 +33,8 @@ public:
     Query_list::reverse_iterator query_iter;
     QueryUsage *usage_cache;
 
-    void publish(const std::string &sql, const struct rusage &r_usage);
+    void publish(const std::string &sql, const struct rusage &r_usage,
+                 uint64_t memory_peak);
 
   public:
     Generator(drizzled::Field **arg);
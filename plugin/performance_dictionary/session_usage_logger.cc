@@ -23,6 +23,7 @@
 #include <plugin/performance_dictionary/dictionary.h>
 
 #include <drizzled/session.h>
+#include <drizzled/session/memory_usage.h>
 
 #include <sys/resource.h>
 
@@ -42,7 +43,8 @@ bool SessionUsageLogger::post(Session *session)
   QueryUsage* usage_cache= session->getProperty<QueryUsage>("query_usage");
   if (not usage_cache)
     usage_cache= session->setProperty("query_usage", new QueryUsage);
-  usage_cache->push(session->getQueryString(), session->getUsage());
+  usage_cache->push(session->getQueryString(), session->getUsage(),
+                    session->memory_usage.getStatementPeak());
   return false;
 }
 
@@ -30,6 +30,7 @@
 #include <drizzled/plugin/authorization.h>
 #include <drizzled/plugin/client.h>
 #include <drizzled/pthread_globals.h>
+#include <drizzled/session/memory_usage.h>
 #include <drizzled/session/state.h>
 #include <set>
 
@@ -52,6 +53,9 @@ Sessions::Sessions() :
   add_field("HAS_GLOBAL_LOCK", plugin::TableFunction::BOOLEAN, 0, false);
   add_field("IS_INTERACTIVE", plugin::TableFunction::BOOLEAN, 0, false);
   add_field("IS_CONSOLE", plugin::TableFunction::BOOLEAN, 0, false);
+  add_field("MEMORY_USED", plugin::TableFunction::NUMBER, 0, false);
+  add_field("MEMORY_PEAK", plugin::TableFunction::NUMBER, 0, false);
+  add_field("STATEMENT_MEMORY_PEAK", plugin::TableFunction::NUMBER, 0, false);
 }
 
 Sessions::Generator::Generator(Field **arg) :
@@ -129,6 +133,15 @@ bool Sessions::Generator::populate()
     /* IS_CONSOLE */
     push(tmp->getClient()->isConsole());
 
+    /* MEMORY_USED */
+    push(tmp->memory_usage.getCurrent());
+
+    /* MEMORY_PEAK */
+    push(tmp->memory_usage.getPeak());
+
+    /* STATEMENT_MEMORY_PEAK */
+    push(tmp->memory_usage.getStatementPeak());
+
     return true;
   }
 
@@ -0,0 +1,436 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#include "definition.h"
+
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+using namespace std;
+
+namespace drizzle_plugin {
+namespace summary_table {
+
+namespace {
+
+struct Token
+{
+  enum Type { IDENTIFIER, SYMBOL, END };
+
+  Type type;
+  bool quoted;
+  string text; /**< In lower case */
+  size_t begin;
+  size_t end;
+};
+
+bool identifier_char(unsigned char c)
+{
+  return isalnum(c) || c == '_' || c == '$' || c >= 0x80;
+}
+
+/* Split text into identifiers and punctuation, true if it holds anything else */
+bool tokenize(const string &text, vector<Token> &tokens)
+{
+  size_t pos= 0;
+  while (true)
+  {
+    while (pos < text.size() && isspace((unsigned char) text[pos]))
+      pos++;
+
+    Token token;
+    token.type= Token::IDENTIFIER;
+    token.quoted= false;
+    token.begin= pos;
+
+    if (pos == text.size())
+    {
+      token.type= Token::END;
+      token.end= pos;
+      tokens.push_back(token);
+      return false;
+    }
+
+    unsigned char c= text[pos];
+    if (c == '`')
+    {
+      token.quoted= true;
+      for (pos++; ; pos++)
+      {
+        if (pos == text.size())
+          return true;
+        if (text[pos] == '`')
+        {
+          if (pos + 1 < text.size() && text[pos + 1] == '`')
+            pos++;
+          else
+            break;
+        }
+        token.text.push_back(text[pos]);
+      }
+      pos++;
+      if (token.text.empty())
+        return true;
+    }
+    else if (identifier_char(c))
+    {
+      while (pos < text.size() && identifier_char(text[pos]))
+        token.text.push_back(text[pos++]);
+    }
+    else if (strchr("(),.*;=", c))
+    {
+      token.type= Token::SYMBOL;
+      token.text.push_back(c);
+      pos++;
+    }
+    else
+    {
+      return true;
+    }
+
+    boost::to_lower(token.text);
+    token.end= pos;
+    tokens.push_back(token);
+  }
+}
+
+class Parser
+{
+public:
+  Parser(const string &text_arg, const vector<Token> &tokens_arg) :
+    text(text_arg),
+    tokens(tokens_arg),
+    pos(0)
+  { }
+
+  bool at_end() const
+  {
+    return tokens[pos].type == Token::END;
+  }
+
+  bool symbol(char c)
+  {
+    if (tokens[pos].type != Token::SYMBOL || tokens[pos].text[0] != c)
+      return false;
+    pos++;
+    return true;
+  }
+
+  bool keyword(const char *word)
+  {
+    if (tokens[pos].type != Token::IDENTIFIER || tokens[pos].quoted ||
+        tokens[pos].text != word)
+      return false;
+    pos++;
+    return true;
+  }
+
+  bool identifier(string &to)
+  {
+    if (tokens[pos].type != Token::IDENTIFIER)
+      return false;
+    to= tokens[pos++].text;
+    return true;
+  }
+
+  /* [schema.]table, returns false on error */
+  bool table_name(string &schema, string &table)
+  {
+    if (not identifier(table))
+      return false;
+    if (symbol('.'))
+    {
+      schema= table;
+      return identifier(table);
+    }
+    return true;
+  }
+
+  bool item(Item &to)
+  {
+    size_t first= pos;
+    string name;
+    if (not identifier(name))
+      return false;
+
+    to.kind= Item::GROUP;
+    to.column= name;
+    if (not tokens[first].quoted && symbol('('))
+    {
+      if (name == "count")
+        to.kind= Item::COUNT;
+      else if (name == "sum")
+        to.kind= Item::SUM;
+      else if (name == "min")
+        to.kind= Item::MIN;
+      else if (name == "max")
+        to.kind= Item::MAX;
+      else
+        return false;
+
+      to.column.clear();
+      if (to.kind == Item::COUNT && symbol('*'))
+        to.kind= Item::COUNT_ROWS;
+      else if (not identifier(to.column))
+        return false;
+      if (not symbol(')'))
+        return false;
+    }
+    to.text= text.substr(tokens[first].begin, tokens[pos - 1].end - tokens[first].begin);
+    return true;
+  }
+
+  /* A summary query up to the end of the text or a semicolon */
+  bool select(Select &to, const string &default_schema)
+  {
+    if (not keyword("select"))
+      return false;
+    do
+    {
+      Item column;
+      if (not item(column))
+        return false;
+      to.items.push_back(column);
+    } while (symbol(','));
+
+    if (not keyword("from") || not table_name(to.schema, to.table))
+      return false;
+    if (to.schema.empty())
+    {
+      if (default_schema.empty())
+        return false;
+      to.schema= boost::to_lower_copy(default_schema);
+    }
+
+    if (keyword("group"))
+    {
+      if (not keyword("by"))
+        return false;
+      do
+      {
+        string column;
+        if (not identifier(column))
+          return false;
+        to.group_by.push_back(column);
+      } while (symbol(','));
+    }
+    return true;
+  }
+
+  size_t offset() const
+  {
+    return tokens[pos].begin;
+  }
+
+private:
+  const string &text;
+  const vector<Token> &tokens;
+  size_t pos;
+};
+
+/* Map the GROUP BY columns to the select items, returns an error or "" */
+string check_definition(Definition &definition)
+{
+  const Select &select= definition.select;
+  if (definition.columns.size() != select.items.size())
+    return "the summary table lists " + boost::lexical_cast<string>(definition.columns.size()) +
+      " columns for " + boost::lexical_cast<string>(select.items.size()) + " select items";
+  if (select.schema == definition.schema && select.table == definition.table)
+    return "a summary table can not summarize itself";
+
+  for (vector<string>::const_iterator it= select.group_by.begin(); it != select.group_by.end(); ++it)
+  {
+    size_t x= 0;
+    while (x < select.items.size() &&
+           (select.items[x].kind != Item::GROUP || select.items[x].column != *it))
+      x++;
+    if (x == select.items.size())
+      return "GROUP BY column " + *it + " is not selected";
+    definition.group_items.push_back(x);
+  }
+
+  for (vector<Item>::const_iterator it= select.items.begin(); it != select.items.end(); ++it)
+  {
+    if (it->kind == Item::GROUP &&
+        find(select.group_by.begin(), select.group_by.end(), it->column) == select.group_by.end())
+      return "column " + it->column + " is neither grouped nor aggregated";
+  }
+  return "";
+}
+
+boost::mutex definitions_mutex;
+Definitions current_definitions(new vector<Definition>);
+
+} /* namespace */
+
+string Item::canonical() const
+{
+  switch (kind)
+  {
+  case GROUP:
+    return column;
+  case COUNT_ROWS:
+    return "count(*)";
+  case COUNT:
+    return "count(" + column + ")";
+  case SUM:
+    return "sum(" + column + ")";
+  case MIN:
+    return "min(" + column + ")";
+  case MAX:
+    return "max(" + column + ")";
+  }
+  return "";
+}
+
+bool Select::parse(const string &query, const string &default_schema)
+{
+  vector<Token> tokens;
+  if (tokenize(query, tokens))
+    return true;
+  Parser parser(query, tokens);
+  return not parser.select(*this, default_schema) || not parser.at_end();
+}
+
+int Select::find(const Item &item) const
+{
+  string canonical= item.canonical();
+  for (size_t x= 0; x < items.size(); x++)
+  {
+    if (items[x].canonical() == canonical)
+      return (int) x;
+  }
+  return -1;
+}
+
+bool parse_definitions(const string &text, vector<Definition> &definitions, string &error)
+{
+  vector<Token> tokens;
+  if (tokenize(text, tokens))
+  {
+    error= "only identifiers and punctuation may be used";
+    return true;
+  }
+
+  Parser parser(text, tokens);
+  while (not parser.at_end())
+  {
+    Definition definition;
+    size_t offset= parser.offset();
+    bool ok= parser.table_name(definition.schema, definition.table) &&
+      not definition.schema.empty() && parser.symbol('(');
+    while (ok)
+    {
+      string column;
+      ok= parser.identifier(column);
+      definition.columns.push_back(column);
+      if (not parser.symbol(','))
+        break;
+    }
+    ok= ok && parser.symbol(')') && parser.symbol('=') &&
+      parser.select(definition.select, definition.schema) &&
+      (parser.symbol(';') || parser.at_end());
+    if (not ok)
+    {
+      error= "syntax error in the definition at offset " + boost::lexical_cast<string>(offset);
+      return true;
+    }
+
+    error= check_definition(definition);
+    if (not error.empty())
+    {
+      error= definition.schema + "." + definition.table + ": " + error;
+      return true;
+    }
+    definitions.push_back(definition);
+  }
+
+  /* The statements that update a summary table must not touch another one */
+  for (vector<Definition>::const_iterator it= definitions.begin(); it != definitions.end(); ++it)
+  {
+    for (vector<Definition>::const_iterator summary= definitions.begin(); summary != definitions.end(); ++summary)
+    {
+      if (it->select.schema == summary->schema && it->select.table == summary->table)
+      {
+        error= it->schema + "." + it->table + ": the base table is a summary table";
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+Definitions definitions()
+{
+  boost::mutex::scoped_lock lock(definitions_mutex);
+  return current_definitions;
+}
+
+void set_definitions(Definitions arg)
+{
+  boost::mutex::scoped_lock lock(definitions_mutex);
+  current_definitions= arg;
+}
+
+string quote_identifier(const string &name)
+{
+  string result("`");
+  for (string::const_iterator it= name.begin(); it != name.end(); ++it)
+  {
+    if (*it == '`')
+      result.push_back('`');
+    result.push_back(*it);
+  }
+  result.push_back('`');
+  return result;
+}
+
+string quote_string(const char *str, size_t length)
+{
+  string result("'");
+  for (const char *end= str + length; str < end; str++)
+  {
+    switch (*str)
+    {
+    case '\0':
+      result.append("\\0");
+      break;
+    case '\\':
+    case '\'':
+    case ';': /* Execute splits statements on semicolons that are not escaped */
+      result.push_back('\\');
+      result.push_back(*str);
+      break;
+    default:
+      result.push_back(*str);
+    }
+  }
+  result.push_back('\'');
+  return result;
+}
+
+} /* namespace summary_table */
+} /* namespace drizzle_plugin */
@@ -0,0 +1,125 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#pragma once
+
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+namespace drizzle_plugin {
+namespace summary_table {
+
+/** One item of the select list of a summary query */
+struct Item
+{
+  enum Kind { GROUP, COUNT_ROWS, COUNT, SUM, MIN, MAX };
+
+  Kind kind;
+  std::string column; /**< Column of the base table, empty for COUNT(*) */
+  std::string text; /**< The item as the query wrote it */
+
+  /** The item in the form queries are matched on */
+  std::string canonical() const;
+};
+
+/**
+  An aggregate query over one table, restricted to what a summary table
+  can hold:
+
+    SELECT item [, item ...] FROM [schema.]table [GROUP BY column [, column ...]]
+
+  where an item is a grouped column, COUNT(*) or COUNT, SUM, MIN or MAX
+  of a column. Identifiers are kept in lower case.
+*/
+struct Select
+{
+  std::string schema;
+  std::string table;
+  std::vector<Item> items;
+  std::vector<std::string> group_by;
+
+  /**
+    Parse a query, taking tables without a schema from schema.
+
+    @retval true  The query is not a summary query
+    @retval false OK
+  */
+  bool parse(const std::string &query, const std::string &default_schema);
+
+  /** Index of the item with the canonical form of item, -1 if none */
+  int find(const Item &item) const;
+};
+
+/**
+  A summary table and the query whose result it holds. Each column of
+  the summary table listed in columns holds the select item at the same
+  position, and the grouped columns form a unique key of the table.
+*/
+struct Definition
+{
+  std::string schema;
+  std::string table;
+  std::vector<std::string> columns;
+  Select select;
+  std::vector<size_t> group_items; /**< Item of each GROUP BY column */
+
+  /** Summary column holding item */
+  const std::string &column(size_t item) const
+  {
+    return columns[item];
+  }
+};
+
+typedef boost::shared_ptr<const std::vector<Definition> > Definitions;
+
+/**
+  Parse summary table definitions separated by semicolons, each written
+
+    schema.summary (column [, column ...]) = SELECT ...
+
+  The base table defaults to the schema of the summary table.
+
+  @retval true  Error, described in error
+  @retval false OK
+*/
+bool parse_definitions(const std::string &text, std::vector<Definition> &definitions,
+                       std::string &error);
+
+/** The definitions in use */
+Definitions definitions();
+
+void set_definitions(Definitions arg);
+
+/**
+  Whether queries may be answered from the summary table: no transaction
+  has changes that are not written to it yet, and its last write
+  succeeded. Kept by the Observer.
+*/
+bool current(const Definition &definition);
+
+/** Quote an identifier for a statement */
+std::string quote_identifier(const std::string &name);
+
+/** Quote a string literal for a statement run by drizzled::Execute */
+std::string quote_string(const char *str, size_t length);
+
+} /* namespace summary_table */
+} /* namespace drizzle_plugin */
@@ -0,0 +1,143 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#include <boost/program_options.hpp>
+#include <drizzled/catalog/local.h>
+#include <drizzled/errmsg_print.h>
+#include <drizzled/item.h>
+#include <drizzled/module/option_map.h>
+#include <drizzled/plugin.h>
+#include <drizzled/session.h>
+#include <drizzled/sql_base.h>
+#include <drizzled/table/cache.h>
+
+#include "definition.h"
+#include "observer.h"
+#include "rewriter.h"
+
+namespace po= boost::program_options;
+using namespace std;
+using namespace drizzled;
+
+namespace drizzle_plugin {
+namespace summary_table {
+
+static string sysvar_definitions;
+static bool sysvar_rewrite;
+static Rewriter *rewriter= NULL;
+
+static int check_definitions(Session *, set_var *var)
+{
+  const char *text= var->value->str_value.ptr();
+  if (not text)
+    return 1;
+
+  vector<Definition> list;
+  string error;
+  if (parse_definitions(text, list, error))
+  {
+    errmsg_printf(error::ERROR, _("summary_table: %s"), error.c_str());
+    return 1;
+  }
+  return 0;
+}
+
+/**
+  Install new definitions. Base tables that are open without the observer
+  get it once they are opened again, so the ones that are not in use are
+  closed right away, and the summary tables are aggregated from scratch.
+*/
+static bool update_definitions(Session *session, set_var *var)
+{
+  const char *text= var->value->str_value.ptr();
+  boost::shared_ptr<vector<Definition> > list(new vector<Definition>);
+  string error;
+  if (parse_definitions(text, *list, error))
+    return true;
+
+  set_definitions(list);
+  sysvar_definitions= text;
+
+  {
+    boost::mutex::scoped_lock scoped_lock(table::Cache::mutex());
+    for (vector<Definition>::const_iterator it= list->begin(); it != list->end(); ++it)
+    {
+      identifier::Table base(session->catalog().identifier(), it->select.schema, it->select.table);
+      table::Cache::removeTable(*session, base, RTFC_NO_FLAG);
+    }
+  }
+  return Observer::refresh(*session, *list);
+}
+
+static int init(module::Context &context)
+{
+  vector<Definition> *list= new vector<Definition>;
+  string error;
+  if (parse_definitions(sysvar_definitions, *list, error))
+  {
+    delete list;
+    errmsg_printf(error::ERROR, _("summary_table: %s"), error.c_str());
+    return 1;
+  }
+  set_definitions(Definitions(list));
+  /* Transactions committed before a restart may not be in the summary tables */
+  Observer::invalidate(*list);
+
+  rewriter= new Rewriter;
+  rewriter->enabled= sysvar_rewrite;
+  context.add(new Observer);
+  context.add(rewriter);
+
+  context.registerVariable(new sys_var_std_string("definitions",
+                                                  sysvar_definitions,
+                                                  check_definitions,
+                                                  update_definitions));
+  context.registerVariable(new sys_var_bool_ptr("rewrite", &rewriter->enabled));
+  return 0;
+}
+
+static void init_options(drizzled::module::option_context &context)
+{
+  context("definitions",
+          po::value<string>(&sysvar_definitions)->default_value(""),
+          N_("Summary tables to maintain, separated by semicolons, each written as "
+             "schema.summary(column, ...)=SELECT ... FROM base GROUP BY ..."));
+  context("rewrite",
+          po::value<bool>(&sysvar_rewrite)->default_value(true),
+          N_("Answer matching aggregate queries from summary tables"));
+}
+
+} /* namespace summary_table */
+} /* namespace drizzle_plugin */
+
+DRIZZLE_DECLARE_PLUGIN
+{
+  DRIZZLE_VERSION_ID,
+  "summary_table",
+  "0.1",
+  "Drizzle Developer Group",
+  N_("Aggregate summary tables maintained from row events"),
+  PLUGIN_LICENSE_GPL,
+  drizzle_plugin::summary_table::init,
+  NULL,
+  drizzle_plugin::summary_table::init_options
+}
+DRIZZLE_DECLARE_PLUGIN_END;
@@ -0,0 +1,889 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#include <drizzled/errmsg_print.h>
+#include <drizzled/field.h>
+#include <drizzled/gettext.h>
+#include <drizzled/session.h>
+#include <drizzled/execute.h>
+#include <drizzled/sql/result_set.h>
+#include <drizzled/sql_lex.h>
+#include <drizzled/table.h>
+#include <drizzled/table/instance/base.h>
+#include <drizzled/util/storable.h>
+
+#include "observer.h"
+
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <map>
+
+using namespace std;
+using drizzled::Field;
+using drizzled::Session;
+using drizzled::String;
+using drizzled::Table;
+using drizzled::TableShare;
+
+namespace drizzle_plugin {
+namespace summary_table {
+
+const size_t Observer::MAX_GROUPS;
+const size_t Observer::GROUPS_PER_STATEMENT;
+
+namespace {
+
+const char *PROPERTY= "summary_table";
+
+/* How one definition reads the rows of an open base table */
+struct Binding
+{
+  size_t definition;
+  bool exact; /**< Groups can be found by the text of their keys */
+  bool delta; /**< Inserted rows can be added to the summary rows */
+  vector<Field *> fields; /**< Column of each item, NULL for COUNT(*) */
+};
+
+/* What the inserted rows of a group add to one aggregate */
+struct Value
+{
+  Value() : count(0), has_value(false) {}
+
+  int64_t count;
+  bool has_value;
+  string text; /**< The sum, or the minimum or maximum as a literal */
+  string raw; /**< The minimum or maximum in the record format of the field */
+};
+
+struct Group
+{
+  Group() : recompute(false) {}
+
+  bool recompute;
+  vector<Value> values;
+};
+
+/* Literals of the grouped columns, in GROUP BY order */
+typedef vector<string> Key;
+typedef map<Key, Group> Groups;
+
+/* How the maintenance of one summary table stands, shared by the sessions writing it */
+struct State
+{
+  State() : writers(0), generation(0), invalid(false) {}
+
+  boost::mutex mutex; /**< Held while the summary table is written */
+  size_t writers; /**< Transactions whose changes are not in the summary table yet */
+  uint64_t generation; /**< Times groups were aggregated again from the base table */
+  bool invalid; /**< The last write failed */
+};
+
+typedef boost::shared_ptr<State> StatePtr;
+
+/* Guards the map and the counters of the states */
+boost::mutex states_mutex;
+map<string, StatePtr> states;
+
+StatePtr find_state(const Definition &definition)
+{
+  boost::mutex::scoped_lock lock(states_mutex);
+  StatePtr &result= states[definition.schema + "." + definition.table];
+  if (not result)
+    result.reset(new State);
+  return result;
+}
+
+struct Summary
+{
+  Summary() : refresh(false), generation(0) {}
+
+  bool refresh;
+  Groups groups;
+  StatePtr state; /**< Set once the transaction changed the base table */
+  uint64_t generation; /**< Of the state when the transaction first changed the base table */
+};
+
+/* The value of a field as a literal */
+string literal(Field *field)
+{
+  if (field->is_null())
+    return "NULL";
+
+  String str;
+  field->val_str_internal(&str);
+  switch (field->result_type())
+  {
+  case INT_RESULT:
+  case DECIMAL_RESULT:
+    return string(str.ptr(), str.length());
+  default:
+    return quote_string(str.ptr(), str.length());
+  }
+}
+
+string decimal_text(const drizzled::type::Decimal &value)
+{
+  String str;
+  drizzled::class_decimal2string(&value, 0, &str);
+  return string(str.ptr(), str.length());
+}
+
+/* Point the fields of table at row for as long as the object lives */
+class RowPosition
+{
+public:
+  RowPosition(Table &table_arg, const unsigned char *row) :
+    table(table_arg),
+    offset(row - table_arg.getInsertRecord())
+  {
+    move(offset);
+  }
+
+  ~RowPosition()
+  {
+    move(-offset);
+  }
+
+private:
+  void move(ptrdiff_t diff)
+  {
+    if (not diff)
+      return;
+    for (Field **field= table.getFields(); *field; field++)
+      (*field)->move_field_offset(diff);
+  }
+
+  Table &table;
+  ptrdiff_t offset;
+};
+
+/* The changes a transaction made to the summaries */
+class Deltas : public drizzled::util::Storable
+{
+public:
+  Definitions definitions;
+  vector<Summary> summaries;
+
+  ~Deltas()
+  {
+    clear();
+  }
+
+  void start()
+  {
+    if (definitions)
+      return;
+    definitions= summary_table::definitions();
+    summaries.resize(definitions->size());
+  }
+
+  void clear()
+  {
+    for (vector<Summary>::iterator summary= summaries.begin(); summary != summaries.end(); ++summary)
+    {
+      if (not summary->state)
+        continue;
+      boost::mutex::scoped_lock lock(states_mutex);
+      summary->state->writers--;
+    }
+    definitions.reset();
+    summaries.clear();
+    bindings.clear();
+  }
+
+  /* The bindings only hold while the tables of a statement are open */
+  void end_statement()
+  {
+    bindings.clear();
+  }
+
+  void recompute_all()
+  {
+    for (vector<Summary>::iterator summary= summaries.begin(); summary != summaries.end(); ++summary)
+    {
+      for (Groups::iterator group= summary->groups.begin(); group != summary->groups.end(); ++group)
+        group->second.recompute= true;
+    }
+  }
+
+  void change(Table &table, const unsigned char *row, bool inserted);
+  void update(Table &table, const unsigned char *old_row, const unsigned char *new_row);
+
+private:
+  const vector<Binding> &bind(Table &table);
+  void add(const Definition &definition, const Binding &binding, Group &group);
+
+  map<Table *, vector<Binding> > bindings;
+};
+
+const vector<Binding> &Deltas::bind(Table &table)
+{
+  map<Table *, vector<Binding> >::iterator found= bindings.find(&table);
+  if (found != bindings.end())
+    return found->second;
+
+  vector<Binding> &result= bindings[&table];
+  string schema= boost::to_lower_copy(string(table.getShare()->getSchemaName()));
+  string name= boost::to_lower_copy(string(table.getShare()->getTableName()));
+
+  for (size_t x= 0; x < definitions->size(); x++)
+  {
+    const Definition &definition= (*definitions)[x];
+    if (definition.select.schema != schema || definition.select.table != name)
+      continue;
+
+    Binding binding;
+    binding.definition= x;
+    binding.exact= true;
+    binding.delta= true;
+    for (vector<Item>::const_iterator item= definition.select.items.begin();
+         item != definition.select.items.end(); ++item)
+    {
+      Field *field= NULL;
+      if (item->kind != Item::COUNT_ROWS)
+      {
+        for (Field **it= table.getFields(); *it && not field; it++)
+        {
+          if (boost::iequals(item->column, (*it)->field_name))
+            field= *it;
+        }
+        if (not field)
+        {
+          drizzled::errmsg_printf(drizzled::error::ERROR,
+                                  _("summary_table: %s.%s has no column %s, %s.%s is not maintained"),
+                                  schema.c_str(), name.c_str(), item->column.c_str(),
+                                  definition.schema.c_str(), definition.table.c_str());
+          break;
+        }
+
+        switch (item->kind)
+        {
+        case Item::GROUP:
+          /* Floating point keys may not read back as the text they print as */
+          if (field->result_type() == REAL_RESULT)
+            binding.exact= false;
+          break;
+        case Item::SUM:
+          if (field->result_type() != INT_RESULT &&
+              field->result_type() != DECIMAL_RESULT)
+            binding.delta= false;
+          break;
+        case Item::MIN:
+        case Item::MAX:
+          if (field->type() == drizzled::DRIZZLE_TYPE_BLOB)
+            binding.delta= false;
+          break;
+        default:
+          break;
+        }
+      }
+      binding.fields.push_back(field);
+    }
+
+    if (binding.fields.size() == definition.select.items.size())
+      result.push_back(binding);
+  }
+  return result;
+}
+
+void Deltas::change(Table &table, const unsigned char *row, bool inserted)
+{
+  const vector<Binding> &list= bind(table);
+  if (list.empty())
+    return;
+
+  RowPosition position(table, row);
+  for (vector<Binding>::const_iterator binding= list.begin(); binding != list.end(); ++binding)
+  {
+    const Definition &definition= (*definitions)[binding->definition];
+    Summary &summary= summaries[binding->definition];
+    if (not summary.state)
+    {
+      summary.state= find_state(definition);
+      boost::mutex::scoped_lock lock(states_mutex);
+      summary.state->writers++;
+      summary.generation= summary.state->generation;
+    }
+    if (summary.refresh)
+      continue;
+    if (not binding->exact || definition.group_items.empty())
+    {
+      summary.refresh= true;
+      summary.groups.clear();
+      continue;
+    }
+
+    Key key;
+    bool null_key= false;
+    for (vector<size_t>::const_iterator it= definition.group_items.begin();
+         it != definition.group_items.end(); ++it)
+    {
+      Field *field= binding->fields[*it];
+      null_key|= field->is_null();
+      key.push_back(literal(field));
+    }
+
+    Group &group= summary.groups[key];
+    /* A unique key does not stop summary rows with NULL keys from being duplicated */
+    if (not inserted || not binding->delta || null_key)
+      group.recompute= true;
+    else if (not group.recompute)
+      add(definition, *binding, group);
+
+    if (summary.groups.size() > Observer::MAX_GROUPS)
+    {
+      summary.refresh= true;
+      summary.groups.clear();
+    }
+  }
+}
+
+void Deltas::add(const Definition &definition, const Binding &binding, Group &group)
+{
+  group.values.resize(definition.select.items.size());
+  for (size_t x= 0; x < definition.select.items.size(); x++)
+  {
+    Value &value= group.values[x];
+    Field *field= binding.fields[x];
+    Item::Kind kind= definition.select.items[x].kind;
+    if (kind == Item::COUNT_ROWS)
+    {
+      value.count++;
+      continue;
+    }
+    if (kind == Item::GROUP || field->is_null())
+      continue;
+
+    switch (kind)
+    {
+    case Item::COUNT:
+      value.count++;
+      break;
+
+    case Item::SUM:
+      {
+        drizzled::type::Decimal buffer;
+        drizzled::type::Decimal *decimal= field->val_decimal(&buffer);
+        if (value.has_value)
+        {
+          drizzled::type::Decimal sum, previous;
+          previous.store(E_DEC_FATAL_ERROR, value.text.data(), value.text.size(),
+                         &drizzled::my_charset_bin);
+          drizzled::class_decimal_add(E_DEC_FATAL_ERROR, &sum, &previous, decimal);
+          value.text= decimal_text(sum);
+        }
+        else
+        {
+          value.text= decimal_text(*decimal);
+        }
+        value.has_value= true;
+        break;
+      }
+
+    case Item::MIN:
+    case Item::MAX:
+      {
+        int cmp= value.has_value ? field->cmp(field->ptr, (const unsigned char *) value.raw.data()) : 0;
+        if (not value.has_value || (kind == Item::MIN ? cmp < 0 : cmp > 0))
+        {
+          value.raw.assign((const char *) field->ptr, field->pack_length());
+          value.text= literal(field);
+          value.has_value= true;
+        }
+        break;
+      }
+
+    default:
+      break;
+    }
+  }
+}
+
+void Deltas::update(Table &table, const unsigned char *old_row, const unsigned char *new_row)
+{
+  const vector<Binding> &list= bind(table);
+  bool changed= false;
+  for (vector<Binding>::const_iterator binding= list.begin(); binding != list.end() && not changed; ++binding)
+  {
+    for (vector<Field *>::const_iterator it= binding->fields.begin(); it != binding->fields.end(); ++it)
+    {
+      Field *field= *it;
+      if (not field)
+        continue;
+      bool old_null= field->is_null_in_record(old_row);
+      if (old_null != field->is_null_in_record(new_row))
+      {
+        changed= true;
+        break;
+      }
+      uint32_t offset= field->offset(table.getInsertRecord());
+      if (not old_null && field->cmp(old_row + offset, new_row + offset))
+      {
+        changed= true;
+        break;
+      }
+    }
+  }
+
+  /* Rows whose summarized columns stay the same leave the summaries as they are */
+  if (not changed)
+    return;
+  change(table, old_row, false);
+  change(table, new_row, false);
+}
+
+string target(const Definition &definition)
+{
+  return quote_identifier(definition.schema) + "." + quote_identifier(definition.table);
+}
+
+/* INSERT INTO summary (columns) SELECT items FROM base */
+string insert_select(const Definition &definition)
+{
+  string columns, items;
+  for (size_t x= 0; x < definition.select.items.size(); x++)
+  {
+    const Item &item= definition.select.items[x];
+    if (x)
+    {
+      columns.append(", ");
+      items.append(", ");
+    }
+    columns.append(quote_identifier(definition.column(x)));
+    switch (item.kind)
+    {
+    case Item::GROUP:
+      items.append(quote_identifier(item.column));
+      break;
+    case Item::COUNT_ROWS:
+      items.append("COUNT(*)");
+      break;
+    case Item::COUNT:
+      items.append("COUNT(" + quote_identifier(item.column) + ")");
+      break;
+    case Item::SUM:
+      items.append("SUM(" + quote_identifier(item.column) + ")");
+      break;
+    case Item::MIN:
+      items.append("MIN(" + quote_identifier(item.column) + ")");
+      break;
+    case Item::MAX:
+      items.append("MAX(" + quote_identifier(item.column) + ")");
+      break;
+    }
+  }
+  return "INSERT INTO " + target(definition) + " (" + columns + ") SELECT " + items +
+    " FROM " + quote_identifier(definition.select.schema) + "." +
+    quote_identifier(definition.select.table);
+}
+
+string group_by(const Definition &definition)
+{
+  string result;
+  for (size_t x= 0; x < definition.select.group_by.size(); x++)
+  {
+    result.append(x ? ", " : " GROUP BY ");
+    result.append(quote_identifier(definition.select.group_by[x]));
+  }
+  return result;
+}
+
+/* Rows of the groups, of the summary table or of the base table */
+string condition(const Definition &definition, const vector<const Key *> &keys, bool summary)
+{
+  string result;
+  for (vector<const Key *>::const_iterator key= keys.begin(); key != keys.end(); ++key)
+  {
+    result.append(key == keys.begin() ? "(" : " OR (");
+    for (size_t x= 0; x < definition.group_items.size(); x++)
+    {
+      if (x)
+        result.append(" AND ");
+      result.append(quote_identifier(summary ? definition.column(definition.group_items[x]) :
+                                     definition.select.group_by[x]));
+      result.append(" <=> ");
+      result.append((**key)[x]);
+    }
+    result.push_back(')');
+  }
+  return result;
+}
+
+void recompute(const Definition &definition, const vector<const Key *> &keys,
+               vector<string> &statements)
+{
+  statements.push_back("DELETE FROM " + target(definition) + " WHERE " +
+                       condition(definition, keys, true));
+  statements.push_back(insert_select(definition) + " WHERE " +
+                       condition(definition, keys, false) + group_by(definition));
+}
+
+/* Add the inserted rows to the summary rows, creating missing ones */
+void add_rows(const Definition &definition, const vector<Groups::const_iterator> &groups,
+              vector<string> &statements)
+{
+  const vector<Item> &items= definition.select.items;
+  string columns, update;
+  for (size_t x= 0; x < items.size(); x++)
+  {
+    string column= quote_identifier(definition.column(x));
+    string value= "VALUES(" + column + ")";
+    columns.append(x ? ", " : "").append(column);
+    if (items[x].kind == Item::GROUP)
+      continue;
+
+    update.append(update.empty() ? "" : ", ").append(column).append("= ");
+    switch (items[x].kind)
+    {
+    case Item::COUNT_ROWS:
+    case Item::COUNT:
+      update.append(column + " + " + value);
+      break;
+    case Item::SUM:
+      update.append("IFNULL(" + column + " + " + value + ", IFNULL(" + column + ", " + value + "))");
+      break;
+    case Item::MIN:
+      update.append("IFNULL(LEAST(" + column + ", " + value + "), IFNULL(" + column + ", " + value + "))");
+      break;
+    case Item::MAX:
+      update.append("IFNULL(GREATEST(" + column + ", " + value + "), IFNULL(" + column + ", " + value + "))");
+      break;
+    case Item::GROUP:
+      break;
+    }
+  }
+  if (update.empty())
+  {
+    string column= quote_identifier(definition.column(definition.group_items[0]));
+    update= column + "= " + column;
+  }
+
+  string rows;
+  for (vector<Groups::const_iterator>::const_iterator it= groups.begin(); it != groups.end(); ++it)
+  {
+    const Key &key= (*it)->first;
+    const Group &group= (*it)->second;
+    rows.append(it == groups.begin() ? "(" : ", (");
+    for (size_t x= 0; x < items.size(); x++)
+    {
+      if (x)
+        rows.append(", ");
+      const Value &value= group.values[x];
+      switch (items[x].kind)
+      {
+      case Item::GROUP:
+        rows.append(key[find(definition.group_items.begin(), definition.group_items.end(), x) -
+                        definition.group_items.begin()]);
+        break;
+      case Item::COUNT_ROWS:
+      case Item::COUNT:
+        rows.append(boost::lexical_cast<string>(value.count));
+        break;
+      default:
+        rows.append(value.has_value ? value.text : "NULL");
+      }
+    }
+    rows.push_back(')');
+  }
+
+  statements.push_back("INSERT INTO " + target(definition) + " (" + columns + ") VALUES " + rows +
+                       " ON DUPLICATE KEY UPDATE " + update);
+}
+
+void refresh_statements(const Definition &definition, vector<string> &statements)
+{
+  statements.push_back("DELETE FROM " + target(definition));
+  statements.push_back(insert_select(definition) + group_by(definition));
+}
+
+/* Run statements in one transaction of a session of their own */
+bool run(Session &session, const vector<string> &statements)
+{
+  if (statements.empty())
+    return false;
+
+  string sql= boost::join(statements, "; ");
+  if (not session.isConcurrentExecuteAllowed())
+  {
+    drizzled::errmsg_printf(drizzled::error::ERROR,
+                            _("summary_table: session %" PRIu64 " can not update summary tables: %s"),
+                            session.getSessionId(), sql.c_str());
+    return true;
+  }
+
+  drizzled::Execute execute(session, true);
+  drizzled::sql::ResultSet result_set(1);
+  execute.run(sql, result_set);
+
+  drizzled::error_t err= result_set.getException().getErrorCode();
+  if (err != drizzled::EE_OK && err != drizzled::ER_EMPTY_QUERY)
+  {
+    drizzled::errmsg_printf(drizzled::error::ERROR, _("summary_table: %s while running: %s"),
+                            result_set.getException().getErrorMessage().c_str(), sql.c_str());
+    return true;
+  }
+  return false;
+}
+
+/*
+  Statements writing the changes of a transaction to one summary table.
+  With recompute_inserted the groups that only gained rows are
+  aggregated again as well.
+*/
+void summary_statements(const Definition &definition, const Summary &summary,
+                        bool recompute_inserted, vector<string> &statements)
+{
+  if (summary.refresh)
+  {
+    refresh_statements(definition, statements);
+    return;
+  }
+
+  vector<const Key *> keys;
+  vector<Groups::const_iterator> inserted;
+  for (Groups::const_iterator group= summary.groups.begin(); group != summary.groups.end(); ++group)
+  {
+    if (group->second.recompute || recompute_inserted)
+    {
+      keys.push_back(&group->first);
+      if (keys.size() == Observer::GROUPS_PER_STATEMENT)
+      {
+        recompute(definition, keys, statements);
+        keys.clear();
+      }
+    }
+    else
+    {
+      inserted.push_back(group);
+      if (inserted.size() == Observer::GROUPS_PER_STATEMENT)
+      {
+        add_rows(definition, inserted, statements);
+        inserted.clear();
+      }
+    }
+  }
+  if (not keys.empty())
+    recompute(definition, keys, statements);
+  if (not inserted.empty())
+    add_rows(definition, inserted, statements);
+}
+
+/*
+  Write statements to the summary table of state, one session at a time.
+  aggregated tells whether they aggregate groups again from the base
+  table, refresh whether they rebuild the whole summary table.
+*/
+bool write_summary(Session &session, const Definition &definition, State &state,
+                   const vector<string> &statements, bool aggregated, bool refresh)
+{
+  bool failed= run(session, statements);
+
+  boost::mutex::scoped_lock lock(states_mutex);
+  if (aggregated)
+    state.generation++;
+  if (failed)
+  {
+    if (not state.invalid)
+      drizzled::errmsg_printf(drizzled::error::ERROR,
+                              _("summary_table: %s.%s is not read until it is aggregated again"),
+                              definition.schema.c_str(), definition.table.c_str());
+    state.invalid= true;
+  }
+  else if (refresh)
+  {
+    state.invalid= false;
+  }
+  return failed;
+}
+
+void apply(Session &session, Deltas &deltas)
+{
+  for (size_t x= 0; x < deltas.summaries.size(); x++)
+  {
+    const Definition &definition= (*deltas.definitions)[x];
+    Summary &summary= deltas.summaries[x];
+    if (not summary.state)
+      continue;
+
+    State &state= *summary.state;
+    boost::mutex::scoped_lock lock(state.mutex);
+    bool recompute_inserted;
+    {
+      boost::mutex::scoped_lock states_lock(states_mutex);
+      /* A summary table whose last write failed is rebuilt as a whole */
+      summary.refresh|= state.invalid;
+      /*
+        Groups aggregated again since the transaction began may already
+        count the rows it inserted, adding them would count them twice.
+      */
+      recompute_inserted= state.generation != summary.generation;
+    }
+
+    vector<string> statements;
+    summary_statements(definition, summary, recompute_inserted, statements);
+    bool aggregated= summary.refresh || recompute_inserted;
+    for (Groups::const_iterator group= summary.groups.begin(); group != summary.groups.end() && not aggregated; ++group)
+      aggregated= group->second.recompute;
+    write_summary(session, definition, state, statements, aggregated, summary.refresh);
+  }
+}
+
+void observe_statement(Session &session)
+{
+  Deltas *deltas= session.getProperty<Deltas>(PROPERTY);
+  if (not deltas || not deltas->definitions)
+    return;
+
+  deltas->end_statement();
+  switch (session.lex().sql_command)
+  {
+  case drizzled::SQLCOM_ROLLBACK:
+    deltas->clear();
+    return;
+  case drizzled::SQLCOM_ROLLBACK_TO_SAVEPOINT:
+    deltas->recompute_all();
+    break;
+  default:
+    /* Rows written before the error may or may not have been kept */
+    if (session.is_error())
+      deltas->recompute_all();
+  }
+
+  if (session.inTransaction())
+    return;
+  apply(session, *deltas);
+  deltas->clear();
+}
+
+Deltas &session_deltas(Session &session)
+{
+  Deltas *deltas= session.getProperty<Deltas>(PROPERTY);
+  if (not deltas)
+    deltas= session.setProperty(PROPERTY, new Deltas);
+  deltas->start();
+  return *deltas;
+}
+
+} /* namespace */
+
+Observer::Observer() :
+  drizzled::plugin::EventObserver("summary_table")
+{ }
+
+void Observer::registerTableEventsDo(TableShare &table_share,
+                                     drizzled::plugin::EventObserverList &observers)
+{
+  if (table_share.getType() != drizzled::message::Table::STANDARD)
+    return;
+
+  string schema= boost::to_lower_copy(string(table_share.getSchemaName()));
+  string name= boost::to_lower_copy(string(table_share.getTableName()));
+  Definitions list= definitions();
+  for (std::vector<Definition>::const_iterator it= list->begin(); it != list->end(); ++it)
+  {
+    if (it->select.schema == schema && it->select.table == name)
+    {
+      registerEvent(observers, AFTER_INSERT_RECORD);
+      registerEvent(observers, AFTER_UPDATE_RECORD);
+      registerEvent(observers, AFTER_DELETE_RECORD);
+      return;
+    }
+  }
+}
+
+void Observer::registerSessionEventsDo(Session &, drizzled::plugin::EventObserverList &observers)
+{
+  registerEvent(observers, AFTER_STATEMENT);
+}
+
+bool Observer::observeEventDo(drizzled::plugin::EventData &data)
+{
+  switch (data.event)
+  {
+  case AFTER_INSERT_RECORD:
+    {
+      drizzled::plugin::AfterInsertRecordEventData &event= (drizzled::plugin::AfterInsertRecordEventData &) data;
+      if (not event.err)
+        session_deltas(event.session).change(event.table, event.row, true);
+      break;
+    }
+
+  case AFTER_UPDATE_RECORD:
+    {
+      drizzled::plugin::AfterUpdateRecordEventData &event= (drizzled::plugin::AfterUpdateRecordEventData &) data;
+      if (not event.err)
+        session_deltas(event.session).update(event.table, event.old_row, event.new_row);
+      break;
+    }
+
+  case AFTER_DELETE_RECORD:
+    {
+      drizzled::plugin::AfterDeleteRecordEventData &event= (drizzled::plugin::AfterDeleteRecordEventData &) data;
+      if (not event.err)
+        session_deltas(event.session).change(event.table, event.row, false);
+      break;
+    }
+
+  case AFTER_STATEMENT:
+    observe_statement(((drizzled::plugin::AfterStatementEventData &) data).session);
+    break;
+
+  default:
+    break;
+  }
+  return false;
+}
+
+bool Observer::refresh(Session &session, const std::vector<Definition> &list)
+{
+  bool failed= false;
+  for (std::vector<Definition>::const_iterator it= list.begin(); it != list.end(); ++it)
+  {
+    StatePtr state= find_state(*it);
+    boost::mutex::scoped_lock lock(state->mutex);
+    std::vector<string> statements;
+    refresh_statements(*it, statements);
+    failed|= write_summary(session, *it, *state, statements, true, true);
+  }
+  return failed;
+}
+
+void Observer::invalidate(const std::vector<Definition> &list)
+{
+  for (std::vector<Definition>::const_iterator it= list.begin(); it != list.end(); ++it)
+  {
+    StatePtr state= find_state(*it);
+    boost::mutex::scoped_lock lock(states_mutex);
+    state->invalid= true;
+  }
+}
+
+bool current(const Definition &definition)
+{
+  boost::mutex::scoped_lock lock(states_mutex);
+  map<string, StatePtr>::const_iterator found= states.find(definition.schema + "." + definition.table);
+  return found == states.end() || (not found->second->writers && not found->second->invalid);
+}
+
+} /* namespace summary_table */
+} /* namespace drizzle_plugin */
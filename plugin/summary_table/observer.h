@@ -0,0 +1,83 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#pragma once
+
+#include <drizzled/plugin/event_observer.h>
+
+#include "definition.h"
+
+namespace drizzle_plugin {
+namespace summary_table {
+
+/**
+  Keeps summary tables up to date with the rows written to their base
+  tables.
+
+  The row events of a transaction are collected per summary group. When
+  the transaction commits, the collected changes are written to each
+  summary table by a session of its own, one writing session per summary
+  table at a time: groups
+  that only gained rows get their counts, sums, minimums and maximums
+  added with INSERT ... ON DUPLICATE KEY UPDATE, and groups that lost or
+  changed rows are aggregated again from the base table. A rollback drops
+  the changes, and after a failed statement or a rollback to a savepoint
+  every group the transaction touched is aggregated again. So are the
+  groups that only gained rows when groups of the summary table were
+  aggregated again since the transaction began, as those may already
+  count its rows. A summary table whose write failed is rebuilt as a
+  whole by the next transaction writing it.
+*/
+class Observer : public drizzled::plugin::EventObserver
+{
+public:
+  /** Groups of one summary a transaction may touch before the summary is rebuilt as a whole */
+  static const size_t MAX_GROUPS= 10000;
+
+  /** Groups one statement that updates a summary table covers */
+  static const size_t GROUPS_PER_STATEMENT= 100;
+
+  Observer();
+
+  void registerTableEventsDo(drizzled::TableShare &table_share,
+                             drizzled::plugin::EventObserverList &observers);
+  void registerSessionEventsDo(drizzled::Session &session,
+                               drizzled::plugin::EventObserverList &observers);
+
+  bool observeEventDo(drizzled::plugin::EventData &data);
+
+  /**
+    Aggregate the summary tables again from their base tables.
+
+    @retval true  Error, written to the error log
+    @retval false OK
+  */
+  static bool refresh(drizzled::Session &session, const std::vector<Definition> &list);
+
+  /**
+    Mark the summary tables as not current until they are aggregated
+    again. Their state is only kept in memory, so a server that starts
+    can not tell whether a transaction committed before it stopped was
+    written to them.
+  */
+  static void invalidate(const std::vector<Definition> &list);
+};
+
+} /* namespace summary_table */
+} /* namespace drizzle_plugin */
@@ -0,0 +1,107 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#include "rewriter.h"
+
+#include <algorithm>
+#include <strings.h>
+
+using namespace std;
+
+namespace drizzle_plugin {
+namespace summary_table {
+
+namespace {
+
+bool same_groups(const Select &a, const Select &b)
+{
+  if (a.group_by.size() != b.group_by.size())
+    return false;
+  for (vector<string>::const_iterator it= a.group_by.begin(); it != a.group_by.end(); ++it)
+  {
+    if (find(b.group_by.begin(), b.group_by.end(), *it) == b.group_by.end())
+      return false;
+  }
+  return true;
+}
+
+string rewritten(const Definition &definition, const Select &query)
+{
+  string result("SELECT ");
+  for (size_t x= 0; x < query.items.size(); x++)
+  {
+    if (x)
+      result.append(", ");
+    result.append(quote_identifier(definition.column(definition.select.find(query.items[x]))));
+    result.append(" AS ");
+    result.append(quote_identifier(query.items[x].text));
+  }
+  result.append(" FROM ");
+  result.append(quote_identifier(definition.schema));
+  result.push_back('.');
+  result.append(quote_identifier(definition.table));
+
+  for (size_t x= 0; x < query.group_by.size(); x++)
+  {
+    Item group;
+    group.kind= Item::GROUP;
+    group.column= query.group_by[x];
+    result.append(x ? ", " : " ORDER BY ");
+    result.append(quote_identifier(definition.column(definition.select.find(group))));
+  }
+  return result;
+}
+
+} /* namespace */
+
+void Rewriter::rewrite(const string &schema, string &to_rewrite)
+{
+  /* Most statements are no aggregate queries, tell them apart quickly */
+  if (not enabled || to_rewrite.size() < 6 || strncasecmp(to_rewrite.c_str(), "select", 6))
+    return;
+
+  Definitions list= definitions();
+  if (list->empty())
+    return;
+
+  Select query;
+  if (query.parse(to_rewrite, schema))
+    return;
+
+  for (std::vector<Definition>::const_iterator it= list->begin(); it != list->end(); ++it)
+  {
+    if (it->select.schema != query.schema || it->select.table != query.table ||
+        not same_groups(it->select, query))
+      continue;
+
+    bool covered= true;
+    for (std::vector<Item>::const_iterator item= query.items.begin(); item != query.items.end() && covered; ++item)
+      covered= it->select.find(*item) >= 0;
+    if (covered && current(*it))
+    {
+      to_rewrite= rewritten(*it, query);
+      return;
+    }
+  }
+}
+
+} /* namespace summary_table */
+} /* namespace drizzle_plugin */
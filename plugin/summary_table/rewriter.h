@@ -0,0 +1,53 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#pragma once
+
+#include <drizzled/plugin/query_rewrite.h>
+
+#include "definition.h"
+
+namespace drizzle_plugin {
+namespace summary_table {
+
+/**
+  Answers aggregate queries from a summary table.
+
+  A query is rewritten when it reads the base table of a summary table
+  with the same GROUP BY columns and selects only items the summary
+  table holds, in any order. The rewritten query reads the summary table,
+  names its columns the way the query wrote its items, and sorts by the
+  GROUP BY columns like the aggregate query would. Summary tables that
+  are not current() are left alone.
+*/
+class Rewriter : public drizzled::plugin::QueryRewriter
+{
+public:
+  Rewriter() :
+    drizzled::plugin::QueryRewriter("summary_table"),
+    enabled(true)
+  { }
+
+  void rewrite(const std::string &schema, std::string &to_rewrite);
+
+  bool enabled;
+};
+
+} /* namespace summary_table */
+} /* namespace drizzle_plugin */
@@ -0,0 +1,152 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <drizzled/memory/block_pool.h>
+#include <drizzled/memory/root.h>
+
+using namespace drizzled;
+
+namespace {
+
+class CountingTracker : public memory::Tracker
+{
+public:
+  CountingTracker() : bytes(0) {}
+
+  bool allocated(size_t size)
+  {
+    bytes+= size;
+    return true;
+  }
+
+  void freed(size_t size)
+  {
+    bytes-= size;
+  }
+
+  size_t bytes;
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE(BlockPoolTests)
+BOOST_AUTO_TEST_CASE(block_size)
+{
+  BOOST_REQUIRE_EQUAL(memory::BlockPool::block_size(1), memory::BlockPool::MIN_CLASS_SIZE);
+  BOOST_REQUIRE_EQUAL(memory::BlockPool::block_size(1024), 1024U);
+  BOOST_REQUIRE_EQUAL(memory::BlockPool::block_size(1025), 1280U);
+  BOOST_REQUIRE_EQUAL(memory::BlockPool::block_size(2048), 2048U);
+  BOOST_REQUIRE_EQUAL(memory::BlockPool::block_size(8193), 10240U);
+  BOOST_REQUIRE_EQUAL(memory::BlockPool::block_size(14000), 14336U);
+  BOOST_REQUIRE_EQUAL(memory::BlockPool::block_size(memory::BlockPool::MAX_CLASS_SIZE), memory::BlockPool::MAX_CLASS_SIZE);
+  BOOST_REQUIRE_EQUAL(memory::BlockPool::block_size(memory::BlockPool::MAX_CLASS_SIZE + 1), memory::BlockPool::MAX_CLASS_SIZE + 1);
+}
+
+BOOST_AUTO_TEST_CASE(retain)
+{
+  memory::BlockPool::clear();
+  BOOST_REQUIRE_EQUAL(memory::BlockPool::retained_bytes(), 0U);
+
+  memory::internal::UsedMemory *block= memory::BlockPool::acquire(4096);
+  BOOST_REQUIRE(block);
+  BOOST_REQUIRE_EQUAL(block->size, 4096U);
+  memory::BlockPool::release(block);
+  BOOST_REQUIRE_EQUAL(memory::BlockPool::retained_bytes(), 4096U);
+
+  /* No size class, always freed */
+  block= memory::BlockPool::acquire(3000);
+  BOOST_REQUIRE(block);
+  memory::BlockPool::release(block);
+  BOOST_REQUIRE_EQUAL(memory::BlockPool::retained_bytes(), 4096U);
+
+  memory::BlockPool::clear();
+  BOOST_REQUIRE_EQUAL(memory::BlockPool::retained_bytes(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(trim)
+{
+  uint64_t saved_size= memory::root_block_pool_size;
+  memory::BlockPool::clear();
+
+  memory::BlockPool::release(memory::BlockPool::acquire(4096));
+  BOOST_REQUIRE_EQUAL(memory::BlockPool::retained_bytes(), 4096U);
+
+  /* Lowering the limit frees what no longer fits */
+  memory::root_block_pool_size= 0;
+  memory::BlockPool::trim();
+  BOOST_REQUIRE_EQUAL(memory::BlockPool::retained_bytes(), 0U);
+
+  memory::root_block_pool_size= saved_size;
+}
+
+BOOST_AUTO_TEST_CASE(disabled)
+{
+  uint64_t saved_size= memory::root_block_pool_size;
+  memory::root_block_pool_size= 0;
+  memory::BlockPool::clear();
+
+  uint64_t hits= memory::BlockPool::hits();
+  uint64_t misses= memory::BlockPool::misses();
+  memory::BlockPool::release(memory::BlockPool::acquire(4096));
+  BOOST_REQUIRE_EQUAL(memory::BlockPool::retained_bytes(), 0U);
+  BOOST_REQUIRE_EQUAL(memory::BlockPool::hits(), hits);
+  BOOST_REQUIRE_EQUAL(memory::BlockPool::misses(), misses);
+
+  memory::root_block_pool_size= saved_size;
+}
+
+BOOST_AUTO_TEST_CASE(root)
+{
+  memory::BlockPool::clear();
+
+  memory::Root root(8192);
+  root.alloc(100);
+  root.alloc(20000);
+  root.free_root(MYF(0));
+  BOOST_REQUIRE_EQUAL(memory::BlockPool::retained_bytes(), 8192U + 20480U);
+
+  uint64_t lookups= memory::BlockPool::hits() + memory::BlockPool::misses();
+  root.alloc(100);
+  BOOST_REQUIRE_EQUAL(memory::BlockPool::hits() + memory::BlockPool::misses(), lookups + 1);
+  root.free_root(MYF(0));
+
+  memory::BlockPool::clear();
+}
+
+BOOST_AUTO_TEST_CASE(tracker)
+{
+  CountingTracker tracker;
+  memory::Root root(8192);
+  root.tracker= &tracker;
+
+  root.alloc(100);
+  BOOST_REQUIRE_EQUAL(tracker.bytes, 8192U);
+  root.alloc(20000);
+  BOOST_REQUIRE_EQUAL(tracker.bytes, 8192U + 20480U);
+  root.free_root(MYF(0));
+  BOOST_REQUIRE_EQUAL(tracker.bytes, 0U);
+
+  memory::BlockPool::clear();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,127 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <drizzled/optimizer/cost_model.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+using namespace drizzled;
+
+namespace {
+
+/** A cost model file that is removed again at the end of the test */
+class ModelFile
+{
+public:
+  explicit ModelFile(const char *contents)
+  {
+    char name[]= "/tmp/cost_model_test.XXXXXX";
+    int fd= mkstemp(name);
+    BOOST_REQUIRE(fd >= 0);
+    path= name;
+    FILE *file= fdopen(fd, "w");
+    fputs(contents, file);
+    fclose(file);
+  }
+
+  ~ModelFile()
+  {
+    unlink(path.c_str());
+  }
+
+  std::string path;
+};
+
+/* Put the defaults back for the tests that come after */
+void reset_model()
+{
+  ModelFile empty("");
+  BOOST_REQUIRE(not optimizer::CostModel::load(empty.path));
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(CostModelTests)
+
+BOOST_AUTO_TEST_CASE(defaults)
+{
+  reset_model();
+  const optimizer::CostModel &model= optimizer::CostModel::global();
+
+  BOOST_REQUIRE_EQUAL(1.0, model.getIOBlockReadCost());
+  BOOST_REQUIRE_EQUAL(0.2, model.getRowEvaluateCost());
+  BOOST_REQUIRE_EQUAL(5.0, model.timeForCompare());
+  BOOST_REQUIRE_EQUAL(10.0, model.timeForCompareRowid());
+  BOOST_REQUIRE_EQUAL(20.0, model.memoryRowsPerRead());
+  BOOST_REQUIRE_EQUAL(&model, &optimizer::CostModel::forEngine("MEMORY"));
+}
+
+BOOST_AUTO_TEST_CASE(engineOverride)
+{
+  ModelFile file("# written by hand\n"
+                 "row_evaluate_cost = 0.4\n"
+                 "\n"
+                 "MEMORY.memory_row_read_cost = 0.01  # cheaper than the default\n"
+                 "memory.key_compare_cost= 0.05\n");
+  BOOST_REQUIRE(not optimizer::CostModel::load(file.path));
+
+  const optimizer::CostModel &global= optimizer::CostModel::global();
+  BOOST_REQUIRE_EQUAL(0.4, global.getRowEvaluateCost());
+  BOOST_REQUIRE_EQUAL(0.05, global.getMemoryRowReadCost());
+  BOOST_REQUIRE_EQUAL(0.1, global.getKeyCompareCost());
+
+  /* Engine names are matched case insensitively */
+  const optimizer::CostModel &memory= optimizer::CostModel::forEngine("Memory");
+  BOOST_REQUIRE_EQUAL(0.4, memory.getRowEvaluateCost());
+  BOOST_REQUIRE_EQUAL(0.01, memory.getMemoryRowReadCost());
+  BOOST_REQUIRE_EQUAL(0.05, memory.getKeyCompareCost());
+
+  /* Engines without an override use the server wide model */
+  BOOST_REQUIRE_EQUAL(&global, &optimizer::CostModel::forEngine("InnoDB"));
+
+  reset_model();
+}
+
+BOOST_AUTO_TEST_CASE(badFileKeepsModel)
+{
+  ModelFile good("io_seek_cost = 2\n");
+  BOOST_REQUIRE(not optimizer::CostModel::load(good.path));
+
+  ModelFile negative("io_seek_cost = -1\n");
+  BOOST_REQUIRE(optimizer::CostModel::load(negative.path));
+  ModelFile unknown("io_seek_cost = 3\nno_such_cost = 1\n");
+  BOOST_REQUIRE(optimizer::CostModel::load(unknown.path));
+  ModelFile garbage("io_seek_cost = 3x\n");
+  BOOST_REQUIRE(optimizer::CostModel::load(garbage.path));
+  BOOST_REQUIRE(optimizer::CostModel::load("/nonexistent/cost_model"));
+
+  BOOST_REQUIRE_EQUAL(2.0, optimizer::CostModel::global().getIOSeekCost());
+
+  reset_model();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,115 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <drizzled/internal/iocache.h>
+
+#include <vector>
+
+using namespace drizzled;
+
+static const size_t CACHE_SIZE= 16384;
+static const size_t FILE_SIZE= 1024 * 1024 + 123;
+
+static unsigned char byte_at(size_t pos)
+{
+  return (unsigned char) ((pos * 7) ^ (pos >> 9));
+}
+
+/* Write FILE_SIZE bytes in records of varying size, some larger than the cache */
+static void write_file(internal::io_cache_st &cache)
+{
+  std::vector<unsigned char> record;
+  size_t pos= 0;
+  for (size_t length= 1; pos < FILE_SIZE; length= (length * 3 + 1) % (CACHE_SIZE * 2))
+  {
+    length= std::min(length, FILE_SIZE - pos);
+    record.resize(length);
+    for (size_t x= 0; x < length; x++)
+      record[x]= byte_at(pos + x);
+    BOOST_REQUIRE_EQUAL(cache.write(&record[0], length), 0);
+    pos+= length;
+  }
+  BOOST_REQUIRE_EQUAL(cache.tell(), FILE_SIZE);
+}
+
+static void check_read(internal::io_cache_st &cache, size_t from)
+{
+  std::vector<unsigned char> record;
+  size_t pos= from;
+  for (size_t length= 5; pos < FILE_SIZE; length= (length * 5 + 3) % (CACHE_SIZE * 3))
+  {
+    length= std::min(length, FILE_SIZE - pos);
+    record.resize(length);
+    BOOST_REQUIRE_EQUAL(cache.read(&record[0], length), 0);
+    for (size_t x= 0; x < length; x++)
+      BOOST_REQUIRE_EQUAL(record[x], byte_at(pos + x));
+    pos+= length;
+  }
+  unsigned char past_end;
+  BOOST_REQUIRE(cache.read(&past_end, 1));
+}
+
+BOOST_AUTO_TEST_SUITE(IOCacheTests)
+BOOST_AUTO_TEST_CASE(async_write_and_read)
+{
+  internal::io_cache_st cache;
+  BOOST_REQUIRE(not cache.open_cached_file("/tmp", "iocache_test", CACHE_SIZE, MYF(0), true));
+  BOOST_REQUIRE(cache.async);
+
+  write_file(cache);
+  BOOST_REQUIRE(cache.async_requests > 0);
+
+  BOOST_REQUIRE(not cache.reinit_io_cache(internal::READ_CACHE, 0, true, false));
+  check_read(cache, 0);
+
+  /* Start in the middle, the read-ahead of the old position is not used */
+  BOOST_REQUIRE(not cache.reinit_io_cache(internal::READ_CACHE, FILE_SIZE / 3, true, false));
+  check_read(cache, FILE_SIZE / 3);
+
+  /* The same file read without async io */
+  BOOST_REQUIRE(not cache.reinit_io_cache(internal::READ_CACHE, 0, false, false));
+  check_read(cache, 0);
+
+  cache.close_cached_file();
+}
+
+BOOST_AUTO_TEST_CASE(async_rewrite)
+{
+  internal::io_cache_st cache;
+  BOOST_REQUIRE(not cache.open_cached_file("/tmp", "iocache_test", CACHE_SIZE, MYF(0), true));
+
+  write_file(cache);
+  BOOST_REQUIRE(not cache.reinit_io_cache(internal::READ_CACHE, 0, true, false));
+  unsigned char first[100];
+  BOOST_REQUIRE_EQUAL(cache.read(first, sizeof(first)), 0);
+
+  /* Back to writing while a read-ahead may be running */
+  BOOST_REQUIRE(not cache.reinit_io_cache(internal::WRITE_CACHE, 0, true, false));
+  write_file(cache);
+  BOOST_REQUIRE(not cache.reinit_io_cache(internal::READ_CACHE, 0, true, false));
+  check_read(cache, 0);
+
+  cache.close_cached_file();
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,137 @@
+/* -*- mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; -*-
+ *  vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ *  Copyright (C) 2011 Drizzle Developer Group
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <drizzled/sort_run_codec.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace drizzled;
+
+namespace {
+
+const uint32_t REC_LENGTH= 40;
+
+/* Encode records, decode the block again and compare */
+size_t round_trip(const std::vector<unsigned char> &records, bool expect_packed)
+{
+  uint32_t count= (uint32_t) (records.size() / REC_LENGTH);
+  std::vector<unsigned char> block(SortRunCodec::max_block_length(count, REC_LENGTH));
+  size_t length= SortRunCodec::encode(&records[0], count, REC_LENGTH, &block[0]);
+  BOOST_REQUIRE(length <= block.size());
+
+  uint32_t block_records;
+  bool packed;
+  size_t data_length= SortRunCodec::read_header(&block[0], &block_records, &packed);
+  BOOST_REQUIRE_EQUAL(data_length + SortRunCodec::HEADER_LENGTH, length);
+  BOOST_REQUIRE_EQUAL(block_records, count);
+  BOOST_REQUIRE_EQUAL(packed, expect_packed);
+
+  std::vector<unsigned char> decoded(records.size());
+  BOOST_REQUIRE(not SortRunCodec::decode(&block[SortRunCodec::HEADER_LENGTH], data_length,
+                                         packed, count, REC_LENGTH, &decoded[0]));
+  BOOST_REQUIRE(decoded == records);
+  return length;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(SortRunCodecTests)
+BOOST_AUTO_TEST_CASE(sorted_keys)
+{
+  /* Sorted keys with a counter in front and space padding after */
+  std::vector<unsigned char> records(1000 * REC_LENGTH, ' ');
+  for (uint32_t x= 0; x < 1000; x++)
+  {
+    unsigned char *record= &records[x * REC_LENGTH];
+    record[0]= (unsigned char) (x >> 8);
+    record[1]= (unsigned char) x;
+    memcpy(record + 2, "name", 4);
+  }
+  size_t length= round_trip(records, true);
+  BOOST_REQUIRE(length < records.size() / 4);
+}
+
+BOOST_AUTO_TEST_CASE(pair_padding)
+{
+  /* Keys padded with the two byte weight of a space, all different */
+  std::vector<unsigned char> records(100 * REC_LENGTH);
+  for (uint32_t x= 0; x < 100; x++)
+  {
+    unsigned char *record= &records[x * REC_LENGTH];
+    for (uint32_t y= 0; y < REC_LENGTH; y+= 2)
+    {
+      record[y]= 0x00;
+      record[y + 1]= 0x20;
+    }
+    record[0]= (unsigned char) (255 - x);
+    record[REC_LENGTH - 1]= (unsigned char) x;
+  }
+  size_t length= round_trip(records, true);
+  BOOST_REQUIRE(length < records.size() / 4);
+}
+
+BOOST_AUTO_TEST_CASE(random_bytes)
+{
+  std::vector<unsigned char> records(100 * REC_LENGTH);
+  srandom(1);
+  for (size_t x= 0; x < records.size(); x++)
+    records[x]= (unsigned char) random();
+  /* Does not compress, kept as it is */
+  size_t length= round_trip(records, false);
+  BOOST_REQUIRE_EQUAL(length, records.size() + SortRunCodec::HEADER_LENGTH);
+}
+
+BOOST_AUTO_TEST_CASE(long_runs)
+{
+  /* Equal records and repeats longer than one control byte covers */
+  std::vector<unsigned char> records(10 * REC_LENGTH * 8, 0);
+  uint32_t count= 10 * 8;
+  for (uint32_t x= 0; x < count; x++)
+    records[x * REC_LENGTH + REC_LENGTH - 1]= (unsigned char) (x / 3);
+  round_trip(records, true);
+
+  std::vector<unsigned char> single(REC_LENGTH, 'a');
+  round_trip(single, true);
+}
+
+BOOST_AUTO_TEST_CASE(corrupt)
+{
+  std::vector<unsigned char> records(10 * REC_LENGTH, 'x');
+  std::vector<unsigned char> block(SortRunCodec::max_block_length(10, REC_LENGTH));
+  size_t length= SortRunCodec::encode(&records[0], 10, REC_LENGTH, &block[0]);
+  size_t data_length= length - SortRunCodec::HEADER_LENGTH;
+  std::vector<unsigned char> decoded(records.size());
+
+  /* Truncated data, too many records and a prefix in the first record */
+  BOOST_REQUIRE(SortRunCodec::decode(&block[SortRunCodec::HEADER_LENGTH], data_length - 1,
+                                     true, 10, REC_LENGTH, &decoded[0]));
+  BOOST_REQUIRE(SortRunCodec::decode(&block[SortRunCodec::HEADER_LENGTH], data_length,
+                                     true, 11, REC_LENGTH, &decoded[0]));
+  block[SortRunCodec::HEADER_LENGTH]= 1;
+  BOOST_REQUIRE(SortRunCodec::decode(&block[SortRunCodec::HEADER_LENGTH], data_length,
+                                     true, 10, REC_LENGTH, &decoded[0]));
+}
+BOOST_AUTO_TEST_SUITE_END()